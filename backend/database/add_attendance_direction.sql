@@ -0,0 +1,7 @@
+-- Migration: Entry/exit direction on attendance records
+-- Date: 2026-10-19
+-- Purpose: Terminals with two RFID readers tag every tap with the lane it was
+-- read at. Taps from single-reader terminals carry no direction (NULL).
+
+ALTER TABLE attendance ADD COLUMN IF NOT EXISTS direction TEXT
+  CHECK (direction IN ('entry', 'exit'));
@@ -0,0 +1,9 @@
+-- Migration: Device event claim timeout
+-- Date: 2026-10-19
+-- Purpose: A claim whose request died mid-processing kept status_code NULL
+-- forever, so every resend got 409 and the high-water mark stalled on it.
+-- claimed_at lets a resend take over a claim older than the backend's
+-- DEVICE_EVENT_CLAIM_TIMEOUT_MS. Requires add_device_event_dedupe.sql.
+
+-- Step 1: When the event was last claimed
+ALTER TABLE device_events ADD COLUMN IF NOT EXISTS claimed_at TIMESTAMPTZ NOT NULL DEFAULT NOW();
@@ -0,0 +1,26 @@
+-- Migration: Idempotent device attendance events
+-- Date: 2026-10-19
+-- Purpose: Terminals number every tap with a per-device sequence number and may
+-- resend it after a timeout or during offline sync. Each (device_id, seq) is
+-- processed once; a resend gets the stored outcome back.
+
+-- Step 1: One row per device event, claimed before the tap is processed
+CREATE TABLE IF NOT EXISTS device_events (
+  device_id TEXT NOT NULL,
+  seq BIGINT NOT NULL CHECK (seq > 0),
+  status_code INTEGER,          -- HTTP status sent for the event, NULL while processing
+  attendance_id UUID REFERENCES attendance(id) ON DELETE SET NULL,
+  created_at TIMESTAMPTZ DEFAULT NOW(),
+  PRIMARY KEY (device_id, seq)
+);
+
+-- Step 2: Per-device high-water mark. Every seq at or below it has been
+-- processed (or was declared absent by the device), so a terminal can resume
+-- its sync right after it.
+CREATE TABLE IF NOT EXISTS device_sync_state (
+  device_id TEXT PRIMARY KEY,
+  high_water BIGINT NOT NULL DEFAULT 0,
+  updated_at TIMESTAMPTZ DEFAULT NOW()
+);
+
+CREATE TRIGGER update_device_sync_state_updated_at BEFORE UPDATE ON device_sync_state FOR EACH ROW EXECUTE PROCEDURE update_updated_at_column();
@@ -1,3 +1,4 @@
+const crypto = require('crypto');
 const jwt = require('jsonwebtoken');
 const User = require('../models/User');
 
@@ -118,6 +119,30 @@ const optionalAuthMiddleware = async (req, res, next) => {
   }
 };
 
+// Terminals (and the MQTT bridge on their behalf) send the shared
+// DEVICE_API_KEY in X-Device-Key
+const isDeviceRequest = (req) => {
+  const expected = process.env.DEVICE_API_KEY;
+  const given = req.header('X-Device-Key');
+  if (!expected || !given) {
+    return false;
+  }
+  const a = Buffer.from(given);
+  const b = Buffer.from(expected);
+  return a.length === b.length && crypto.timingSafeEqual(a, b);
+};
+
+// Middleware for routes only terminals may call
+const deviceAuthMiddleware = (req, res, next) => {
+  if (!process.env.DEVICE_API_KEY) {
+    return res.status(503).json({ error: 'Device authentication is not configured' });
+  }
+  if (!isDeviceRequest(req)) {
+    return res.status(401).json({ error: 'Invalid or missing device key' });
+  }
+  next();
+};
+
 module.exports = {
   authMiddleware,
   adminMiddleware,
@@ -125,5 +150,7 @@ module.exports = {
   adminOrTeacherMiddleware,
   teacherOnlyMiddleware,
   teacherOrPrincipalMiddleware,
-  optionalAuthMiddleware
+  optionalAuthMiddleware,
+  deviceAuthMiddleware,
+  isDeviceRequest
 };
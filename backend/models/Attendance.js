@@ -1,5 +1,9 @@
 const { supabase } = require('../config/supabase');
 
+// Longest a terminal's request may hold a device event claim; firmware
+// requests time out well before this
+const DEVICE_EVENT_CLAIM_TIMEOUT_MS = 60 * 1000;
+
 class Attendance {
   constructor(attendanceData) {
     Object.assign(this, attendanceData);
@@ -29,7 +33,8 @@ class Attendance {
         user_id: this.user_id || this.user,
         date: this.date,
         timestamp: this.timestamp,
-        status: this.status || 'present'
+        status: this.status || 'present',
+        direction: this.direction || null
       };
 
       let result;
@@ -263,6 +268,137 @@ class Attendance {
     }
   }
 
+  // Claim a device event before processing it. Returns { claimed: true } for
+  // a new (deviceId, seq), or { claimed: false, event } with the stored row
+  // when the terminal is resending an event it already submitted. A claim
+  // left without an outcome for DEVICE_EVENT_CLAIM_TIMEOUT_MS belongs to a
+  // request that died mid-processing, and the resend takes it over.
+  static async claimDeviceEvent(deviceId, seq) {
+    const { error } = await supabase
+      .from('device_events')
+      .insert({ device_id: deviceId, seq });
+
+    if (!error) {
+      return { claimed: true };
+    }
+    if (error.code !== '23505') throw error; // Anything but a unique violation
+
+    const { data, error: selectError } = await supabase
+      .from('device_events')
+      .select('*')
+      .eq('device_id', deviceId)
+      .eq('seq', seq)
+      .single();
+
+    if (selectError) throw selectError;
+
+    const claimedAt = new Date(data.claimed_at).getTime();
+    if (data.status_code === null && Date.now() - claimedAt > DEVICE_EVENT_CLAIM_TIMEOUT_MS) {
+      // Only one resend wins the takeover
+      const { data: taken, error: takeError } = await supabase
+        .from('device_events')
+        .update({ claimed_at: new Date().toISOString() })
+        .eq('device_id', deviceId)
+        .eq('seq', seq)
+        .is('status_code', null)
+        .eq('claimed_at', data.claimed_at)
+        .select('seq');
+
+      if (takeError) throw takeError;
+      if (taken.length > 0) {
+        console.warn('Reclaimed stale device event:', deviceId, seq);
+        return { claimed: true };
+      }
+    }
+    return { claimed: false, event: data };
+  }
+
+  // Record the outcome sent for a claimed event
+  static async completeDeviceEvent(deviceId, seq, statusCode, attendanceId = null) {
+    const { error } = await supabase
+      .from('device_events')
+      .update({ status_code: statusCode, attendance_id: attendanceId })
+      .eq('device_id', deviceId)
+      .eq('seq', seq);
+
+    if (error) throw error;
+  }
+
+  // Drop a claim whose processing failed so the terminal's retry is processed
+  static async releaseDeviceEvent(deviceId, seq) {
+    const { error } = await supabase
+      .from('device_events')
+      .delete()
+      .eq('device_id', deviceId)
+      .eq('seq', seq);
+
+    if (error) throw error;
+  }
+
+  // Advance and return the device's high-water mark: the highest seq such that
+  // every seq up to it has been processed. `floor` is the lowest seq the
+  // terminal still holds; anything below it will never be sent (taps that
+  // never reached the backend, sequence numbers skipped across a reboot), so
+  // it closes those gaps.
+  static async getDeviceHighWater(deviceId, floor = 0) {
+    const { data: state, error } = await supabase
+      .from('device_sync_state')
+      .select('high_water')
+      .eq('device_id', deviceId)
+      .maybeSingle();
+
+    if (error) throw error;
+
+    const stored = state ? Number(state.high_water) : 0;
+    let highWater = Math.max(stored, Number(floor) - 1);
+
+    // Walk forward over contiguous processed events
+    while (true) {
+      const { data: events, error: eventsError } = await supabase
+        .from('device_events')
+        .select('seq')
+        .eq('device_id', deviceId)
+        .gt('seq', highWater)
+        .not('status_code', 'is', null)
+        .order('seq', { ascending: true })
+        .limit(500);
+
+      if (eventsError) throw eventsError;
+
+      let advanced = 0;
+      for (const event of events) {
+        if (Number(event.seq) !== highWater + 1) break;
+        highWater++;
+        advanced++;
+      }
+      if (advanced < 500) break;
+    }
+
+    if (!state || highWater !== stored) {
+      const { error: upsertError } = await supabase
+        .from('device_sync_state')
+        .upsert({ device_id: deviceId, high_water: highWater });
+
+      if (upsertError) throw upsertError;
+    }
+
+    return highWater;
+  }
+
+  // Highest seq seen from the device, processed or not. A terminal that lost
+  // its sequence file resumes numbering above it.
+  static async getDeviceLastSeq(deviceId) {
+    const { data: events, error } = await supabase
+      .from('device_events')
+      .select('seq')
+      .eq('device_id', deviceId)
+      .order('seq', { ascending: false })
+      .limit(1);
+
+    if (error) throw error;
+    return events.length > 0 ? Number(events[0].seq) : 0;
+  }
+
   // Static method to find attendance records
   static async find(conditions = {}, populate = null) {
     try {
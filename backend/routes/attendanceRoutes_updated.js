@@ -1,7 +1,7 @@
 const express = require('express');
 const User = require('../models/User');
 const Attendance = require('../models/Attendance');
-const { authMiddleware, adminOrMentorMiddleware, optionalAuthMiddleware } = require('../middleware/auth');
+const { authMiddleware, adminOrMentorMiddleware, optionalAuthMiddleware, deviceAuthMiddleware, isDeviceRequest } = require('../middleware/auth');
 const { supabase } = require('../config/supabase');
 
 const router = express.Router();
@@ -43,12 +43,78 @@ function getDateOnly(date) {
   return d.toISOString().split('T')[0];
 }
 
+// Send a response to a terminal, recording it as the outcome of the
+// device event (if the request carried one) and reporting the high-water mark
+async function respondToDevice(res, deviceEvent, statusCode, body, attendanceId = null) {
+  if (deviceEvent && deviceEvent.claimed) {
+    try {
+      if (statusCode >= 500) {
+        await Attendance.releaseDeviceEvent(deviceEvent.deviceId, deviceEvent.seq);
+      } else {
+        await Attendance.completeDeviceEvent(deviceEvent.deviceId, deviceEvent.seq, statusCode, attendanceId);
+      }
+      body.seq = deviceEvent.seq;
+      body.highWater = await Attendance.getDeviceHighWater(deviceEvent.deviceId, deviceEvent.floor);
+    } catch (error) {
+      console.error('Device event bookkeeping error:', error);
+    }
+  }
+  res.status(statusCode).json(body);
+}
+
+const ATTENDANCE_DIRECTIONS = ['entry', 'exit'];
+
+// Terminals send { deviceId, seq } with every tap and an X-Seq-Floor header
+// (lowest seq they still hold) during sync. Both move the device's
+// bookkeeping, so they only count from a request with the device key; other
+// requests are recorded without dedupe.
+function getDeviceEvent(req) {
+  const { deviceId, seq } = req.body;
+  if (!isDeviceRequest(req) || !deviceId || !Number.isInteger(seq) || seq <= 0) {
+    return null;
+  }
+  return { deviceId, seq, floor: parseInt(req.get('X-Seq-Floor'), 10) || 0 };
+}
+
 // POST /attendance - Record attendance
 router.post('/', async (req, res) => {
+  const deviceEvent = getDeviceEvent(req);
+
   try {
-    const { rfidTag, timestamp } = req.body;
+    const { rfidTag, timestamp, direction } = req.body;
     
     console.log('RFID Tag: ', rfidTag);
+
+    // Two-reader terminals tag each tap with its lane; single readers send none
+    if (direction !== undefined && !ATTENDANCE_DIRECTIONS.includes(direction)) {
+      return res.status(400).json({ error: "direction must be 'entry' or 'exit'" });
+    }
+
+    // A resent event gets its original outcome instead of a second record
+    if (deviceEvent) {
+      const claim = await Attendance.claimDeviceEvent(deviceEvent.deviceId, deviceEvent.seq);
+      deviceEvent.claimed = claim.claimed;
+      if (!claim.claimed) {
+        console.log('Duplicate device event:', deviceEvent.deviceId, deviceEvent.seq);
+        const highWater = await Attendance.getDeviceHighWater(deviceEvent.deviceId, deviceEvent.floor);
+        if (claim.event.status_code === null) {
+          return res.status(409).json({
+            error: 'Event is still being processed',
+            duplicate: true,
+            seq: deviceEvent.seq,
+            highWater
+          });
+        }
+        const statusCode = claim.event.status_code;
+        return res.status(statusCode).json({
+          success: statusCode < 300,
+          duplicate: true,
+          message: 'Event already processed',
+          seq: deviceEvent.seq,
+          highWater
+        });
+      }
+    }
     
     // Parse timestamp as IST FIRST (firmware sends IST timestamps)
     const currentTime = parseISTTimestamp(timestamp);
@@ -57,7 +123,7 @@ router.post('/', async (req, res) => {
     // Find user by RFID tag
     const user = await User.findByRfidTag(rfidTag);
     if (!user) {
-      return res.status(404).json({ error: 'User not found with this RFID tag' });
+      return respondToDevice(res, deviceEvent, 404, { error: 'User not found with this RFID tag' });
     }
 
     console.log('User found:', user.name);
@@ -67,7 +133,8 @@ router.post('/', async (req, res) => {
       user_id: user.id,
       date: currentDate,
       timestamp: currentTime,
-      status: 'present' // Default to present for RFID-based attendance
+      status: 'present', // Default to present for RFID-based attendance
+      direction: direction || null
     });
 
     await attendance.save();
@@ -88,7 +155,7 @@ router.post('/', async (req, res) => {
       timestamp: currentTime.toISOString()
     });
 
-    res.json({
+    await respondToDevice(res, deviceEvent, 200, {
       success: true,
       message: `Attendance recorded for ${user.name}`,
       data: {
@@ -99,20 +166,38 @@ router.post('/', async (req, res) => {
         },
         attendance: {
           date: currentDate,
-          timestamp: currentTime.toISOString()
+          timestamp: currentTime.toISOString(),
+          direction: attendance.direction
         }
       }
-    });
+    }, attendance.id);
 
   } catch (error) {
     console.error('Attendance recording error:', error);
-    res.status(500).json({ 
+    await respondToDevice(res, deviceEvent, 500, { 
       error: 'Failed to record attendance',
       details: error.message 
     });
   }
 });
 
+// GET /attendance/device/:deviceId/watermark - Highest seq processed without
+// gaps, and the highest seq seen at all (lastSeq)
+router.get('/device/:deviceId/watermark', deviceAuthMiddleware, async (req, res) => {
+  try {
+    const floor = parseInt(req.query.floor, 10) || 0;
+    const highWater = await Attendance.getDeviceHighWater(req.params.deviceId, floor);
+    const lastSeq = Math.max(highWater, await Attendance.getDeviceLastSeq(req.params.deviceId));
+    res.json({ deviceId: req.params.deviceId, highWater, lastSeq });
+  } catch (error) {
+    console.error('Get watermark error:', error);
+    res.status(500).json({ 
+      error: 'Failed to get watermark',
+      details: error.message 
+    });
+  }
+});
+
 // GET /attendance - Get attendance records with filtering
 router.get('/', authMiddleware, async (req, res) => {
   try {
@@ -169,6 +169,11 @@ app.listen(PORT, () => {
   console.log(`📱 Health check: http://localhost:${PORT}/health`);
   console.log(`📋 API info: http://localhost:${PORT}/`);
   console.log(`🔐 Make sure to set JWT_SECRET in your .env file`);
+
+  // Terminals in MQTT transport mode publish taps to a broker instead of POSTing
+  if (process.env.MQTT_URL) {
+    require('./services/mqttBridge').start(process.env.MQTT_URL);
+  }
 });
 
 // Schedule auto-cleanup task to run every day at 10:00 PM
@@ -0,0 +1,95 @@
+const mqtt = require('mqtt');
+
+// Bridges terminals in MQTT transport mode to the HTTP attendance API.
+// Taps on attendee/<deviceId>/tap are posted to POST /attendance and the
+// outcome is published on attendee/<deviceId>/result. The PUBACK for a tap
+// is only sent once the backend has answered, so a tap the terminal saw
+// acknowledged is already recorded; taps the backend could not take stay
+// unacknowledged and reach it again through the broker's persistent session
+// or the terminal's offline sync (both deduped on deviceId + seq).
+class MqttBridge {
+  constructor() {
+    this.client = null;
+    this.topicRoot = process.env.MQTT_TOPIC_ROOT || 'attendee';
+    this.apiBase = `http://localhost:${process.env.PORT || 3000}`;
+  }
+
+  start(url) {
+    this.client = mqtt.connect(url, {
+      clientId: process.env.MQTT_CLIENT_ID || 'attendee-bridge',
+      clean: false,
+      username: process.env.MQTT_USERNAME,
+      password: process.env.MQTT_PASSWORD
+    });
+
+    // Hold the PUBACK until the tap has been processed
+    this.client.handleMessage = (packet, callback) => {
+      this.handleMessage(packet.topic, packet.payload)
+        .then(() => callback())
+        .catch(error => {
+          console.error('❌ MQTT bridge could not deliver message:', error.message);
+          callback(error);
+        });
+    };
+
+    this.client.on('connect', (connack) => {
+      console.log(`📡 MQTT bridge connected to ${url}${connack.sessionPresent ? ' (session resumed)' : ''}`);
+      this.client.subscribe([
+        `${this.topicRoot}/+/tap`,
+        `${this.topicRoot}/+/status`
+      ], { qos: 1 }, (error) => {
+        if (error) console.error('❌ MQTT bridge subscribe failed:', error.message);
+      });
+    });
+
+    this.client.on('error', (error) => {
+      console.error('❌ MQTT bridge error:', error.message);
+    });
+  }
+
+  async handleMessage(topic, payload) {
+    const [, deviceId, kind] = topic.split('/');
+
+    let message;
+    try {
+      message = JSON.parse(payload.toString());
+    } catch (error) {
+      console.error(`⚠️ Ignoring malformed MQTT message on ${topic}`);
+      return;
+    }
+
+    if (kind === 'status') {
+      console.log(`📟 Device ${deviceId} ${message.online === false ? 'offline' : 'online'}`);
+      return;
+    }
+    if (kind === 'tap') {
+      await this.forwardTap(deviceId, message);
+    }
+  }
+
+  async forwardTap(deviceId, tap) {
+    // Throws when the backend is unreachable, which leaves the tap unacknowledged
+    const response = await fetch(`${this.apiBase}/attendance`, {
+      method: 'POST',
+      headers: { 'Content-Type': 'application/json', 'X-Device-Key': process.env.DEVICE_API_KEY || '' },
+      body: JSON.stringify({ ...tap, deviceId })
+    });
+    const body = await response.json().catch(() => ({}));
+
+    if (response.status >= 500 || response.status === 409) {
+      throw new Error(`HTTP ${response.status} for ${deviceId} seq ${tap.seq}`);
+    }
+
+    const result = {
+      seq: tap.seq,
+      status: response.status,
+      success: response.ok,
+      duplicate: body.duplicate === true,
+      name: body.data?.user?.name || '',
+      message: response.ok ? (body.duplicate ? 'Already recorded' : 'Attendance OK') : (body.error || 'Rejected')
+    };
+    this.client.publish(`${this.topicRoot}/${deviceId}/result`, JSON.stringify(result), { qos: 1 });
+  }
+}
+
+module.exports = new MqttBridge();
@@ -0,0 +1,108 @@
+#!/bin/bash
+
+# Test script for idempotent device events
+# Sends the same (deviceId, seq) twice and checks the high-water mark
+# Requires database/add_device_event_dedupe.sql and
+# add_device_event_claim_timeout.sql to be applied, and DEVICE_API_KEY set
+#
+# With TERMINAL_IP set, also gives that terminal the key and checks it
+# cannot be read back from the terminal's file download
+
+API_BASE="http://localhost:3000"
+TEST_RFID="TEST12345"
+DEVICE_ID="TEST_TERMINAL_$(date +%s)"
+DEVICE_KEY="${DEVICE_API_KEY:-change-this-device-key}"
+TERMINAL_IP="${TERMINAL_IP:-}"
+
+echo "🧪 Testing Attendee - Device Event Dedupe"
+echo "=========================================================="
+
+# Test 1: First submission of seq 1
+echo "📝 Test 1: Submitting seq 1..."
+FIRST_RESPONSE=$(curl -s -X POST \
+  -H "Content-Type: application/json" \
+  -H "X-Device-Key: $DEVICE_KEY" \
+  -d "{\"rfidTag\":\"$TEST_RFID\",\"deviceId\":\"$DEVICE_ID\",\"seq\":1}" \
+  "$API_BASE/attendance")
+
+echo "First Response: $FIRST_RESPONSE"
+echo ""
+
+# Test 2: Resend seq 1 (simulates a timed-out request being retried)
+echo "📝 Test 2: Resending seq 1 (should be a duplicate)..."
+DUPLICATE_RESPONSE=$(curl -s -X POST \
+  -H "Content-Type: application/json" \
+  -H "X-Device-Key: $DEVICE_KEY" \
+  -d "{\"rfidTag\":\"$TEST_RFID\",\"deviceId\":\"$DEVICE_ID\",\"seq\":1}" \
+  "$API_BASE/attendance")
+
+echo "Duplicate Response: $DUPLICATE_RESPONSE"
+echo ""
+
+# Test 3: Submit seq 3 out of order, watermark should stay at 1
+echo "📝 Test 3: Submitting seq 3 (gap at 2)..."
+GAP_RESPONSE=$(curl -s -X POST \
+  -H "Content-Type: application/json" \
+  -H "X-Device-Key: $DEVICE_KEY" \
+  -d "{\"rfidTag\":\"$TEST_RFID\",\"deviceId\":\"$DEVICE_ID\",\"seq\":3}" \
+  "$API_BASE/attendance")
+
+echo "Gap Response: $GAP_RESPONSE"
+echo ""
+
+# Test 4: Device declares it holds nothing below seq 3
+echo "📝 Test 4: Watermark with floor=3 (closes the gap)..."
+WATERMARK_RESPONSE=$(curl -s -X GET -H "X-Device-Key: $DEVICE_KEY" "$API_BASE/attendance/device/$DEVICE_ID/watermark?floor=3")
+echo "Watermark: $WATERMARK_RESPONSE"
+echo ""
+
+# Test 4b: Without the device key the watermark is refused
+echo "📝 Test 4b: Watermark without the device key..."
+UNAUTH_STATUS=$(curl -s -o /dev/null -w "%{http_code}" "$API_BASE/attendance/device/$DEVICE_ID/watermark?floor=100")
+echo "Status: $UNAUTH_STATUS"
+echo ""
+
+# Test 5: Two pipelined requests on one connection
+echo "📝 Test 5: Pipelining seq 4 and 5 on one connection..."
+HOST_PORT=${API_BASE#http://}
+{
+  for SEQ in 4 5; do
+    BODY="{\"rfidTag\":\"$TEST_RFID\",\"deviceId\":\"$DEVICE_ID\",\"seq\":$SEQ}"
+    printf "POST /attendance HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\nX-Device-Key: %s\r\nX-Seq-Floor: 4\r\nContent-Length: %d\r\n\r\n%s" \
+      "$HOST_PORT" "$DEVICE_KEY" "${#BODY}" "$BODY"
+  done
+  sleep 3
+} | nc "${HOST_PORT%:*}" "${HOST_PORT#*:}" | grep -a -E "^HTTP/1.1|highWater"
+echo ""
+
+# Test 6: The terminal never serves its device key
+if [ -n "$TERMINAL_IP" ]; then
+  echo "📝 Test 6: Device key is not downloadable from terminal $TERMINAL_IP..."
+  curl -s -o /dev/null -X POST -H "Content-Type: application/json" \
+    -d "{\"deviceKey\":\"$DEVICE_KEY\"}" "http://$TERMINAL_IP/api/config"
+  KEY_LEAKED=0
+  for FILE in config.json device_key.txt; do
+    DOWNLOAD=$(curl -s "http://$TERMINAL_IP/api/firmware/download?file=$FILE")
+    if echo "$DOWNLOAD" | grep -q -F -e "$DEVICE_KEY" -e '"deviceKey"'; then
+      echo "❌ $FILE download contains the device key"
+      KEY_LEAKED=1
+    fi
+  done
+  if curl -s "http://$TERMINAL_IP/api/config" | grep -q -F -e "$DEVICE_KEY" -e '"deviceKey"'; then
+    echo "❌ /api/config returns the device key"
+    KEY_LEAKED=1
+  fi
+  [ "$KEY_LEAKED" -eq 0 ] && echo "Key not exposed (config.json, device_key.txt, /api/config)"
+  echo ""
+fi
+
+echo "✅ Test completed!"
+echo ""
+echo "💡 Expected behavior:"
+echo "   - First call records attendance (or 404 if the tag is unknown) with highWater 1"
+echo "   - Second call returns the same status with duplicate: true and no new record"
+echo "   - Third call keeps highWater at 1 because seq 2 is missing"
+echo "   - Watermark with floor=3 reports highWater 3 and lastSeq 3"
+echo "   - Watermark without the key returns 401 and leaves highWater alone"
+echo "   - Pipelined calls return two responses in order, the last with highWater 5"
+echo "   - With TERMINAL_IP, no terminal download or config read contains the key"
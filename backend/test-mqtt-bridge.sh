@@ -0,0 +1,66 @@
+#!/bin/bash
+
+# Test script for the MQTT bridge
+# Publishes a tap the way a terminal in MQTT transport mode does and waits
+# for the result. Requires a local Mosquitto (mosquitto_pub/mosquitto_sub),
+# database/add_device_event_dedupe.sql, and the backend started with
+# MQTT_URL=mqtt://localhost:1883
+
+BROKER_HOST="localhost"
+TEST_RFID="TEST12345"
+DEVICE_ID="TEST_TERMINAL_$(date +%s)"
+TOPIC="attendee/$DEVICE_ID"
+
+echo "🧪 Testing Attendee - MQTT Bridge"
+echo "=========================================================="
+
+if ! command -v mosquitto_pub > /dev/null; then
+  echo "❌ mosquitto_pub not found (install mosquitto-clients)"
+  exit 1
+fi
+
+# Test 1: Retained status, as sent on connect and with every heartbeat
+echo "📝 Test 1: Publishing retained online status..."
+mosquitto_pub -h "$BROKER_HOST" -q 1 -r -t "$TOPIC/status" \
+  -m "{\"deviceId\":\"$DEVICE_ID\",\"online\":true}"
+echo ""
+
+# Test 2: Tap with seq 1, result should arrive on the result topic
+echo "📝 Test 2: Publishing tap seq 1..."
+mosquitto_sub -h "$BROKER_HOST" -q 1 -t "$TOPIC/result" -C 1 -W 10 > /tmp/mqtt_result_1 &
+SUB_PID=$!
+sleep 1
+mosquitto_pub -h "$BROKER_HOST" -q 1 -t "$TOPIC/tap" \
+  -m "{\"rfidTag\":\"$TEST_RFID\",\"deviceId\":\"$DEVICE_ID\",\"seq\":1}"
+wait $SUB_PID
+echo "Result: $(cat /tmp/mqtt_result_1)"
+echo ""
+
+# Test 3: Same seq again (terminal resend with DUP), should be a duplicate
+echo "📝 Test 3: Republishing tap seq 1 (should be a duplicate)..."
+mosquitto_sub -h "$BROKER_HOST" -q 1 -t "$TOPIC/result" -C 1 -W 10 > /tmp/mqtt_result_2 &
+SUB_PID=$!
+sleep 1
+mosquitto_pub -h "$BROKER_HOST" -q 1 -t "$TOPIC/tap" \
+  -m "{\"rfidTag\":\"$TEST_RFID\",\"deviceId\":\"$DEVICE_ID\",\"seq\":1}"
+wait $SUB_PID
+DUPLICATE_RESULT=$(cat /tmp/mqtt_result_2)
+echo "Result: $DUPLICATE_RESULT"
+
+if echo "$DUPLICATE_RESULT" | grep -q '"duplicate":true'; then
+  echo "✅ Resent tap was deduped"
+else
+  echo "❌ Resent tap was not reported as a duplicate"
+fi
+echo ""
+
+# Test 4: Command topic (watch the terminal's serial log or /api/jobs)
+echo "📝 Test 4: Sending sync command..."
+mosquitto_pub -h "$BROKER_HOST" -q 1 -t "$TOPIC/cmd" -m '{"command":"sync"}'
+echo ""
+
+# Clear the retained status for the test device
+mosquitto_pub -h "$BROKER_HOST" -r -t "$TOPIC/status" -n
+rm -f /tmp/mqtt_result_1 /tmp/mqtt_result_2
+
+echo "🏁 MQTT bridge test completed"
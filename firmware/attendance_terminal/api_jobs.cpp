@@ -0,0 +1,390 @@
+/*
+ * Background jobs for the configuration API - Attendee Attendance Terminal v2.0
+ *
+ * Each job is a small state machine. serviceApiJobs() runs from loop() and
+ * gives every active job one step; steps only start work or check on it
+ * (WiFi status, sync job progress, elapsed time) and never wait in place.
+ */
+
+#include <ESP8266WiFi.h>
+#include <WiFiManager.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "display_frontend.h"
+#include "api_jobs.h"
+#include "offline_sync.h"
+#include "circuit_breaker.h"
+#include "rfid_spi.h"
+
+// External references from main file
+extern bool isOnline;
+extern int offlineLogsCount;
+
+// Function declarations from main file
+extern bool sendHeartbeat();
+
+#define JOB_SWITCH_CONNECT_TIMEOUT_MS 20000UL   // Matches the old 20 x 1 s attempt loop
+#define JOB_RESPONSE_GRACE_MS 1000UL            // Let the 202 reach the client before disruptive steps
+
+static ApiJob jobs[API_JOB_SLOTS];
+static uint16_t nextJobId = 1;
+
+// ========================================
+// JOB TABLE
+// ========================================
+
+bool isApiJobFinished(const ApiJob& job) {
+  return job.state == JOB_DONE || job.state == JOB_FAILED;
+}
+
+ApiJob* findApiJob(uint16_t id) {
+  if (id == 0) {
+    return nullptr;
+  }
+  for (int i = 0; i < API_JOB_SLOTS; i++) {
+    if (jobs[i].id == id) {
+      return &jobs[i];
+    }
+  }
+  return nullptr;
+}
+
+// Returns the already-running job of the same type if there is one, so a
+// double-clicked admin button does not start the same action twice.
+ApiJob* createApiJob(ApiJobType type) {
+  ApiJob* freeSlot = nullptr;
+  ApiJob* oldestFinished = nullptr;
+
+  for (int i = 0; i < API_JOB_SLOTS; i++) {
+    if (jobs[i].id == 0) {
+      if (!freeSlot) {
+        freeSlot = &jobs[i];
+      }
+    } else if (!isApiJobFinished(jobs[i])) {
+      if (jobs[i].type == type) {
+        return &jobs[i];
+      }
+    } else if (!oldestFinished || jobs[i].finishedAt < oldestFinished->finishedAt) {
+      oldestFinished = &jobs[i];
+    }
+  }
+
+  ApiJob* slot = freeSlot ? freeSlot : oldestFinished;
+  if (!slot) {
+    return nullptr;
+  }
+
+  *slot = ApiJob();
+  slot->id = nextJobId++;
+  if (nextJobId == 0) {
+    nextJobId = 1;
+  }
+  slot->type = type;
+  slot->state = JOB_QUEUED;
+  slot->progress = 0;
+  slot->step = 0;
+  slot->createdAt = millis();
+  slot->stepStart = slot->createdAt;
+  slot->finishedAt = 0;
+  slot->message = "Queued";
+  return slot;
+}
+
+static void nextStep(ApiJob& job) {
+  job.step++;
+  job.stepStart = millis();
+}
+
+static void finishJob(ApiJob& job, bool success, const String& message) {
+  job.state = success ? JOB_DONE : JOB_FAILED;
+  job.progress = 100;
+  job.message = message;
+  job.finishedAt = millis();
+  // Credentials are not kept once the switch is over
+  job.password = "";
+  job.previousPassword = "";
+  LOG_INFO("API job %u (%s) %s: %s", job.id, apiJobTypeName(job.type),
+           apiJobStateName(job.state), job.message.c_str());
+}
+
+// ========================================
+// JOB STEPS
+// ========================================
+
+static void stepSyncJob(ApiJob& job) {
+  const OfflineSyncStatus& sync = getOfflineSyncStatus();
+
+  if (job.step == 0) {
+    if (!isOnline) {
+      finishJob(job, false, "Device is offline");
+      return;
+    }
+    if (offlineLogsCount <= 0) {
+      finishJob(job, true, "Nothing to sync");
+      return;
+    }
+    Display::status(LCD_SYNC_PROGRESS);
+    startOfflineSync();
+    job.message = "Syncing " + String(offlineLogsCount) + " logs";
+    nextStep(job);
+    return;
+  }
+
+  if (isOfflineSyncActive()) {
+    if (sync.initialCount > 0) {
+      job.progress = (uint8_t)min(99, (sync.syncedCount + sync.deferredCount) * 100 / sync.initialCount);
+    }
+    return;
+  }
+
+  finishJob(job, sync.deferredCount == 0 && offlineLogsCount == 0,
+            "Synced " + String(sync.syncedCount) + "/" + String(sync.initialCount) +
+            ", " + String(offlineLogsCount) + " remaining");
+}
+
+static void stepHeartbeatJob(ApiJob& job) {
+  if (!isOnline) {
+    finishJob(job, false, "Device is offline");
+    return;
+  }
+  // A single POST bounded by the breaker's RTT-derived timeout
+  bool sent = sendHeartbeat();
+  Display::status(LCD_SYNC_COMPLETE, sent ? "Heartbeat Sent" : "Heartbeat Fail");
+  finishJob(job, sent, sent ? "Heartbeat sent to backend" : "Heartbeat failed");
+}
+
+static void stepResetWiFiJob(ApiJob& job) {
+  switch (job.step) {
+    case 0:
+      Display::status(LCD_WIFI_RESET);
+      job.message = "Resetting WiFi settings";
+      nextStep(job);
+      break;
+
+    case 1:
+      if (millis() - job.stepStart < JOB_RESPONSE_GRACE_MS) {
+        return;
+      }
+      {
+        WiFi.disconnect(true);
+        WiFiManager wifiManager;
+        wifiManager.resetSettings();
+      }
+      Display::status(LCD_RESTART);
+      job.progress = 50;
+      nextStep(job);
+      break;
+
+    default:
+      if (millis() - job.stepStart < JOB_RESPONSE_GRACE_MS) {
+        return;
+      }
+      LOG_INFO("WiFi settings reset via API - restarting");
+      ESP.restart();
+      break;
+  }
+}
+
+static void stepRestartJob(ApiJob& job) {
+  if (job.step == 0) {
+    Display::status(LCD_RESTART, "Via Frontend");
+    job.message = "Restarting";
+    nextStep(job);
+    return;
+  }
+  if (millis() - job.stepStart < JOB_RESPONSE_GRACE_MS) {
+    return;
+  }
+  LOG_INFO("Device restart triggered via API");
+  ESP.restart();
+}
+
+static void stepSwitchNetworkJob(ApiJob& job) {
+  switch (job.step) {
+    case 0:
+      job.previousSsid = WiFi.SSID();
+      job.previousPassword = WiFi.psk();
+      Display::status(LCD_NETWORK_SWITCH, job.ssid);
+      job.message = "Switching to " + job.ssid;
+      nextStep(job);
+      break;
+
+    case 1:
+      if (millis() - job.stepStart < JOB_RESPONSE_GRACE_MS) {
+        return;
+      }
+      WiFi.disconnect();
+      WiFi.begin(job.ssid.c_str(), job.password.c_str());
+      Display::status(LCD_CONNECTION_PROGRESS, "20"); // Max attempts
+      job.message = "Connecting to " + job.ssid;
+      nextStep(job);
+      break;
+
+    case 2: {
+      unsigned long elapsed = millis() - job.stepStart;
+      job.progress = (uint8_t)min(90UL, elapsed * 90UL / JOB_SWITCH_CONNECT_TIMEOUT_MS);
+
+      if (WiFi.status() == WL_CONNECTED) {
+        Display::status(LCD_CONNECTION_SUCCESS, WiFi.localIP().toString());
+        isOnline = true;
+        setLEDState(LED_GREEN);
+        breakerReset(); // RTT history belongs to the old network
+        syncTimeWithNTP();
+        finishJob(job, true, "Connected to " + job.ssid + " - IP: " + WiFi.localIP().toString());
+        return;
+      }
+
+      if (elapsed < JOB_SWITCH_CONNECT_TIMEOUT_MS) {
+        return;
+      }
+
+      // Fall back to the network we were on before the switch
+      Display::status(LCD_CONNECTION_FAILED);
+      LOG_ERROR("Failed to connect to WiFi: %s", job.ssid.c_str());
+      isOnline = false;
+      setLEDState(LED_RED);
+      WiFi.disconnect();
+      if (job.previousSsid.length() > 0) {
+        WiFi.begin(job.previousSsid.c_str(), job.previousPassword.c_str());
+      }
+      job.message = "Restoring previous network";
+      nextStep(job);
+      break;
+    }
+
+    default:
+      if (WiFi.status() == WL_CONNECTED) {
+        isOnline = true;
+        setLEDState(LED_GREEN);
+        Display::status(LCD_CONNECTION_SUCCESS, WiFi.localIP().toString());
+        finishJob(job, false, "Could not join " + job.ssid + ", restored " + job.previousSsid);
+      } else if (millis() - job.stepStart > WIFI_RECONNECT_ATTEMPT_WINDOW_MS) {
+        finishJob(job, false, "Could not join " + job.ssid + ", running offline");
+      }
+      break;
+  }
+}
+
+static void stepRfidBenchmarkJob(ApiJob& job) {
+  switch (job.step) {
+    case 0:
+      rfidBenchBegin();
+      job.message = "Measuring stock driver poll rate, keep cards away";
+      nextStep(job);
+      break;
+
+    case 1:
+      if (rfidBenchPolls(false)) {
+        job.progress = 30;
+        job.message = "Measuring burst driver poll rate";
+        nextStep(job);
+      }
+      break;
+
+    case 2:
+      if (rfidBenchPolls(true)) {
+        job.progress = 60;
+        job.message = "Hold a card on the reader to time UID reads";
+        nextStep(job);
+      }
+      break;
+
+    default: {
+      const RfidBenchResult& result = rfidBenchResult();
+      // The burst driver probes first: with no card it gives up in 2 ms, the stock one in 25
+      bool timed = rfidBenchReads(true) && rfidBenchReads(false);
+      if (!timed && millis() - job.stepStart < RFID_BENCH_CARD_WAIT_MS) {
+        return;
+      }
+      rfidBenchEnd();
+      String message = "Polls/s stock " + String(result.stockPollsPerSec) + ", burst " +
+                       String(result.fastPollsPerSec) + " at " + String(result.fastClockHz / 1000) + " kHz";
+      if (timed) {
+        message += "; UID read stock " + String(result.stockReadUs) + " us, burst " +
+                   String(result.fastReadUs) + " us";
+      } else {
+        message += "; no card for UID timing";
+      }
+      finishJob(job, true, message);
+      break;
+    }
+  }
+}
+
+void serviceApiJobs() {
+  for (int i = 0; i < API_JOB_SLOTS; i++) {
+    ApiJob& job = jobs[i];
+    if (job.id == 0 || isApiJobFinished(job)) {
+      continue;
+    }
+    job.state = JOB_RUNNING;
+
+    switch (job.type) {
+      case JOB_SYNC:
+        stepSyncJob(job);
+        break;
+      case JOB_HEARTBEAT:
+        stepHeartbeatJob(job);
+        break;
+      case JOB_SWITCH_NETWORK:
+        stepSwitchNetworkJob(job);
+        break;
+      case JOB_RESET_WIFI:
+        stepResetWiFiJob(job);
+        break;
+      case JOB_RESTART:
+        stepRestartJob(job);
+        break;
+      case JOB_RFID_BENCHMARK:
+        stepRfidBenchmarkJob(job);
+        break;
+    }
+  }
+}
+
+// ========================================
+// REPORTING
+// ========================================
+
+const char* apiJobTypeName(ApiJobType type) {
+  switch (type) {
+    case JOB_SYNC:           return "sync";
+    case JOB_HEARTBEAT:      return "heartbeat";
+    case JOB_SWITCH_NETWORK: return "switch-network";
+    case JOB_RESET_WIFI:     return "reset-wifi";
+    case JOB_RESTART:        return "restart";
+    case JOB_RFID_BENCHMARK: return "rfid-benchmark";
+  }
+  return "unknown";
+}
+
+const char* apiJobStateName(ApiJobState state) {
+  switch (state) {
+    case JOB_QUEUED:  return "queued";
+    case JOB_RUNNING: return "running";
+    case JOB_DONE:    return "done";
+    case JOB_FAILED:  return "failed";
+  }
+  return "unknown";
+}
+
+void apiJobToJson(const ApiJob& job, JsonObject out) {
+  out["id"] = job.id;
+  out["type"] = apiJobTypeName(job.type);
+  out["state"] = apiJobStateName(job.state);
+  out["progress"] = job.progress;
+  out["message"] = job.message;
+  out["ageMs"] = millis() - job.createdAt;
+  if (isApiJobFinished(job)) {
+    out["durationMs"] = job.finishedAt - job.createdAt;
+  }
+}
+
+void apiJobsToJson(JsonArray out) {
+  for (int i = 0; i < API_JOB_SLOTS; i++) {
+    if (jobs[i].id != 0) {
+      apiJobToJson(jobs[i], out.createNestedObject());
+    }
+  }
+}
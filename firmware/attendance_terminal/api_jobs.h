@@ -0,0 +1,63 @@
+/*
+ * Background jobs for the configuration API
+ * Attendee Attendance Terminal v2.0
+ *
+ * Long-running admin actions (sync, heartbeat, network switch, WiFi reset,
+ * restart, RFID driver benchmark) are accepted with 202 and a job id, then advanced one short step
+ * per loop() iteration so the web server never holds up RFID polling.
+ * Progress is pollable at /api/jobs/<id>.
+ */
+
+#ifndef API_JOBS_H
+#define API_JOBS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define API_JOB_SLOTS 4                 // Jobs kept in the table (finished ones are recycled)
+
+enum ApiJobType {
+  JOB_SYNC,
+  JOB_HEARTBEAT,
+  JOB_SWITCH_NETWORK,
+  JOB_RESET_WIFI,
+  JOB_RESTART,
+  JOB_RFID_BENCHMARK
+};
+
+enum ApiJobState {
+  JOB_QUEUED,
+  JOB_RUNNING,
+  JOB_DONE,
+  JOB_FAILED
+};
+
+struct ApiJob {
+  uint16_t id;                  // 0 = free slot
+  ApiJobType type;
+  ApiJobState state;
+  uint8_t progress;             // 0-100
+  uint8_t step;                 // Internal state machine step
+  unsigned long createdAt;
+  unsigned long stepStart;
+  unsigned long finishedAt;
+  String message;
+  String ssid;                  // JOB_SWITCH_NETWORK target
+  String password;
+  String previousSsid;          // Restored if the switch fails
+  String previousPassword;
+};
+
+// Job table
+ApiJob* createApiJob(ApiJobType type);
+ApiJob* findApiJob(uint16_t id);
+bool isApiJobFinished(const ApiJob& job);
+void serviceApiJobs();
+
+// Reporting
+const char* apiJobTypeName(ApiJobType type);
+const char* apiJobStateName(ApiJobState state);
+void apiJobToJson(const ApiJob& job, JsonObject out);
+void apiJobsToJson(JsonArray out);
+
+#endif // API_JOBS_H
@@ -47,6 +47,87 @@
  * • utils.h                    - Header file declaring utility functions
  *                               Function prototypes and external declarations
  * 
+ * • offline_sync.cpp/.h        - Resumable, time-sliced offline log sync job
+ *                               Persists its cursor and yields to card taps
+ * 
+ * • circuit_breaker.cpp/.h     - Backend circuit breaker with RTT-adaptive timeouts
+ *                               Sends taps straight offline while the backend is down
+ * 
+ * • api_jobs.cpp/.h            - Background jobs behind the long-running API actions
+ *                               Stepped from loop() so admin calls never stall scanning
+ * 
+ * • event_stream.cpp/.h        - Server-Sent Events push of taps, connectivity and sync
+ *                               Non-blocking writes with drop-oldest per subscriber
+ * 
+ * • metrics.cpp/.h             - Prometheus counters and histograms for /metrics
+ *                               Streamed in small chunks without a JSON document
+ * 
+ * • soft_clock.cpp/.h          - RAM wall clock disciplined by the DS3231 and SNTP
+ *                               Slewed corrections, drift tracking, no I2C per read
+ * 
+ * • offline_staging.cpp/.h     - RTC-memory staging of offline taps
+ *                               Group commits to LittleFS, replayed after a reset
+ * 
+ * • offline_store.cpp/.h       - Compact block store for offline records
+ *                               UID dictionary, delta timestamps, per-block CRC
+ * 
+ * • event_seq.cpp/.h           - Per-device tap sequence numbers leased from flash
+ *                               Lets the backend dedupe retried and synced taps
+ * 
+ * • sync_pipeline.cpp/.h       - HTTP/1.1 pipelined submission for offline sync
+ *                               One round trip per slice, watermark-based resume
+ * 
+ * • backend_pool.cpp/.h        - Ordered backend endpoints with background /health probes
+ *                               Routes to the fastest healthy one, fails over on errors
+ * 
+ * • peer_ledger.cpp/.h         - Daily cross-gate tap ledger and gossip packet format
+ *                               Portable core, also built by test_peer_gossip_host.cpp
+ * 
+ * • peer_gossip.cpp/.h         - UDP multicast gossip of taps between terminals
+ *                               Answers cross-gate duplicates without the backend
+ * 
+ * • rfid_spi.cpp/.h            - Burst-FIFO RC522 driver with verified fast SPI clock
+ *                               2 ms REQA timeout, on-device benchmark against the stock driver
+ * 
+ * • rfid_lanes.cpp/.h          - Entry/exit lanes for a second RC522 on the same SPI bus
+ *                               Round-robin polling, per-reader debounce, direction tags
+ * 
+ * • rfid_gain.cpp/.h           - Closed-loop RC522 antenna gain from read outcomes
+ *                               Persists the chosen gain, reapplied on every re-init
+ * 
+ * • mqtt_transport.cpp/.h      - Optional MQTT 3.1.1 transport for taps and status
+ *                               Persistent session, QoS 1 with an inflight window
+ * 
+ * • lcd_shadow.cpp/.h          - Shadow-buffer 1602 LCD driver on the PCF8574 backpack
+ *                               Sends only changed characters, CGRAM status icons
+ * 
+ * • i2c_bus.cpp/.h             - Fast-mode I2C bus with a prioritized transfer queue
+ *                               Page-sized OLED steps, stuck-bus recovery
+ * 
+ * • sprite_atlas.cpp/.h        - PROGMEM OLED emojis and icons in SSD1306 page layout
+ *                               Generated by ../gen_sprite_atlas_host.cpp, byte blits
+ * 
+ * • oled_anim.cpp/.h           - Non-blocking keyframe animation engine for the OLED
+ *                               Frames advanced from loop(), fixed-point trig, cancellable
+ * 
+ * • display_frontend.h         - Semantic display calls over compile-time panel policies
+ *                               DISPLAY_LCD_FITTED / DISPLAY_OLED_FITTED, per-tap render time
+ * 
+ * • task_sched.cpp/.h          - Timer-wheel scheduler for the periodic loop() work
+ *                               Priorities, deadlines, per-task CPU time, sleeps until due
+ * 
+ * • stall_profiler.cpp/.h      - Loop pass histogram and longest stalls with their subsystem tag
+ *                               Counts delay() and blocking network time, kept in RTC memory
+ * 
+ * • debug_log.cpp/.h           - LOG_ERROR..LOG_DEBUG, compiled out above LOG_LEVEL
+ *                               RAM ring of recent lines; serial writes never block the loop
+ * 
+ * • json_arena.cpp/.h          - Static arena for JSON documents and HTTP request/response text
+ *                               Scoped checkpoints with a high-water mark per call site
+ * 
+ * • memory_governor.cpp/.h     - Heap pressure levels from free heap and largest block
+ *                               Sheds TLS buffer size, animations, sync batch size, then network
+ * 
  * Configuration Files:
  * ------------------
  * • config.h                   - Hardware pin definitions and system constants
@@ -62,10 +143,13 @@
  * File System:
  * -----------
  * • /config.json              - Device configuration stored in LittleFS
- *                               Backend URL, device ID, settings persistence
+ *                               Backend URLs, device ID, settings persistence
+ * 
+ * • /device_key.txt           - Backend device key (also the peer gossip key)
+ *                               Kept apart so config.json downloads never carry it
  * 
- * • /offline_logs.txt          - Offline attendance records in LittleFS
- *                               JSON-formatted attendance data for sync
+ * • /offline_logs.bin          - Offline attendance records in LittleFS
+ *                               Delta-encoded blocks, UIDs in /offline_uids.bin
  * 
  * Web API Endpoints:
  * -----------------
@@ -73,20 +157,34 @@
  * • POST /api/config           - Update device configuration
  * • GET  /api/status           - Get comprehensive device status
  * • GET  /api/logs             - Get offline logs information
- * • POST /api/actions/sync     - Force sync offline logs
- * • POST /api/actions/heartbeat - Force send heartbeat to backend
- * • POST /api/actions/reset-wifi - Reset WiFi credentials
- * • POST /api/actions/restart  - Restart device
- * • POST /api/actions/switch-network - Switch WiFi network with credentials
+ * • POST /api/actions/sync     - Force sync offline logs (202 + job id)
+ * • POST /api/actions/heartbeat - Force send heartbeat to backend (202 + job id)
+ * • POST /api/actions/reset-wifi - Reset WiFi credentials (202 + job id)
+ * • POST /api/actions/restart  - Restart device (202 + job id)
+ * • POST /api/actions/switch-network - Switch WiFi network with credentials (202 + job id)
+ * • POST /api/actions/rfid-benchmark - Compare RC522 drivers, scanning paused (202 + job id)
+ * • GET  /api/jobs             - List recent background jobs
+ * • GET  /api/jobs/<id>        - Poll progress of a background job
+ * • GET  /api/events           - Live event stream (text/event-stream)
+ * • GET  /metrics              - Prometheus text exposition format
+ * • GET  /api/debug/log        - Recent log lines from the RAM ring (?clear=1 empties it)
  * • GET  /api/firmware/list    - Get list of firmware files
  * • GET  /api/firmware/download - Download specific firmware file
  * 
  * Backend API Endpoints (Expected):
  * ---------------------------------
- * • POST /attendance           - Submit attendance record
+ * • POST /attendance           - Submit attendance record (deduped on deviceId + seq)
+ * • GET  /attendance/device/<id>/watermark - Highest seq processed without gaps
  * • POST /api/device/heartbeat - Receive device heartbeat with status
  * • GET  /health              - Basic health check (legacy)
  * 
+ * MQTT Topics (when mqttBroker is configured):
+ * -------------------------------------------
+ * • attendee/<id>/tap          - Published taps, QoS 1 (same JSON as POST /attendance)
+ * • attendee/<id>/status       - Retained heartbeat; will message marks the device offline
+ * • attendee/<id>/cmd          - Subscribed commands: sync, heartbeat, restart
+ * • attendee/<id>/result       - Subscribed tap outcomes from the backend bridge
+ * 
  * Key Features:
  * ------------
  * ✓ Web-based device administration (replaces hardware admin menu)
@@ -120,13 +218,13 @@
 #include <ArduinoJson.h>
 #include <SPI.h>
 #include <Wire.h>
+#include "config.h"
+#if DISPLAY_OLED_FITTED
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
+#endif
 #include <MFRC522v2.h>
-#include <MFRC522DriverSPI.h>
-#include <MFRC522DriverPinSimple.h>
 #include <MFRC522Debug.h>
-#include <LiquidCrystal_I2C.h>
 #include <RTClib.h>
 #include <EEPROM.h>           // DEPRECATED: Only used for one-time migration from EEPROM to LittleFS
 #include <LittleFS.h>
@@ -135,9 +233,30 @@
 #include <math.h>
 
 // Include configuration and utilities
-#include "config.h"
 #include "utils.h"
-#include "display_utils.h"
+#include "display_frontend.h"
+#include "offline_sync.h"
+#include "circuit_breaker.h"
+#include "api_jobs.h"
+#include "event_stream.h"
+#include "metrics.h"
+#include "soft_clock.h"
+#include "offline_staging.h"
+#include "offline_store.h"
+#include "event_seq.h"
+#include "sync_pipeline.h"
+#include "mqtt_transport.h"
+#include "backend_pool.h"
+#include "peer_gossip.h"
+#include "rfid_spi.h"
+#include "rfid_lanes.h"
+#include "i2c_bus.h"
+#include "rfid_gain.h"
+#include "task_sched.h"
+#include "stall_profiler.h"
+#include "debug_log.h"
+#include "json_arena.h"
+#include "memory_governor.h"
 // #include
 // Web server for configuration endpoints
 ESP8266WebServer configServer(80);
@@ -156,30 +275,50 @@ void setupConfigurationEndpoints();
 
 // ----- Network and Connectivity -----
 void checkWiFiConnection();
-void sendHeartbeat();
+bool sendHeartbeat();
 void warmupHTTPSConnection();
+void probeBackendHealth();
+void addBreakerStatus(JsonObject backend);
+void buildHeartbeatPayload(JsonDocument& doc);
 
 // ----- RFID and Attendance Processing -----
 void handleRFIDScan();
+void serveLatchedCard(uint8_t readerIndex);
+void processTap(const String& rfidTag, uint8_t lane);
 String scanRFIDCard();
-void processOnlineAttendance(String rfidTag, String timestamp);
-void processOfflineAttendance(String rfidTag, String timestamp);
+void processOnlineAttendance(String rfidTag, String timestamp, uint32_t seq, uint8_t lane);
+void processOfflineAttendance(String rfidTag, String timestamp, uint32_t seq, uint8_t lane);
+void processMqttAttendance(String rfidTag, String timestamp, uint32_t seq, uint8_t lane);
+void showMqttTapResult(const String& name, const String& message, bool ok);
 void handleSuccessfulAttendance(String response, String timestamp);
 void handleBadRequestAttendance(String response);
 void handleAttendanceError(String error);
+void reportTapOutcome(const char* outcome, const String& name, bool offline);
+void handlePeerDuplicate(const PeerTapEvent& last);
 
 // ----- Data Sync and Logging -----
-void syncOfflineLogs();
-bool syncSingleLog(String logEntry);
+bool pollForPendingCard();
+void delayPollingReaders(unsigned long ms);
 
 // ----- Display Management -----
-void updateDisplay();
+void restoreI2cDevices();
 void displayMainScreen();
 void updateLCDDisplay();
 
 // ----- Hardware Control -----
 void updateLED();
 
+// ----- Scheduled Tasks -----
+void registerTasks();
+void serviceConfigServer();
+void serviceRFIDScan();
+void serviceDisplay();
+void periodicWiFiReconnect();
+void rfidMaintenance();
+void serviceBackendHealth();
+void serviceSync();
+void heartbeatTask();
+
 // ----- Configuration Management -----
 bool loadJsonConfiguration();
 bool saveConfiguration();
@@ -194,9 +333,20 @@ void handleForceHeartbeat();
 void handleResetWiFi();
 void handleRestartDevice();
 void handleSwitchNetwork();
+void handleRfidBenchmark();
+void handleGetJob();
+void handleListJobs();
+void sendJobAccepted(ApiJob* job, const char* message);
+void handleEventStream();
+void handleMetrics();
+void handleDebugLog();
+#if TEST_TAP_INJECTION
+void handleInjectTap();
+#endif
 void handleGetLogsInfo();
 void handleGetFirmwareList();
 void handleDownloadFirmware();
+void sendOfflineExport();
 void handleNotFound();
 
 // ========================================
@@ -204,14 +354,22 @@ void handleNotFound();
 // ========================================
 
 // RFID setup with proper pin configuration
-MFRC522DriverPinSimple ss_pin(RFID_SS_PIN);
-MFRC522DriverSPI driver(ss_pin);
-MFRC522 mfrc522(driver);
+MFRC522DriverFastSPI rfidDriver(RFID_SS_PIN);
+MFRC522 mfrc522(rfidDriver);
+#if RFID_READER_COUNT > 1
+MFRC522DriverFastSPI rfidExitDriver(RFID_EXIT_SS_PIN);   // Exit lane, same SPI bus
+MFRC522 mfrc522Exit(rfidExitDriver);
+#endif
 
 // Other hardware objects
-LiquidCrystal_I2C lcd(LCD_ADDRESS, LCD_COLS, LCD_ROWS);
+#if DISPLAY_LCD_FITTED
+ShadowLcd lcd(LCD_ADDRESS);
+#endif
 RTC_DS3231 rtc;
-Adafruit_SSD1306 oledDisplay(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+#if DISPLAY_OLED_FITTED
+// Keep the bus in fast mode after each transfer (the library drops it to 100 kHz by default)
+Adafruit_SSD1306 oledDisplay(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET, I2C_CLOCK_HZ, I2C_CLOCK_HZ);
+#endif
 WiFiClient wifiClient;        // For HTTP connections
 WiFiClientSecure wifiClientSecure;  // For HTTPS connections
 HTTPClient http;
@@ -219,6 +377,9 @@ HTTPClient http;
 // Connection optimization flags
 bool sslSessionValid = false;
 
+// A0 reads the supply voltage (ESP.getVcc()) for the offline write brownout flush
+ADC_MODE(ADC_VCC);
+
 // ========================================
 // GLOBAL VARIABLES
 // ========================================
@@ -226,6 +387,8 @@ bool sslSessionValid = false;
 // ----- Configuration Variables -----
 String backendUrl = DEFAULT_BACKEND_URL;
 String deviceId = "";
+String mqttBroker = "";                  // "host[:port]", empty = taps over HTTP
+String deviceKey = "";                   // Backend DEVICE_API_KEY, sent as X-Device-Key
 
 // ----- Attendance Tracking Variables -----
 String lastScannedName = "";
@@ -233,11 +396,15 @@ String lastScannedTime = "";
 String lastScannedMessage = "";
 int offlineLogsCount = 0;
 unsigned long lastCardScan = 0;
+const char* lastTapOutcome = "";         // Set by reportTapOutcome() for peer gossip
+#if TEST_TAP_INJECTION
+String injectedTag = "";                 // Simulated tap waiting for handleRFIDScan()
+uint8_t injectedLane = RFID_LANE_NONE;
+#endif
 
 // ----- RFID Watchdog/Maintenance Variables -----
 unsigned long lastRFIDMaintenance = 0;   // last periodic re-init
 unsigned long lastRFIDActivity = 0;      // updated on each detection/read
-int consecutiveRFIDReadFailures = 0;     // to trigger soft reset on repeated failures
 
 // ----- Network and Communication Variables -----
 bool isOnline = false;
@@ -257,11 +424,13 @@ unsigned long lastPeriodicReconnectAttempt = 0;
 // the hardware admin interface for reference
 
 // ----- LCD State Management Variables -----
+#if DISPLAY_LCD_FITTED
 LCDState currentLcdState = LCD_MAIN_SCREEN;
 unsigned long lcdStateStart = 0;
 String lcdParam1 = "";
 String lcdParam2 = "";
 int lcdProgressCounter = 0;
+#endif
 
 // ----- LED State Management Variables -----
 LEDState currentLedState = LED_OFF;
@@ -282,60 +451,69 @@ unsigned long configModeStartTime = 0;
 // ========================================
 
 void setup() {
+  #if RFID_EXIT_SS_PIN == 3
+  // RX is the exit reader's chip select; don't let the UART claim it
+  Serial.begin(DEBUG_BAUD_RATE, SERIAL_8N1, SERIAL_TX_ONLY);
+  #else
   Serial.begin(DEBUG_BAUD_RATE);
+  #endif
   Serial.println();
-  Serial.println("=== Attendee Attendance Terminal v2.0 ===");
-  Serial.println("Firmware Version: " + String(FIRMWARE_VERSION));
-  Serial.println("Updated for MFRC522v2 library");
+  LOG_INFO("=== Attendee Attendance Terminal v2.0 ===");
+  LOG_INFO("Firmware Version: %s", FIRMWARE_VERSION);
+  
+  // Restore stall records from RTC memory and note a watchdog reset mid-pass
+  stallProfilerBegin();
   
   systemStartTime = millis();
   
   // Initialize hardware in correct order
   if (!initializeHardware()) {
-    Serial.println("CRITICAL: Hardware initialization failed!");
-    setLCDState(LCD_ERROR, "Hardware Error");
+    LOG_ERROR("CRITICAL: Hardware initialization failed!");
+    Display::status(LCD_ERROR, "Hardware Error");
     return;
   }
 
   // Initialize file system with LittleFS
-  Serial.println("Initializing file system (LittleFS)...");
+  LOG_INFO("Initializing file system (LittleFS)...");
   if (!LittleFS.begin()) {
-    Serial.println("LittleFS initialization failed, attempting format...");
+    LOG_WARN("LittleFS initialization failed, attempting format...");
     if (LittleFS.format()) {
-      Serial.println("LittleFS formatted successfully");
+      LOG_INFO("LittleFS formatted successfully");
       if (!LittleFS.begin()) {
-        Serial.println("CRITICAL: LittleFS initialization failed after format!");
+        LOG_ERROR("CRITICAL: LittleFS initialization failed after format!");
         
         // Show error on LCD
-        setLCDState(LCD_FS_ERROR);
+        Display::status(LCD_FS_ERROR);
         delay(2000);
       } else {
-        Serial.println("LittleFS initialized successfully after format");
+        LOG_INFO("LittleFS initialized successfully after format");
       }
     } else {
-      Serial.println("CRITICAL: LittleFS format failed!");
+      LOG_ERROR("CRITICAL: LittleFS format failed!");
       
       // Show error on LCD
-      setLCDState(LCD_FS_ERROR);
+      Display::status(LCD_FS_ERROR);
       delay(2000);
     }
   } else {
-    Serial.println("LittleFS initialized successfully");
+    LOG_INFO("LittleFS initialized successfully");
   }
   
   // Show boot screen
   // Show boot screens using state-based LCD
-  setLCDState(LCD_BOOT_SCREEN, "startup");
+  Display::status(LCD_BOOT_SCREEN, "startup");
   delay(1500);
   
-  setLCDState(LCD_BOOT_SCREEN, "version");
+  Display::status(LCD_BOOT_SCREEN, "version");
   delay(1500);
   
   // Load configuration from LittleFS only
   loadConfiguration();
-  // Check for reset requests during startup
-  Serial.println("Press 'y' for WiFi reset or 'c' for config reset within 2 seconds...");
-  setLCDState(LCD_BOOT_SCREEN, "reset_prompt");
+  
+  #if RFID_EXIT_SS_PIN != 3
+  // Check for reset requests during startup (needs serial input on RX)
+  LOG_INFO("Press 'y' for WiFi reset or 'c' for config reset within 2 seconds...");
+  Display::status(LCD_BOOT_SCREEN, "reset_prompt");
   
   unsigned long startTime = millis();
   bool resetWiFi = false;
@@ -346,13 +524,13 @@ void setup() {
       char input = Serial.read();
       if (input == 'y' || input == 'Y') {
         resetWiFi = true;
-        Serial.println("WiFi reset requested!");
-        setLCDState(LCD_WIFI_RESET);
+        LOG_WARN("WiFi reset requested!");
+        Display::status(LCD_WIFI_RESET);
         break;
       } else if (input == 'c' || input == 'C') {
         resetConfig = true;
-        Serial.println("Config reset requested!");
-        setLCDState(LCD_CONFIG_UPDATE, "Resetting");
+        LOG_WARN("Config reset requested!");
+        Display::status(LCD_CONFIG_UPDATE, "Resetting");
         break;
       }
     }
@@ -360,7 +538,7 @@ void setup() {
   }
   
   if (resetWiFi) {
-    Serial.println("Clearing WiFi credentials...");
+    LOG_INFO("Clearing WiFi credentials...");
     WiFi.disconnect(true); // Clear stored WiFi credentials
     delay(1000);
     
@@ -369,40 +547,42 @@ void setup() {
     wifiManager.resetSettings();
     delay(1000);
     
-    Serial.println("WiFi settings cleared. Starting fresh setup...");
+    LOG_INFO("WiFi settings cleared. Starting fresh setup...");
   }
   
   if (resetConfig) {
-    Serial.println("Resetting configuration to defaults...");
+    LOG_INFO("Resetting configuration to defaults...");
     
-    // Delete existing config file
+    // Delete existing config file and the device key kept beside it
     if (LittleFS.exists("/config.json")) {
       LittleFS.remove("/config.json");
-      Serial.println("Existing config.json deleted");
+      LOG_INFO("Existing config.json deleted");
     }
+    deviceKey = "";
+    saveDeviceKey();
     
     // Reset to defaults
     backendUrl = DEFAULT_BACKEND_URL;
+    backendPoolSetUrls(&backendUrl, 1);
     deviceId = "ESP_" + formatMacAddress(WiFi.macAddress());
     
     // Save default configuration
     if (saveConfiguration()) {
-      Serial.println("Default configuration saved");
-      Serial.println("Backend URL reset to: " + backendUrl);
-      Serial.println("Device ID reset to: " + deviceId);
+      LOG_INFO("Default configuration saved: backend %s, device %s", backendUrl.c_str(), deviceId.c_str());
     } else {
-      Serial.println("Warning: Failed to save default configuration");
+      LOG_WARN("Failed to save default configuration");
     }
     
 
     delay(2000); // Show message on LCD
   }
+  #endif // RFID_EXIT_SS_PIN != 3
   
   // Initialize WiFi
   initializeWiFi();
 
   //Dispaly Update
-  updateDisplay();
+  Display::ready();
   
   // Sync time if online
   if (WiFi.status() == WL_CONNECTED) {
@@ -413,30 +593,46 @@ void setup() {
     setLED(false, true); // Red LED for offline
   }
   
-  // Load offline logs count
+  // Resume event numbering and the saved antenna gain, convert JSON-line logs
+  // from older firmware, replay offline taps staged in RTC memory before a reset, then count logs
+  beginEventSequence();
+  beginRfidGain();
+  migrateLegacyOfflineLogs();
+  beginOfflineStaging();
   loadOfflineLogsCount();
   
   // Setup web-based configuration endpoints (replaces admin menu)
   if (WiFi.status() == WL_CONNECTED) {
     setupConfigurationEndpoints();
     configServerStarted = true;
-    Serial.println("Configuration API available at: http://" + WiFi.localIP().toString() + "/api/config");
+    LOG_INFO("Configuration API available at: http://%s/api/config", WiFi.localIP().toString().c_str());
     
     // Pre-warm HTTPS connection for faster first attendance submission
-    if (backendUrl.startsWith("https://")) {
-      Serial.println("Pre-warming HTTPS connection for faster performance...");
+    if (getEffectiveBackendUrl().startsWith("https://")) {
+      LOG_DEBUG("Pre-warming HTTPS connection for faster performance...");
       warmupHTTPSConnection();
     }
   }
   
+  // Optional MQTT transport; connects from loop()
+  beginMqttTransport(mqttBroker);
+  
+  // Share taps with terminals at other gates
+  beginPeerGossip(deviceKey);
+  
   // Initial display update
-  updateDisplay();
+  Display::ready();
+  
+  // Periodic work from here on runs as scheduled tasks
+  registerTasks();
   
   systemInitialized = true;
-  Serial.println("Setup complete. Ready for operation.");
-  Serial.println("System ready at: " + String(millis()) + "ms");
+  LOG_INFO("Setup complete. Ready for operation.");
+
+  // Boot lines are all out; from here a full UART FIFO drops the line instead of stalling the loop
+  debugLogSetSerialBlocking(false);
   
-  syncOfflineLogs();
+  startOfflineSync();
 
   // Play startup sound
   if (BUZZER_ENABLED) {
@@ -454,109 +650,165 @@ void loop() {
     return;
   }
   
-  // Handle configuration server requests
+  // Loop period for the /metrics histogram
+  static unsigned long lastLoopStartMicros = 0;
+  unsigned long loopStartMicros = micros();
+  if (lastLoopStartMicros != 0) {
+    metricsObserveLoop(loopStartMicros - lastLoopStartMicros);
+  }
+  lastLoopStartMicros = loopStartMicros;
+  
+  // Run the tasks that are due, then sleep until the next one or an interrupt
+  stallLoopStart();
+  schedRunDue();
+  stallLoopEnd();
+  schedSleep();
+}
+
+// ========================================
+// SCHEDULED TASKS
+// ========================================
+
+// Periodic work, run from loop() by the scheduler (task_sched.h)
+void registerTasks() {
+  // Card reads and display feedback come first
+  schedAdd("rfid", serviceRFIDScan, SCHED_RFID_MS, TASK_PRIO_HIGH);
+  schedAdd("display", serviceDisplay, SCHED_DISPLAY_MS, TASK_PRIO_HIGH);
+  
+  schedAdd("http", serviceConfigServer, SCHED_NETWORK_MS, TASK_PRIO_NORMAL);
+  schedAdd("mqtt", serviceMqttTransport, SCHED_NETWORK_MS, TASK_PRIO_NORMAL);
+  schedAdd("gossip", servicePeerGossip, SCHED_NETWORK_MS, TASK_PRIO_NORMAL);
+  schedAdd("apiJobs", serviceApiJobs, SCHED_JOBS_MS, TASK_PRIO_NORMAL);
+  schedAdd("events", serviceEventStream, SCHED_JOBS_MS, TASK_PRIO_NORMAL);
+  schedAdd("sync", serviceSync, SCHED_JOBS_MS, TASK_PRIO_NORMAL);
+  schedAdd("led", updateLED, SCHED_JOBS_MS, TASK_PRIO_NORMAL);
+  schedAdd("memory", serviceMemoryGovernor, SCHED_MEMORY_MS, TASK_PRIO_NORMAL);
+  clockWakeOnEdge(schedAdd("clock", serviceSoftClock, SCHED_CLOCK_MS, TASK_PRIO_NORMAL));
+  schedAdd("staging", serviceOfflineStaging, SCHED_HOUSEKEEPING_MS, TASK_PRIO_NORMAL);
+  schedAdd("rfidGain", serviceRfidGain, SCHED_HOUSEKEEPING_MS, TASK_PRIO_NORMAL);
+  
+  schedAdd("backend", serviceBackendHealth, SCHED_BACKEND_MS, TASK_PRIO_LOW);
+  schedAdd("seqSeed", serviceEventSequence, SCHED_WATCHDOG_MS, TASK_PRIO_LOW);
+  schedAdd("wifiCheck", checkWiFiConnection, SCHED_WIFI_CHECK_MS, TASK_PRIO_LOW);
+  schedAdd("reconnect", periodicWiFiReconnect, SCHED_WATCHDOG_MS, TASK_PRIO_LOW);
+  schedAdd("rfidMaint", rfidMaintenance, SCHED_WATCHDOG_MS, TASK_PRIO_LOW);
+  schedAdd("heartbeat", heartbeatTask, SCHED_WATCHDOG_MS, TASK_PRIO_LOW);
+}
+
+// Handle configuration server requests
+void serviceConfigServer() {
   if (WiFi.status() == WL_CONNECTED) {
     configServer.handleClient();
   }
-  
-  // Check WiFi connection periodically
-  static unsigned long lastWiFiCheck = 0;
-  if (millis() - lastWiFiCheck > 30000) { // Check every 30 seconds
-    checkWiFiConnection();
-    lastWiFiCheck = millis();
+}
+
+// Handle RFID scanning - MAIN FUNCTION (paused while the driver benchmark owns the reader)
+void serviceRFIDScan() {
+  if (!rfidBenchActive()) {
+    handleRFIDScan();
   }
+}
 
-  // Periodically try to reconnect WiFi and sync when running offline
-  if (!isOnline && (millis() - lastPeriodicReconnectAttempt > WIFI_PERIODIC_RECONNECT_INTERVAL)) {
-    lastPeriodicReconnectAttempt = millis();
-    Serial.println("Periodic WiFi reconnect attempt...");
-    setLCDState(LCD_CONNECTION_PROGRESS, "Retry WiFi");
+// Display timers and animation frames, then queued display transfers, a bounded slice per pass
+void serviceDisplay() {
+  Display::service();
+  serviceI2cBus();
+}
 
-    // Try to connect using stored credentials
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(); // Use saved credentials if available
+// Periodically try to reconnect WiFi and sync when running offline
+void periodicWiFiReconnect() {
+  if (isOnline || (millis() - lastPeriodicReconnectAttempt <= WIFI_PERIODIC_RECONNECT_INTERVAL)) {
+    return;
+  }
+  lastPeriodicReconnectAttempt = millis();
+  LOG_DEBUG("Periodic WiFi reconnect attempt...");
+  Display::status(LCD_CONNECTION_PROGRESS, "Retry WiFi");
+
+  // Try to connect using stored credentials
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(); // Use saved credentials if available
 
-    unsigned long startAttempt = millis();
+  unsigned long startAttempt = millis();
+  {
+    StallScope net("wifi-join", STALL_NET);
     while (WiFi.status() != WL_CONNECTED && (millis() - startAttempt) < WIFI_RECONNECT_ATTEMPT_WINDOW_MS) {
       delay(500);
     }
+  }
 
-    if (WiFi.status() == WL_CONNECTED) {
-      isOnline = true;
-      setLEDState(LED_GREEN);
-      Serial.println("Reconnected to WiFi during periodic attempt. IP: " + WiFi.localIP().toString());
-      syncTimeWithNTP();
-
-      // Start config server if not started yet
-      if (!configServerStarted) {
-        setupConfigurationEndpoints();
-        configServerStarted = true;
-        Serial.println("Configuration API available at: http://" + WiFi.localIP().toString() + "/api/config");
-      }
+  if (WiFi.status() == WL_CONNECTED) {
+    isOnline = true;
+    setLEDState(LED_GREEN);
+    LOG_INFO("Reconnected to WiFi during periodic attempt. IP: %s", WiFi.localIP().toString().c_str());
+    syncTimeWithNTP();
+    publishConnectivityEvent(true, "wifi-reconnected");
+    metricsCountWiFiReconnect();
 
-      // Immediately try syncing offline logs
-      if (offlineLogsCount > 0) {
-        setLCDState(LCD_SYNC_PROGRESS);
-        syncOfflineLogs();
-        setLCDState(LCD_SYNC_COMPLETE);
-      }
+    // Start config server if not started yet
+    if (!configServerStarted) {
+      setupConfigurationEndpoints();
+      configServerStarted = true;
+      LOG_INFO("Configuration API available at: http://%s/api/config", WiFi.localIP().toString().c_str());
+    }
 
-      delay(1000);
-      updateDisplay();
-    } else {
-      // Remain offline
-      isOnline = false;
-      setLEDState(LED_RED);
-      Serial.println("WiFi reconnect failed. Staying offline.");
-      delay(1000);
-      updateDisplay();
+    // Immediately start syncing offline logs (runs in slices from the sync task)
+    if (offlineLogsCount > 0) {
+      Display::status(LCD_SYNC_PROGRESS);
+      startOfflineSync();
     }
+
+    delay(1000);
+    Display::ready();
+  } else {
+    // Remain offline
+    isOnline = false;
+    setLEDState(LED_RED);
+    LOG_WARN("WiFi reconnect failed. Staying offline.");
+    delay(1000);
+    Display::ready();
   }
-  
-  // Handle RFID scanning - MAIN FUNCTION
-  handleRFIDScan();
+}
 
-  // RFID maintenance watchdog: periodic soft reset and idle recovery
+// RFID maintenance watchdog: periodic soft reset and idle recovery
+void rfidMaintenance() {
   unsigned long nowMillis = millis();
   if (nowMillis - lastRFIDMaintenance > RFID_MAINTENANCE_INTERVAL_MS) {
-    Serial.println("RFID maintenance: periodic re-init");
+    LOG_DEBUG("RFID maintenance: periodic re-init");
     softResetRFID();
     lastRFIDMaintenance = nowMillis;
   }
   if (lastRFIDActivity > 0 && (nowMillis - lastRFIDActivity > RFID_REINIT_IF_IDLE_MS)) {
-    Serial.println("RFID maintenance: idle too long, forcing re-init");
+    LOG_INFO("RFID maintenance: idle too long, forcing re-init");
     softResetRFID();
     lastRFIDActivity = nowMillis;
     lastRFIDMaintenance = nowMillis;
   }
+}
+
+void serviceBackendHealth() {
+  // Half-open the backend circuit breaker with a cheap probe once its cooldown expires
+  if (isOnline && memNetworkAllowed() && breakerProbeDue()) {
+    probeBackendHealth();
+  }
   
-  // Update LED state
-  updateLED();
-  
-  // Update LCD display state
-  updateLCDState();
-  
-  // Sync offline logs if available and online
-  if (isOnline && offlineLogsCount > 0 && 
+  // Probe standby backends and move traffic to the fastest healthy one
+  serviceBackendPool();
+}
+
+// Arm the offline sync job when logs are waiting, then run one bounded slice
+void serviceSync() {
+  if (isOnline && memNetworkAllowed() && offlineLogsCount > 0 && !isOfflineSyncActive() &&
       (millis() - lastSyncAttempt > SYNC_RETRY_INTERVAL)) {
-    syncOfflineLogs();
+    startOfflineSync();
   }
-  
-  // Send heartbeat ping to backend every 30 minutes
+  serviceOfflineSync();
+}
+
+// Send heartbeat ping to backend every HEARTBEAT_INTERVAL
+void heartbeatTask() {
   if (isOnline && (millis() - lastHeartbeat > HEARTBEAT_INTERVAL)) {
     sendHeartbeat();
   }
-  
-  // Update display periodically
-  static unsigned long lastDisplayUpdate = 0;
-  if (millis() - lastDisplayUpdate > 1000) { // Update every second
-    if (currentLcdState == LCD_MAIN_SCREEN) {
-      updateDisplay(); // Only update main screen periodically
-    }
-    lastDisplayUpdate = millis();
-  }
-  
-  delay(100);  // Small delay to prevent excessive CPU usage
 }
 
 // ========================================
@@ -564,39 +816,36 @@ void loop() {
 // ========================================
 
 bool initializeHardware() {
-  Serial.println("Initializing hardware...");
+  LOG_INFO("Initializing hardware...");
   
   // Initialize SPI for RFID first
   SPI.begin();
-  Serial.println("SPI initialized");
+  LOG_DEBUG("SPI initialized");
   
   initializeRFID();
-  Serial.println("RFID initialized successfully");
-  
-  // Initialize I2C for LCD and RTC
-  Wire.begin(SDA_PIN, SCL_PIN);
-  Serial.println("I2C initialized on SDA:" + String(SDA_PIN) + ", SCL:" + String(SCL_PIN));
+  LOG_DEBUG("RFID initialized successfully");
   
-  // Initialize LCD
-  lcd.init();
-  lcd.backlight();
-  setLCDState(LCD_INITIALIZING);
-  Serial.println("LCD initialized");
+  // Initialize I2C for LCD, OLED and RTC (fast mode)
+  i2cBusBegin();
+  LOG_DEBUG("I2C initialized on SDA:%d, SCL:%d", SDA_PIN, SCL_PIN);
   
-  // Initialize OLED
-  initializeOLED();
-  showLoadingScreen("Starting...", 0);
-  Serial.println("OLED initialized");
+  // Initialize the fitted displays
+  Display::begin();
+  Display::status(LCD_INITIALIZING);
+  LOG_DEBUG("Displays initialized");
   
   // Initialize RTC
   if (!rtc.begin()) {
-    Serial.println("RTC initialization failed!");
-    setLCDState(LCD_BOOT_SCREEN, "error");
+    LOG_ERROR("RTC initialization failed!");
+    Display::status(LCD_BOOT_SCREEN, "error");
     delay(2000);
     return false;
   }
 
-  Serial.println("RTC initialized");
+  // rtc.begin() restarts Wire with its default clock
+  i2cBusBegin();
+  LOG_DEBUG("RTC initialized");
+  clockBegin();
   
   // Initialize output pins
   pinMode(GREEN_LED, OUTPUT);
@@ -612,7 +861,7 @@ bool initializeHardware() {
   digitalWrite(GREEN_LED, LOW);
   digitalWrite(RED_LED, LOW);
   
-  Serial.println("All hardware initialized successfully");
+  LOG_INFO("All hardware initialized successfully");
   return true;
 }
 
@@ -621,25 +870,24 @@ bool initializeHardware() {
 // ========================================
 
 void loadConfiguration() {
-  Serial.println("Loading configuration from LittleFS...");
+  LOG_DEBUG("Loading configuration from LittleFS...");
   
   // Always initialize with defaults first
   backendUrl = DEFAULT_BACKEND_URL;
   if (deviceId.length() == 0) {
     deviceId = "ESP_" + formatMacAddress(WiFi.macAddress());
-    Serial.println("Generated new device ID: " + deviceId);
+    LOG_INFO("Generated new device ID: %s", deviceId.c_str());
   }
   
   // Try to load from JSON configuration file
   if (loadJsonConfiguration()) {
-    Serial.println("Backend URL: " + backendUrl);
-    Serial.println("Device ID: " + deviceId);
-    Serial.println("Configuration loaded from JSON successfully");
+    LOG_INFO("Configuration loaded: backend %s, device %s", backendUrl.c_str(), deviceId.c_str());
   } else {
-    Serial.println("No valid configuration found, using defaults");
+    LOG_WARN("No valid configuration found, using defaults");
     // Save the default configuration for future use
     saveConfiguration();
   }
+  loadDeviceKey();
 }
 
 // ========================================
@@ -649,18 +897,27 @@ void loadConfiguration() {
 void saveBackendUrl() {
   // Save to LittleFS JSON configuration only
   if (saveConfiguration()) {
-    Serial.println("Backend URL saved to LittleFS: " + backendUrl);
+    LOG_INFO("Backend URL saved to LittleFS: %s", backendUrl.c_str());
   } else {
-    Serial.println("Failed to save backend URL to LittleFS");
+    LOG_ERROR("Failed to save backend URL to LittleFS");
   }
 }
 
 void saveDeviceId() {
   // Save to LittleFS JSON configuration only  
   if (saveConfiguration()) {
-    Serial.println("Device ID saved to LittleFS: " + deviceId);
+    LOG_INFO("Device ID saved to LittleFS: %s", deviceId.c_str());
+  } else {
+    LOG_ERROR("Failed to save device ID to LittleFS");
+  }
+}
+
+void saveMqttBroker() {
+  // Save to LittleFS JSON configuration only
+  if (saveConfiguration()) {
+    LOG_INFO("MQTT broker saved to LittleFS: %s", mqttBroker.length() > 0 ? mqttBroker.c_str() : "(disabled)");
   } else {
-    Serial.println("Failed to save device ID to LittleFS");
+    LOG_ERROR("Failed to save MQTT broker to LittleFS");
   }
 }
 
@@ -669,9 +926,9 @@ void saveDeviceId() {
 // ========================================
 
 void initializeWiFi() {
-  Serial.println("Initializing WiFi...");
+  LOG_INFO("Initializing WiFi...");
   
-  setLCDState(LCD_WIFI_SETUP);
+  Display::status(LCD_WIFI_SETUP);
   
   WiFiManager wifiManager;
   
@@ -682,22 +939,22 @@ void initializeWiFi() {
   wifiManager.setConfigPortalTimeout(WIFI_CONFIG_PORTAL_TIMEOUT);
   
   // Try to connect with saved credentials, else briefly open portal
-  if (!wifiManager.autoConnect(apName.c_str())) {
-    Serial.println("WiFi not configured or unavailable. Continuing in offline mode.");
+  bool connected;
+  {
+    StallScope net("wifi-portal", STALL_NET);
+    connected = wifiManager.autoConnect(apName.c_str());
+  }
+  if (!connected) {
+    LOG_WARN("WiFi not configured or unavailable. Continuing in offline mode.");
     isOnline = false;
     setLEDState(LED_RED);
-    updateDisplay();
+    Display::ready();
     // Do NOT restart; device will operate offline and retry periodically
     return;
   }
   
-  Serial.println("WiFi connected successfully");
-  Serial.print("IP Address: ");
-  Serial.println(WiFi.localIP());
-  Serial.print("MAC Address: ");
-  Serial.println(WiFi.macAddress());
-  Serial.print("Signal Strength: ");
-  Serial.println(WiFi.RSSI());
+  LOG_INFO("WiFi connected: IP %s, MAC %s, RSSI %d", WiFi.localIP().toString().c_str(),
+           WiFi.macAddress().c_str(), (int)WiFi.RSSI());
 }
 
 void checkWiFiConnection() {
@@ -705,22 +962,23 @@ void checkWiFiConnection() {
   isOnline = (WiFi.status() == WL_CONNECTED);
   
   if (!wasOnline && isOnline) {
-    Serial.println("WiFi reconnected");
     syncTimeWithNTP();
     setLEDState(LED_GREEN);
-    showWiFiStatus(true);
+    Display::status(LCD_CONNECTION_SUCCESS, WiFi.localIP().toString());
     delay(1000);
-    logInfo("WiFi reconnected - IP: " + WiFi.localIP().toString());
+    LOG_INFO("WiFi reconnected - IP: %s", WiFi.localIP().toString().c_str());
+    publishConnectivityEvent(true, "wifi-reconnected");
+    metricsCountWiFiReconnect();
     // Ensure config server is started on first connection
     if (!configServerStarted) {
       setupConfigurationEndpoints();
       configServerStarted = true;
-      Serial.println("Configuration API available at: http://" + WiFi.localIP().toString() + "/api/config");
+      LOG_INFO("Configuration API available at: http://%s/api/config", WiFi.localIP().toString().c_str());
     }
   } else if (wasOnline && !isOnline) {
-    Serial.println("WiFi disconnected");
     setLEDState(LED_RED);
-    logError("WiFi disconnected");
+    LOG_WARN("WiFi disconnected");
+    publishConnectivityEvent(false, "wifi-disconnected");
   }
 }
 
@@ -731,32 +989,54 @@ void checkWiFiConnection() {
 // ========================================
 
 void handleRFIDScan() {
-  Serial.println("herher");
-  // Check for new card with improved error handling
-  if (!mfrc522.PICC_IsNewCardPresent()) {
+  #if TEST_TAP_INJECTION
+  // A simulated tap goes through the same path as a card, minus the reader
+  if (injectedTag.length() > 0) {
+    String rfidTag = injectedTag;
+    injectedTag = "";
+    lastCardScan = millis();
+    LOG_INFO("Injected tap: %s", rfidTag.c_str());
+    processTap(rfidTag, injectedLane);
     return;
   }
+  #endif
+
+  // Poll the next reader in turn, then serve a card either lane has latched
+  pollForPendingCard();
+  int readerIndex = rfidLanesTakeLatched();
+  if (readerIndex < 0) {
+    return;
+  }
+  rfidLanesBeginServing(readerIndex);
+  serveLatchedCard(readerIndex);
+  rfidLanesEndServing();
+}
+
+void serveLatchedCard(uint8_t readerIndex) {
+  MFRC522& reader = rfidReader(readerIndex);
+  uint8_t lane = rfidLaneOf(readerIndex);
   lastRFIDActivity = millis();
   
-  if (!mfrc522.PICC_ReadCardSerial()) {
-    consecutiveRFIDReadFailures++;
-    if (consecutiveRFIDReadFailures >= 5) {
-      Serial.println("RFID warning: consecutive read failures, soft resetting reader");
+  // Select directly (what PICC_ReadCardSerial wraps) so the gain controller sees why it failed
+  MFRC522::StatusCode selectStatus = reader.PICC_Select(&reader.uid);
+  rfidGainRecordRead(selectStatus);
+  if (selectStatus != MFRC522::STATUS_OK) {
+    if (rfidLanesReadFailed(readerIndex) >= 5) {
+      LOG_WARN("RFID: consecutive read failures, soft resetting reader");
       softResetRFID();
-      consecutiveRFIDReadFailures = 0;
     }
     return;
   }
-  consecutiveRFIDReadFailures = 0;
+  rfidLanesClearFailures(readerIndex);
   lastRFIDActivity = millis();
 
-  // Prevent duplicate reads
+  // Prevent duplicate reads (each lane has its own debounce)
   unsigned long currentTime = millis();
-  if (currentTime - lastCardScan < CARD_READ_DELAY) {
-    mfrc522.PICC_HaltA();
+  if (!rfidLanesAccept(readerIndex, currentTime)) {
+    reader.PICC_HaltA();
     // Stop crypto to ensure clean next transaction
     #ifdef MFRC522_h
-    mfrc522.PCD_StopCrypto1();
+    reader.PCD_StopCrypto1();
     #endif
     return;
   }
@@ -764,65 +1044,94 @@ void handleRFIDScan() {
 
   // Build RFID tag string
   String rfidTag = "";
-  for (byte i = 0; i < mfrc522.uid.size; i++) {
-    if (mfrc522.uid.uidByte[i] < 0x10) rfidTag += "0";
-    rfidTag += String(mfrc522.uid.uidByte[i], HEX);
+  for (byte i = 0; i < reader.uid.size; i++) {
+    if (reader.uid.uidByte[i] < 0x10) rfidTag += "0";
+    rfidTag += String(reader.uid.uidByte[i], HEX);
   }
   rfidTag.toUpperCase();
 
+  processTap(rfidTag, lane);
+
+  // Halt communication with card and stop crypto
+  reader.PICC_HaltA();
+  #ifdef MFRC522_h
+  reader.PCD_StopCrypto1();
+  #endif
+  delay(50);
+}
+
+// Everything after the card is read: duplicate check, feedback, and the
+// MQTT, online or offline path
+void processTap(const String& rfidTag, uint8_t lane) {
+  // Tapped here or at another gate moments ago, in the same direction
+  // (an exit right after an entry is a new event): answer locally without
+  // waiting on the backend. The tap is still queued offline and synced,
+  // and the backend makes its own duplicate decision.
+  PeerTapEvent lastTap;
+  if (peerGossipFindDuplicate(rfidTag, lane, lastTap)) {
+    LOG_INFO("RFID Tag scanned: %s (duplicate)", rfidTag.c_str());
+    if (offlineLogsCount < MAX_OFFLINE_LOGS &&
+        stageOfflineRecord(rfidTag, getCurrentTimestamp(), nextEventSeq(), lane)) {
+      offlineLogsCount++;
+    }
+    handlePeerDuplicate(lastTap);
+    return;
+  }
+
   // ===== STAGE 1: IMMEDIATE CARD DETECTION FEEDBACK =====
-  Serial.println("RFID Tag scanned: " + rfidTag);
-  logInfo("RFID scanned: " + rfidTag);
+  const char* direction = rfidLaneDirection(lane);
+  LOG_INFO("RFID Tag scanned: %s%s%s", rfidTag.c_str(), direction ? " at " : "", direction ? direction : "");
   
   // Immediate feedback: Card detected
   playCardDetectedBeep();               // Instant audio feedback
   setLEDState(LED_BLINK_GREEN);         // Quick green blink to show card detected
   
-  // Show immediate "Card Detected" feedback on LCD and OLED
+  // Show immediate "Card Detected" feedback on LCD and OLED (pre-empts any animation still playing)
   lastScannedName = "Card Detected";
   lastScannedTime = getCurrentTimestamp().substring(11, 16);
   lastScannedMessage = "Processing...";
-  updateDisplay();
-  
-  // Show card detection animation on OLED
-  showCardScanScreen("Card Detected");
-  delay(500);
-  showLoadingScreen("Processing...", 50);
+  Display::processing("Card Detected", 0);
+  delayPollingReaders(500);
+  Display::processing("Processing...", 50);
   
   // Brief pause to separate stage 1 from stage 2
-  delay(200);
+  delayPollingReaders(200);
 
-  // Get current timestamp
+  // Get current timestamp and the tap's sequence number (the backend
+  // dedupes on deviceId + seq, so retries and late syncs are safe)
   String timestamp = getCurrentTimestamp();
-
-  // Process attendance
-  if (isOnline) {
-    processOnlineAttendance(rfidTag, timestamp);
+  uint32_t seq = nextEventSeq();
+  lastTapOutcome = "";
+
+  // Process attendance (an open circuit breaker sends the tap straight offline,
+  // and so does critical memory pressure, sampled fresh for this tap).
+  // reportTapOutcome() records what happened for the peer gossip below.
+  // With an MQTT session up the tap is published and its outcome arrives on
+  // the result topic; a full inflight window falls through to HTTP.
+  serviceMemoryGovernor();
+  bool online = isOnline && memNetworkAllowed();
+  if (online && mqttConnected() && mqttPublishTap(rfidTag, timestamp, seq, lane)) {
+    processMqttAttendance(rfidTag, timestamp, seq, lane);
+  } else if (online && breakerAllowRequest()) {
+    processOnlineAttendance(rfidTag, timestamp, seq, lane);
   } else {
-    processOfflineAttendance(rfidTag, timestamp);
+    processOfflineAttendance(rfidTag, timestamp, seq, lane);
   }
-
-  // Halt communication with card and stop crypto
-  mfrc522.PICC_HaltA();
-  #ifdef MFRC522_h
-  mfrc522.PCD_StopCrypto1();
-  #endif
-  delay(50);
+  peerGossipRecordTap(rfidTag, lane, lastTapOutcome);
 }
 
 // ========================================
 // ATTENDANCE PROCESSING
 // ========================================
 
-void processOnlineAttendance(String rfidTag, String timestamp) {
-  Serial.println("Backend URL: " + backendUrl);
+void processOnlineAttendance(String rfidTag, String timestamp, uint32_t seq, uint8_t lane) {
+  LOG_DEBUG("Backend URL: %s", getEffectiveBackendUrl().c_str());
   
   // Get effective URL (may be modified for testing)
   String effectiveUrl = getEffectiveBackendUrl();
   String attendanceUrl = getAttendanceEndpointUrl();
   
-  Serial.println("Effective URL: " + effectiveUrl);
-  Serial.println("Full attendance URL: " + attendanceUrl);
+  LOG_DEBUG("Attendance URL: %s", attendanceUrl.c_str());
   
   // Determine if we need HTTPS or HTTP
   bool isHTTPS = effectiveUrl.startsWith("https://");
@@ -830,30 +1139,29 @@ void processOnlineAttendance(String rfidTag, String timestamp) {
   if (isHTTPS) {
     // Configure WiFiClientSecure for HTTPS with aggressive speed optimizations
     wifiClientSecure.setInsecure(); // Skip SSL certificate verification for testing
-    wifiClientSecure.setTimeout(5000); // Reduced timeout for faster failure detection
+    wifiClientSecure.setTimeout(breakerTimeoutMs()); // Derived from observed backend RTT
     
-    // Aggressive optimization for ESP8266 HTTPS performance
-    wifiClientSecure.setBufferSizes(512, 512); // Minimal buffers for fastest processing
+    // Small MFLN buffers, smaller still under memory pressure
+    memConfigureTls(wifiClientSecure);
     
     // Network optimizations for lower latency
     wifiClientSecure.setNoDelay(true); // Disable Nagle's algorithm for lower latency
     
-    Serial.println("Using HTTPS connection with speed optimizations");
-    Serial.println("Free heap before HTTPS: " + String(ESP.getFreeHeap()));
+    LOG_DEBUG("Using HTTPS, free heap %lu", (unsigned long)ESP.getFreeHeap());
     
     unsigned long sslStartTime = millis();
     if (!http.begin(wifiClientSecure, getAttendanceEndpointUrl())) {
-      Serial.println("Failed to initialize HTTPS connection");
+      LOG_ERROR("Failed to initialize HTTPS connection");
       handleAttendanceError("HTTPS init failed");
       return;
     }
     unsigned long sslConnectTime = millis() - sslStartTime;
-    Serial.println("SSL connection time: " + String(sslConnectTime) + "ms");
+    LOG_DEBUG("SSL connection time: %lums", (unsigned long)sslConnectTime);
   } else {
     // Use regular WiFiClient for HTTP
-    Serial.println("Using HTTP connection");
+    LOG_DEBUG("Using HTTP connection");
     if (!http.begin(wifiClient, getAttendanceEndpointUrl())) {
-      Serial.println("Failed to initialize HTTP connection");
+      LOG_ERROR("Failed to initialize HTTP connection");
       handleAttendanceError("HTTP init failed");
       return;
     }
@@ -861,54 +1169,65 @@ void processOnlineAttendance(String rfidTag, String timestamp) {
   
   http.addHeader("Content-Type", "application/json");
   http.addHeader("User-Agent", "ESP8266-Attendance-Terminal/2.0");
-  http.setTimeout(5000); // Reduced HTTP timeout for faster response
+  http.addHeader("X-Device-Key", deviceKey);   // Without it the backend does not dedupe on seq
+  http.setTimeout(breakerTimeoutMs()); // Derived from observed backend RTT
   
   // Create JSON payload
-  StaticJsonDocument<200> doc;
+  ArenaScope arena("tap-post");
+  ArenaJsonDocument doc(200);
   doc["rfidTag"] = rfidTag;
   doc["timestamp"] = timestamp;
   doc["deviceId"] = deviceId;
   doc["firmware"] = FIRMWARE_VERSION;
+  doc["seq"] = seq;
+  if (const char* direction = rfidLaneDirection(lane)) {
+    doc["direction"] = direction;  // Dual-reader terminal: the lane says entry or exit
+  }
   
-  String payload;
-  serializeJson(doc, payload);
+  ArenaBuffer payload(doc);
   
   // ===== STAGE 2: PROCESSING INDICATION =====
-  Serial.println("Sending attendance: " + payload);
+  LOG_DEBUG("Sending attendance: %s", payload.data());
   
   // Update LCD to show "Sending..." 
   lastScannedName = "Sending...";
   lastScannedMessage = "Please wait";
-  updateDisplay();
+  Display::processing("Sending...", 75);
   
   playProcessingBeep(); // Indicate that we're sending the request
   
   unsigned long requestStartTime = millis();
-  int httpResponseCode = http.POST(payload);
+  int httpResponseCode;
+  {
+    StallScope net("tap-post", STALL_NET);
+    httpResponseCode = http.POST((const uint8_t*)payload.data(), payload.length());
+  }
   unsigned long requestTime = millis() - requestStartTime;
+  metricsObserveHttp(METRIC_HTTP_ATTENDANCE, requestTime, httpResponseCode);
   
   String response = http.getString();
   
-  Serial.println("HTTP Response Code: " + String(httpResponseCode));
-  Serial.println("Request time: " + String(requestTime) + "ms");
-  Serial.println("HTTP Response Body: " + response);
-  Serial.println("Free heap after request: " + String(ESP.getFreeHeap()));
+  // Feed the circuit breaker: transport errors and 5xx count as backend failures
+  if (httpResponseCode <= 0 || httpResponseCode >= 500) {
+    breakerRecordFailure();
+  } else {
+    breakerRecordSuccess(requestTime);
+  }
+  
+  LOG_INFO("Attendance HTTP %d in %lums", httpResponseCode, (unsigned long)requestTime);
+  LOG_DEBUG("Response body: %s, free heap %lu", response.c_str(), (unsigned long)ESP.getFreeHeap());
   
   // Mark SSL session as valid for faster future connections (HTTPS only)
   if (isHTTPS && httpResponseCode > 0) {
     sslSessionValid = true;
-    Serial.println("SSL session established for reuse");
+    LOG_DEBUG("SSL session established for reuse");
   }
   
   // Enhanced error reporting for SSL/connection issues
   if (httpResponseCode == -1) {
-    Serial.println("Connection failed - possible causes:");
-    Serial.println("1. SSL/TLS handshake failure");
-    Serial.println("2. DNS resolution failed");
-    Serial.println("3. Network timeout");
-    Serial.println("4. Insufficient memory for SSL");
-    Serial.println("WiFi status: " + String(WiFi.status()));
-    Serial.println("WiFi RSSI: " + String(WiFi.RSSI()));
+    // TLS handshake, DNS, timeout or too little heap for TLS
+    LOG_ERROR("Connection failed: WiFi status %d, RSSI %d, free heap %lu",
+              (int)WiFi.status(), (int)WiFi.RSSI(), (unsigned long)ESP.getFreeHeap());
   }
   
   if (httpResponseCode == 200 || httpResponseCode == 201) {
@@ -917,8 +1236,7 @@ void processOnlineAttendance(String rfidTag, String timestamp) {
     handleBadRequestAttendance(response);
   } else {
     // HTTP error - store offline
-    Serial.println("HTTP Error: " + String(httpResponseCode));
-    Serial.println("Response: " + response);
+    LOG_ERROR("HTTP Error %d: %s", httpResponseCode, response.c_str());
     
     // Provide more specific error messages
     String errorMsg;
@@ -935,8 +1253,9 @@ void processOnlineAttendance(String rfidTag, String timestamp) {
     handleAttendanceError(errorMsg);
     
     // Only store offline if it's a real network/server error, not a client error
+    // Same seq: if the request did land, the sync is deduped by the backend
     if (httpResponseCode >= 500 || httpResponseCode <= 0) {
-      processOfflineAttendance(rfidTag, timestamp);
+      processOfflineAttendance(rfidTag, timestamp, seq, lane);
     }
   }
   
@@ -944,13 +1263,14 @@ void processOnlineAttendance(String rfidTag, String timestamp) {
 }
 
 void handleSuccessfulAttendance(String response, String timestamp) {
-  Serial.println("Processing successful response: " + response);
+  LOG_DEBUG("Processing successful response: %s", response.c_str());
   
-  StaticJsonDocument<400> responseDoc;
+  ArenaScope arena("tap-reply");
+  ArenaJsonDocument responseDoc(400);
   DeserializationError error = deserializeJson(responseDoc, response);
   
   if (error) {
-    Serial.println("JSON parsing error: " + String(error.c_str()));
+    LOG_ERROR("JSON parsing error: %s", error.c_str());
     handleAttendanceError("JSON parse error: " + String(error.c_str()));
     return;
   }
@@ -969,54 +1289,56 @@ void handleSuccessfulAttendance(String response, String timestamp) {
     lastScannedName = userName;
     lastScannedTime = timestamp.substring(11, 16);  // Extract time HH:MM
     
+    // Publish before the feedback delays so monitors see the tap immediately
+    bool knownType = attendanceType == "entry" || attendanceType == "exit" || attendanceType == "complete";
+    reportTapOutcome(knownType ? attendanceType.c_str() : "ok", userName, false);
+    
     if (attendanceType == "entry") {
       lastScannedMessage = "Entry logged";
       setLEDState(LED_GREEN);
       playSuccessBeep();
-      showSuccessScreen("Entry Logged");
-      animateSuccess();
-      delay(2000);  // Show success message for 2 seconds
-      logInfo("Entry: " + userName);
+      Display::result(DISPLAY_RESULT_LOGGED, "Entry Logged");
+      delayPollingReaders(2000);  // Show success message for 2 seconds
+      LOG_INFO("Entry: %s", userName.c_str());
     } else if (attendanceType == "exit") {
       lastScannedMessage = "Exit logged";
       setLEDState(LED_GREEN);
       playSuccessBeep();
-      showSuccessScreen("Exit Logged");
-      animateSuccess();
-      delay(2000);  // Show success message for 2 seconds
-      logInfo("Exit: " + userName);
+      Display::result(DISPLAY_RESULT_LOGGED, "Exit Logged");
+      delayPollingReaders(2000);  // Show success message for 2 seconds
+      LOG_INFO("Exit: %s", userName.c_str());
     } else if (attendanceType == "complete") {
       lastScannedMessage = "Already logged";
       setLEDState(LED_YELLOW);
       playDuplicateBeep();      // Use specific duplicate beep pattern
-      showInfoScreen("Already Complete", "Logged today");
-      delay(2000);  // Show already complete message for 2 seconds
-      logInfo("Already complete: " + userName);
+      Display::result(DISPLAY_RESULT_NOTICE, "Already Complete", "Logged today");
+      delayPollingReaders(2000);  // Show already complete message for 2 seconds
+      LOG_INFO("Already complete: %s", userName.c_str());
     } else {
       lastScannedMessage = "Attendance OK";
       setLEDState(LED_GREEN);
       playSuccessBeep();
-      showSuccessScreen("Attendance OK");
-      animateSuccess();
-      delay(2000);  // Show success message for 2 seconds
-      logInfo("Attendance: " + userName);
+      Display::result(DISPLAY_RESULT_LOGGED, "Attendance OK");
+      delayPollingReaders(2000);  // Show success message for 2 seconds
+      LOG_INFO("Attendance: %s", userName.c_str());
     }
     
     ledBlinkTimer = millis();
-    updateDisplay();  // Update OLED display with success message
+    Display::ready();
   } else {
     handleAttendanceError("Unknown response format");
   }
 }
 
 void handleBadRequestAttendance(String response) {
-  Serial.println("Processing bad request response: " + response);
+  LOG_DEBUG("Processing bad request response: %s", response.c_str());
   
-  StaticJsonDocument<300> responseDoc;
+  ArenaScope arena("tap-reject");
+  ArenaJsonDocument responseDoc(300);
   DeserializationError error = deserializeJson(responseDoc, response);
   
   if (error) {
-    Serial.println("JSON parsing error in bad request: " + String(error.c_str()));
+    LOG_ERROR("JSON parsing error in bad request: %s", error.c_str());
     handleAttendanceError("Bad request - JSON parse error");
     return;
   }
@@ -1030,30 +1352,29 @@ void handleBadRequestAttendance(String response) {
   if (attendanceType == "complete") {
     lastScannedName = "Already logged";
     lastScannedMessage = "Complete today";
+    reportTapOutcome("complete", "", false);
     setLEDState(LED_YELLOW);
     ledBlinkTimer = millis();
     playDuplicateBeep();        // Use specific duplicate beep pattern
-    showInfoScreen("Already Complete", "Logged today");
-    delay(2000);  // Show already complete message for 2 seconds
-    updateDisplay();  // Update OLED display with duplicate message
+    Display::result(DISPLAY_RESULT_NOTICE, "Already Complete", "Logged today");
+    delayPollingReaders(2000);  // Show already complete message for 2 seconds
+    Display::ready();
   } else {
     handleAttendanceError(errorMsg);
   }
 }
 
-void processOfflineAttendance(String rfidTag, String timestamp) {
+void processOfflineAttendance(String rfidTag, String timestamp, uint32_t seq, uint8_t lane) {
   // ===== STAGE 2: PROCESSING INDICATION FOR OFFLINE =====
   // Update LCD and OLED to show "Storing offline..." 
   lastScannedName = "Offline Mode";
   lastScannedMessage = "Storing...";
-  updateDisplay();
   
-  // Show offline storage animation on OLED
-  showLoadingScreen("Storing Offline...", 50);
-  delay(500);
+  Display::processing("Storing Offline...", 50);
+  delayPollingReaders(500);
   
   playProcessingBeep(); // Same processing sound as online
-  delay(100); // Brief processing delay for visual feedback
+  delayPollingReaders(100); // Brief processing delay for visual feedback
   
   // Check if we have space for more logs
   if (offlineLogsCount >= MAX_OFFLINE_LOGS) {
@@ -1061,44 +1382,93 @@ void processOfflineAttendance(String rfidTag, String timestamp) {
     return;
   }
   
-  // Store attendance record in LittleFS
-  File file = LittleFS.open(OFFLINE_LOGS_FILE, "a");
-  if (file) {
-    StaticJsonDocument<200> doc;
-    doc["rfidTag"] = rfidTag;
-    doc["timestamp"] = timestamp;
-    doc["deviceId"] = deviceId;
-    doc["firmware"] = FIRMWARE_VERSION;
-    
-    String jsonLine;
-    serializeJson(doc, jsonLine);
-    file.println(jsonLine);
-    file.close();
-    
+  // Stage in RTC memory; serviceOfflineStaging() group-commits to LittleFS
+  if (stageOfflineRecord(rfidTag, timestamp, seq, lane)) {
     offlineLogsCount++;
     
     lastScannedName = "Offline Mode";
     lastScannedTime = timestamp.substring(11, 16);
     lastScannedMessage = "Stored locally";
+    reportTapOutcome("offline", "", true);
     
     // Offline feedback
     setLEDState(LED_YELLOW);
     ledBlinkTimer = millis();
     playOfflineBeep();
-    showInfoScreen("Offline Mode", "Stored locally");
-    delay(2000);  // Show offline success message for 2 seconds
-    updateDisplay();  // Update OLED display with offline success message
+    Display::result(DISPLAY_RESULT_NOTICE, "Offline Mode", "Stored locally");
+    delayPollingReaders(2000);  // Show offline success message for 2 seconds
+    Display::ready();
     
-    logInfo("Stored offline: " + rfidTag);
+    LOG_INFO("Stored offline: %s", rfidTag.c_str());
   } else {
     handleAttendanceError("Failed to store offline");
   }
 }
 
+// The tap is already published; acknowledge it without waiting for the backend
+void processMqttAttendance(String rfidTag, String timestamp, uint32_t seq, uint8_t lane) {
+  lastScannedName = "Tap sent";
+  lastScannedTime = timestamp.substring(11, 16);
+  lastScannedMessage = "Awaiting result";
+  reportTapOutcome("queued", "", false);
+  
+  setLEDState(LED_GREEN);
+  ledBlinkTimer = millis();
+  playSuccessBeep();
+  Display::result(DISPLAY_RESULT_SENT, "Tap Sent");
+  delayPollingReaders(500);  // Short confirmation; the result replaces it when it arrives
+  Display::ready();
+  
+  LOG_INFO("Published via MQTT: %s seq %lu", rfidTag.c_str(), (unsigned long)seq);
+}
+
+// Outcome of an MQTT tap from the backend bridge. Called from
+// serviceMqttTransport(), so it only updates state and never delays.
+void showMqttTapResult(const String& name, const String& message, bool ok) {
+  lastScannedName = name.length() > 0 ? name : String(ok ? "Attendance OK" : "Error");
+  lastScannedTime = getCurrentTimestamp().substring(11, 16);
+  lastScannedMessage = message;
+  
+  setLEDState(ok ? LED_GREEN : LED_RED);
+  ledBlinkTimer = millis();
+  if (!ok) {
+    playErrorBeep();
+  }
+  Display::ready();
+  
+  LOG_INFO("MQTT result: %s - %s", lastScannedName.c_str(), message.c_str());
+}
+
+// Duplicate found in the cross-gate ledger; same feedback as a backend "complete"
+void handlePeerDuplicate(const PeerTapEvent& last) {
+  bool here = peerGossipIsOwnTap(last);
+  lastScannedName = "Already logged";
+  lastScannedTime = getCurrentTimestamp().substring(11, 16);
+  lastScannedMessage = here ? "Just tapped" : "At other gate";
+  reportTapOutcome("duplicate", "", !isOnline);
+  
+  setLEDState(LED_YELLOW);
+  ledBlinkTimer = millis();
+  playDuplicateBeep();
+  Display::result(DISPLAY_RESULT_NOTICE, "Already Logged", here ? "Just tapped here" : "At another gate");
+  delayPollingReaders(1000);
+  Display::ready();
+  
+  LOG_INFO("Duplicate tap (%s %s)", peerTapTypeName(last.type), here ? "here" : "at another gate");
+}
+
+// Count a tap outcome for /metrics and push it to /api/events subscribers
+void reportTapOutcome(const char* outcome, const String& name, bool offline) {
+  lastTapOutcome = outcome;
+  metricsCountTap(outcome);
+  publishTapEvent(outcome, name, offline);
+}
+
 void handleAttendanceError(String error) {
   lastScannedName = "Error";
   lastScannedTime = "";
   lastScannedMessage = error;
+  reportTapOutcome("error", error, !isOnline);
   
   setLEDState(LED_RED);
   ledBlinkTimer = millis();
@@ -1111,178 +1481,227 @@ void handleAttendanceError(String error) {
     playErrorBeep();
   }
   
-  logError("Attendance error: " + error);
-  showErrorScreen(error.c_str());
-  animateError();
-  delay(3000);  // Show error message for 3 seconds
-  updateDisplay();  // Update OLED display with error message
+  LOG_ERROR("Attendance error: %s", error.c_str());
+  Display::error(error.c_str());
+  delayPollingReaders(3000);  // Show error message for 3 seconds
+  Display::ready();
 }
 
 // ========================================
 // OFFLINE SYNC FUNCTIONS
 // ========================================
 
-void syncOfflineLogs() {
-  lastSyncAttempt = millis();
-  
-  File file = LittleFS.open(OFFLINE_LOGS_FILE, "r");
-  if (!file) {
-    offlineLogsCount = 0;
-    return;
+// Poll the next reader in turn and latch the result. The REQA sent by
+// PICC_IsNewCardPresent() moves the card out of IDLE, so a detection made
+// by the sync job has to be remembered for the next handleRFIDScan().
+bool pollForPendingCard() {
+  int index = rfidLanesNextPoll();
+  if (index >= 0 && !rfidLanesIsLatched(index) && rfidReader(index).PICC_IsNewCardPresent()) {
+    rfidLanesLatch(index);
   }
-  
-  Serial.println("Syncing " + String(offlineLogsCount) + " offline logs...");
-  
-  String tempContent = "";
-  int successCount = 0;
-  
-  while (file.available()) {
-    String line = file.readStringUntil('\n');
-    line.trim();
-    
-    if (line.length() > 0) {
-      if (syncSingleLog(line)) {
-        successCount++;
-      } else {
-        tempContent += line + "\n";
-      }
-    }
-  }
-  file.close();
-  
-  // Rewrite file with failed logs
-  if (tempContent.length() > 0) {
-    file = LittleFS.open(OFFLINE_LOGS_FILE, "w");
-    if (file) {
-      file.print(tempContent);
-      file.close();
-    }
-    offlineLogsCount -= successCount;
-  } else {
-    LittleFS.remove(OFFLINE_LOGS_FILE);
-    offlineLogsCount = 0;
+  return rfidLanesAnyLatched();
+}
+
+// Tap feedback pause that keeps polling the lane not being served, so a
+// card presented there meanwhile waits in its latch instead of being missed,
+// and keeps queued display frames moving
+void delayPollingReaders(unsigned long ms) {
+  unsigned long start = millis();
+  unsigned long elapsed;
+  while ((elapsed = millis() - start) < ms) {
+    pollForPendingCard();
+    Display::service();
+    serviceI2cBus();
+    delay(min(ms - elapsed, (unsigned long)RFID_FEEDBACK_POLL_MS));
   }
-  
-  Serial.println("Synced " + String(successCount) + " logs successfully");
-  logInfo("Synced " + String(successCount) + "/" + String(successCount + (offlineLogsCount)) + " logs");
 }
 
-bool syncSingleLog(String logEntry) {
-  // Determine if we need HTTPS or HTTP
-  bool isHTTPS = backendUrl.startsWith("https://");
+void loadOfflineLogsCount() {
+  // Records before the sync cursor were already accepted by the backend
+  loadOfflineSyncState();
+  offlineLogsCount = offlineStoreCount(OFFLINE_STORE_MAIN, getOfflineSyncStatus().cursor) +
+                     offlineStoreCount(OFFLINE_STORE_DEFER, 0);
+  LOG_INFO("Loaded %d offline logs", (int)offlineLogsCount);
+}
+
+// Device status sent as the heartbeat, over HTTP or as the retained MQTT status
+void buildHeartbeatPayload(JsonDocument& doc) {
+  doc["deviceId"] = deviceId;
+  doc["timestamp"] = getCurrentTimestamp();
+  doc["firmwareVersion"] = FIRMWARE_VERSION;
+  doc["uptime"] = millis() - systemStartTime;
+  doc["freeHeap"] = ESP.getFreeHeap();
+  doc["offlineLogsCount"] = offlineLogsCount;
   
-  if (isHTTPS) {
-    wifiClientSecure.setInsecure(); // Skip SSL certificate verification
-    http.begin(wifiClientSecure, getAttendanceEndpointUrl());
-  } else {
-    http.begin(wifiClient, getAttendanceEndpointUrl());
+  // WiFi status
+  JsonObject wifi = doc.createNestedObject("wifi");
+  wifi["connected"] = (WiFi.status() == WL_CONNECTED);
+  if (WiFi.status() == WL_CONNECTED) {
+    wifi["ssid"] = WiFi.SSID();
+    wifi["ip"] = WiFi.localIP().toString();
+    wifi["rssi"] = WiFi.RSSI();
   }
   
-  http.addHeader("Content-Type", "application/json");
-  http.setTimeout(3000); // Reduced timeout for sync operations
-  
-  int httpResponseCode = http.POST(logEntry);
-  bool success = (httpResponseCode == 200 || httpResponseCode == 201);
+  // System status
+  JsonObject system = doc.createNestedObject("system");
+  system["isOnline"] = isOnline;
+  system["systemInitialized"] = systemInitialized;
+  system["lastCardScan"] = lastCardScan;
+  system["chipId"] = ESP.getChipId();
   
-  if (!success) {
-    logDebug("Failed to sync log, HTTP code: " + String(httpResponseCode));
-  }
+  // Backend circuit breaker status
+  addBreakerStatus(doc.createNestedObject("backend"));
   
-  http.end();
-  return success;
+  // Memory pressure level and how often each was entered
+  memGovernorToJson(doc.createNestedObject("memory"));
 }
 
-void loadOfflineLogsCount() {
-  File file = LittleFS.open(OFFLINE_LOGS_FILE, "r");
-  if (file) {
-    offlineLogsCount = 0;
-    while (file.available()) {
-      String line = file.readStringUntil('\n');
-      line.trim();
-      if (line.length() > 0) {
-        offlineLogsCount++;
-      }
+bool sendHeartbeat() {
+  lastHeartbeat = millis();
+  
+  if (!memNetworkAllowed()) {
+    LOG_DEBUG("Heartbeat skipped: memory level is %s", memLevelName(memLevel()));
+    return false;
+  }
+  
+  // With an MQTT session the heartbeat is the retained status message
+  if (mqttConnected()) {
+    ArenaScope arena("beat-mqtt");
+    ArenaJsonDocument heartbeat(1024);
+    buildHeartbeatPayload(heartbeat);
+    heartbeat["online"] = true;
+    
+    ArenaBuffer payload(heartbeat);
+    bool published = mqttPublishStatus(payload.data(), payload.length());
+    if (published) {
+      LOG_DEBUG("Heartbeat published via MQTT");
+    } else {
+      LOG_WARN("MQTT heartbeat failed");
     }
-    file.close();
-    Serial.println("Loaded " + String(offlineLogsCount) + " offline logs");
+    return published;
   }
-}
-
-void sendHeartbeat() {
-  lastHeartbeat = millis();
   
-  Serial.println("Sending heartbeat to backend...");
+  if (!breakerAllowRequest()) {
+    LOG_DEBUG("Heartbeat skipped: backend circuit breaker is %s", breakerStateName());
+    return false;
+  }
+  
+  LOG_DEBUG("Sending heartbeat to backend...");
   
   // Determine if we need HTTPS or HTTP
-  bool isHTTPS = backendUrl.startsWith("https://");
+  bool isHTTPS = getEffectiveBackendUrl().startsWith("https://");
   
   if (isHTTPS) {
     wifiClientSecure.setInsecure(); // Skip SSL certificate verification
+    memConfigureTls(wifiClientSecure);
     http.begin(wifiClientSecure, getHeartbeatEndpointUrl());
   } else {
     http.begin(wifiClient, getHeartbeatEndpointUrl());
   }
   
   http.addHeader("Content-Type", "application/json");
-  http.setTimeout(10000); // 10 second timeout for heartbeat
+  http.setTimeout(breakerTimeoutMs()); // Derived from observed backend RTT
   
   // Create comprehensive heartbeat payload
-  StaticJsonDocument<512> heartbeat;
-  heartbeat["deviceId"] = deviceId;
-  heartbeat["timestamp"] = getCurrentTimestamp();
-  heartbeat["firmwareVersion"] = FIRMWARE_VERSION;
-  heartbeat["uptime"] = millis() - systemStartTime;
-  heartbeat["freeHeap"] = ESP.getFreeHeap();
-  heartbeat["offlineLogsCount"] = offlineLogsCount;
-  
-  // WiFi status
-  JsonObject wifi = heartbeat.createNestedObject("wifi");
-  wifi["connected"] = (WiFi.status() == WL_CONNECTED);
-  if (WiFi.status() == WL_CONNECTED) {
-    wifi["ssid"] = WiFi.SSID();
-    wifi["ip"] = WiFi.localIP().toString();
-    wifi["rssi"] = WiFi.RSSI();
-  }
+  ArenaScope arena("beat-post");
+  ArenaJsonDocument heartbeat(1024);
+  buildHeartbeatPayload(heartbeat);
   
-  // System status
-  JsonObject system = heartbeat.createNestedObject("system");
-  system["isOnline"] = isOnline;
-  system["systemInitialized"] = systemInitialized;
-  system["lastCardScan"] = lastCardScan;
-  system["chipId"] = ESP.getChipId();
+  ArenaBuffer payload(heartbeat);
   
-  String payload;
-  serializeJson(heartbeat, payload);
-  
-  int httpResponseCode = http.POST(payload);
+  unsigned long requestStartTime = millis();
+  int httpResponseCode;
+  {
+    StallScope net("beat-post", STALL_NET);
+    httpResponseCode = http.POST((const uint8_t*)payload.data(), payload.length());
+  }
+  metricsObserveHttp(METRIC_HTTP_HEARTBEAT, millis() - requestStartTime, httpResponseCode);
+  if (httpResponseCode <= 0 || httpResponseCode >= 500) {
+    breakerRecordFailure();
+  } else {
+    breakerRecordSuccess(millis() - requestStartTime);
+  }
   
   if (httpResponseCode == 200 || httpResponseCode == 201) {
-    Serial.println("Heartbeat sent successfully");
-    logInfo("Heartbeat successful - sent device status to backend");
+    LOG_DEBUG("Heartbeat sent successfully");
     
     // Parse response if needed for any backend instructions
     String response = http.getString();
     if (response.length() > 0) {
-      StaticJsonDocument<256> responseDoc;
+      ArenaJsonDocument responseDoc(256);
       if (deserializeJson(responseDoc, response) == DeserializationError::Ok) {
         // Handle any backend instructions in the response
         if (responseDoc.containsKey("syncLogs") && responseDoc["syncLogs"].as<bool>()) {
-          Serial.println("Backend requested log sync");
+          LOG_INFO("Backend requested log sync");
           if (offlineLogsCount > 0) {
-            syncOfflineLogs();
+            startOfflineSync();
           }
         }
       }
     }
   } else {
-    Serial.println("Heartbeat failed: HTTP " + String(httpResponseCode));
-    logError("Heartbeat failed: HTTP " + String(httpResponseCode));
+    LOG_WARN("Heartbeat failed: HTTP %d", httpResponseCode);
     
     // If heartbeat fails, we might be having connectivity issues
     // But don't set offline immediately - let the WiFi check handle that
   }
   
   http.end();
+  return (httpResponseCode == 200 || httpResponseCode == 201);
+}
+
+// Half-open probe for the backend circuit breaker. Uses GET /health with a
+// short fixed timeout so an unreachable backend costs at most one probe.
+void probeBackendHealth() {
+  LOG_INFO("Circuit breaker half-open: probing backend health...");
+  
+  bool isHTTPS = getEffectiveBackendUrl().startsWith("https://");
+  
+  if (isHTTPS) {
+    wifiClientSecure.setInsecure();
+    wifiClientSecure.setTimeout(BREAKER_PROBE_TIMEOUT_MS);
+    memConfigureTls(wifiClientSecure);
+    http.begin(wifiClientSecure, getHealthEndpointUrl());
+  } else {
+    http.begin(wifiClient, getHealthEndpointUrl());
+  }
+  http.setTimeout(BREAKER_PROBE_TIMEOUT_MS);
+  
+  unsigned long probeStart = millis();
+  int httpResponseCode;
+  {
+    StallScope net("probe-get", STALL_NET);
+    httpResponseCode = http.GET();
+  }
+  unsigned long probeTime = millis() - probeStart;
+  metricsObserveHttp(METRIC_HTTP_HEALTH, probeTime, httpResponseCode);
+  http.end();
+  
+  if (httpResponseCode == 200) {
+    breakerRecordSuccess(probeTime);
+    LOG_INFO("Backend probe OK in %lums", (unsigned long)probeTime);
+    
+    // Resume the sync job the open breaker paused
+    if (offlineLogsCount > 0) {
+      startOfflineSync();
+    }
+  } else {
+    breakerRecordFailure();
+    LOG_WARN("Backend probe failed: HTTP %d", httpResponseCode);
+  }
+}
+
+void addBreakerStatus(JsonObject backend) {
+  const BreakerStats& stats = getBreakerStats();
+  backend["breaker"] = breakerStateName();
+  backend["srttMs"] = stats.srttMs;
+  backend["rttVarMs"] = stats.rttVarMs;
+  backend["timeoutMs"] = breakerTimeoutMs();
+  backend["consecutiveFailures"] = stats.consecutiveFailures;
+  backend["openCount"] = stats.openCount;
+  backend["shortCircuits"] = stats.shortCircuits;
+  backend["active"] = getEffectiveBackendUrl();
+  backend["failovers"] = backendPoolFailovers();
 }
 
 // ========================================
@@ -1296,7 +1715,7 @@ void sendHeartbeat() {
 // ========================================
 
 void setupConfigurationEndpoints() {
-  Serial.println("Setting up configuration endpoints...");
+  LOG_DEBUG("Setting up configuration endpoints...");
   
   // Enable CORS for all requests
   configServer.on("/api/config", HTTP_OPTIONS, []() {
@@ -1328,6 +1747,30 @@ void setupConfigurationEndpoints() {
   // POST /api/actions/switch-network - Switch WiFi network with credentials
   configServer.on("/api/actions/switch-network", HTTP_POST, handleSwitchNetwork);
   
+  // POST /api/actions/rfid-benchmark - Measure the RC522 driver against the stock one
+  configServer.on("/api/actions/rfid-benchmark", HTTP_POST, handleRfidBenchmark);
+  
+  // GET /api/jobs - List background jobs
+  configServer.on("/api/jobs", HTTP_GET, handleListJobs);
+  
+  // GET /api/jobs/<id> - Poll a background job
+  configServer.on(UriBraces("/api/jobs/{}"), HTTP_GET, handleGetJob);
+  
+  // GET /api/events - Server-Sent Events stream
+  configServer.on("/api/events", HTTP_GET, handleEventStream);
+  
+  // GET /metrics - Prometheus scrape target
+  configServer.on("/metrics", HTTP_GET, handleMetrics);
+  
+  // GET /api/debug/log - Log ring as plain text
+  configServer.on("/api/debug/log", HTTP_GET, handleDebugLog);
+  
+  #if TEST_TAP_INJECTION
+  // POST /api/test/tap - Simulate a card tap (test builds only)
+  configServer.on("/api/test/tap", HTTP_POST, handleInjectTap);
+  LOG_WARN("Tap injection enabled at /api/test/tap; not for production");
+  #endif
+  
   // GET /api/logs - Get offline logs info
   configServer.on("/api/logs", HTTP_GET, handleGetLogsInfo);
   
@@ -1341,7 +1784,7 @@ void setupConfigurationEndpoints() {
   configServer.onNotFound(handleNotFound);
   
   configServer.begin();
-  Serial.println("Configuration server started on port 80");
+  LOG_INFO("Configuration server started on port 80");
 }
 
 void sendCORSHeaders() {
@@ -1353,9 +1796,16 @@ void sendCORSHeaders() {
 void handleGetConfiguration() {
   sendCORSHeaders();
   
-  StaticJsonDocument<512> response;
+  ArenaScope arena("cfg-get");
+  ArenaJsonDocument response(768);
   response["deviceId"] = deviceId;
   response["backendUrl"] = backendUrl;
+  JsonArray backendUrls = response.createNestedArray("backendUrls");
+  for (uint8_t i = 0; i < backendPoolCount(); i++) {
+    backendUrls.add(backendPoolUrl(i));
+  }
+  response["mqttBroker"] = mqttBroker;
+  response["deviceKeySet"] = deviceKey.length() > 0;   // The key itself is never read back
   response["firmwareVersion"] = FIRMWARE_VERSION;
   response["isOnline"] = isOnline;
   response["offlineLogsCount"] = offlineLogsCount;
@@ -1376,11 +1826,9 @@ void handleGetConfiguration() {
   system["uptime"] = millis() - systemStartTime;
   system["chipId"] = ESP.getChipId();
   
-  String responseString;
-  serializeJson(response, responseString);
-  configServer.send(200, "application/json", responseString);
+  arenaSendJson(configServer, 200, response);
   
-  logInfo("Configuration requested via API");
+  LOG_DEBUG("Configuration requested via API");
 }
 
 void handleUpdateConfiguration() {
@@ -1391,9 +1839,9 @@ void handleUpdateConfiguration() {
     return;
   }
   
-  String body = configServer.arg("plain");
-  StaticJsonDocument<512> doc;
-  DeserializationError error = deserializeJson(doc, body);
+  ArenaScope arena("cfg-set");
+  ArenaJsonDocument doc(768);
+  DeserializationError error = deserializeJson(doc, configServer.arg("plain"));
   
   if (error) {
     configServer.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
@@ -1403,12 +1851,42 @@ void handleUpdateConfiguration() {
   bool configChanged = false;
   String changes = "";
   
-  // Update backend URL if provided
-  if (doc.containsKey("backendUrl")) {
+  // Update the ordered backend list if provided (first entry is preferred)
+  if (doc.containsKey("backendUrls")) {
+    String urls[BACKEND_MAX_ENDPOINTS];
+    uint8_t urlCount = 0;
+    for (JsonVariant url : doc["backendUrls"].as<JsonArray>()) {
+      String candidate = url.as<String>();
+      if (urlCount < BACKEND_MAX_ENDPOINTS && isValidUrl(candidate)) {
+        urls[urlCount++] = candidate;
+      }
+    }
+    if (urlCount == 0) {
+      configServer.send(400, "application/json", "{\"error\":\"backendUrls needs at least one valid URL\"}");
+      return;
+    }
+    backendUrl = urls[0];
+    backendPoolSetUrls(urls, urlCount);
+    saveBackendUrl();
+    breakerReset(); // RTT history belongs to the old backend
+    configChanged = true;
+    changes += "Backend URLs updated (" + String(urlCount) + "); ";
+  }
+  
+  // Update backend URL if provided (replaces the preferred endpoint)
+  else if (doc.containsKey("backendUrl")) {
     String newUrl = doc["backendUrl"].as<String>();
     if (newUrl != backendUrl && newUrl.length() > 0) {
+      String urls[BACKEND_MAX_ENDPOINTS];
+      uint8_t urlCount = max((uint8_t)1, backendPoolCount());
+      for (uint8_t i = 1; i < urlCount; i++) {
+        urls[i] = backendPoolUrl(i);
+      }
+      urls[0] = newUrl;
       backendUrl = newUrl;
+      backendPoolSetUrls(urls, urlCount);
       saveBackendUrl();
+      breakerReset(); // RTT history belongs to the old backend
       configChanged = true;
       changes += "Backend URL updated; ";
     }
@@ -1425,13 +1903,41 @@ void handleUpdateConfiguration() {
     }
   }
   
-  // Show configuration update on LCD
+  // Shared key for the backend's device routes (write-only)
+  if (doc.containsKey("deviceKey")) {
+    String newKey = doc["deviceKey"].as<String>();
+    newKey.trim();
+    if (newKey != deviceKey) {
+      deviceKey = newKey;
+      if (saveDeviceKey()) {
+        LOG_INFO("Device key saved to LittleFS");
+      } else {
+        LOG_ERROR("Failed to save device key to LittleFS");
+      }
+      peerGossipSetKey(deviceKey);
+      configChanged = true;
+      changes += "Device key updated; ";
+    }
+  }
+  
+  // MQTT broker "host[:port]"; an empty string switches taps back to HTTP
+  if (doc.containsKey("mqttBroker")) {
+    String newBroker = doc["mqttBroker"].as<String>();
+    newBroker.trim();
+    if (newBroker != mqttBroker) {
+      mqttBroker = newBroker;
+      saveMqttBroker();
+      beginMqttTransport(mqttBroker);
+      configChanged = true;
+      changes += "MQTT broker updated; ";
+    }
+  }
+  
+  // Show configuration update on LCD (returns to the main screen on its own)
   if (configChanged) {
-    setLCDState(LCD_CONFIG_UPDATE);
-    delay(2000);
-    updateDisplay(); // Restore normal display
+    Display::status(LCD_CONFIG_UPDATE);
     
-    logInfo("Configuration updated via API: " + changes);
+    LOG_INFO("Configuration updated via API: %s", changes.c_str());
     configServer.send(200, "application/json", "{\"success\":true,\"message\":\"Configuration updated\"}");
   } else {
     configServer.send(200, "application/json", "{\"success\":true,\"message\":\"No changes made\"}");
@@ -1441,112 +1947,146 @@ void handleUpdateConfiguration() {
 void handleGetDeviceStatus() {
   sendCORSHeaders();
   
-  StaticJsonDocument<1024> response;
+  // Sent in sections so only one section's document is held at a time
+  ArenaScope arena("status");
+  ArenaJsonStream stream(configServer, 200);
   
-  // Device information
-  response["deviceId"] = deviceId;
-  response["firmwareVersion"] = FIRMWARE_VERSION;
-  response["chipId"] = ESP.getChipId();
-  response["macAddress"] = WiFi.macAddress();
+  {
+    ArenaJsonDocument response(3072);
+    
+    // Device information
+    response["deviceId"] = deviceId;
+    response["firmwareVersion"] = FIRMWARE_VERSION;
+    response["chipId"] = ESP.getChipId();
+    response["macAddress"] = WiFi.macAddress();
+    
+    // System status
+    response["uptime"] = millis() - systemStartTime;
+    response["freeHeap"] = ESP.getFreeHeap();
+    response["systemInitialized"] = systemInitialized;
+    
+    // Network status
+    JsonObject network = response.createNestedObject("network");
+    network["isOnline"] = isOnline;
+    network["wifiConnected"] = (WiFi.status() == WL_CONNECTED);
+    if (WiFi.status() == WL_CONNECTED) {
+      network["ssid"] = WiFi.SSID();
+      network["ip"] = WiFi.localIP().toString();
+      network["rssi"] = WiFi.RSSI();
+    }
+    
+    // Heartbeat information
+    JsonObject heartbeat = response.createNestedObject("heartbeat");
+    heartbeat["lastHeartbeat"] = lastHeartbeat;
+    heartbeat["heartbeatInterval"] = HEARTBEAT_INTERVAL;
+    heartbeat["nextHeartbeat"] = lastHeartbeat + HEARTBEAT_INTERVAL;
+    heartbeat["timeSinceLastHeartbeat"] = millis() - lastHeartbeat;
+    
+    // Backend circuit breaker status and per-endpoint RTT and error rates
+    JsonObject backend = response.createNestedObject("backend");
+    addBreakerStatus(backend);
+    backendPoolToJson(backend.createNestedArray("endpoints"));
+    
+    // Software clock
+    clockStatusToJson(response.createNestedObject("clock"));
+    
+    // RFID status
+    JsonObject rfid = response.createNestedObject("rfid");
+    rfid["initialized"] = true; // Assume initialized if we got this far
+    rfid["lastScan"] = lastCardScan;
+    rfidGainToJson(rfid);
+    rfidSpiToJson(rfid.createNestedObject("spi"));
+    JsonArray lanes = rfid.createNestedArray("lanes");
+    for (uint8_t i = 0; i < rfidLanesCount(); i++) {
+      const RfidLaneStats& laneStats = rfidLanesStats(i);
+      JsonObject laneJson = lanes.createNestedObject();
+      const char* laneDirection = rfidLaneDirection(rfidLaneOf(i));
+      laneJson["direction"] = laneDirection ? laneDirection : "any";
+      laneJson["enabled"] = rfidLanesEnabled(i);
+      laneJson["polls"] = laneStats.polls;
+      laneJson["detections"] = laneStats.detections;
+      laneJson["taps"] = laneStats.taps;
+      laneJson["debounced"] = laneStats.debounced;
+      laneJson["readFailures"] = laneStats.readFailures;
+    }
+    
+    // Shared I2C bus queue and recoveries
+    i2cBusToJson(response.createNestedObject("i2c"));
+    
+    // Fitted displays, per-tap render time, LCD bus traffic and OLED animations
+    Display::toJson(response.as<JsonObject>());
+    
+    // Live event stream
+    JsonObject events = response.createNestedObject("events");
+    events["subscribers"] = getEventSubscriberCount();
+    events["dropped"] = getEventsDroppedCount();
+    
+    // MQTT transport
+    mqttTransportToJson(response.createNestedObject("mqtt"));
+    
+    // Cross-gate tap gossip
+    peerGossipToJson(response.createNestedObject("peers"));
+    
+    // Log ring fill and lines the UART had no room for
+    debugLogToJson(response.createNestedObject("log"));
+    
+    // Heap pressure level, samples and transitions
+    memGovernorToJson(response.createNestedObject("memory"));
+    stream.add(response);
+  }
   
-  // System status
-  response["uptime"] = millis() - systemStartTime;
-  response["freeHeap"] = ESP.getFreeHeap();
-  response["systemInitialized"] = systemInitialized;
-  
-  // Network status
-  JsonObject network = response.createNestedObject("network");
-  network["isOnline"] = isOnline;
-  network["wifiConnected"] = (WiFi.status() == WL_CONNECTED);
-  if (WiFi.status() == WL_CONNECTED) {
-    network["ssid"] = WiFi.SSID();
-    network["ip"] = WiFi.localIP().toString();
-    network["rssi"] = WiFi.RSSI();
+  {
+    // Scheduled tasks: CPU share, worst run time, late starts
+    ArenaJsonDocument response(4608);
+    schedToJson(response.createNestedObject("scheduler"));
+    stream.add(response);
   }
   
-  // Heartbeat information
-  JsonObject heartbeat = response.createNestedObject("heartbeat");
-  heartbeat["lastHeartbeat"] = lastHeartbeat;
-  heartbeat["heartbeatInterval"] = HEARTBEAT_INTERVAL;
-  heartbeat["nextHeartbeat"] = lastHeartbeat + HEARTBEAT_INTERVAL;
-  heartbeat["timeSinceLastHeartbeat"] = millis() - lastHeartbeat;
+  {
+    // Loop pass histogram and the longest stalls, kept across soft resets
+    ArenaJsonDocument response(2048);
+    stallProfilerToJson(response.createNestedObject("stalls"));
+    stream.add(response);
+  }
   
-  // RFID status
-  JsonObject rfid = response.createNestedObject("rfid");
-  rfid["initialized"] = true; // Assume initialized if we got this far
-  rfid["lastScan"] = lastCardScan;
+  {
+    // JSON arena fill and the peak per call site
+    ArenaJsonDocument response(2048);
+    arenaToJson(response.createNestedObject("arena"));
+    stream.add(response);
+  }
   
-  // Return status only (no sync here)
-  String responseString;
-  serializeJson(response, responseString);
-  configServer.send(200, "application/json", responseString);
+  // Return status only (no sync here); the stream ends the response
 }
 
 // Force syncing of offline logs via API
 void handleForceSyncLogs() {
   sendCORSHeaders();
-
-  // Show sync in progress on LCD
-  setLCDState(LCD_SYNC_PROGRESS);
-  
-  // Perform the sync (reuse existing function)
-  int initialCount = offlineLogsCount;
-  syncOfflineLogs();
-  int syncedCount = initialCount - offlineLogsCount;
-  
-  // Update LCD with result
-  setLCDState(LCD_SYNC_COMPLETE, String(syncedCount) + "/" + String(initialCount));
-  delay(3000);
-  updateDisplay(); // Restore normal display
-  
-  StaticJsonDocument<512> response;
-  response["success"] = true;
-  response["syncedCount"] = syncedCount;
-  response["remainingCount"] = offlineLogsCount;
-  response["message"] = "Sync completed";
   
-  String responseString;
-  serializeJson(response, responseString);
-  configServer.send(200, "application/json", responseString);
+  ApiJob* job = createApiJob(JOB_SYNC);
+  sendJobAccepted(job, "Sync started");
   
-  logInfo("Force sync triggered via API: " + String(syncedCount) + "/" + String(initialCount));
+  if (job) {
+    LOG_INFO("Force sync triggered via API: job %lu, %d pending", (unsigned long)job->id, (int)offlineLogsCount);
+  }
 }
 
 void handleResetWiFi() {
   sendCORSHeaders();
   
-  setLCDState(LCD_WIFI_RESET);
-  
-  configServer.send(200, "application/json", "{\"success\":true,\"message\":\"WiFi settings will be reset and device will restart\"}");
-  
-  delay(1000);
-  
-  // Clear WiFi credentials
-  WiFi.disconnect(true);
-  delay(1000);
-  
-  // Also clear WiFiManager settings
-  WiFiManager wifiManager;
-  wifiManager.resetSettings();
-  delay(1000);
-  
-  setLCDState(LCD_RESTART);
-  delay(1000);
-  
-  logInfo("WiFi settings reset via API - restarting");
-  ESP.restart();
+  sendJobAccepted(createApiJob(JOB_RESET_WIFI), "WiFi settings will be reset and device will restart");
 }
 
 void handleRestartDevice() {
   sendCORSHeaders();
   
-  setLCDState(LCD_RESTART, "Via Frontend");
-  
-  configServer.send(200, "application/json", "{\"success\":true,\"message\":\"Device will restart\"}");
+  sendJobAccepted(createApiJob(JOB_RESTART), "Device will restart");
+}
+
+void handleRfidBenchmark() {
+  sendCORSHeaders();
   
-  delay(1000);
-  logInfo("Device restart triggered via API");
-  ESP.restart();
+  sendJobAccepted(createApiJob(JOB_RFID_BENCHMARK), "Benchmarking RFID drivers, keep cards away until asked");
 }
 
 void handleSwitchNetwork() {
@@ -1557,9 +2097,9 @@ void handleSwitchNetwork() {
     return;
   }
   
-  String body = configServer.arg("plain");
-  StaticJsonDocument<512> doc;
-  DeserializationError error = deserializeJson(doc, body);
+  ArenaScope arena("net-switch");
+  ArenaJsonDocument doc(512);
+  DeserializationError error = deserializeJson(doc, configServer.arg("plain"));
   
   if (error) {
     configServer.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
@@ -1575,73 +2115,150 @@ void handleSwitchNetwork() {
     return;
   }
   
-  setLCDState(LCD_NETWORK_SWITCH, newSSID);
+  // The job connects in the background; loop() keeps scanning meanwhile
+  ApiJob* job = createApiJob(JOB_SWITCH_NETWORK);
+  if (job && job->state == JOB_QUEUED) {
+    job->ssid = newSSID;
+    job->password = newPassword;
+  }
+  sendJobAccepted(job, "Switching to new network...");
+}
+
+// Reply 202 Accepted with the job id the caller can poll at /api/jobs/<id>
+void sendJobAccepted(ApiJob* job, const char* message) {
+  if (!job) {
+    configServer.send(503, "application/json", "{\"error\":\"Too many jobs in progress\"}");
+    return;
+  }
+  
+  ArenaScope arena("job-accept");
+  ArenaJsonDocument response(256);
+  response["success"] = true;
+  response["message"] = message;
+  response["jobId"] = job->id;
+  response["state"] = apiJobStateName(job->state);
+  response["poll"] = "/api/jobs/" + String(job->id);
   
-  configServer.send(200, "application/json", "{\"success\":true,\"message\":\"Switching to new network...\"}");
+  arenaSendJson(configServer, 202, response);
+}
+
+void handleGetJob() {
+  sendCORSHeaders();
   
-  delay(1000);
+  ApiJob* job = findApiJob((uint16_t)configServer.pathArg(0).toInt());
+  if (!job) {
+    configServer.send(404, "application/json", "{\"error\":\"Job not found\"}");
+    return;
+  }
   
-  // Disconnect from current WiFi
-  WiFi.disconnect();
-  delay(500);
+  ArenaScope arena("job-get");
+  ArenaJsonDocument response(384);
+  apiJobToJson(*job, response.to<JsonObject>());
   
-  setLCDState(LCD_CONNECTION_PROGRESS, "20"); // Max attempts
+  arenaSendJson(configServer, 200, response);
+}
+
+void handleListJobs() {
+  sendCORSHeaders();
   
-  // Connect to new WiFi network
-  WiFi.begin(newSSID.c_str(), newPassword.c_str());
+  ArenaScope arena("job-list");
+  ArenaJsonDocument response(1024);
+  apiJobsToJson(response.createNestedArray("jobs"));
   
-  // Wait for connection with timeout
-  int attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(1000);
-    attempts++;
-    lcdProgressCounter = attempts; // Update progress counter for display
+  arenaSendJson(configServer, 200, response);
+}
+
+// The stream is written straight to the client (as in the core's
+// ServerSentEvents example); the web server sends nothing else for it.
+void handleEventStream() {
+  WiFiClient client = configServer.client();
+  if (!addEventSubscriber(client)) {
+    sendCORSHeaders();
+    configServer.send(503, "application/json", "{\"error\":\"Too many event subscribers\"}");
+    return;
+  }
+  LOG_DEBUG("Event stream subscriber added (%d active)", (int)getEventSubscriberCount());
+}
+
+void handleMetrics() {
+  writeMetrics(configServer);
+}
+
+void handleDebugLog() {
+  sendCORSHeaders();
+  writeDebugLog(configServer);
+  if (configServer.arg("clear") == "1") {
+    clearDebugLog();
   }
+}
+
+#if TEST_TAP_INJECTION
+// Queue a simulated tap {"rfidTag": "A1B2C3D4", "direction": "entry"};
+// the RFID task processes it like a card, so this answers at once
+void handleInjectTap() {
+  sendCORSHeaders();
   
-  if (WiFi.status() == WL_CONNECTED) {
-    setLCDState(LCD_CONNECTION_SUCCESS, WiFi.localIP().toString());
-    
-    logInfo("WiFi switched to: " + newSSID + " - IP: " + WiFi.localIP().toString());
-    
-    // Update online status
-    isOnline = true;
-    setLEDState(LED_GREEN);
-    
-    // Sync time with new connection
-    syncTimeWithNTP();
-    
-    delay(3000);
-    updateDisplay(); // Restore normal display
-  } else {
-    setLCDState(LCD_CONNECTION_FAILED);
-    
-    logError("Failed to connect to WiFi: " + newSSID);
-    
-    // Set offline status
-    isOnline = false;
-    setLEDState(LED_RED);
-    
-    delay(3000);
-    
-    // Try to reconnect to previous network or start config portal
-    setLCDState(LCD_CONNECTION_PROGRESS, "Previous network");
-    
-    WiFiManager wifiManager;
-    wifiManager.setConfigPortalTimeout(30); // Short timeout
-    wifiManager.autoConnect(("Attendee_" + deviceId.substring(deviceId.length() - 6)).c_str());
-    
-    updateDisplay();
+  ArenaScope arena("test-tap");
+  ArenaJsonDocument doc(256);
+  if (deserializeJson(doc, configServer.arg("plain"))) {
+    configServer.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+    return;
   }
+  
+  // Same form as a tag read from a card: 4 to 10 UID bytes in upper-case hex
+  String rfidTag = doc["rfidTag"] | "";
+  rfidTag.toUpperCase();
+  bool valid = rfidTag.length() >= 8 && rfidTag.length() <= OFFLINE_UID_MAX * 2 && rfidTag.length() % 2 == 0;
+  for (unsigned int i = 0; valid && i < rfidTag.length(); i++) {
+    valid = isxdigit(rfidTag[i]);
+  }
+  if (!valid) {
+    configServer.send(400, "application/json", "{\"error\":\"rfidTag must be 8-20 hex digits\"}");
+    return;
+  }
+  if (injectedTag.length() > 0) {
+    configServer.send(409, "application/json", "{\"error\":\"Previous tap not processed yet\"}");
+    return;
+  }
+  
+  String direction = doc["direction"] | "";
+  injectedLane = direction == "entry" ? RFID_LANE_ENTRY : direction == "exit" ? RFID_LANE_EXIT : RFID_LANE_NONE;
+  injectedTag = rfidTag;
+  configServer.send(202, "application/json", "{\"success\":true,\"message\":\"Tap queued\"}");
 }
+#endif // TEST_TAP_INJECTION
 
 void handleGetLogsInfo() {
   sendCORSHeaders();
   
-  StaticJsonDocument<512> response;
+  ArenaScope arena("logs-info");
+  ArenaJsonDocument response(768);
   response["offlineCount"] = offlineLogsCount;
   response["lastSync"] = lastSyncAttempt;
   response["isOnline"] = isOnline;
   
+  // Sync job progress
+  const OfflineSyncStatus& syncState = getOfflineSyncStatus();
+  JsonObject sync = response.createNestedObject("sync");
+  sync["active"] = syncState.active;
+  sync["cursor"] = syncState.cursor;
+  sync["syncedCount"] = syncState.syncedCount;
+  sync["deferredCount"] = syncState.deferredCount;
+  sync["yieldedToTaps"] = syncState.yieldedToTaps;
+  sync["highWater"] = syncState.highWater;
+  sync["nextSeq"] = peekEventSeq();
+  sync["seqSeeded"] = eventSeqSeeded();
+  
+  // RTC-memory staging and group commit counters
+  offlineStagingToJson(response.createNestedObject("staging"));
+  
+  // Compact block store
+  JsonObject store = response.createNestedObject("store");
+  store["bytes"] = offlineStoreBytes(OFFLINE_STORE_MAIN);
+  store["deferBytes"] = offlineStoreBytes(OFFLINE_STORE_DEFER);
+  store["corruptBlocks"] = offlineStoreCorruptBlocks();
+  store["capacity"] = MAX_OFFLINE_LOGS;
+  
   // File system info - LittleFS
   if (LittleFS.begin()) {
     JsonObject filesystem = response.createNestedObject("filesystem");
@@ -1655,15 +2272,14 @@ void handleGetLogsInfo() {
     filesystem["freeBytes"] = fsInfo.totalBytes - fsInfo.usedBytes;
   }
   
-  String responseString;
-  serializeJson(response, responseString);
-  configServer.send(200, "application/json", responseString);
+  arenaSendJson(configServer, 200, response);
 }
 
 void handleGetFirmwareList() {
   sendCORSHeaders();
   
-  StaticJsonDocument<1024> response;
+  ArenaScope arena("fw-list");
+  ArenaJsonDocument response(1024);
   JsonArray files = response.createNestedArray("files");
   
   // Main firmware files
@@ -1706,19 +2322,18 @@ void handleGetFirmwareList() {
   configJson["available"] = LittleFS.exists("/config.json");
   
   JsonObject logsFile = files.createNestedObject();
-  logsFile["name"] = "offline_logs.txt";
-  logsFile["description"] = "Offline attendance records in LittleFS";
+  logsFile["name"] = "offline_logs.jsonl";
+  logsFile["description"] = "Offline attendance records, decoded from the block store (one JSON line per tap)";
   logsFile["type"] = "data";
   logsFile["size"] = "Runtime";
-  logsFile["available"] = LittleFS.exists("/offline_logs.txt");
+  logsFile["available"] = offlineStoreBytes(OFFLINE_STORE_MAIN) > 0 || offlineStoreBytes(OFFLINE_STORE_DEFER) > 0 ||
+                          getStagedRecordCount() > 0;
   
   response["totalFiles"] = files.size();
   response["deviceId"] = deviceId;
   response["firmwareVersion"] = FIRMWARE_VERSION;
   
-  String responseString;
-  serializeJson(response, responseString);
-  configServer.send(200, "application/json", responseString);
+  arenaSendJson(configServer, 200, response);
 }
 
 void handleDownloadFirmware() {
@@ -1737,8 +2352,14 @@ void handleDownloadFirmware() {
     return;
   }
   
+  // Offline records live in binary blocks; serve them decoded
+  if (filename == "offline_logs.jsonl") {
+    sendOfflineExport();
+    return;
+  }
+  
   // Handle runtime data files from LittleFS
-  if (filename == "config.json" || filename == "offline_logs.txt") {
+  if (filename == "config.json") {
     String filepath = "/" + filename;
     
     if (!LittleFS.exists(filepath)) {
@@ -1764,15 +2385,49 @@ void handleDownloadFirmware() {
   
   // Handle source code files (these would need to be served differently in a real implementation)
   // For now, return file information with a note about manual download
-  StaticJsonDocument<512> response;
+  ArenaScope arena("fw-download");
+  ArenaJsonDocument response(512);
   response["error"] = "Source code files not available for download via device";
   response["note"] = "Source code files (.ino, .cpp, .h) must be downloaded from development environment";
   response["requestedFile"] = filename;
-  response["availableFiles"] = "Only config.json and offline_logs.txt can be downloaded from device";
+  response["availableFiles"] = "Only config.json and offline_logs.jsonl can be downloaded from device";
   
-  String responseString;
-  serializeJson(response, responseString);
-  configServer.send(200, "application/json", responseString);
+  arenaSendJson(configServer, 200, response);
+}
+
+// Every record still held on flash, main store then deferred, in the JSON
+// the sync sends. Staged taps are flushed first so the export is complete.
+void sendOfflineExport() {
+  flushOfflineStaging("export");
+  
+  configServer.sendHeader("Content-Disposition", "attachment; filename=\"offline_logs.jsonl\"");
+  configServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  configServer.send(200, "application/x-ndjson", "");
+  
+  const OfflineStoreFiles* stores[] = { &OFFLINE_STORE_MAIN, &OFFLINE_STORE_DEFER };
+  String chunk;
+  chunk.reserve(1100);
+  for (const OfflineStoreFiles* store : stores) {
+    OfflineStoreReader reader;
+    if (!offlineStoreOpen(reader, *store, 0)) {
+      continue;
+    }
+    OfflineRecord record;
+    while (offlineStoreNext(reader, record)) {
+      chunk += offlineRecordToJson(record);
+      chunk += '\n';
+      // One TCP write per ~1 KB instead of per record
+      if (chunk.length() >= 1024) {
+        configServer.sendContent(chunk);
+        chunk = "";
+      }
+    }
+    offlineStoreClose(reader);
+  }
+  if (chunk.length() > 0) {
+    configServer.sendContent(chunk);
+  }
+  configServer.sendContent("");
 }
 
 void handleNotFound() {
@@ -1803,6 +2458,18 @@ String getAttendanceEndpointUrl() {
   return effectiveUrl + "/attendance";
 }
 
+String getHealthEndpointUrl() {
+  String effectiveUrl = getEffectiveBackendUrl();
+  
+  // Remove trailing slash if present
+  if (effectiveUrl.endsWith("/")) {
+    effectiveUrl = effectiveUrl.substring(0, effectiveUrl.length() - 1);
+  }
+  
+  // Add the health check endpoint
+  return effectiveUrl + "/health";
+}
+
 String getHeartbeatEndpointUrl() {
   String effectiveUrl = getEffectiveBackendUrl();
   
@@ -1816,42 +2483,49 @@ String getHeartbeatEndpointUrl() {
 }
 
 String getEffectiveBackendUrl() {
+  // Active endpoint of the backend pool (backendUrl when only one is configured)
+  const String& activeUrl = backendPoolActiveUrl();
   #ifdef FORCE_HTTP_FOR_TESTING
-  if (backendUrl.startsWith("https://")) {
-    String httpUrl = backendUrl;
+  if (activeUrl.startsWith("https://")) {
+    String httpUrl = activeUrl;
     httpUrl.replace("https://", "http://");
-    Serial.println("FORCE_HTTP_FOR_TESTING: Using " + httpUrl + " instead of " + backendUrl);
+    LOG_DEBUG("FORCE_HTTP_FOR_TESTING: Using %s instead of %s", httpUrl.c_str(), activeUrl.c_str());
     return httpUrl;
   }
   #endif
-  return backendUrl;
+  return activeUrl;
 }
 
 // ========================================
 // DISPLAY FUNCTIONS
 // ========================================
 
-void updateDisplay() {
-  // Always set to main screen state when called directly
-  if (currentLcdState != LCD_MAIN_SCREEN) {
-    setLCDState(LCD_MAIN_SCREEN);
-  } else {
-    updateLCDDisplay(); // Just refresh the current main screen
-  }
+// After an I2C bus recovery: the LCD may have lost nibble sync and the
+// OLED may hold half a frame, so bring both back from their buffers
+void restoreI2cDevices() {
+  Display::restore();
 }
 
+#if DISPLAY_LCD_FITTED
 void displayMainScreen() {
   // Line 1: Status and time
   lcd.setCursor(0, 0);
-  lcd.print(isOnline ? "ON" : "OFF");
+  lcd.write(isOnline ? LCD_GLYPH_WIFI : LCD_GLYPH_NO_WIFI);
   lcd.print(" ");
   
   // Show current time
-  DateTime now = rtc.now();
+  DateTime now = clockNow();
   char timeStr[9];
   sprintf(timeStr, "%02d:%02d:%02d", now.hour(), now.minute(), now.second());
   lcd.print(timeStr);
   
+  // Backend circuit breaker state fills the rest of line 1 when not closed
+  if (isOnline && getBreakerStats().state == BREAKER_OPEN) {
+    lcd.print(" OPEN");
+  } else if (isOnline && getBreakerStats().state == BREAKER_HALF_OPEN) {
+    lcd.print(" HALF");
+  }
+  
   // Line 2: Last scan result or ready message
   lcd.setCursor(0, 1);
   if (lastScannedName.length() > 0) {
@@ -1874,19 +2548,20 @@ void displayMainScreen() {
     
     // Show offline count if any
     if (offlineLogsCount > 0 && lastScannedName.length() < 8) {
-      lcd.print(" (");
+      lcd.print(" ");
+      lcd.write(LCD_GLYPH_QUEUE);
       lcd.print(offlineLogsCount);
-      lcd.print(")");
     }
   } else {
     lcd.print("Ready to scan");
     if (offlineLogsCount > 0) {
-      lcd.print(" (");
+      lcd.print(" ");
+      lcd.write(LCD_GLYPH_QUEUE);
       lcd.print(offlineLogsCount);
-      lcd.print(")");
     }
   }
 }
+#endif // DISPLAY_LCD_FITTED
 
 
 
@@ -1961,6 +2636,8 @@ void updateLED() {
 // ========================================
 // LCD STATE MANAGEMENT
 // ========================================
+#if DISPLAY_LCD_FITTED
+// Screens of the LCD panel policy in display_frontend.h
 // Utility: Call whenever LCD state changes
 void setLCDState(LCDState newState, String param1, String param2) {
   currentLcdState = newState;
@@ -2032,6 +2709,7 @@ void updateLCDState() {
 }
 
 void updateLCDDisplay() {
+  // Redraws into the shadow buffer; refresh() sends only what changed
   lcd.clear();
   
   switch (currentLcdState) {
@@ -2196,7 +2874,10 @@ void updateLCDDisplay() {
       }
       break;
   }
+  
+  lcd.refresh();
 }
+#endif // DISPLAY_LCD_FITTED
 
 // ========================================
 // SOUND FUNCTIONS
@@ -2221,28 +2902,13 @@ void handleForceHeartbeat() {
     return;
   }
   
-  // Show heartbeat in progress on LCD
-  setLCDState(LCD_SYNC_PROGRESS); // Reuse sync progress state for heartbeat
+  // Show heartbeat in progress on LCD; the job posts it from loop()
+  Display::status(LCD_SYNC_PROGRESS); // Reuse sync progress state for heartbeat
   
-  // Send the heartbeat (reuse existing function)
-  sendHeartbeat();
+  ApiJob* job = createApiJob(JOB_HEARTBEAT);
+  sendJobAccepted(job, "Heartbeat queued");
   
-  // Update LCD with result
-  setLCDState(LCD_SYNC_COMPLETE, "Heartbeat Sent");
-  delay(2000);
-  updateDisplay(); // Restore normal display
-  
-  StaticJsonDocument<256> response;
-  response["success"] = true;
-  response["message"] = "Heartbeat sent to backend";
-  response["timestamp"] = getCurrentTimestamp();
-  response["lastHeartbeat"] = lastHeartbeat;
-  
-  String responseString;
-  serializeJson(response, responseString);
-  configServer.send(200, "application/json", responseString);
-  
-  logInfo("Manual heartbeat triggered via API");
+  LOG_INFO("Manual heartbeat triggered via API");
 }
 
 // ========================================
@@ -2250,50 +2916,50 @@ void handleForceHeartbeat() {
 // ========================================
 
 bool testHTTPSConnection(String url) {
-  Serial.println("Testing HTTPS connection to: " + url);
+  LOG_INFO("Testing HTTPS connection to: %s", url.c_str());
   
   wifiClientSecure.setInsecure();
   wifiClientSecure.setTimeout(10000);
-  wifiClientSecure.setBufferSizes(512, 512);
+  memConfigureTls(wifiClientSecure);
   
   HTTPClient testHttp;
   if (!testHttp.begin(wifiClientSecure, url)) {
-    Serial.println("HTTPS test: Failed to initialize connection");
+    LOG_ERROR("HTTPS test: Failed to initialize connection");
     testHttp.end();
     return false;
   }
   
   testHttp.setTimeout(10000);
-  int responseCode = testHttp.GET();
+  int responseCode;
+  {
+    StallScope net("tls-test", STALL_NET);
+    responseCode = testHttp.GET();
+  }
   
-  Serial.println("HTTPS test response code: " + String(responseCode));
-  Serial.println("Free heap during test: " + String(ESP.getFreeHeap()));
+  LOG_INFO("HTTPS test response code: %d, free heap %lu", responseCode, (unsigned long)ESP.getFreeHeap());
   
   testHttp.end();
   return (responseCode > 0);
 }
 
-void processOnlineAttendanceWithFallback(String rfidTag, String timestamp) {
-  Serial.println("Backend URL: " + backendUrl);
+void processOnlineAttendanceWithFallback(String rfidTag, String timestamp, uint32_t seq, uint8_t lane) {
+  LOG_DEBUG("Backend URL: %s", getEffectiveBackendUrl().c_str());
   
   // Determine if we need HTTPS or HTTP
-  bool isHTTPS = backendUrl.startsWith("https://");
+  bool isHTTPS = getEffectiveBackendUrl().startsWith("https://");
   bool useHTTPS = isHTTPS;
   
   // For HTTPS, test connection first
   if (isHTTPS) {
-    Serial.println("Testing HTTPS connectivity...");
-    if (!testHTTPSConnection(backendUrl + "/health")) {
-      Serial.println("HTTPS test failed. You may want to:");
-      Serial.println("1. Check if your ESP8266 has enough memory");
-      Serial.println("2. Verify the SSL certificate");
-      Serial.println("3. Try using HTTP for testing");
-      Serial.println("4. Check network connectivity");
+    LOG_DEBUG("Testing HTTPS connectivity...");
+    if (!testHTTPSConnection(getHealthEndpointUrl())) {
+      // Low heap, a bad certificate or no route; plain HTTP helps tell them apart
+      LOG_WARN("HTTPS test failed");
     }
   }
   
   // Proceed with the actual request
-  processOnlineAttendance(rfidTag, timestamp);
+  processOnlineAttendance(rfidTag, timestamp, seq, lane);
 }
 
 // ========================================
@@ -2301,12 +2967,12 @@ void processOnlineAttendanceWithFallback(String rfidTag, String timestamp) {
 // ========================================
 
 void warmupHTTPSConnection() {
-  Serial.println("Warming up HTTPS connection...");
+  LOG_DEBUG("Warming up HTTPS connection...");
   
   // Configure SSL client with same optimizations
   wifiClientSecure.setInsecure();
   wifiClientSecure.setTimeout(3000); // Short timeout for warmup
-  wifiClientSecure.setBufferSizes(512, 512);
+  memConfigureTls(wifiClientSecure);
   wifiClientSecure.setNoDelay(true);
   
   HTTPClient warmupHttp;
@@ -2315,20 +2981,24 @@ void warmupHTTPSConnection() {
   if (warmupHttp.begin(wifiClientSecure, getEffectiveBackendUrl() + "/health")) {
     warmupHttp.setTimeout(3000);
     
-    int responseCode = warmupHttp.GET();
+    int responseCode;
+    {
+      StallScope net("tls-warmup", STALL_NET);
+      responseCode = warmupHttp.GET();
+    }
     unsigned long warmupTime = millis() - warmupStart;
     
     if (responseCode > 0) {
       // Mark session as established for reuse
       sslSessionValid = true;
-      Serial.println("HTTPS warmup successful: " + String(warmupTime) + "ms (session established)");
+      LOG_INFO("HTTPS warmup successful: %lums (session established)", (unsigned long)warmupTime);
     } else {
-      Serial.println("HTTPS warmup failed: " + String(responseCode));
+      LOG_WARN("HTTPS warmup failed: %d", responseCode);
     }
     
     warmupHttp.end();
   } else {
-    Serial.println("HTTPS warmup connection failed");
+    LOG_WARN("HTTPS warmup connection failed");
   }
 }
 
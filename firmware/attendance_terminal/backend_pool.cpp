@@ -0,0 +1,279 @@
+/*
+ * Backend endpoint pool for Attendee Attendance Terminal v2.0
+ *
+ * Per-endpoint RTT uses the same RFC 6298 smoothing as the circuit breaker
+ * but is fed only by /health probes, so the active endpoint (which also
+ * carries real requests) is compared like for like. An endpoint's score is
+ * SRTT + 4 * RTTVAR scaled up by its error rate, so a fast but flaky
+ * backend loses to a slightly slower steady one. Probes
+ * use their own clients so they never close the sync job's keep-alive
+ * connection.
+ */
+
+#include <ESP8266HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "backend_pool.h"
+#include "circuit_breaker.h"
+#include "event_stream.h"
+#include "offline_sync.h"
+#include "stall_profiler.h"
+#include "memory_governor.h"
+
+// External references from main file
+extern String backendUrl;
+extern bool isOnline;
+extern int offlineLogsCount;
+
+// Function declarations from main file
+extern bool pollForPendingCard();
+
+static BackendEndpoint endpoints[BACKEND_MAX_ENDPOINTS];
+static uint8_t endpointCount = 0;
+static uint8_t activeIndex = 0;
+static uint8_t nextProbe = 0;
+static unsigned long lastProbe = 0;
+static uint32_t failovers = 0;
+
+static WiFiClient probeClient;
+static WiFiClientSecure probeClientSecure;
+
+// ========================================
+// CONFIGURATION
+// ========================================
+
+void backendPoolSetUrls(const String* urls, uint8_t count) {
+  endpointCount = 0;
+  for (uint8_t i = 0; i < count && endpointCount < BACKEND_MAX_ENDPOINTS; i++) {
+    if (urls[i].length() == 0) {
+      continue;
+    }
+    BackendEndpoint& endpoint = endpoints[endpointCount++];
+    endpoint = BackendEndpoint();
+    endpoint.url = urls[i];
+  }
+  activeIndex = 0;
+  nextProbe = 0;
+}
+
+uint8_t backendPoolCount() {
+  return endpointCount;
+}
+
+const String& backendPoolUrl(uint8_t index) {
+  return index < endpointCount ? endpoints[index].url : backendUrl;
+}
+
+const String& backendPoolActiveUrl() {
+  return endpointCount > 0 ? endpoints[activeIndex].url : backendUrl;
+}
+
+// ========================================
+// STATISTICS
+// ========================================
+
+static void recordRtt(BackendEndpoint& endpoint, unsigned long rttMs) {
+  if (endpoint.srttMs == 0) {
+    endpoint.srttMs = rttMs > 0 ? rttMs : 1;
+    endpoint.rttVarMs = rttMs / 2;
+  } else {
+    uint32_t delta = (rttMs > endpoint.srttMs) ? rttMs - endpoint.srttMs : endpoint.srttMs - rttMs;
+    endpoint.rttVarMs = (3 * endpoint.rttVarMs + delta) / 4;
+    endpoint.srttMs = (7 * endpoint.srttMs + rttMs) / 8;
+  }
+}
+
+static void recordSuccess(BackendEndpoint& endpoint) {
+  endpoint.requests++;
+  endpoint.consecutiveFailures = 0;
+  endpoint.errorRatePermille = (endpoint.errorRatePermille * 7) / 8;
+}
+
+static void recordFailure(BackendEndpoint& endpoint) {
+  endpoint.requests++;
+  endpoint.failures++;
+  if (endpoint.consecutiveFailures < 255) {
+    endpoint.consecutiveFailures++;
+  }
+  endpoint.errorRatePermille = (endpoint.errorRatePermille * 7 + 1000) / 8;
+}
+
+// Request latency includes backend work, so it only counts toward health
+void backendPoolRecordSuccess() {
+  if (endpointCount > 0) {
+    recordSuccess(endpoints[activeIndex]);
+  }
+}
+
+void backendPoolRecordFailure() {
+  if (endpointCount > 0) {
+    recordFailure(endpoints[activeIndex]);
+  }
+}
+
+static bool isHealthy(const BackendEndpoint& endpoint) {
+  return endpoint.consecutiveFailures < BACKEND_UNHEALTHY_FAILURES;
+}
+
+// Lower is better; endpoints never measured score as unknown (0)
+static uint32_t score(const BackendEndpoint& endpoint) {
+  if (endpoint.srttMs == 0) {
+    return 0;
+  }
+  uint32_t base = endpoint.srttMs + 4 * endpoint.rttVarMs;
+  return base * (1000 + 4 * (uint32_t)endpoint.errorRatePermille) / 1000;
+}
+
+// ========================================
+// SELECTION
+// ========================================
+
+static void switchTo(uint8_t index, const char* reason) {
+  LOG_WARN("Backend failover (%s): %s -> %s", reason, endpoints[activeIndex].url.c_str(),
+           endpoints[index].url.c_str());
+  activeIndex = index;
+  failovers++;
+
+  // RTT history and any open state belong to the old endpoint
+  breakerReset();
+  publishConnectivityEvent(true, "backend-failover");
+
+  // Offline taps (including any that failed during the switch) go to the
+  // new endpoint right away
+  if (offlineLogsCount > 0) {
+    startOfflineSync();
+  }
+}
+
+static void selectEndpoint() {
+  const BackendEndpoint& active = endpoints[activeIndex];
+  bool activeHealthy = isHealthy(active) && getBreakerStats().state == BREAKER_CLOSED;
+
+  // Best measured healthy endpoint, ties broken by configured order
+  int best = -1;
+  for (uint8_t i = 0; i < endpointCount; i++) {
+    if (i == activeIndex || !isHealthy(endpoints[i]) || score(endpoints[i]) == 0) {
+      continue;
+    }
+    if (best < 0 || score(endpoints[i]) < score(endpoints[best])) {
+      best = i;
+    }
+  }
+
+  if (!activeHealthy) {
+    if (best < 0) {
+      // Nothing measured yet; fall to the next endpoint in preference order
+      for (uint8_t i = 1; i < endpointCount; i++) {
+        uint8_t candidate = (activeIndex + i) % endpointCount;
+        if (isHealthy(endpoints[candidate])) {
+          best = candidate;
+          break;
+        }
+      }
+    }
+    if (best >= 0) {
+      switchTo(best, "unreachable");
+    }
+    return;
+  }
+
+  uint32_t activeScore = score(active);
+  if (best >= 0 && activeScore > 0 &&
+      score(endpoints[best]) * 100 < activeScore * (100 - BACKEND_SWITCH_MARGIN_PCT)) {
+    switchTo(best, "lower latency");
+  }
+}
+
+// ========================================
+// BACKGROUND PROBES
+// ========================================
+
+static void probeEndpoint(BackendEndpoint& endpoint) {
+  String url = endpoint.url;
+  if (url.endsWith("/")) {
+    url.remove(url.length() - 1);
+  }
+  url += "/health";
+
+  HTTPClient probeHttp;
+  if (url.startsWith("https://")) {
+    probeClientSecure.setInsecure();
+    memConfigureTls(probeClientSecure);
+    probeClientSecure.setTimeout(BREAKER_PROBE_TIMEOUT_MS);
+    probeHttp.begin(probeClientSecure, url);
+  } else {
+    probeHttp.begin(probeClient, url);
+  }
+  probeHttp.setTimeout(BREAKER_PROBE_TIMEOUT_MS);
+
+  unsigned long start = millis();
+  int code;
+  {
+    StallScope net("pool-probe", STALL_NET);
+    code = probeHttp.GET();
+  }
+  unsigned long rtt = millis() - start;
+  probeHttp.end();
+
+  endpoint.lastProbeAt = millis();
+  if (code == 200) {
+    recordRtt(endpoint, rtt);
+    recordSuccess(endpoint);
+  } else {
+    recordFailure(endpoint);
+    LOG_DEBUG("Backend probe failed for %s: HTTP %d", endpoint.url.c_str(), code);
+  }
+}
+
+void serviceBackendPool() {
+  if (endpointCount < 2) {
+    return; // The breaker's half-open probe covers a single backend
+  }
+
+  selectEndpoint();
+
+  if (!isOnline || !memNetworkAllowed() || millis() - lastProbe < BACKEND_PROBE_INTERVAL_MS) {
+    return;
+  }
+  // Never make a student wait on a probe
+  if (pollForPendingCard()) {
+    return;
+  }
+  lastProbe = millis();
+
+  // While the breaker is open the active endpoint has its own half-open probe
+  uint8_t index = nextProbe;
+  nextProbe = (nextProbe + 1) % endpointCount;
+  if (index == activeIndex && getBreakerStats().state != BREAKER_CLOSED) {
+    return;
+  }
+  probeEndpoint(endpoints[index]);
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+uint32_t backendPoolFailovers() {
+  return failovers;
+}
+
+void backendPoolToJson(JsonArray out) {
+  for (uint8_t i = 0; i < endpointCount; i++) {
+    const BackendEndpoint& endpoint = endpoints[i];
+    JsonObject entry = out.createNestedObject();
+    entry["url"] = endpoint.url.c_str();
+    entry["active"] = i == activeIndex;
+    entry["healthy"] = isHealthy(endpoint);
+    entry["srttMs"] = endpoint.srttMs;
+    entry["rttVarMs"] = endpoint.rttVarMs;
+    entry["requests"] = endpoint.requests;
+    entry["failures"] = endpoint.failures;
+    entry["errorRatePct"] = endpoint.errorRatePermille / 10.0;
+    if (endpoint.lastProbeAt > 0) {
+      entry["lastProbeAgoMs"] = millis() - endpoint.lastProbeAt;
+    }
+  }
+}
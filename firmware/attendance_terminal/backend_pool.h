@@ -0,0 +1,51 @@
+/*
+ * Backend endpoint pool with latency-based selection
+ * Attendee Attendance Terminal v2.0
+ *
+ * /config.json may list several backends in order of preference
+ * ("backendUrls", e.g. an on-prem server first and the cloud second). All
+ * tap, sync and heartbeat traffic goes to the active endpoint. Its request
+ * outcomes are reported through the circuit breaker; the others are kept
+ * current by one cheap /health probe every BACKEND_PROBE_INTERVAL_MS.
+ *
+ * The active endpoint is replaced when it stops answering and another one
+ * is healthy, or when a healthy one is BACKEND_SWITCH_MARGIN_PCT faster.
+ * Taps taken while switching are already in offline storage and the sync
+ * job resumes against the new endpoint, which dedupes on deviceId + seq.
+ */
+
+#ifndef BACKEND_POOL_H
+#define BACKEND_POOL_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+struct BackendEndpoint {
+  String url;
+  uint32_t srttMs;              // Smoothed RTT, 0 until the first sample
+  uint32_t rttVarMs;
+  uint8_t consecutiveFailures;
+  uint32_t requests;
+  uint32_t failures;
+  uint16_t errorRatePermille;   // EWMA of failures, gain 1/8
+  unsigned long lastProbeAt;
+};
+
+// Configuration
+void backendPoolSetUrls(const String* urls, uint8_t count);
+uint8_t backendPoolCount();
+const String& backendPoolUrl(uint8_t index);
+
+// Routing
+const String& backendPoolActiveUrl();
+void serviceBackendPool();
+
+// Outcome reporting for the active endpoint (from the circuit breaker)
+void backendPoolRecordSuccess();
+void backendPoolRecordFailure();
+
+// Status
+uint32_t backendPoolFailovers();
+void backendPoolToJson(JsonArray out);
+
+#endif // BACKEND_POOL_H
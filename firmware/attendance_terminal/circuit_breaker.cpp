@@ -0,0 +1,150 @@
+/*
+ * Backend circuit breaker for Attendee Attendance Terminal v2.0
+ *
+ * RTT smoothing follows the TCP retransmit timer (RFC 6298): SRTT with
+ * gain 1/8, RTTVAR with gain 1/4, timeout = SRTT + 4 * RTTVAR, all in
+ * integer milliseconds.
+ */
+
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "circuit_breaker.h"
+#include "event_stream.h"
+#include "backend_pool.h"
+
+static BreakerStats breaker = {
+  BREAKER_CLOSED,
+  BREAKER_INITIAL_RTT_MS,
+  BREAKER_INITIAL_RTT_MS / 2,
+  0,
+  0,
+  0,
+  0,
+  BREAKER_COOLDOWN_MS
+};
+static bool haveRttSample = false;
+
+// ========================================
+// STATE TRANSITIONS
+// ========================================
+
+static void openBreaker() {
+  breaker.state = BREAKER_OPEN;
+  breaker.openedAt = millis();
+  breaker.openCount++;
+  LOG_WARN("Backend circuit breaker OPEN - taps go to offline storage");
+  publishConnectivityEvent(false, "breaker-open");
+}
+
+static void closeBreaker() {
+  breaker.state = BREAKER_CLOSED;
+  breaker.consecutiveFailures = 0;
+  breaker.cooldownMs = BREAKER_COOLDOWN_MS;
+  LOG_INFO("Backend circuit breaker CLOSED");
+  publishConnectivityEvent(true, "breaker-closed");
+}
+
+// ========================================
+// REQUEST GATING
+// ========================================
+
+// Only a closed breaker lets tap and sync traffic through. Probing is done
+// by the caller of breakerProbeDue() so no student waits on a dead backend.
+bool breakerAllowRequest() {
+  if (breaker.state == BREAKER_CLOSED) {
+    return true;
+  }
+  breaker.shortCircuits++;
+  return false;
+}
+
+bool breakerProbeDue() {
+  if (breaker.state != BREAKER_OPEN) {
+    return false;
+  }
+  if (millis() - breaker.openedAt < breaker.cooldownMs) {
+    return false;
+  }
+  breaker.state = BREAKER_HALF_OPEN;
+  return true;
+}
+
+uint16_t breakerTimeoutMs() {
+  uint32_t timeout = breaker.srttMs + 4 * breaker.rttVarMs;
+  if (timeout < BREAKER_MIN_TIMEOUT_MS) {
+    timeout = BREAKER_MIN_TIMEOUT_MS;
+  } else if (timeout > BREAKER_MAX_TIMEOUT_MS) {
+    timeout = BREAKER_MAX_TIMEOUT_MS;
+  }
+  return (uint16_t)timeout;
+}
+
+// ========================================
+// OUTCOME REPORTING
+// ========================================
+
+// Outcomes also feed the per-endpoint stats of whichever backend is active
+void breakerRecordSuccess(unsigned long rttMs) {
+  backendPoolRecordSuccess();
+  if (!haveRttSample) {
+    breaker.srttMs = rttMs;
+    breaker.rttVarMs = rttMs / 2;
+    haveRttSample = true;
+  } else {
+    uint32_t delta = (rttMs > breaker.srttMs) ? rttMs - breaker.srttMs : breaker.srttMs - rttMs;
+    breaker.rttVarMs = (3 * breaker.rttVarMs + delta) / 4;
+    breaker.srttMs = (7 * breaker.srttMs + rttMs) / 8;
+  }
+
+  if (breaker.state != BREAKER_CLOSED) {
+    closeBreaker();
+  }
+  breaker.consecutiveFailures = 0;
+}
+
+void breakerRecordFailure() {
+  backendPoolRecordFailure();
+  if (breaker.state == BREAKER_HALF_OPEN) {
+    // Probe failed: back off before the next one
+    breaker.cooldownMs = min((unsigned long)BREAKER_MAX_COOLDOWN_MS, breaker.cooldownMs * 2);
+    openBreaker();
+    return;
+  }
+
+  if (breaker.consecutiveFailures < 255) {
+    breaker.consecutiveFailures++;
+  }
+  if (breaker.state == BREAKER_CLOSED && breaker.consecutiveFailures >= BREAKER_FAILURE_THRESHOLD) {
+    openBreaker();
+  }
+}
+
+// Called when the backend URL or network changes; old RTT data is meaningless
+void breakerReset() {
+  breaker.state = BREAKER_CLOSED;
+  breaker.srttMs = BREAKER_INITIAL_RTT_MS;
+  breaker.rttVarMs = BREAKER_INITIAL_RTT_MS / 2;
+  breaker.consecutiveFailures = 0;
+  breaker.cooldownMs = BREAKER_COOLDOWN_MS;
+  haveRttSample = false;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+const BreakerStats& getBreakerStats() {
+  return breaker;
+}
+
+const char* breakerStateName() {
+  switch (breaker.state) {
+    case BREAKER_OPEN:
+      return "open";
+    case BREAKER_HALF_OPEN:
+      return "half-open";
+    default:
+      return "closed";
+  }
+}
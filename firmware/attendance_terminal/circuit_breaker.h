@@ -0,0 +1,47 @@
+/*
+ * Backend circuit breaker with RTT-adaptive timeouts
+ * Attendee Attendance Terminal v2.0
+ *
+ * Tracks backend round-trip time with an EWMA and derives request timeouts
+ * from it. After BREAKER_FAILURE_THRESHOLD consecutive failures the breaker
+ * opens and taps go straight to offline storage; a background /health
+ * probe half-opens it once the cooldown has elapsed.
+ */
+
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <Arduino.h>
+
+enum BreakerState {
+  BREAKER_CLOSED,     // Backend healthy, requests allowed
+  BREAKER_OPEN,       // Backend failing, requests short-circuit to offline
+  BREAKER_HALF_OPEN   // Probe in progress
+};
+
+struct BreakerStats {
+  BreakerState state;
+  uint32_t srttMs;              // Smoothed RTT
+  uint32_t rttVarMs;            // Smoothed RTT deviation
+  uint8_t consecutiveFailures;
+  uint32_t openCount;           // Times the breaker has opened since boot
+  uint32_t shortCircuits;       // Requests refused while open
+  unsigned long openedAt;       // millis() when last opened
+  unsigned long cooldownMs;     // Current wait before the next probe
+};
+
+// Request gating
+bool breakerAllowRequest();
+bool breakerProbeDue();
+uint16_t breakerTimeoutMs();
+
+// Outcome reporting
+void breakerRecordSuccess(unsigned long rttMs);
+void breakerRecordFailure();
+void breakerReset();
+
+// Status
+const BreakerStats& getBreakerStats();
+const char* breakerStateName();
+
+#endif // CIRCUIT_BREAKER_H
@@ -17,6 +17,8 @@
 // RFID RC522 Pins (SPI Interface)
 #define RFID_SS_PIN     15    // D8 - SPI SS (Slave Select)
 #define RFID_RST_PIN    -1     // D3 - Reset pin (optional, can be -1 if not used)
+#define RFID_EXIT_SS_PIN -1    // Second reader's SS for an exit lane; -1 = single reader. The only pin left
+                               // on a D1 mini is 3 (RX): serial then runs TX-only and the boot reset prompt is compiled out
 
 // I2C Pins (LCD & RTC) - MOVED TO AVOID SPI CONFLICT
 #define SDA_PIN         4     // D2 - I2C SDA (was conflicting with MISO)
@@ -55,6 +57,18 @@
 #define LCD_COLS        16    // Number of columns
 #define LCD_ROWS        2     // Number of rows
 
+// Display panels fitted. An unfitted panel's driver, buffers, fonts and
+// animations compile out; display_frontend.h picks the backends.
+#define DISPLAY_LCD_FITTED true         // 1602 LCD on the PCF8574 backpack
+#define DISPLAY_OLED_FITTED true        // 128x64 SSD1306
+
+// Shared I2C bus (LCD, OLED, RTC)
+#define I2C_CLOCK_HZ 400000             // Fast mode, supported by all three devices
+#define I2C_STRETCH_LIMIT_US 1000       // Longest a slave may hold SCL low
+#define I2C_SLICE_US 3000               // Queued transfer time per serviceI2cBus() call
+#define I2C_STUCK_ERRORS 3              // Bus errors (line busy, timeout) in a row before recovery
+#define I2C_LINE_CHECK_MS 1000          // Idle check for a line held low
+
 // ========================================
 // NETWORK CONFIGURATION
 // ========================================
@@ -76,6 +90,20 @@
 #define IST_OFFSET   (5*3600 + 30*60) // IST offset in seconds
 #define DAYLIGHT_OFFSET_SEC 0       // 24 hours in seconds
 
+// Software clock (RAM clock disciplined by the DS3231 and background SNTP)
+#define RTC_SQW_PIN -1                  // DS3231 SQW 1 Hz output (falling edge = new second); -1 = not wired, poll instead
+#define CLOCK_TICK_MS 1000              // Re-anchor and slew step interval
+#define CLOCK_RTC_RESYNC_MS (10UL*60UL*1000UL)     // Read the DS3231 this often
+#define CLOCK_RTC_POLL_MS 20            // Seconds-edge polling interval when SQW is not wired
+#define CLOCK_RTC_WINDOW_MS 3000        // Give up on one edge search after this long
+#define CLOCK_STEP_THRESHOLD_MS 2000    // Larger offsets are stepped, smaller ones slewed
+#define CLOCK_MAX_SLEW_PPM 5000         // Slew at most 5 ms per second of real time
+#define CLOCK_MAX_DRIFT_PPM 1000        // Discard drift samples beyond this (reference jumped)
+#define CLOCK_NTP_FRESH_MS (2UL*60UL*60UL*1000UL)  // NTP disciplines the clock while this recent
+#define CLOCK_RTC_WRITE_THRESHOLD_MS 250 // Rewrite the DS3231 when NTP shows it off by this much
+#define CLOCK_RTC_DRIFT_MIN_INTERVAL_MS (6UL*60UL*60UL*1000UL) // Span needed to estimate DS3231 drift
+#define CLOCK_AGING_MAX_STEP 5          // DS3231 aging trim change per estimate (~0.1 ppm per LSB)
+
 // ========================================
 // TIMING CONFIGURATION
 // ========================================
@@ -83,11 +111,86 @@
 #define HEARTBEAT_INTERVAL 600000      // 10 minutes in milliseconds (10 * 60 * 1000)
 #define SYNC_RETRY_INTERVAL 10*60*1000  // 1 minute in milliseconds
 #define CARD_READ_DELAY 2000            // Prevent duplicate reads (2 seconds)
+#define RFID_FEEDBACK_POLL_MS 10        // Other-lane poll period during tap feedback delays
 #define LED_DISPLAY_DURATION 2000       // How long to show LED status (2 seconds)
 #define BUZZER_SUCCESS_DURATION 200     // Success beep duration
 #define BUZZER_ERROR_DURATION 500       // Error beep duration
 #define BUZZER_OFFLINE_DURATION 300     // Offline beep duration
 
+// Cooperative scheduler (task_sched.cpp); loop() sleeps until the next task is due
+#define SCHED_MAX_TASKS 20              // At most 32: wake-ups are bits in one word
+#define SCHED_TICK_MS 5                 // Timer wheel resolution
+#define SCHED_RFID_MS 25                // Card reader poll
+#define SCHED_DISPLAY_MS 10             // Animation frames and queued I2C transfers
+#define SCHED_NETWORK_MS 20             // Web server, MQTT and gossip sockets
+#define SCHED_JOBS_MS 50                // API jobs, event stream, offline sync slices, LED
+#define SCHED_CLOCK_MS CLOCK_RTC_POLL_MS // Soft clock, fast enough for edge polling
+#define SCHED_HOUSEKEEPING_MS 100       // Offline staging, antenna gain
+#define SCHED_BACKEND_MS 250            // Breaker probe and backend pool
+#define SCHED_WATCHDOG_MS 1000          // Reconnect, RFID re-init and heartbeat checks
+#define SCHED_WIFI_CHECK_MS 30000       // WiFi connection check
+
+// Loop stall profiler (stall_profiler.cpp); top stalls survive soft resets in RTC memory
+#define STALL_THRESHOLD_MS 100          // Passes this long count as stalls
+#define STALL_TOP_COUNT 4               // Longest stalls kept
+#define STALL_MAX_DEPTH 4               // Nested tag scopes tracked
+#define STALL_PERSIST_MS 10000          // Histogram write-back interval to RTC memory
+
+// Static arena for JSON documents and HTTP text (json_arena.cpp); spills go to the heap
+#define JSON_ARENA_SIZE 6144            // Largest user: scheduler section of /api/status plus one chunk; at most 65535
+#define ARENA_CHUNK_SIZE 512            // Response text buffer for arenaSendJson() and ArenaJsonStream
+#define ARENA_MAX_SITES 24              // Call sites with their own high-water mark
+
+// Memory-pressure governor (memory_governor.cpp); a level applies when free heap or largest block is below it
+#define SCHED_MEMORY_MS 250             // Heap sample interval
+#define MEM_TIGHT_FREE 16384            // Shrink TLS buffers, close the idle TLS connection
+#define MEM_TIGHT_BLOCK 8192
+#define MEM_LOW_FREE 11264              // Also stop OLED animations, smaller sync slices
+#define MEM_LOW_BLOCK 5120
+#define MEM_CRITICAL_FREE 7168          // Offline-only
+#define MEM_CRITICAL_BLOCK 3072
+#define MEM_HYSTERESIS_BYTES 2048       // Margin above a threshold before easing past it
+#define MEM_RESTORE_MS 5000             // Margin held this long before each step down
+#define MEM_TLS_RX_BUFFER 1024          // BearSSL receive buffer (MFLN) at NORMAL
+#define MEM_TLS_RX_BUFFER_MIN 512       // From TIGHT on; the smallest MFLN size
+#define MEM_TLS_TX_BUFFER 512
+#define MEM_SYNC_BATCH_LOW 1            // Records per sync slice from LOW on
+
+// Offline sync job time slicing (sync runs a bounded slice per loop iteration)
+#define SYNC_SLICE_MAX_RECORDS 4        // Records submitted per slice, pipelined on one connection
+#define SYNC_SLICE_BUDGET_MS 400        // Stop starting new records after this long
+#define SYNC_MAX_CONSECUTIVE_FAILURES 3 // Pause job until next retry after this many failures
+
+// Offline write group commit (taps are staged in RTC memory between commits)
+#define OFFLINE_GROUP_COMMIT_COUNT 8    // Commit once this many taps are staged
+#define OFFLINE_GROUP_COMMIT_AGE_MS 60000UL // ...or once the oldest staged tap is this old
+#define OFFLINE_FLUSH_VCC_MV 2900       // ...or at once when VCC sags below this (mV)
+#define OFFLINE_VCC_CHECK_MS 500        // VCC sampling interval while records are staged
+
+// MQTT transport (used instead of per-tap HTTP when an mqttBroker is configured)
+#define MQTT_DEFAULT_PORT 1883
+#define MQTT_TOPIC_ROOT "attendee"      // Topics are attendee/<deviceId>/{tap,status,cmd,result}
+#define MQTT_KEEPALIVE_S 30             // Broker drops the session (and sends the will) after 1.5x this
+#define MQTT_INFLIGHT_MAX 4             // Taps published but not yet PUBACKed
+#define MQTT_ACK_TIMEOUT_MS 5000        // Resend with DUP after this long without a PUBACK
+#define MQTT_CONNACK_TIMEOUT_MS 5000
+#define MQTT_RECONNECT_MS 15000         // Wait between connection attempts
+
+// LAN peer gossip of taps between terminals (UDP multicast, same subnet)
+#define PEER_GOSSIP_ENABLED true
+#define PEER_MULTICAST_GROUP "239.255.42.99"
+#define PEER_MULTICAST_PORT 4210
+#define PEER_DUPLICATE_WINDOW_S 120     // A tap this soon after one at any gate is a duplicate
+#define PEER_MAX_SKEW_S 10              // Peer taps further ahead of our clock than this are ignored
+#define PEER_LEDGER_SIZE 256            // Students remembered per day (4-way buckets, oldest evicted)
+#define PEER_OUTBOX_SIZE 8              // Own recent taps carried in every packet
+#define PEER_EVENT_SENDS 3              // Each tap is sent this many times to ride out packet loss
+#define PEER_RESEND_MS 1500             // Interval between repeat packets
+
+// Attendance event sequence numbers (backend dedupes on deviceId + seq)
+#define EVENT_SEQ_LEASE 64              // Numbers reserved per flash write; a power cut skips the rest
+#define EVENT_SEQ_SEED_RETRY_MS 30000   // Backend query interval while the counter is unseeded
+
 // ========================================
 // AUDIO FEEDBACK CONFIGURATION - ENHANCED
 // ========================================
@@ -126,7 +229,7 @@
 // ========================================
 
 // Maximum number of offline logs to store
-#define MAX_OFFLINE_LOGS 1000
+#define MAX_OFFLINE_LOGS 30000
 
 // RFID read timeout and retry settings
 #define RFID_READ_TIMEOUT 100
@@ -138,6 +241,20 @@
 #define RFID_GAIN_MIN       0x01        // Minimum antenna gain
 #define RFID_DEFAULT_GAIN   RFID_GAIN_AVG
 
+// Adaptive antenna gain (steps the RxGain bits of RFCfgReg, see rfid_gain.h)
+#define RFID_GAIN_WINDOW 24             // Read attempts judged per decision
+#define RFID_GAIN_TARGET_FAIL_PCT 5     // Gain is left alone while failures stay at or below this
+#define RFID_PHANTOM_MS 1500            // A failed read with no good read this soon after is a phantom
+
+// RC522 SPI driver (see rfid_spi.h)
+#define RFID_SPI_MAX_HZ 10000000UL      // RC522 datasheet limit, tried first at init
+#define RFID_SPI_SAFE_HZ 4000000UL      // Stock MFRC522DriverSPI clock, always used as the fallback
+#define RFID_SPI_VERIFY_ROUNDS 4        // FIFO loopback patterns that must survive at a clock
+#define RFID_TIMER_RELOAD 80            // Timeout in 25 us ticks (2 ms, library default 25 ms)
+#define RFID_BENCH_PHASE_MS 2000        // Poll-rate measurement time per driver
+#define RFID_BENCH_READS 16             // UID reads timed per driver when a card is on the reader
+#define RFID_BENCH_CARD_WAIT_MS 10000   // How long the benchmark waits for a card before skipping reads
+
 // Periodic RFID maintenance to recover from reader stalls
 #define RFID_MAINTENANCE_INTERVAL_MS (5UL * 60UL * 1000UL)   // Re-init every 5 minutes
 #define RFID_REINIT_IF_IDLE_MS       (15UL * 60UL * 1000UL)  // If idle >15 minutes, force re-init
@@ -158,8 +275,17 @@
 #define SETTINGS_SIZE 50
 
 // LittleFS file paths - Primary storage system
-#define OFFLINE_LOGS_FILE "/offline_logs.txt"
+#define OFFLINE_LOGS_FILE "/offline_logs.bin"      // Block store, see offline_store.h
+#define OFFLINE_UIDS_FILE "/offline_uids.bin"      // UID dictionary for OFFLINE_LOGS_FILE
+#define OFFLINE_DEFER_FILE "/offline_defer.bin"    // Records that failed during the current sync pass
+#define OFFLINE_DEFER_UIDS_FILE "/offline_defer_uids.bin"
+#define OFFLINE_LEGACY_LOGS_FILE "/offline_logs.txt"     // JSON-lines log of older firmware, migrated at boot
+#define OFFLINE_LEGACY_DEFER_FILE "/offline_logs.defer"
+#define SYNC_CURSOR_FILE "/sync_cursor.txt"        // Record cursor of the sync job in OFFLINE_LOGS_FILE
+#define EVENT_SEQ_FILE "/event_seq.txt"            // End of the current sequence number lease
+#define RFID_GAIN_FILE "/rfid_gain.txt"            // Antenna gain chosen by the adaptive controller
 #define CONFIG_FILE "/config.json"
+#define DEVICE_KEY_FILE "/device_key.txt"          // Backend device key; kept out of CONFIG_FILE, which can be downloaded
 #define WIFI_CONFIG_FILE "/wifi_config.json"
 #define MIGRATION_FLAG_FILE "/migration_complete.flag"
 
@@ -175,23 +301,18 @@
 // DEBUGGING CONFIGURATION
 // ========================================
 
-#define DEBUG_ENABLED true              // Enable serial debugging
 #define DEBUG_BAUD_RATE 115200          // Serial baud rate
 #define DEBUG_WIFI_CONNECTION true      // Debug WiFi connection
 #define DEBUG_RFID true                 // Debug RFID operations
 #define DEBUG_HTTP true                 // Debug HTTP requests
 #define DEBUG_RTC true                  // Debug RTC operations
+#define TEST_TAP_INJECTION false        // POST /api/test/tap simulates a card; test builds only, never ship
 
-// Debug macros
-#if DEBUG_ENABLED
-  #define DEBUG_PRINT(x) Serial.print(x)
-  #define DEBUG_PRINTLN(x) Serial.println(x)
-  #define DEBUG_PRINTF(format, ...) Serial.printf(format, ##__VA_ARGS__)
-#else
-  #define DEBUG_PRINT(x)
-  #define DEBUG_PRINTLN(x)
-  #define DEBUG_PRINTF(format, ...)
-#endif
+// Logging (debug_log.h): LOG_ERROR() .. LOG_DEBUG() above LOG_LEVEL compile out
+#define LOG_LEVEL 3                     // 0 off, 1 errors, 2 +warnings, 3 +info, 4 +debug
+#define LOG_SERIAL true                 // Mirror lines to the UART while its FIFO has room
+#define LOG_RING_SIZE 2048              // RAM ring served at /api/debug/log
+#define LOG_LINE_MAX 128                // Longest line with its prefix; the UART FIFO is 128 bytes
 
 // ========================================
 // SECURITY CONFIGURATION
@@ -204,6 +325,21 @@
 #define HTTP_TIMEOUT 10000              // 10 seconds
 #define HTTP_RETRY_COUNT 3              // Number of retries for failed requests
 
+// Backend circuit breaker (RTT-adaptive request timeouts)
+#define BREAKER_FAILURE_THRESHOLD 3     // Consecutive failures before opening
+#define BREAKER_MIN_TIMEOUT_MS 800      // Lower clamp for derived timeouts
+#define BREAKER_MAX_TIMEOUT_MS 5000     // Upper clamp (the old fixed tap timeout)
+#define BREAKER_INITIAL_RTT_MS 600      // RTT estimate before any sample
+#define BREAKER_COOLDOWN_MS 15000       // First wait before a half-open probe
+#define BREAKER_MAX_COOLDOWN_MS 120000  // Cooldown doubles up to this after failed probes
+#define BREAKER_PROBE_TIMEOUT_MS 1500   // Timeout for background /health probes
+
+// Backend endpoint pool (ordered "backendUrls" in /config.json)
+#define BACKEND_MAX_ENDPOINTS 4         // On-prem, cloud and a couple of spares
+#define BACKEND_PROBE_INTERVAL_MS 20000 // One background /health probe per interval, round robin
+#define BACKEND_UNHEALTHY_FAILURES 2    // Consecutive failures before an endpoint is passed over
+#define BACKEND_SWITCH_MARGIN_PCT 25    // A healthy endpoint must be this much faster to take over
+
 // ========================================
 // POWER MANAGEMENT
 // ========================================
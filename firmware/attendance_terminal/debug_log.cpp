@@ -0,0 +1,140 @@
+/*
+ * Leveled logging - Attendee Attendance Terminal v2.0
+ *
+ * The ring is a byte buffer of whole lines, each ending in '\n'. To make
+ * room for a new line, whole lines are dropped from the oldest end.
+ * Line format: "<uptime s>.<ms> <E|W|I|D> <message>".
+ */
+
+#include <stdarg.h>
+#include "debug_log.h"
+
+struct DebugLogStats {
+  uint32_t lines;
+  uint32_t evicted;             // Pushed out of the ring by newer lines
+  uint32_t truncated;           // Longer than LOG_LINE_MAX
+  uint32_t serialDropped;       // Left off the UART because its FIFO was full
+};
+
+static const char LEVEL_CHARS[] = "-EWID";
+
+static char ring[LOG_RING_SIZE];
+static size_t ringHead = 0;      // Next byte written
+static size_t ringUsed = 0;
+static DebugLogStats stats;
+static bool serialBlocking = true;
+
+// ========================================
+// RING
+// ========================================
+
+static size_t ringTail() {
+  return (ringHead + LOG_RING_SIZE - ringUsed) % LOG_RING_SIZE;
+}
+
+static void evictOldestLine() {
+  size_t tail = ringTail();
+  while (ringUsed > 0) {
+    char c = ring[tail];
+    tail = (tail + 1) % LOG_RING_SIZE;
+    ringUsed--;
+    if (c == '\n') {
+      break;
+    }
+  }
+  stats.evicted++;
+}
+
+static void ringAppend(const char* line, size_t len) {
+  while (LOG_RING_SIZE - ringUsed < len) {
+    evictOldestLine();
+  }
+  size_t first = LOG_RING_SIZE - ringHead;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(ring + ringHead, line, first);
+  memcpy(ring, line + first, len - first);
+  ringHead = (ringHead + len) % LOG_RING_SIZE;
+  ringUsed += len;
+}
+
+// ========================================
+// WRITING
+// ========================================
+
+void logWrite(uint8_t level, PGM_P format, ...) {
+  char line[LOG_LINE_MAX];
+  unsigned long now = millis();
+  int prefix = snprintf_P(line, sizeof(line), PSTR("%lu.%03lu %c "),
+                          now / 1000, now % 1000, LEVEL_CHARS[level <= LOG_LEVEL_DEBUG ? level : 0]);
+
+  // One byte is kept back for the newline
+  size_t room = sizeof(line) - prefix - 1;
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf_P(line + prefix, room, format, args);
+  va_end(args);
+  if (len < 0) {
+    len = 0;
+  } else if ((size_t)len >= room) {
+    len = room - 1;
+    stats.truncated++;
+  }
+  size_t total = prefix + len;
+  line[total++] = '\n';
+
+  ringAppend(line, total);
+  stats.lines++;
+
+#if LOG_SERIAL
+  if (serialBlocking || Serial.availableForWrite() >= (int)total) {
+    Serial.write((const uint8_t*)line, total);
+  } else {
+    stats.serialDropped++;
+  }
+#endif
+}
+
+void debugLogSetSerialBlocking(bool blocking) {
+  serialBlocking = blocking;
+}
+
+// ========================================
+// DOWNLOAD AND STATUS
+// ========================================
+
+void writeDebugLog(ESP8266WebServer& server) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; charset=utf-8", "");
+
+  // At most two pieces, split where the ring wraps
+  size_t tail = ringTail();
+  size_t first = LOG_RING_SIZE - tail;
+  if (first > ringUsed) {
+    first = ringUsed;
+  }
+  size_t second = ringUsed - first;
+  if (first > 0) {
+    server.sendContent(ring + tail, first);
+  }
+  if (second > 0) {
+    server.sendContent(ring, second);
+  }
+  server.sendContent("");
+}
+
+void clearDebugLog() {
+  ringHead = 0;
+  ringUsed = 0;
+}
+
+void debugLogToJson(JsonObject out) {
+  out["level"] = LOG_LEVEL;
+  out["ringBytes"] = LOG_RING_SIZE;
+  out["usedBytes"] = ringUsed;
+  out["lines"] = stats.lines;
+  out["evicted"] = stats.evicted;
+  out["truncated"] = stats.truncated;
+  out["serialDropped"] = stats.serialDropped;
+}
@@ -0,0 +1,72 @@
+/*
+ * Leveled logging for Attendee Attendance Terminal v2.0
+ *
+ *   LOG_ERROR("Failed to open %s", path);
+ *   LOG_INFO("Synced %d logs", count);
+ *
+ * Levels above LOG_LEVEL (config.h) compile to nothing. Their format
+ * strings are not in the image, and their arguments are never evaluated.
+ * A kept format string stays in flash via PSTR(), and is formatted with
+ * vsnprintf_P into a stack buffer, so no String is built. Pass a String
+ * as "%s" with .c_str(). Pass a flash string (F(), PSTR()) as "%S".
+ *
+ * Each line goes into a RAM ring of LOG_RING_SIZE bytes, stamped with the
+ * uptime and level; the oldest lines are dropped to make room. GET
+ * /api/debug/log downloads the ring. With LOG_SERIAL the line is also
+ * written to the UART, but only when its TX FIFO has room. A line that
+ * would block is counted and left out; it is still in the ring.
+ */
+
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESP8266WebServer.h>
+#include "config.h"
+
+#define LOG_LEVEL_OFF 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+void logWrite(uint8_t level, PGM_P format, ...) __attribute__((format(printf, 2, 3)));
+
+#define LOG_AT(level, format, ...) logWrite(level, PSTR(format), ##__VA_ARGS__)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) LOG_AT(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) LOG_AT(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) LOG_AT(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) LOG_AT(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) do {} while (0)
+#endif
+
+// Setup runs with blocking UART writes, so boot logs are complete; loop() must not block
+void debugLogSetSerialBlocking(bool blocking);
+
+// GET /api/debug/log: the ring as text, oldest line first
+void writeDebugLog(ESP8266WebServer& server);
+void clearDebugLog();
+
+// Status: ring fill and lines dropped from the ring and the UART
+void debugLogToJson(JsonObject out);
+
+#endif // DEBUG_LOG_H
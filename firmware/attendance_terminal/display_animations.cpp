@@ -1,118 +1,118 @@
+#include "config.h"
+#if DISPLAY_OLED_FITTED
+
 #include "display_utils.h"
 #include <Arduino.h>
-#include <math.h>
+#include "oled_anim.h"
 
 // Additional animation functions beyond the main display_utils.cpp functions
 // Note: This file contains extended animations that complement the core display functions
 
 // Extended card swipe animation with more visual effects
-void animateCardSwipeExtended() {
-    const int cardWidth = 30;
-    const int cardHeight = 20;
+static void cardSwipeTrailFrame(uint8_t step) {
+    int x = -30 + step * 4;
+    
+    // Draw card
+    drawSwipeCard(x);
     
-    for(int x = -cardWidth; x <= SCREEN_WIDTH; x += 4) {
-        oledDisplay.clearDisplay();
-        
-        // Draw card
-        oledDisplay.drawRoundRect(x, 22, cardWidth, cardHeight, 2, SSD1306_WHITE);
-        oledDisplay.drawLine(x + 5, 32, x + 25, 32, SSD1306_WHITE);
-        
-        // Draw motion lines
-        for(int i = 1; i <= 3; i++) {
-            int lineX = x - i * 8;
-            if(lineX > -10) {
-                oledDisplay.drawLine(lineX, 28, lineX + 5, 28, SSD1306_WHITE);
-                oledDisplay.drawLine(lineX, 36, lineX + 5, 36, SSD1306_WHITE);
-            }
+    // Draw motion lines
+    for(int i = 1; i <= 3; i++) {
+        int lineX = x - i * 8;
+        if(lineX > -10) {
+            oledDisplay.drawLine(lineX, 28, lineX + 5, 28, SSD1306_WHITE);
+            oledDisplay.drawLine(lineX, 36, lineX + 5, 36, SSD1306_WHITE);
         }
-        
-        oledDisplay.display();
-        delay(FRAME_DELAY/2);
     }
 }
 
-// Extended heartbeat animation with pulse effect
-void animateHeartbeatExtended() {
-    const int centerX = 64;
-    const int centerY = 32;
-    const int maxSize = 20;
+// Extended heartbeat animation with pulse effect; the step is the heart size
+#define HEART_MAX_SIZE 20
+#define HEART_MIN_SIZE 10
+
+static void heartPulseFrame(uint8_t size) {
+    drawHeartExtended(64, 32, size);
     
-    for(int size = maxSize; size >= 10; size--) {
-        oledDisplay.clearDisplay();
-        drawHeartExtended(centerX, centerY, size);
-        
-        // Add pulse rings
-        for(int ring = 1; ring <= 3; ring++) {
-            int ringSize = size + ring * 5;
-            if(ringSize <= maxSize + 15) {
-                oledDisplay.drawCircle(centerX, centerY, ringSize, SSD1306_WHITE);
-            }
+    // Add pulse rings
+    for(int ring = 1; ring <= 3; ring++) {
+        int ringSize = size + ring * 5;
+        if(ringSize <= HEART_MAX_SIZE + 15) {
+            oledDisplay.drawCircle(64, 32, ringSize, SSD1306_WHITE);
         }
-        
-        oledDisplay.display();
-        delay(FRAME_DELAY/2);
-    }
-    for(int size = 10; size <= maxSize; size++) {
-        oledDisplay.clearDisplay();
-        drawHeartExtended(centerX, centerY, size);
-        oledDisplay.display();
-        delay(FRAME_DELAY/2);
     }
 }
 
+static void heartFrame(uint8_t size) {
+    drawHeartExtended(64, 32, size);
+}
+
 // Helper function to draw heart shape
 void drawHeartExtended(int x, int y, int size) {
-    float angle = PI/4;
     int radius = size/2;
     
+    // 31 points, 12 degrees apart, starting 45 degrees back
     for(int i = 0; i <= 30; i++) {
-        float a = i * (PI/15) - angle;
-        int hx = x + cos(a) * radius;
-        int hy = y + sin(a) * radius;
+        uint8_t a = i * 256 / 30 - 32;
+        int hx = x + ((radius * animCos(a)) >> 8);
+        int hy = y + ((radius * animSin(a)) >> 8);
         oledDisplay.drawPixel(hx, hy, SSD1306_WHITE);
     }
 }
 
-// Extended sync animation with rotating elements
-void animateSyncExtended() {
+// Extended sync animation with rotating elements, 30 degrees per step
+static void syncSpokesFrame(uint8_t step) {
     const int centerX = 64;
     const int centerY = 32;
     const int radius = 15;
+    uint8_t angle = step * 256 / 12;
     
-    for(int i = 0; i < 360; i += 30) {
-        oledDisplay.clearDisplay();
-        float angle = i * PI / 180;
-        
-        // Draw rotating arrows
-        int x1 = centerX + cos(angle) * radius;
-        int y1 = centerY + sin(angle) * radius;
-        int x2 = centerX + cos(angle + PI) * radius;
-        int y2 = centerY + sin(angle + PI) * radius;
-        
-        oledDisplay.drawLine(centerX, centerY, x1, y1, SSD1306_WHITE);
-        oledDisplay.drawLine(centerX, centerY, x2, y2, SSD1306_WHITE);
-        
-        // Draw arrowheads
-        drawArrowheadExtended(centerX, centerY, x1, y1);
-        drawArrowheadExtended(centerX, centerY, x2, y2);
-        
-        // Draw center circle
-        oledDisplay.drawCircle(centerX, centerY, 3, SSD1306_WHITE);
-        
-        oledDisplay.display();
-        delay(FRAME_DELAY);
-    }
+    // Draw rotating arrows
+    int x1 = centerX + ((radius * animCos(angle)) >> 8);
+    int y1 = centerY + ((radius * animSin(angle)) >> 8);
+    int x2 = centerX + ((radius * animCos(angle + 128)) >> 8);
+    int y2 = centerY + ((radius * animSin(angle + 128)) >> 8);
+    
+    oledDisplay.drawLine(centerX, centerY, x1, y1, SSD1306_WHITE);
+    oledDisplay.drawLine(centerX, centerY, x2, y2, SSD1306_WHITE);
+    
+    // Draw arrowheads
+    drawArrowheadExtended(x1, y1, angle);
+    drawArrowheadExtended(x2, y2, angle + 128);
+    
+    // Draw center circle
+    oledDisplay.drawCircle(centerX, centerY, 3, SSD1306_WHITE);
 }
 
-void drawArrowheadExtended(int x1, int y1, int x2, int y2) {
-    float angle = atan2(y2 - y1, x2 - x1);
-    int arrowSize = 4;
+// Arrowhead at (x, y) pointing along the binary angle
+void drawArrowheadExtended(int x, int y, uint8_t angle) {
+    const int arrowSize = 4;
+    const uint8_t spread = 21;          // 30 degrees
     
-    int ax1 = x2 - arrowSize * cos(angle - PI/6);
-    int ay1 = y2 - arrowSize * sin(angle - PI/6);
-    int ax2 = x2 - arrowSize * cos(angle + PI/6);
-    int ay2 = y2 - arrowSize * sin(angle + PI/6);
+    int ax1 = x - ((arrowSize * animCos(angle - spread)) >> 8);
+    int ay1 = y - ((arrowSize * animSin(angle - spread)) >> 8);
+    int ax2 = x - ((arrowSize * animCos(angle + spread)) >> 8);
+    int ay2 = y - ((arrowSize * animSin(angle + spread)) >> 8);
     
-    oledDisplay.drawLine(x2, y2, ax1, ay1, SSD1306_WHITE);
-    oledDisplay.drawLine(x2, y2, ax2, ay2, SSD1306_WHITE);
+    oledDisplay.drawLine(x, y, ax1, ay1, SSD1306_WHITE);
+    oledDisplay.drawLine(x, y, ax2, ay2, SSD1306_WHITE);
 }
+
+static const AnimKeyframe CARD_SWIPE_TRAIL_FRAMES[] PROGMEM = {
+    { cardSwipeTrailFrame, 0, (SCREEN_WIDTH + 30) / 4, FRAME_DELAY/2, 0 },
+};
+static const AnimKeyframe HEART_PULSE_FRAMES[] PROGMEM = {
+    { heartPulseFrame, HEART_MAX_SIZE, HEART_MIN_SIZE, FRAME_DELAY/2, 0 },
+    { heartFrame, HEART_MIN_SIZE, HEART_MAX_SIZE, FRAME_DELAY/2, 0 },
+};
+static const AnimKeyframe SYNC_SPOKES_FRAMES[] PROGMEM = {
+    { syncSpokesFrame, 0, 11, FRAME_DELAY, 0 },
+};
+
+static const Animation CARD_SWIPE_TRAIL = { "cardSwipeExtended", ANIM_KEYFRAMES(CARD_SWIPE_TRAIL_FRAMES), 0, I2C_PRIO_DECOR };
+static const Animation HEART_PULSE = { "heartbeatExtended", ANIM_KEYFRAMES(HEART_PULSE_FRAMES), 0, I2C_PRIO_DECOR };
+static const Animation SYNC_SPOKES = { "syncExtended", ANIM_KEYFRAMES(SYNC_SPOKES_FRAMES), 0, I2C_PRIO_DECOR };
+
+void animateCardSwipeExtended() { animStart(CARD_SWIPE_TRAIL); }
+void animateHeartbeatExtended() { animStart(HEART_PULSE); }
+void animateSyncExtended() { animStart(SYNC_SPOKES); }
+
+#endif // DISPLAY_OLED_FITTED
@@ -0,0 +1,303 @@
+/*
+ * Display front-end for Attendee Attendance Terminal v2.0
+ *
+ * The sketch drives its displays through one fixed set of semantic calls
+ * on `Display`: ready, processing, result, error, status and
+ * replaceStatus, plus the begin/service/restore hooks. Display is a pair of panel policies chosen
+ * at compile time from DISPLAY_LCD_FITTED and DISPLAY_OLED_FITTED in
+ * config.h. A policy is a struct of static functions. An unfitted panel
+ * is NoPanel, whose empty bodies inline away. Nothing then references the
+ * unfitted panel's driver, framebuffer, font or animations, and the .cpp
+ * files behind them are guarded by the same flags, so they compile out.
+ *
+ * The LCD's screens are the sketch's LCDState machine (setLCDState()),
+ * which also serves as the status vocabulary. The OLED's screens are in
+ * display_utils.cpp.
+ *
+ * Render time per tap: every call from processing(.., 0), the card just
+ * read, to the closing ready() is timed, across both panels. Feedback
+ * frames drain their transfers inside the call, so these are counted;
+ * queued decorative animation frames are not.
+ */
+
+#ifndef DISPLAY_FRONTEND_H
+#define DISPLAY_FRONTEND_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "utils.h"
+
+#if DISPLAY_LCD_FITTED
+#include "lcd_shadow.h"
+#endif
+#if DISPLAY_OLED_FITTED
+#include "display_utils.h"
+#include "oled_anim.h"
+#endif
+
+enum DisplayResult : uint8_t {
+  DISPLAY_RESULT_LOGGED,        // Entry or exit recorded
+  DISPLAY_RESULT_SENT,          // Handed off, outcome to follow
+  DISPLAY_RESULT_NOTICE         // Duplicate, stored offline and the like
+};
+
+struct NoPanel {
+  static void begin() {}
+  static void service() {}
+  static void restore() {}
+  static void ready() {}
+  static void processing(const char* message, int progress) {}
+  static void result(DisplayResult kind, const char* title, const char* detail) {}
+  static void error(const char* message) {}
+  static void status(LCDState state, const String& param1, const String& param2) {}
+  static void replaceStatus(LCDState showing, LCDState state, const String& param1) {}
+  static void toJson(JsonObject out) {}
+};
+
+#if DISPLAY_LCD_FITTED
+// The LCD state machine lives in the sketch
+extern ShadowLcd lcd;
+extern LCDState currentLcdState;
+void updateLCDDisplay();
+
+// Tap screens all show the main screen, which reads lastScanned*
+struct LcdPanel {
+  static void begin() {
+    lcd.init();
+    lcd.backlight();
+  }
+
+  static void service() {
+    static unsigned long lastRefresh = 0;
+    updateLCDState();
+    if (millis() - lastRefresh > 1000) {        // Clock on the main screen
+      if (currentLcdState == LCD_MAIN_SCREEN) {
+        updateLCDDisplay();
+      } else if (lcd.needsRewrite()) {
+        lcd.refresh();                          // Retry a screen a bus error cut short
+      }
+      lastRefresh = millis();
+    }
+  }
+
+  // The panel may have lost nibble sync; redraw from the shadow buffer
+  static void restore() {
+    lcd.init();
+    lcd.backlight();
+    updateLCDDisplay();
+  }
+
+  static void ready() {
+    if (currentLcdState != LCD_MAIN_SCREEN) {
+      setLCDState(LCD_MAIN_SCREEN);
+    } else {
+      updateLCDDisplay();
+    }
+  }
+
+  static void processing(const char* message, int progress) { ready(); }
+  static void result(DisplayResult kind, const char* title, const char* detail) { ready(); }
+  static void error(const char* message) { ready(); }
+
+  static void status(LCDState state, const String& param1, const String& param2) {
+    setLCDState(state, param1, param2);
+  }
+
+  static void replaceStatus(LCDState showing, LCDState state, const String& param1) {
+    if (currentLcdState == showing) {
+      setLCDState(state, param1);
+    }
+  }
+
+  static void toJson(JsonObject out) {
+    // stockBytes: what LiquidCrystal_I2C would have sent
+    lcd.toJson(out.createNestedObject("lcd"));
+  }
+};
+typedef LcdPanel DisplayLcdPanel;
+#else
+typedef NoPanel DisplayLcdPanel;
+#endif
+
+#if DISPLAY_OLED_FITTED
+struct OledPanel {
+  static void begin() { initializeOLED(); }
+  static void service() { serviceAnimation(); }
+  static void restore() { presentFrame(I2C_PRIO_STATUS); }
+
+  // The last result stays up until the next tap
+  static void ready() {}
+
+  // Progress 0 is the card just read: its symbol rather than an empty bar
+  static void processing(const char* message, int progress) {
+    if (progress == 0) {
+      showCardScanScreen(message);
+    } else {
+      showLoadingScreen(message, progress);
+    }
+  }
+
+  static void result(DisplayResult kind, const char* title, const char* detail) {
+    switch (kind) {
+      case DISPLAY_RESULT_LOGGED:
+        showSuccessScreen(title);
+        animateSuccess();
+        break;
+      case DISPLAY_RESULT_SENT:
+        showSuccessScreen(title);
+        break;
+      case DISPLAY_RESULT_NOTICE:
+        showInfoScreen(title, detail);
+        break;
+    }
+  }
+
+  static void error(const char* message) {
+    showErrorScreen(message);
+    animateError();
+  }
+
+  // Only boot and connectivity have OLED screens
+  static void status(LCDState state, const String& param1, const String& param2) {
+    switch (state) {
+      case LCD_INITIALIZING:
+        showLoadingScreen("Starting...", 0);
+        break;
+      case LCD_CONNECTION_SUCCESS:
+        showWiFiStatus(true);
+        break;
+      case LCD_CONNECTION_FAILED:
+        showWiFiStatus(false);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // No sync or heartbeat screens to replace
+  static void replaceStatus(LCDState showing, LCDState state, const String& param1) {}
+
+  static void toJson(JsonObject out) { animToJson(out.createNestedObject("oledAnim")); }
+};
+typedef OledPanel DisplayOledPanel;
+#else
+typedef NoPanel DisplayOledPanel;
+#endif
+
+struct DisplayTapTiming {
+  bool inTap;
+  uint32_t tapMicros;           // Of the tap in progress
+  uint32_t taps;
+  uint32_t lastTapMicros;
+  uint32_t maxTapMicros;
+  uint64_t totalTapMicros;
+};
+
+template <class First, class Second>
+class DisplayFrontend {
+public:
+  static void begin() {
+    First::begin();
+    Second::begin();
+  }
+
+  static void service() {
+    Timed timed;
+    First::service();
+    Second::service();
+  }
+
+  // After an I2C bus recovery
+  static void restore() {
+    First::restore();
+    Second::restore();
+  }
+
+  // Idle screen; closes the tap being timed
+  static void ready() {
+    {
+      Timed timed;
+      First::ready();
+      Second::ready();
+    }
+    DisplayTapTiming& t = timing();
+    if (t.inTap) {
+      t.inTap = false;
+      t.taps++;
+      t.lastTapMicros = t.tapMicros;
+      t.totalTapMicros += t.tapMicros;
+      if (t.tapMicros > t.maxTapMicros) {
+        t.maxTapMicros = t.tapMicros;
+      }
+    }
+  }
+
+  static void processing(const char* message, int progress) {
+    if (progress == 0) {
+      timing().inTap = true;
+      timing().tapMicros = 0;
+    }
+    Timed timed;
+    First::processing(message, progress);
+    Second::processing(message, progress);
+  }
+
+  static void result(DisplayResult kind, const char* title, const char* detail = "") {
+    Timed timed;
+    First::result(kind, title, detail);
+    Second::result(kind, title, detail);
+  }
+
+  static void error(const char* message) {
+    Timed timed;
+    First::error(message);
+    Second::error(message);
+  }
+
+  static void status(LCDState state, const String& param1 = "", const String& param2 = "") {
+    First::status(state, param1, param2);
+    Second::status(state, param1, param2);
+  }
+
+  // Only where `showing` is still up; a screen that took over since stays
+  static void replaceStatus(LCDState showing, LCDState state, const String& param1 = "") {
+    First::replaceStatus(showing, state, param1);
+    Second::replaceStatus(showing, state, param1);
+  }
+
+  // Adds the panels' own objects next to "display"
+  static void toJson(JsonObject out) {
+    DisplayTapTiming& t = timing();
+    JsonObject display = out.createNestedObject("display");
+    display["lcd"] = (bool)DISPLAY_LCD_FITTED;
+    display["oled"] = (bool)DISPLAY_OLED_FITTED;
+    display["taps"] = t.taps;
+    display["lastTapMicros"] = t.lastTapMicros;
+    display["maxTapMicros"] = t.maxTapMicros;
+    display["avgTapMicros"] = t.taps > 0 ? (uint32_t)(t.totalTapMicros / t.taps) : 0;
+    First::toJson(out);
+    Second::toJson(out);
+  }
+
+private:
+  static DisplayTapTiming& timing() {
+    static DisplayTapTiming t;
+    return t;
+  }
+
+  // Adds the enclosing call's time to the tap in progress
+  struct Timed {
+    unsigned long start;
+    Timed() : start(micros()) {}
+    ~Timed() {
+      if (timing().inTap) {
+        timing().tapMicros += micros() - start;
+      }
+    }
+  };
+};
+
+typedef DisplayFrontend<DisplayLcdPanel, DisplayOledPanel> Display;
+
+#endif // DISPLAY_FRONTEND_H
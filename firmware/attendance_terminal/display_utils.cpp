@@ -1,107 +1,133 @@
+#include "config.h"
+#if DISPLAY_OLED_FITTED
+
 #include "display_utils.h"
-#include <math.h>
+#include "debug_log.h"
+#include "oled_anim.h"
 
 // Screen Transitions
-void transitionSlideLeft() {
+// Slides move the frame on screen 8 columns per step, in place
+static void slideLeftFrame(uint8_t step) {
+    if(step == 0) {
+        return;
+    }
     uint8_t* buffer = oledDisplay.getBuffer();
-    
-    for(int offset = 0; offset <= SCREEN_WIDTH; offset += 8) {
-        oledDisplay.clearDisplay();
-        for(int y = 0; y < SCREEN_HEIGHT; y++) {
-            for(int x = 0; x < SCREEN_WIDTH - offset; x++) {
-                if(buffer[(y/8)*SCREEN_WIDTH + (x+offset)] & (1 << (y&7))) {
-                    oledDisplay.drawPixel(x, y, SSD1306_WHITE);
-                }
-            }
-        }
-        oledDisplay.display();
-        delay(TRANSITION_DELAY);
+    for(int page = 0; page < SCREEN_HEIGHT / 8; page++) {
+        uint8_t* row = buffer + page * SCREEN_WIDTH;
+        memmove(row, row + 8, SCREEN_WIDTH - 8);
+        memset(row + SCREEN_WIDTH - 8, 0, 8);
     }
 }
 
-void transitionSlideRight() {
+static void slideRightFrame(uint8_t step) {
+    if(step == 0) {
+        return;
+    }
     uint8_t* buffer = oledDisplay.getBuffer();
-    
-    for(int offset = 0; offset <= SCREEN_WIDTH; offset += 8) {
-        oledDisplay.clearDisplay();
-        for(int y = 0; y < SCREEN_HEIGHT; y++) {
-            for(int x = offset; x < SCREEN_WIDTH; x++) {
-                if(buffer[(y/8)*SCREEN_WIDTH + (x-offset)] & (1 << (y&7))) {
-                    oledDisplay.drawPixel(x, y, SSD1306_WHITE);
-                }
-            }
-        }
-        oledDisplay.display();
-        delay(TRANSITION_DELAY);
+    for(int page = 0; page < SCREEN_HEIGHT / 8; page++) {
+        uint8_t* row = buffer + page * SCREEN_WIDTH;
+        memmove(row + 8, row, SCREEN_WIDTH - 8);
+        memset(row, 0, 8);
     }
 }
 
-void transitionFade() {
-    for(int i = 255; i >= 0; i -= 5) {
-        oledDisplay.dim(true);
-        // Note: setContrast is not available in newer Adafruit_SSD1306 library
-        // Using dim() instead for fade effect
-        oledDisplay.display();
-        delay(TRANSITION_DELAY/4);
-    }
-    oledDisplay.clearDisplay();
-    for(int i = 0; i <= 255; i += 5) {
-        oledDisplay.display();
-        delay(TRANSITION_DELAY/4);
-    }
+static void dimFrame(uint8_t step) {
+    oledDisplay.dim(true);
+}
+
+static void undimFrame(uint8_t step) {
     oledDisplay.dim(false);
 }
 
-void transitionZoom() {
-    uint8_t* buffer = oledDisplay.getBuffer();
-    
-    const int centerX = SCREEN_WIDTH/2;
-    const int centerY = SCREEN_HEIGHT/2;
-    
-    for(int i = 0; i < 32; i++) {
-        oledDisplay.clearDisplay();
-        int size = 32 - i;
-        
-        // Draw zooming rectangle effect
-        for(int x = centerX - size; x < centerX + size && x < SCREEN_WIDTH; x++) {
-            for(int y = centerY - size/2; y < centerY + size/2 && y < SCREEN_HEIGHT; y++) {
-                if(x >= 0 && y >= 0) {
-                    oledDisplay.drawPixel(x, y, SSD1306_WHITE);
-                }
-            }
-        }
-        
-        oledDisplay.display();
-        delay(TRANSITION_DELAY/2);
-    }
-    
-    // Second phase: zoom out effect using buffer scaling
-    for(int scale = 100; scale >= 50; scale -= 5) {
-        oledDisplay.clearDisplay();
-        float s = scale/100.0;
-        for(int y = 0; y < SCREEN_HEIGHT; y++) {
-            for(int x = 0; x < SCREEN_WIDTH; x++) {
-                int srcX = (x - SCREEN_WIDTH/2)/s + SCREEN_WIDTH/2;
-                int srcY = (y - SCREEN_HEIGHT/2)/s + SCREEN_HEIGHT/2;
-                if(srcX >= 0 && srcX < SCREEN_WIDTH && srcY >= 0 && srcY < SCREEN_HEIGHT) {
-                    if(buffer[(srcY/8)*SCREEN_WIDTH + srcX] & (1 << (srcY&7))) {
-                        oledDisplay.drawPixel(x, y, SSD1306_WHITE);
-                    }
-                }
-            }
-        }
-        oledDisplay.display();
-        delay(TRANSITION_DELAY);
+// Centred block shrinking by a pixel each side per step
+static void zoomFrame(uint8_t step) {
+    int size = 32 - step;
+    oledDisplay.fillRect(SCREEN_WIDTH/2 - size, SCREEN_HEIGHT/2 - size/2, size * 2, (size/2) * 2, SSD1306_WHITE);
+}
+
+static const AnimKeyframe SLIDE_LEFT_FRAMES[] PROGMEM = {
+    { slideLeftFrame, 0, SCREEN_WIDTH / 8, TRANSITION_DELAY, ANIM_OVERLAY },
+};
+static const AnimKeyframe SLIDE_RIGHT_FRAMES[] PROGMEM = {
+    { slideRightFrame, 0, SCREEN_WIDTH / 8, TRANSITION_DELAY, ANIM_OVERLAY },
+};
+// Dimmed, then blank, for as long as the old 52-step contrast ramps took
+static const AnimKeyframe FADE_FRAMES[] PROGMEM = {
+    { dimFrame, 0, 0, 13 * TRANSITION_DELAY, ANIM_OVERLAY },
+    { nullptr, 0, 0, 13 * TRANSITION_DELAY, 0 },
+    { undimFrame, 0, 0, 0, 0 },
+};
+// The zoom-out phase rescaled a buffer the shrinking block had already
+// cleared, so it only ever showed a blank screen; that is kept as a hold
+static const AnimKeyframe ZOOM_FRAMES[] PROGMEM = {
+    { zoomFrame, 0, 31, TRANSITION_DELAY/2, 0 },
+    { nullptr, 0, 0, 11 * TRANSITION_DELAY, 0 },
+};
+
+static const Animation SLIDE_LEFT = { "slideLeft", ANIM_KEYFRAMES(SLIDE_LEFT_FRAMES), 0, I2C_PRIO_DECOR };
+static const Animation SLIDE_RIGHT = { "slideRight", ANIM_KEYFRAMES(SLIDE_RIGHT_FRAMES), 0, I2C_PRIO_DECOR };
+static const Animation FADE = { "fade", ANIM_KEYFRAMES(FADE_FRAMES), 0, I2C_PRIO_DECOR };
+static const Animation ZOOM = { "zoom", ANIM_KEYFRAMES(ZOOM_FRAMES), 0, I2C_PRIO_DECOR };
+
+void transitionSlideLeft() { animStart(SLIDE_LEFT); }
+void transitionSlideRight() { animStart(SLIDE_RIGHT); }
+void transitionFade() { animStart(FADE); }
+void transitionZoom() { animStart(ZOOM); }
+
+// Frame transfer: one page (128 bytes) per bus step, so a frame never
+// holds the bus for more than a few hundred microseconds at a time
+#define OLED_PAGES (SCREEN_HEIGHT / 8)
+#define OLED_DATA_CHUNK 31              // Wire's 32-byte buffer less the control byte
+
+static uint8_t framePage = 0;
+static uint8_t framePagesLeft = 0;
+
+static bool sendFramePage() {
+    if(framePagesLeft == 0) {
+        return true;
+    }
+    const uint8_t* data = oledDisplay.getBuffer() + framePage * SCREEN_WIDTH;
+
+    Wire.beginTransmission(SCREEN_ADDRESS);
+    Wire.write((uint8_t)0x00);                  // Command stream
+    Wire.write((uint8_t)SSD1306_PAGEADDR);
+    Wire.write(framePage);
+    Wire.write(framePage);
+    Wire.write((uint8_t)SSD1306_COLUMNADDR);
+    Wire.write((uint8_t)0);
+    Wire.write((uint8_t)(SCREEN_WIDTH - 1));
+    uint8_t error = Wire.endTransmission();
+    for(uint8_t sent = 0; error == 0 && sent < SCREEN_WIDTH; sent += OLED_DATA_CHUNK) {
+        Wire.beginTransmission(SCREEN_ADDRESS);
+        Wire.write((uint8_t)0x40);              // Data stream
+        Wire.write(data + sent, min(OLED_DATA_CHUNK, SCREEN_WIDTH - sent));
+        error = Wire.endTransmission();
+    }
+
+    framePage = (framePage + 1) % OLED_PAGES;
+    framePagesLeft--;
+    // After the bookkeeping: a recovery here re-presents the whole frame
+    i2cBusResult(error);
+    return framePagesLeft == 0;
+}
+
+// A new frame while one is in flight keeps going from the current page;
+// it is done once every page has gone out since this call. Screens shown
+// from blocking code (boot, the tap path) go out at once; animation
+// frames are left to the queue.
+void presentFrame(I2cPriority priority) {
+    framePagesLeft = OLED_PAGES;
+    i2cBusSubmit(priority, sendFramePage);
+    if(priority <= I2C_PRIO_STATUS) {
+        i2cBusDrain(priority);
     }
-    
-    oledDisplay.clearDisplay();
-    oledDisplay.display();
 }
 
 // Initialize OLED Display
 void initializeOLED() {
-    if(!oledDisplay.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS)) {
-        Serial.println(F("SSD1306 allocation failed"));
+    // Wire is already running; periphBegin = false keeps its pins and clock
+    if(!oledDisplay.begin(SSD1306_SWITCHCAPVCC, SCREEN_ADDRESS, true, false)) {
+        LOG_ERROR("SSD1306 allocation failed");
         return;
     }
     oledDisplay.clearDisplay();
@@ -109,273 +135,289 @@ void initializeOLED() {
     oledDisplay.display();
 }
 
-void showSuccessScreen(const char* message) {
+// A screen replaces whatever animation was playing
+static void beginScreen() {
+    animCancel();
     oledDisplay.clearDisplay();
+}
+
+void showSuccessScreen(const char* message) {
+    beginScreen();
     drawHappyEmoji();
     drawCenteredText(message, 45);
-    oledDisplay.display();
+    presentFrame(I2C_PRIO_FEEDBACK);
 }
 
 void showErrorScreen(const char* message) {
-    oledDisplay.clearDisplay();
+    beginScreen();
     drawSadEmoji();
     drawCenteredText(message, 45);
-    oledDisplay.display();
+    presentFrame(I2C_PRIO_FEEDBACK);
 }
 
 void showLoadingScreen(const char* message, int progress) {
-    oledDisplay.clearDisplay();
+    beginScreen();
     drawCenteredText(message, 20);
     drawProgressBar(14, 40, 100, 8, progress);
-    oledDisplay.display();
+    presentFrame(I2C_PRIO_STATUS);
 }
 
 void showInfoScreen(const char* title, const char* message) {
-    oledDisplay.clearDisplay();
+    beginScreen();
     oledDisplay.setTextSize(1);
     drawCenteredText(title, 10);
     drawCenteredText(message, 30);
-    oledDisplay.display();
+    presentFrame(I2C_PRIO_FEEDBACK);
 }
 
 void showWiFiStatus(bool connected) {
-    oledDisplay.clearDisplay();
+    beginScreen();
     drawWiFiSymbol(connected);
     drawCenteredText(connected ? "Connected" : "Disconnected", 45);
-    oledDisplay.display();
+    presentFrame(I2C_PRIO_STATUS);
 }
 
 void showCardScanScreen(const char* message) {
-    oledDisplay.clearDisplay();
+    beginScreen();
     drawCardSymbol();
     drawCenteredText(message, 45);
-    oledDisplay.display();
+    presentFrame(I2C_PRIO_FEEDBACK);
 }
 
-void animateSuccess() {
-    for(int i = 0; i < 3; i++) {
-        oledDisplay.clearDisplay();
-        drawCheckmark();
-        oledDisplay.display();
-        delay(200);
-        oledDisplay.clearDisplay();
-        oledDisplay.display();
-        delay(200);
-    }
+// Animations: keyframe tables played by oled_anim.cpp from loop(). The
+// animate*() calls only start them; the ones that used to draw a frame
+// per call start their loop once and leave it running.
+static void checkmarkFrame(uint8_t step) {
     drawCheckmark();
-    oledDisplay.display();
 }
 
-void animateError() {
-    for(int i = 0; i < 3; i++) {
-        oledDisplay.clearDisplay();
-        drawCross();
-        oledDisplay.display();
-        delay(200);
-        oledDisplay.clearDisplay();
-        oledDisplay.display();
-        delay(200);
-    }
+static void crossFrame(uint8_t step) {
     drawCross();
-    oledDisplay.display();
 }
 
+// Three blinks, then the symbol stays up
+static const AnimKeyframe SUCCESS_FRAMES[] PROGMEM = {
+    { checkmarkFrame, 0, 0, 200, 0 }, { nullptr, 0, 0, 200, 0 },
+    { checkmarkFrame, 0, 0, 200, 0 }, { nullptr, 0, 0, 200, 0 },
+    { checkmarkFrame, 0, 0, 200, 0 }, { nullptr, 0, 0, 200, 0 },
+    { checkmarkFrame, 0, 0, 0, 0 },
+};
+static const AnimKeyframe ERROR_FRAMES[] PROGMEM = {
+    { crossFrame, 0, 0, 200, 0 }, { nullptr, 0, 0, 200, 0 },
+    { crossFrame, 0, 0, 200, 0 }, { nullptr, 0, 0, 200, 0 },
+    { crossFrame, 0, 0, 200, 0 }, { nullptr, 0, 0, 200, 0 },
+    { crossFrame, 0, 0, 0, 0 },
+};
+
+static const Animation SUCCESS = { "success", ANIM_KEYFRAMES(SUCCESS_FRAMES), 0, I2C_PRIO_FEEDBACK };
+static const Animation ERROR_BLINK = { "error", ANIM_KEYFRAMES(ERROR_FRAMES), 0, I2C_PRIO_FEEDBACK };
+
+void animateSuccess() { animStart(SUCCESS); }
+void animateError() { animStart(ERROR_BLINK); }
+
+#define DOTS_COUNT 5
+#define CIRCLE_STEPS 16         // Spinner frames per turn
+#define BAR_TRAVEL 32           // Pixels the bar segment moves, 2 per frame
+#define WAVE_STEPS 64           // Wave frames per period
+
+static void dotsFrame(uint8_t step) { drawDotsLoading(step); }
+static void circleFrame(uint8_t step) { drawCircleLoading(step); }
+static void barFrame(uint8_t step) { drawBarLoading(step); }
+static void waveFrame(uint8_t step) { drawWaveLoading(step); }
+
+static const AnimKeyframe DOTS_FRAMES[] PROGMEM = {
+    { dotsFrame, 0, DOTS_COUNT - 1, FRAME_DELAY, 0 },
+};
+static const AnimKeyframe CIRCLE_FRAMES[] PROGMEM = {
+    { circleFrame, 0, CIRCLE_STEPS - 1, FRAME_DELAY, 0 },
+};
+static const AnimKeyframe BAR_FRAMES[] PROGMEM = {
+    { barFrame, 0, BAR_TRAVEL / 2, FRAME_DELAY, 0 },
+};
+static const AnimKeyframe WAVE_FRAMES[] PROGMEM = {
+    { waveFrame, 0, WAVE_STEPS - 1, FRAME_DELAY, 0 },
+};
+
+static const Animation LOADING[] = {
+    { "dotsLoading", ANIM_KEYFRAMES(DOTS_FRAMES), ANIM_LOOP, I2C_PRIO_DECOR },
+    { "circleLoading", ANIM_KEYFRAMES(CIRCLE_FRAMES), ANIM_LOOP, I2C_PRIO_DECOR },
+    { "barLoading", ANIM_KEYFRAMES(BAR_FRAMES), ANIM_LOOP, I2C_PRIO_DECOR },
+    { "waveLoading", ANIM_KEYFRAMES(WAVE_FRAMES), ANIM_LOOP, I2C_PRIO_DECOR },
+};
+
+// Indexed by LoadingAnimationType
 void animateProcessing(LoadingAnimationType type) {
-    static uint8_t frame = 0;
-    oledDisplay.clearDisplay();
-    
-    switch(type) {
-        case DOTS_LOADING:
-            drawDotsLoading();
-            break;
-        case CIRCLE_LOADING:
-            drawCircleLoading();
-            break;
-        case BAR_LOADING:
-            drawBarLoading();
-            break;
-        case WAVE_LOADING:
-            drawWaveLoading();
-            break;
+    if(!animIsPlaying(LOADING[type])) {
+        animStart(LOADING[type]);
     }
-    
-    frame = (frame + 1) % 8;
-    oledDisplay.display();
-    delay(FRAME_DELAY);
 }
 
-void drawDotsLoading() {
-    static uint8_t pos = 0;
-    const uint8_t dots = 5;
-    for(uint8_t i = 0; i < dots; i++) {
-        uint8_t size = (i == pos) ? 3 : 1;
+void drawDotsLoading(uint8_t step) {
+    for(uint8_t i = 0; i < DOTS_COUNT; i++) {
+        uint8_t size = (i == step) ? 3 : 1;
         oledDisplay.fillCircle(48 + i*8, 32, size, SSD1306_WHITE);
     }
-    pos = (pos + 1) % dots;
 }
 
-void drawCircleLoading() {
-    static float angle = 0;
+void drawCircleLoading(uint8_t step) {
     const int radius = 15;
     const int centerX = 64;
     const int centerY = 32;
     
     for(int i = 0; i < 8; i++) {
-        float a = angle + (i * PI / 4);
-        int x = centerX + cos(a) * radius;
-        int y = centerY + sin(a) * radius;
+        uint8_t a = step * (256 / CIRCLE_STEPS) + i * 32;
+        int x = centerX + ((radius * animCos(a)) >> 8);
+        int y = centerY + ((radius * animSin(a)) >> 8);
         int size = (i == 0) ? 3 : (4-i/2);
         if(size > 0) {
             oledDisplay.fillCircle(x, y, size, SSD1306_WHITE);
         }
     }
-    angle += 0.5;
 }
 
-void drawBarLoading() {
-    static int pos = 0;
+void drawBarLoading(uint8_t step) {
     oledDisplay.drawRect(44, 30, 40, 4, SSD1306_WHITE);
-    oledDisplay.fillRect(44 + pos, 30, 8, 4, SSD1306_WHITE);
-    pos = (pos + 2) % 33;
+    oledDisplay.fillRect(44 + step*2, 30, 8, 4, SSD1306_WHITE);
 }
 
-void drawWaveLoading() {
-    static float offset = 0;
+void drawWaveLoading(uint8_t step) {
     const int amplitude = 8;
     const int yCenter = 32;
     
+    // About 0.2 rad per column, moving 0.1 rad per frame
     for(int x = 0; x < SCREEN_WIDTH; x++) {
-        int y = yCenter + sin((x + offset) * 0.2) * amplitude;
+        uint8_t a = x * 8 + step * (256 / WAVE_STEPS);
+        int y = yCenter + ((amplitude * animSin(a)) >> 8);
         oledDisplay.drawPixel(x, y, SSD1306_WHITE);
     }
-    offset += 0.5;
 }
 
-void animateWiFiConnecting() {
-    static int frame = 0;
-    for(int i = 0; i < 4; i++) {
-        if(i <= frame/8) {
-            int radius = (3-i) * 6 + 4;
-            oledDisplay.drawCircle(64, 32, radius, SSD1306_WHITE);
-        }
+// Rings appear one by one from the outside in
+static void wifiConnectingFrame(uint8_t step) {
+    for(int i = 0; i <= step; i++) {
+        int radius = (3-i) * 6 + 4;
+        oledDisplay.drawCircle(64, 32, radius, SSD1306_WHITE);
     }
-    frame = (frame + 1) % 32;
-    oledDisplay.display();
 }
 
-void animateCardSwipe() {
-    const int cardWidth = 30;
-    const int cardHeight = 20;
-    
-    for(int x = -cardWidth; x <= SCREEN_WIDTH; x += 4) {
-        oledDisplay.clearDisplay();
-        oledDisplay.drawRoundRect(x, 22, cardWidth, cardHeight, 2, SSD1306_WHITE);
-        oledDisplay.drawLine(x + 5, 32, x + 25, 32, SSD1306_WHITE);
-        oledDisplay.display();
-        delay(FRAME_DELAY/4);
-    }
+static void cardSwipeFrame(uint8_t step) {
+    drawSwipeCard(-30 + step * 4);
 }
 
-void animateSync() {
-    static int frame = 0;
+static void syncFrame(uint8_t step) {
     const int centerX = 64;
     const int centerY = 32;
     const int radius = 16;
     
-    oledDisplay.clearDisplay();
-    float angle = frame * PI / 8;
-    
     // Draw rotating arrows
     for(int i = 0; i < 2; i++) {
-        float a = angle + i * PI;
-        int x1 = centerX + cos(a) * radius;
-        int y1 = centerY + sin(a) * radius;
-        int x2 = centerX + cos(a + PI/4) * (radius-8);
-        int y2 = centerY + sin(a + PI/4) * (radius-8);
+        uint8_t a = step * 16 + i * 128;
+        int x1 = centerX + ((radius * animCos(a)) >> 8);
+        int y1 = centerY + ((radius * animSin(a)) >> 8);
+        int x2 = centerX + (((radius-8) * animCos(a + 32)) >> 8);
+        int y2 = centerY + (((radius-8) * animSin(a + 32)) >> 8);
         oledDisplay.drawLine(centerX, centerY, x1, y1, SSD1306_WHITE);
         oledDisplay.drawLine(x1, y1, x2, y2, SSD1306_WHITE);
     }
-    
-    frame = (frame + 1) % 16;
-    oledDisplay.display();
 }
 
-void animateHeartbeat() {
-    static int frame = 0;
+// Flat trace with a three-point spike whose height follows the step
+static void heartbeatFrame(uint8_t step) {
     const int points = 32;
     const int amplitude = 16;
     const int baseY = 32;
+    int pulse = (amplitude * animSin(step * 16)) >> 8;
     
-    oledDisplay.clearDisplay();
-    
-    for(int i = 0; i < points; i++) {
+    int prevX = 0;
+    int prevY = baseY;
+    for(int i = 1; i < points; i++) {
         int x = map(i, 0, points-1, 0, SCREEN_WIDTH);
         int y = baseY;
-        
         if(i == points/2) {
-            y = baseY - amplitude * sin(frame * PI / 8);
+            y = baseY - pulse;
         } else if(i == points/2 + 1) {
-            y = baseY + amplitude * sin(frame * PI / 8);
+            y = baseY + pulse;
         } else if(i == points/2 + 2) {
-            y = baseY - amplitude/2 * sin(frame * PI / 8);
-        }
-        
-        if(i > 0) {
-            int prevX = map(i-1, 0, points-1, 0, SCREEN_WIDTH);
-            int prevY = (i-1 == points/2) ? baseY - amplitude * sin(frame * PI / 8) :
-                       (i-1 == points/2 + 1) ? baseY + amplitude * sin(frame * PI / 8) :
-                       (i-1 == points/2 + 2) ? baseY - amplitude/2 * sin(frame * PI / 8) :
-                       baseY;
-            oledDisplay.drawLine(prevX, prevY, x, y, SSD1306_WHITE);
+            y = baseY - pulse/2;
         }
+        oledDisplay.drawLine(prevX, prevY, x, y, SSD1306_WHITE);
+        prevX = x;
+        prevY = y;
     }
-    
-    frame = (frame + 1) % 16;
-    oledDisplay.display();
 }
 
-void animatePowerOn() {
-    for(int i = 0; i < 32; i++) {
-        oledDisplay.clearDisplay();
-        int size = map(i, 0, 31, 2, 32);
-        oledDisplay.fillCircle(64, 32, size, SSD1306_WHITE);
-        oledDisplay.display();
-        delay(FRAME_DELAY/2);
-    }
-    
-    for(int i = 0; i < 16; i++) {
-        oledDisplay.clearDisplay();
-        oledDisplay.drawCircle(64, 32, 32, SSD1306_WHITE);
-        oledDisplay.drawLine(64, 12, 64, 32, SSD1306_WHITE);
-        // Note: Using dim() instead of setContrast for compatibility
-        oledDisplay.dim(i > 8);
-        oledDisplay.display();
-        delay(FRAME_DELAY/2);
+static void powerDiscFrame(uint8_t step) {
+    oledDisplay.fillCircle(64, 32, map(step, 0, 31, 2, 32), SSD1306_WHITE);
+}
+
+static void powerSymbol() {
+    oledDisplay.drawCircle(64, 32, 32, SSD1306_WHITE);
+    oledDisplay.drawLine(64, 12, 64, 32, SSD1306_WHITE);
+}
+
+// Note: Using dim() instead of setContrast for compatibility
+static void powerOnSymbolFrame(uint8_t step) {
+    powerSymbol();
+    oledDisplay.dim(step > 8);
+}
+
+static void powerOffSymbolFrame(uint8_t step) {
+    powerSymbol();
+    oledDisplay.dim(step < 8);
+}
+
+static const AnimKeyframe WIFI_CONNECTING_FRAMES[] PROGMEM = {
+    { wifiConnectingFrame, 0, 3, FRAME_DELAY * 4, 0 },
+};
+static const AnimKeyframe CARD_SWIPE_FRAMES[] PROGMEM = {
+    { cardSwipeFrame, 0, (SCREEN_WIDTH + 30) / 4, FRAME_DELAY/4, 0 },
+};
+static const AnimKeyframe SYNC_FRAMES[] PROGMEM = {
+    { syncFrame, 0, 15, FRAME_DELAY, 0 },
+};
+static const AnimKeyframe HEARTBEAT_FRAMES[] PROGMEM = {
+    { heartbeatFrame, 0, 15, FRAME_DELAY, 0 },
+};
+static const AnimKeyframe POWER_ON_FRAMES[] PROGMEM = {
+    { powerDiscFrame, 0, 31, FRAME_DELAY/2, 0 },
+    { powerOnSymbolFrame, 0, 15, FRAME_DELAY/2, 0 },
+};
+static const AnimKeyframe POWER_OFF_FRAMES[] PROGMEM = {
+    { powerOffSymbolFrame, 0, 15, FRAME_DELAY/2, 0 },
+    { powerDiscFrame, 31, 0, FRAME_DELAY/2, 0 },
+    { nullptr, 0, 0, 0, 0 },
+};
+
+static const Animation WIFI_CONNECTING = { "wifiConnecting", ANIM_KEYFRAMES(WIFI_CONNECTING_FRAMES), ANIM_LOOP, I2C_PRIO_DECOR };
+static const Animation CARD_SWIPE = { "cardSwipe", ANIM_KEYFRAMES(CARD_SWIPE_FRAMES), 0, I2C_PRIO_DECOR };
+static const Animation SYNC = { "sync", ANIM_KEYFRAMES(SYNC_FRAMES), ANIM_LOOP, I2C_PRIO_DECOR };
+static const Animation HEARTBEAT = { "heartbeat", ANIM_KEYFRAMES(HEARTBEAT_FRAMES), ANIM_LOOP, I2C_PRIO_DECOR };
+static const Animation POWER_ON = { "powerOn", ANIM_KEYFRAMES(POWER_ON_FRAMES), 0, I2C_PRIO_DECOR };
+static const Animation POWER_OFF = { "powerOff", ANIM_KEYFRAMES(POWER_OFF_FRAMES), 0, I2C_PRIO_DECOR };
+
+void animateWiFiConnecting() {
+    if(!animIsPlaying(WIFI_CONNECTING)) {
+        animStart(WIFI_CONNECTING);
     }
 }
 
-void animatePowerOff() {
-    for(int i = 0; i < 16; i++) {
-        oledDisplay.clearDisplay();
-        oledDisplay.drawCircle(64, 32, 32, SSD1306_WHITE);
-        oledDisplay.drawLine(64, 12, 64, 32, SSD1306_WHITE);
-        // Note: Using dim() instead of setContrast for compatibility
-        oledDisplay.dim(i < 8);
-        oledDisplay.display();
-        delay(FRAME_DELAY/2);
+void animateCardSwipe() { animStart(CARD_SWIPE); }
+
+void animateSync() {
+    if(!animIsPlaying(SYNC)) {
+        animStart(SYNC);
     }
-    
-    for(int i = 31; i >= 0; i--) {
-        oledDisplay.clearDisplay();
-        int size = map(i, 0, 31, 2, 32);
-        oledDisplay.fillCircle(64, 32, size, SSD1306_WHITE);
-        oledDisplay.display();
-        delay(FRAME_DELAY/2);
+}
+
+void animateHeartbeat() {
+    if(!animIsPlaying(HEARTBEAT)) {
+        animStart(HEARTBEAT);
     }
-    oledDisplay.clearDisplay();
-    oledDisplay.display();
 }
 
+void animatePowerOn() { animStart(POWER_ON); }
+void animatePowerOff() { animStart(POWER_OFF); }
+
 void drawProgressBar(int x, int y, int width, int height, int progress) {
     oledDisplay.drawRect(x, y, width, height, SSD1306_WHITE);
     int fillWidth = map(progress, 0, 100, 0, width - 4);
@@ -391,204 +433,50 @@ void drawCenteredText(const char* text, int y) {
     oledDisplay.print(text);
 }
 
-void drawHappyEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    oledDisplay.fillCircle(56, 17, 3, SSD1306_WHITE);
-    oledDisplay.fillCircle(72, 17, 3, SSD1306_WHITE);
-    for(int i = 0; i < 15; i++) {
-        int x = 56 + i;
-        oledDisplay.drawPixel(x, 28 + sin((i-7)*0.3)*3, SSD1306_WHITE);
-    }
-}
-
-void drawSadEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    oledDisplay.fillCircle(56, 17, 3, SSD1306_WHITE);
-    oledDisplay.fillCircle(72, 17, 3, SSD1306_WHITE);
-    for(int i = 0; i < 15; i++) {
-        int x = 56 + i;
-        oledDisplay.drawPixel(x, 32 - sin((i-7)*0.3)*3, SSD1306_WHITE);
-    }
-}
-
-void drawVerySadEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    oledDisplay.fillCircle(56, 17, 3, SSD1306_WHITE);
-    oledDisplay.fillCircle(72, 17, 3, SSD1306_WHITE);
-    for(int i = 0; i < 15; i++) {
-        int x = 56 + i;
-        oledDisplay.drawPixel(x, 35 - sin((i-7)*0.4)*5, SSD1306_WHITE);
-    }
-    // Draw tears
-    oledDisplay.drawLine(53, 20, 53, 28, SSD1306_WHITE);
-    oledDisplay.drawLine(75, 20, 75, 28, SSD1306_WHITE);
-}
-
-void drawNeutralEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    oledDisplay.fillCircle(56, 17, 3, SSD1306_WHITE);
-    oledDisplay.fillCircle(72, 17, 3, SSD1306_WHITE);
-    oledDisplay.drawLine(56, 32, 72, 32, SSD1306_WHITE);
-}
-
-void drawWinkEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    // Winking eye
-    oledDisplay.drawLine(54, 17, 58, 17, SSD1306_WHITE);
-    // Open eye
-    oledDisplay.fillCircle(72, 17, 3, SSD1306_WHITE);
-    // Smile
-    for(int i = 0; i < 15; i++) {
-        int x = 56 + i;
-        oledDisplay.drawPixel(x, 28 + sin((i-7)*0.3)*3, SSD1306_WHITE);
-    }
+// Emojis and symbols are blitted from the PROGMEM sprite atlas; their
+// drawings live in ../sprite_shapes.h
+static void blit(SpriteId id) {
+    spriteBlit(oledDisplay.getBuffer(), id);
 }
 
-void drawThinkingEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    oledDisplay.fillCircle(56, 17, 3, SSD1306_WHITE);
-    oledDisplay.fillCircle(72, 17, 3, SSD1306_WHITE);
-    // Thinking bubble
-    oledDisplay.drawCircle(84, 14, 3, SSD1306_WHITE);
-    oledDisplay.drawCircle(80, 18, 2, SSD1306_WHITE);
-    oledDisplay.drawCircle(76, 20, 1, SSD1306_WHITE);
-    // Thinking expression
-    oledDisplay.drawLine(58, 32, 70, 32, SSD1306_WHITE);
-}
-
-void drawSleepyEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    // Closed eyes
-    oledDisplay.drawLine(54, 17, 58, 17, SSD1306_WHITE);
-    oledDisplay.drawLine(70, 17, 74, 17, SSD1306_WHITE);
-    // Z's
-    oledDisplay.drawLine(84, 14, 88, 14, SSD1306_WHITE);
-    oledDisplay.drawLine(88, 14, 84, 18, SSD1306_WHITE);
-    oledDisplay.drawLine(84, 18, 88, 18, SSD1306_WHITE);
-    // Slight smile
-    for(int i = 0; i < 15; i++) {
-        int x = 56 + i;
-        oledDisplay.drawPixel(x, 28 + sin((i-7)*0.2)*2, SSD1306_WHITE);
-    }
-}
-
-void drawConfusedEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    oledDisplay.fillCircle(56, 17, 3, SSD1306_WHITE);
-    oledDisplay.fillCircle(72, 17, 3, SSD1306_WHITE);
-    // Confused mouth
-    for(int i = 0; i < 10; i++) {
-        int x = 59 + i;
-        oledDisplay.drawPixel(x, 32 + sin(i*0.6)*2, SSD1306_WHITE);
-    }
-    // Question mark
-    oledDisplay.drawCircle(84, 14, 2, SSD1306_WHITE);
-    oledDisplay.drawPixel(84, 18, SSD1306_WHITE);
-}
-
-void drawCoolEmoji() {
-    oledDisplay.drawCircle(64, 24, 20, SSD1306_WHITE);
-    // Sunglasses
-    oledDisplay.fillRect(52, 15, 8, 4, SSD1306_WHITE);
-    oledDisplay.fillRect(68, 15, 8, 4, SSD1306_WHITE);
-    oledDisplay.drawLine(60, 17, 68, 17, SSD1306_WHITE);
-    // Cool smile
-    for(int i = 0; i < 12; i++) {
-        int x = 58 + i;
-        oledDisplay.drawPixel(x, 30 + (i < 6 ? 0 : 2), SSD1306_WHITE);
-    }
-}
+void drawHappyEmoji() { blit(SPRITE_HAPPY_EMOJI); }
+void drawSadEmoji() { blit(SPRITE_SAD_EMOJI); }
+void drawVerySadEmoji() { blit(SPRITE_VERY_SAD_EMOJI); }
+void drawNeutralEmoji() { blit(SPRITE_NEUTRAL_EMOJI); }
+void drawWinkEmoji() { blit(SPRITE_WINK_EMOJI); }
+void drawThinkingEmoji() { blit(SPRITE_THINKING_EMOJI); }
+void drawSleepyEmoji() { blit(SPRITE_SLEEPY_EMOJI); }
+void drawConfusedEmoji() { blit(SPRITE_CONFUSED_EMOJI); }
+void drawCoolEmoji() { blit(SPRITE_COOL_EMOJI); }
 
 // Status Symbols
 void drawWiFiSymbol(bool connected) {
-    if(connected) {
-        for(int i = 16; i >= 4; i -= 6) {
-            oledDisplay.drawCircle(64, 32, i, SSD1306_WHITE);
-        }
-        oledDisplay.fillCircle(64, 32, 2, SSD1306_WHITE);
-    } else {
-        oledDisplay.drawCircle(64, 32, 16, SSD1306_WHITE);
-        oledDisplay.drawLine(48, 48, 80, 16, SSD1306_WHITE);
-    }
+    blit(connected ? SPRITE_WIFI_ON : SPRITE_WIFI_OFF);
 }
 
 void drawBatterySymbol(int percentage) {
-    oledDisplay.drawRect(44, 12, 32, 16, SSD1306_WHITE);
-    oledDisplay.fillRect(76, 16, 4, 8, SSD1306_WHITE);
+    blit(SPRITE_BATTERY_FRAME);
     int fillWidth = map(percentage, 0, 100, 0, 28);
     oledDisplay.fillRect(46, 14, fillWidth, 12, SSD1306_WHITE);
 }
 
-void drawCardSymbol() {
-    oledDisplay.drawRoundRect(44, 12, 40, 25, 3, SSD1306_WHITE);
-    oledDisplay.drawLine(54, 22, 74, 22, SSD1306_WHITE);
-    oledDisplay.drawLine(54, 27, 74, 27, SSD1306_WHITE);
-}
-
-void drawCheckmark() {
-    oledDisplay.drawLine(45, 32, 55, 42, SSD1306_WHITE);
-    oledDisplay.drawLine(55, 42, 85, 22, SSD1306_WHITE);
-}
-
-void drawCross() {
-    oledDisplay.drawLine(45, 22, 85, 42, SSD1306_WHITE);
-    oledDisplay.drawLine(45, 42, 85, 22, SSD1306_WHITE);
-}
-
-void drawThumbsUp() {
-    oledDisplay.drawLine(60, 22, 60, 42, SSD1306_WHITE);
-    oledDisplay.drawLine(60, 42, 68, 42, SSD1306_WHITE);
-    oledDisplay.drawLine(68, 42, 68, 32, SSD1306_WHITE);
-    oledDisplay.drawLine(68, 32, 60, 32, SSD1306_WHITE);
-    oledDisplay.fillCircle(64, 22, 4, SSD1306_WHITE);
-}
-
-void drawThumbsDown() {
-    oledDisplay.drawLine(60, 22, 60, 42, SSD1306_WHITE);
-    oledDisplay.drawLine(60, 22, 68, 22, SSD1306_WHITE);
-    oledDisplay.drawLine(68, 22, 68, 32, SSD1306_WHITE);
-    oledDisplay.drawLine(68, 32, 60, 32, SSD1306_WHITE);
-    oledDisplay.fillCircle(64, 42, 4, SSD1306_WHITE);
-}
-
-void drawHeart() {
-    for(int i = -6; i < 7; i++) {
-        for(int j = -6; j < 7; j++) {
-            float x = i / 6.0;
-            float y = j / 6.0;
-            if((x*x + y*y - 1)*(x*x + y*y - 1)*(x*x + y*y - 1) - x*x*y*y*y <= 0) {
-                oledDisplay.drawPixel(64 + i*2, 32 + j*2, SSD1306_WHITE);
-            }
-        }
-    }
-}
+void drawCardSymbol() { blit(SPRITE_CARD); }
+void drawCheckmark() { blit(SPRITE_CHECKMARK); }
+void drawCross() { blit(SPRITE_CROSS); }
+void drawThumbsUp() { blit(SPRITE_THUMBS_UP); }
+void drawThumbsDown() { blit(SPRITE_THUMBS_DOWN); }
+void drawHeart() { blit(SPRITE_HEART); }
 
 void drawLock(bool locked) {
-    if(locked) {
-        oledDisplay.drawRoundRect(58, 24, 12, 16, 2, SSD1306_WHITE);
-        oledDisplay.drawRoundRect(54, 14, 20, 12, 6, SSD1306_WHITE);
-    } else {
-        oledDisplay.drawRoundRect(58, 24, 12, 16, 2, SSD1306_WHITE);
-        oledDisplay.drawRoundRect(68, 14, 20, 12, 6, SSD1306_WHITE);
-    }
+    blit(locked ? SPRITE_LOCK_CLOSED : SPRITE_LOCK_OPEN);
 }
 
-void drawClock() {
-    oledDisplay.drawCircle(64, 32, 16, SSD1306_WHITE);
-    oledDisplay.drawLine(64, 32, 64, 20, SSD1306_WHITE);
-    oledDisplay.drawLine(64, 32, 72, 32, SSD1306_WHITE);
-    oledDisplay.fillCircle(64, 32, 2, SSD1306_WHITE);
-}
+void drawClock() { blit(SPRITE_CLOCK); }
+void drawGear() { blit(SPRITE_GEAR); }
 
-void drawGear() {
-    for(int i = 0; i < 8; i++) {
-        float angle = i * PI / 4;
-        int x1 = 64 + cos(angle) * 12;
-        int y1 = 32 + sin(angle) * 12;
-        int x2 = 64 + cos(angle) * 16;
-        int y2 = 32 + sin(angle) * 16;
-        oledDisplay.drawLine(x1, y1, x2, y2, SSD1306_WHITE);
-    }
-    oledDisplay.drawCircle(64, 32, 12, SSD1306_WHITE);
-    oledDisplay.drawCircle(64, 32, 6, SSD1306_WHITE);
+void drawSwipeCard(int x) {
+    SpriteInfo card = spriteInfo(SPRITE_SWIPE_CARD);
+    spriteBlitAt(oledDisplay.getBuffer(), SPRITE_SWIPE_CARD, x, card.y);
 }
+
+#endif // DISPLAY_OLED_FITTED
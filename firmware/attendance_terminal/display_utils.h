@@ -6,6 +6,8 @@
 #include <Adafruit_SSD1306.h>
 #include <Wire.h>
 #include <math.h>
+#include "i2c_bus.h"
+#include "sprite_atlas.h"
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
@@ -38,6 +40,7 @@ enum LoadingAnimationType {
 
 // Basic Display Functions
 void initializeOLED();
+void presentFrame(I2cPriority priority = I2C_PRIO_DECOR);   // Queue the buffer for the panel
 void clearWithFade();
 void drawCenteredText(const char* text, int y);
 void drawProgressBar(int x, int y, int width, int height, int progress);
@@ -50,7 +53,7 @@ void showInfoScreen(const char* title, const char* message);
 void showWiFiStatus(bool connected);
 void showCardScanScreen(const char* message);
 
-// Animations
+// Animations (non-blocking: they start a keyframe animation, see oled_anim.h)
 void animateSuccess();
 void animateError();
 void animateProcessing(LoadingAnimationType type = DOTS_LOADING);
@@ -85,12 +88,13 @@ void drawHeart();
 void drawLock(bool locked);
 void drawClock();
 void drawGear();
+void drawSwipeCard(int x);     // Card of the swipe animations, left edge at x
 
-// Loading Animations
-void drawDotsLoading();
-void drawCircleLoading();
-void drawBarLoading();
-void drawWaveLoading();
+// Loading Animation frames
+void drawDotsLoading(uint8_t step);
+void drawCircleLoading(uint8_t step);
+void drawBarLoading(uint8_t step);
+void drawWaveLoading(uint8_t step);
 
 // Transitions
 void transitionSlideLeft();
@@ -103,6 +107,6 @@ void animateCardSwipeExtended();
 void animateHeartbeatExtended();
 void drawHeartExtended(int x, int y, int size);
 void animateSyncExtended();
-void drawArrowheadExtended(int x1, int y1, int x2, int y2);
+void drawArrowheadExtended(int x, int y, uint8_t angle);
 
 #endif
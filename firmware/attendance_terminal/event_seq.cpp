@@ -0,0 +1,135 @@
+/*
+ * Attendance event sequence numbers for Attendee Attendance Terminal v2.0
+ */
+
+#include <LittleFS.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "event_seq.h"
+#include "circuit_breaker.h"
+#include "memory_governor.h"
+#include "offline_staging.h"
+#include "offline_store.h"
+#include "sync_pipeline.h"
+
+// External references from main file
+extern bool isOnline;
+
+static uint32_t nextSeq = 1;
+static uint32_t leaseEnd = 1;   // First number not covered by the persisted lease
+static bool seeded = false;
+static unsigned long lastSeedAttempt = 0;
+
+static bool persistLease(uint32_t end) {
+  File file = LittleFS.open(EVENT_SEQ_FILE, "w");
+  if (!file) {
+    return false;
+  }
+  file.print(end);
+  file.close();
+  return true;
+}
+
+// Call after LittleFS is mounted, before any tap is processed
+void beginEventSequence() {
+  File file = LittleFS.open(EVENT_SEQ_FILE, "r");
+  if (file) {
+    uint32_t stored = file.parseInt();
+    file.close();
+    if (stored > 0) {
+      nextSeq = stored;
+      seeded = true;
+    }
+  }
+  leaseEnd = nextSeq;
+  if (seeded) {
+    LOG_INFO("Event sequence resumes at %lu", (unsigned long)nextSeq);
+  } else {
+    LOG_WARN("No event sequence lease; taps are unnumbered until the backend is reached");
+  }
+}
+
+// ========================================
+// SEEDING
+// ========================================
+
+static void raiseToHeld(uint32_t& highest, const OfflineStoreFiles& store) {
+  OfflineStoreReader reader;
+  if (!offlineStoreOpen(reader, store, 0)) {
+    return;
+  }
+  OfflineRecord record;
+  while (offlineStoreNext(reader, record)) {
+    if (record.seq > highest) {
+      highest = record.seq;
+    }
+  }
+  offlineStoreClose(reader);
+}
+
+void serviceEventSequence() {
+  if (seeded || !isOnline || !memNetworkAllowed() ||
+      millis() - lastSeedAttempt < EVENT_SEQ_SEED_RETRY_MS) {
+    return;
+  }
+  if (!breakerAllowRequest()) {
+    return;
+  }
+  lastSeedAttempt = millis();
+
+  uint32_t highWater;
+  uint32_t highest = 0;
+  if (!fetchSyncWatermark(0, highWater, &highest)) {
+    LOG_DEBUG("Event sequence seed: backend not reached");
+    return;
+  }
+
+  // Records staged or stored before the lease file was lost keep their numbers
+  flushOfflineStaging("seq-seed");
+  raiseToHeld(highest, OFFLINE_STORE_MAIN);
+  raiseToHeld(highest, OFFLINE_STORE_DEFER);
+  if (getStagedSeqCeiling() > highest) {
+    highest = getStagedSeqCeiling();
+  }
+
+  // One lease of margin for taps the old numbering still had in flight
+  // (an MQTT session the broker has not delivered yet)
+  nextSeq = highest + EVENT_SEQ_LEASE + 1;
+  if (!persistLease(nextSeq + EVENT_SEQ_LEASE)) {
+    LOG_ERROR("Failed to persist event sequence lease");
+    return;
+  }
+  leaseEnd = nextSeq + EVENT_SEQ_LEASE;
+  seeded = true;
+  LOG_INFO("Event sequence seeded at %lu (backend and store up to %lu)", (unsigned long)nextSeq,
+           (unsigned long)highest);
+}
+
+bool eventSeqSeeded() {
+  return seeded;
+}
+
+// ========================================
+// NUMBERING
+// ========================================
+
+uint32_t nextEventSeq() {
+  if (!seeded) {
+    return 0;
+  }
+  if (nextSeq >= leaseEnd) {
+    if (persistLease(nextSeq + EVENT_SEQ_LEASE)) {
+      leaseEnd = nextSeq + EVENT_SEQ_LEASE;
+    } else {
+      // Still hand out the number; a reboot before the next successful
+      // write may reuse it and the backend will treat it as a duplicate
+      LOG_ERROR("Failed to persist event sequence lease");
+    }
+  }
+  return nextSeq++;
+}
+
+uint32_t peekEventSeq() {
+  return nextSeq;
+}
@@ -0,0 +1,31 @@
+/*
+ * Attendance event sequence numbers
+ * Attendee Attendance Terminal v2.0
+ *
+ * Every tap gets a per-device, monotonically increasing sequence number
+ * that travels with it to the backend (online or after an offline sync),
+ * so a resubmission after a timeout or a retried sync is recognised as the
+ * same event. Numbers are leased from flash EVENT_SEQ_LEASE at a time; a
+ * reboot resumes after the lease, leaving a gap the backend closes through
+ * the X-Seq-Floor header sent during sync.
+ *
+ * Without the lease file (a new board, a LittleFS format, a reflash with
+ * erase) numbering would restart at 1 and collide with events the backend
+ * already has. The counter then starts unseeded: taps get seq 0 and go
+ * without a dedupe key. serviceEventSequence() asks the backend for the
+ * highest seq it has seen for this device, and numbering resumes above
+ * that and above any seq still held in the offline store.
+ */
+
+#ifndef EVENT_SEQ_H
+#define EVENT_SEQ_H
+
+#include <Arduino.h>
+
+void beginEventSequence();
+void serviceEventSequence();    // Scheduled task; seeds an unseeded counter once online
+bool eventSeqSeeded();
+uint32_t nextEventSeq();        // 0 while unseeded
+uint32_t peekEventSeq();        // Number the next tap will get once seeded
+
+#endif // EVENT_SEQ_H
@@ -0,0 +1,212 @@
+/*
+ * Server-Sent Events stream for Attendee Attendance Terminal v2.0
+ *
+ * Follows the ServerSentEvents example shipped with the ESP8266 core: the
+ * /api/events handler keeps a copy of the server's WiFiClient and writes
+ * the stream to it directly. Writes only happen when the socket has room
+ * for a whole event, so a slow subscriber never blocks loop().
+ */
+
+#include "config.h"
+#include "event_stream.h"
+#include "circuit_breaker.h"
+
+// External references from main file
+extern int offlineLogsCount;
+extern bool isOnline;
+
+#if SSE_CLIENT_MAX_LAG > SSE_EVENT_RING
+#error "SSE_CLIENT_MAX_LAG must not exceed SSE_EVENT_RING"
+#endif
+
+struct SseEvent {
+  uint32_t seq;
+  uint8_t len;
+  char text[SSE_EVENT_MAX_LEN];
+};
+
+struct SseSubscriber {
+  WiFiClient client;
+  bool active;
+  uint32_t nextSeq;             // Next event this subscriber has not received
+  unsigned long lastWrite;
+};
+
+static SseEvent eventRing[SSE_EVENT_RING];
+static SseSubscriber subscribers[SSE_MAX_SUBSCRIBERS];
+static uint32_t nextEventSeq = 1;
+static int subscriberCount = 0;
+static unsigned long droppedEvents = 0;
+
+static const char SSE_RESPONSE_HEADERS[] PROGMEM =
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: text/event-stream\r\n"
+  "Cache-Control: no-cache\r\n"
+  "Connection: keep-alive\r\n"
+  "Access-Control-Allow-Origin: *\r\n"
+  "\r\n"
+  "retry: 3000\n\n";
+
+// ========================================
+// SUBSCRIPTION MANAGEMENT
+// ========================================
+
+bool addEventSubscriber(WiFiClient& client) {
+  for (int i = 0; i < SSE_MAX_SUBSCRIBERS; i++) {
+    SseSubscriber& sub = subscribers[i];
+    if (sub.active) {
+      continue;
+    }
+
+    sub.client = client;
+    sub.client.setNoDelay(true);
+    sub.client.write_P(SSE_RESPONSE_HEADERS, strlen_P(SSE_RESPONSE_HEADERS));
+
+    // Initial snapshot so the subscriber does not wait for the first change
+    char hello[SSE_EVENT_MAX_LEN];
+    int len = snprintf(hello, sizeof(hello),
+                       "event: status\ndata: {\"ms\":%lu,\"queue\":%d,\"online\":%s,\"breaker\":\"%s\"}\n\n",
+                       millis(), offlineLogsCount, isOnline ? "true" : "false", breakerStateName());
+    sub.client.write((const uint8_t*)hello, min(len, (int)sizeof(hello) - 1));
+
+    sub.active = true;
+    sub.nextSeq = nextEventSeq;
+    sub.lastWrite = millis();
+    subscriberCount++;
+    return true;
+  }
+  return false;
+}
+
+int getEventSubscriberCount() {
+  return subscriberCount;
+}
+
+unsigned long getEventsDroppedCount() {
+  return droppedEvents;
+}
+
+static void removeSubscriber(SseSubscriber& sub) {
+  sub.client.stop();
+  sub.client = WiFiClient();
+  sub.active = false;
+  subscriberCount--;
+}
+
+// Push pending events to every subscriber without waiting on the socket
+void serviceEventStream() {
+  if (subscriberCount == 0) {
+    return;
+  }
+
+  unsigned long now = millis();
+  uint32_t oldestKept = (nextEventSeq > SSE_CLIENT_MAX_LAG) ? nextEventSeq - SSE_CLIENT_MAX_LAG : 1;
+
+  for (int i = 0; i < SSE_MAX_SUBSCRIBERS; i++) {
+    SseSubscriber& sub = subscribers[i];
+    if (!sub.active) {
+      continue;
+    }
+    if (!sub.client.connected()) {
+      removeSubscriber(sub);
+      continue;
+    }
+
+    // Drop-oldest: a lagging subscriber skips ahead to the newest backlog
+    if (sub.nextSeq < oldestKept) {
+      droppedEvents += oldestKept - sub.nextSeq;
+      sub.nextSeq = oldestKept;
+    }
+
+    while (sub.nextSeq < nextEventSeq) {
+      const SseEvent& ev = eventRing[sub.nextSeq % SSE_EVENT_RING];
+      if (sub.client.availableForWrite() < ev.len) {
+        break;
+      }
+      sub.client.write((const uint8_t*)ev.text, ev.len);
+      sub.nextSeq++;
+      sub.lastWrite = now;
+    }
+
+    if (now - sub.lastWrite > SSE_KEEPALIVE_MS && sub.client.availableForWrite() >= 3) {
+      sub.client.write((const uint8_t*)":\n\n", 3);
+      sub.lastWrite = now;
+    }
+  }
+}
+
+// ========================================
+// PUBLISHING
+// ========================================
+
+// fields is a JSON member list without braces, e.g. "\"result\":\"entry\""
+void publishEvent(const char* type, const char* fields) {
+  if (subscriberCount == 0) {
+    return;
+  }
+
+  uint32_t seq = nextEventSeq;
+  SseEvent& ev = eventRing[seq % SSE_EVENT_RING];
+  int len = snprintf(ev.text, sizeof(ev.text),
+                     "id: %lu\nevent: %s\ndata: {\"ms\":%lu,\"queue\":%d%s%s}\n\n",
+                     (unsigned long)seq, type, millis(), offlineLogsCount,
+                     fields[0] ? "," : "", fields);
+  if (len < 0 || len >= (int)sizeof(ev.text)) {
+    // Never emit a cut-off JSON payload
+    len = snprintf(ev.text, sizeof(ev.text),
+                   "id: %lu\nevent: %s\ndata: {\"ms\":%lu,\"queue\":%d,\"truncated\":true}\n\n",
+                   (unsigned long)seq, type, millis(), offlineLogsCount);
+  }
+
+  ev.seq = seq;
+  ev.len = (uint8_t)len;
+  nextEventSeq++;
+}
+
+// Copy a display string into a JSON string body, escaping quotes and
+// dropping control characters.
+static void escapeJsonString(char* out, size_t outSize, const String& value) {
+  size_t o = 0;
+  for (unsigned int i = 0; i < value.length() && o + 2 < outSize; i++) {
+    char c = value.charAt(i);
+    if (c == '"' || c == '\\') {
+      out[o++] = '\\';
+      out[o++] = c;
+    } else if ((uint8_t)c >= 0x20) {
+      out[o++] = c;
+    }
+  }
+  out[o] = '\0';
+}
+
+void publishTapEvent(const char* result, const String& name, bool offline) {
+  if (subscriberCount == 0) {
+    return;
+  }
+  char escapedName[40];
+  escapeJsonString(escapedName, sizeof(escapedName), name);
+
+  char fields[96];
+  snprintf(fields, sizeof(fields), "\"result\":\"%s\",\"name\":\"%s\",\"offline\":%s",
+           result, escapedName, offline ? "true" : "false");
+  publishEvent("tap", fields);
+}
+
+void publishConnectivityEvent(bool online, const char* reason) {
+  if (subscriberCount == 0) {
+    return;
+  }
+  char fields[80];
+  snprintf(fields, sizeof(fields), "\"online\":%s,\"reason\":\"%s\",\"breaker\":\"%s\"",
+           online ? "true" : "false", reason, breakerStateName());
+  publishEvent("connectivity", fields);
+}
+
+void publishSyncEvent(const char* phase, int synced, int total) {
+  if (subscriberCount == 0) {
+    return;
+  }
+  char fields[64];
+  snprintf(fields, sizeof(fields), "\"phase\":\"%s\",\"synced\":%d,\"total\":%d", phase, synced, total);
+  publishEvent("sync", fields);
+}
@@ -0,0 +1,36 @@
+/*
+ * Server-Sent Events stream for live terminal monitoring
+ * Attendee Attendance Terminal v2.0
+ *
+ * GET /api/events keeps the connection open and pushes tap results,
+ * connectivity changes, sync progress and queue depth as they happen.
+ * Events are formatted once into a shared ring; each subscriber only keeps
+ * a read position, and a subscriber that falls more than
+ * SSE_CLIENT_MAX_LAG events behind loses its oldest events.
+ */
+
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define SSE_MAX_SUBSCRIBERS 3           // Concurrent /api/events connections
+#define SSE_EVENT_RING 12               // Formatted events kept for all subscribers
+#define SSE_EVENT_MAX_LEN 144           // Bytes per formatted event (id/event/data lines)
+#define SSE_CLIENT_MAX_LAG 8            // Per-subscriber backlog before drop-oldest
+#define SSE_KEEPALIVE_MS 15000          // Comment line to keep idle proxies from closing
+
+// Subscription management
+bool addEventSubscriber(WiFiClient& client);
+int getEventSubscriberCount();
+unsigned long getEventsDroppedCount();
+void serviceEventStream();
+
+// Publishing (cheap no-ops when nobody is subscribed)
+void publishEvent(const char* type, const char* fields);
+void publishTapEvent(const char* result, const String& name, bool offline);
+void publishConnectivityEvent(bool online, const char* reason);
+void publishSyncEvent(const char* phase, int synced, int total);
+
+#endif // EVENT_STREAM_H
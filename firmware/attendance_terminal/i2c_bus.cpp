@@ -0,0 +1,243 @@
+/*
+ * I2C bus scheduler - Attendee Attendance Terminal v2.0
+ *
+ * Jobs are few and long-lived (an OLED frame in flight), so the queue is a
+ * small table scanned for the best entry; equal priorities run in the
+ * order they were queued.
+ */
+
+#include <Wire.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "i2c_bus.h"
+
+// External references from main file
+extern void restoreI2cDevices();
+
+#define I2C_MAX_JOBS 6
+#define I2C_RECOVERY_CLOCKS 9           // A slave mid-byte lets go of SDA by the ACK slot
+#define I2C_ERROR_LINE_BUSY 4           // endTransmission(): SDA or SCL held low
+#define I2C_ERROR_TIMEOUT 5             // endTransmission(): clock stretched past the limit
+
+struct I2cJob {
+  I2cStep step;
+  uint8_t priority;
+  bool queued;
+  uint32_t order;
+};
+
+struct I2cBusStats {
+  uint32_t submitted;
+  uint32_t rejected;            // Queue full
+  uint32_t completed;
+  uint32_t steps;
+  uint32_t busyMicros;          // Spent running queued steps
+  uint32_t maxStepMicros;       // Longest the queue held up the loop in one step
+  uint32_t errors;
+  uint32_t nacks;               // Of errors, ones that left the bus free (NACKs)
+  uint32_t recoveries;
+};
+
+static I2cJob jobs[I2C_MAX_JOBS];
+static I2cBusStats stats;
+static uint32_t nextOrder = 0;
+static uint8_t consecutiveErrors = 0;
+static unsigned long lastLineCheck = 0;
+static bool recovering = false;
+static bool running = false;
+
+// ========================================
+// SETUP
+// ========================================
+
+void i2cBusBegin() {
+  Wire.begin(SDA_PIN, SCL_PIN);
+  Wire.setClock(I2C_CLOCK_HZ);
+  Wire.setClockStretchLimit(I2C_STRETCH_LIMIT_US);
+}
+
+// ========================================
+// QUEUE
+// ========================================
+
+bool i2cBusSubmit(I2cPriority priority, I2cStep step) {
+  int freeSlot = -1;
+  for (uint8_t i = 0; i < I2C_MAX_JOBS; i++) {
+    if (jobs[i].queued && jobs[i].step == step) {
+      if (priority < jobs[i].priority) {
+        jobs[i].priority = priority;
+      }
+      return true;
+    }
+    if (!jobs[i].queued && freeSlot < 0) {
+      freeSlot = i;
+    }
+  }
+  if (freeSlot < 0) {
+    stats.rejected++;
+    return false;
+  }
+  jobs[freeSlot].step = step;
+  jobs[freeSlot].priority = priority;
+  jobs[freeSlot].queued = true;
+  jobs[freeSlot].order = nextOrder++;
+  stats.submitted++;
+  return true;
+}
+
+static int nextJob(uint8_t lowestPriority) {
+  int best = -1;
+  for (uint8_t i = 0; i < I2C_MAX_JOBS; i++) {
+    if (!jobs[i].queued || jobs[i].priority > lowestPriority) {
+      continue;
+    }
+    if (best < 0 || jobs[i].priority < jobs[best].priority ||
+        (jobs[i].priority == jobs[best].priority && (int32_t)(jobs[i].order - jobs[best].order) < 0)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+// budgetUs 0 = until no eligible job is left
+static void runJobs(uint8_t lowestPriority, uint32_t budgetUs) {
+  // A step that triggers a recovery re-presents frames; they just queue
+  if (running) {
+    return;
+  }
+  running = true;
+  unsigned long start = micros();
+  int index;
+  while ((index = nextJob(lowestPriority)) >= 0) {
+    unsigned long stepStart = micros();
+    bool finished = jobs[index].step();
+    uint32_t stepMicros = micros() - stepStart;
+
+    stats.steps++;
+    if (stepMicros > stats.maxStepMicros) {
+      stats.maxStepMicros = stepMicros;
+    }
+    if (finished) {
+      jobs[index].queued = false;
+      stats.completed++;
+    }
+    if (budgetUs > 0 && micros() - start >= budgetUs) {
+      break;
+    }
+  }
+  stats.busyMicros += micros() - start;
+  running = false;
+}
+
+void i2cBusDrain(I2cPriority priority) {
+  runJobs(priority, 0);
+}
+
+// Both lines idle high unless a transfer is running; the queue is
+// between steps here, so a low line means a slave is holding it
+static void checkLines() {
+  if (millis() - lastLineCheck < I2C_LINE_CHECK_MS) {
+    return;
+  }
+  lastLineCheck = millis();
+  if (digitalRead(SDA_PIN) == LOW || digitalRead(SCL_PIN) == LOW) {
+    i2cBusRecover();
+  }
+}
+
+void serviceI2cBus() {
+  checkLines();
+  runJobs(I2C_PRIO_DECOR, I2C_SLICE_US);
+}
+
+void i2cBusDelay(unsigned long ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    serviceI2cBus();
+    delay(1);
+  }
+}
+
+// ========================================
+// ERRORS AND RECOVERY
+// ========================================
+
+void i2cBusResult(uint8_t error) {
+  if (error == 0) {
+    consecutiveErrors = 0;
+    return;
+  }
+  stats.errors++;
+  // A NACK went through the address phase, so the lines are free
+  if (error != I2C_ERROR_LINE_BUSY && error != I2C_ERROR_TIMEOUT) {
+    stats.nacks++;
+    consecutiveErrors = 0;
+    return;
+  }
+  if (++consecutiveErrors >= I2C_STUCK_ERRORS) {
+    i2cBusRecover();
+  }
+}
+
+bool i2cBusRecover() {
+  // The redraw below goes through the bus again; don't recurse on its errors
+  if (recovering) {
+    return false;
+  }
+  recovering = true;
+  stats.recoveries++;
+  consecutiveErrors = 0;
+
+  pinMode(SDA_PIN, INPUT_PULLUP);
+  pinMode(SCL_PIN, OUTPUT_OPEN_DRAIN);
+  for (uint8_t i = 0; i < I2C_RECOVERY_CLOCKS && digitalRead(SDA_PIN) == LOW; i++) {
+    digitalWrite(SCL_PIN, LOW);
+    delayMicroseconds(5);
+    digitalWrite(SCL_PIN, HIGH);
+    delayMicroseconds(5);
+  }
+
+  // STOP: SDA rising while SCL is high
+  pinMode(SDA_PIN, OUTPUT_OPEN_DRAIN);
+  digitalWrite(SDA_PIN, LOW);
+  delayMicroseconds(5);
+  digitalWrite(SCL_PIN, HIGH);
+  delayMicroseconds(5);
+  digitalWrite(SDA_PIN, HIGH);
+  delayMicroseconds(5);
+
+  i2cBusBegin();
+  bool released = digitalRead(SDA_PIN) == HIGH && digitalRead(SCL_PIN) == HIGH;
+  if (released) {
+    LOG_WARN("I2C bus recovered");
+    // A device may have seen half a transfer; put every screen back
+    restoreI2cDevices();
+  } else {
+    LOG_ERROR("I2C bus still held low after recovery");
+  }
+  recovering = false;
+  return released;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void i2cBusToJson(JsonObject out) {
+  uint8_t queued = 0;
+  for (uint8_t i = 0; i < I2C_MAX_JOBS; i++) {
+    queued += jobs[i].queued ? 1 : 0;
+  }
+  out["clockHz"] = I2C_CLOCK_HZ;
+  out["queued"] = queued;
+  out["submitted"] = stats.submitted;
+  out["rejected"] = stats.rejected;
+  out["completed"] = stats.completed;
+  out["steps"] = stats.steps;
+  out["busyMicros"] = stats.busyMicros;
+  out["maxStepMicros"] = stats.maxStepMicros;
+  out["errors"] = stats.errors;
+  out["nacks"] = stats.nacks;
+  out["recoveries"] = stats.recoveries;
+}
@@ -0,0 +1,60 @@
+/*
+ * I2C bus scheduler for Attendee Attendance Terminal v2.0
+ *
+ * The 1602 LCD, the SSD1306 OLED and the DS3231 share one Wire bus, run
+ * in fast mode (I2C_CLOCK_HZ). Short transactions - RTC reads and LCD
+ * refreshes, a few dozen bytes - still run inline where they are made;
+ * nothing else holds the bus for longer than one queued step, so they
+ * never wait more than that.
+ *
+ * Long transfers are split into steps and queued by priority: a step is a
+ * function that moves one bounded piece (one 128-byte OLED page) and says
+ * whether the job is finished. serviceI2cBus() runs queued steps, highest
+ * priority first, for at most I2C_SLICE_US per call, so an OLED frame
+ * interleaves with loop work instead of blocking it. Tap feedback and
+ * status screens drain their own frame at once with i2cBusDrain();
+ * i2cBusDelay() and the reader polling delays keep the queue moving while
+ * the sketch waits.
+ *
+ * Transaction owners report endTransmission() results. I2C_STUCK_ERRORS
+ * bus errors in a row (line busy or timeout; an address or data NACK is
+ * just an absent or busy device), or a line found low while the bus is
+ * idle, trigger a recovery: clock SCL until the slave holding SDA lets go, send a STOP,
+ * restart Wire and have the displays redrawn.
+ */
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+enum I2cPriority : uint8_t {
+  I2C_PRIO_FEEDBACK = 0,        // Tap result screens
+  I2C_PRIO_STATUS,              // Loading and connection screens
+  I2C_PRIO_DECOR,               // Animation frames
+  I2C_PRIO_COUNT
+};
+
+// Moves one bounded piece of a transfer; true when the job is finished
+typedef bool (*I2cStep)();
+
+// Setup and loop hooks
+void i2cBusBegin();
+void serviceI2cBus();
+
+// Queue a job (a job already queued keeps its place, at the higher priority)
+bool i2cBusSubmit(I2cPriority priority, I2cStep step);
+// Run every queued job at this priority or above to completion
+void i2cBusDrain(I2cPriority priority);
+// delay() that keeps the queue moving
+void i2cBusDelay(unsigned long ms);
+
+// Transaction owners report Wire.endTransmission() results
+void i2cBusResult(uint8_t error);
+bool i2cBusRecover();
+
+// Status
+void i2cBusToJson(JsonObject out);
+
+#endif // I2C_BUS_H
@@ -0,0 +1,324 @@
+/*
+ * Static arena for JSON documents and HTTP buffers - Attendee Attendance Terminal v2.0
+ *
+ * A bump allocator over a fixed buffer. Each block starts with a 4-byte
+ * header holding its size and the offset of the block before it. Freeing
+ * the newest block therefore pops it and makes the previous one newest.
+ * Freeing any other block does nothing; the space comes back when the
+ * enclosing scope closes.
+ *
+ * Offsets are uint16_t, which caps JSON_ARENA_SIZE at 64 KB. ArduinoJson
+ * aligns its own pool to pointer size, so 4-byte alignment is enough.
+ */
+
+#include "config.h"
+#include "json_arena.h"
+
+#define ARENA_ALIGN 4
+#define ARENA_NO_BLOCK 0xFFFF
+
+struct ArenaBlockHeader {
+  uint16_t size;                // Data bytes after the header, aligned
+  uint16_t prev;                // Data offset of the block before, or ARENA_NO_BLOCK
+};
+
+struct ArenaSite {
+  const char* name;
+  uint32_t calls;
+  uint32_t spills;              // Allocations that went to the heap
+  uint16_t peak;                // Most arena bytes held at once, nested scopes included
+};
+
+static uint8_t arena[JSON_ARENA_SIZE] __attribute__((aligned(ARENA_ALIGN)));
+static uint16_t top = 0;                    // First free byte
+static uint16_t last = ARENA_NO_BLOCK;      // Data offset of the newest block
+static uint16_t scopePeak = 0;              // Highest top since the innermost scope opened
+static uint16_t highWater = 0;
+static uint8_t depth = 0;
+static int8_t currentSite = -1;
+
+static ArenaSite sites[ARENA_MAX_SITES];
+static uint8_t siteCount = 0;
+static uint32_t spills = 0;
+static uint32_t spillBytes = 0;
+static uint32_t failures = 0;               // Heap fallback failed too
+
+static bool inArena(const void* ptr) {
+  return ptr >= (const void*)arena && ptr < (const void*)(arena + JSON_ARENA_SIZE);
+}
+
+static ArenaBlockHeader* headerOf(uint16_t offset) {
+  return (ArenaBlockHeader*)(arena + offset - sizeof(ArenaBlockHeader));
+}
+
+static int8_t findSite(const char* name) {
+  for (uint8_t i = 0; i < siteCount; i++) {
+    if (sites[i].name == name || strcmp(sites[i].name, name) == 0) {
+      return i;
+    }
+  }
+  if (siteCount >= ARENA_MAX_SITES) {
+    return -1;
+  }
+  memset(&sites[siteCount], 0, sizeof(ArenaSite));
+  sites[siteCount].name = name;
+  return siteCount++;
+}
+
+// ========================================
+// SCOPES
+// ========================================
+
+ArenaScope::ArenaScope(const char* site) {
+  mark = top;
+  markLast = last;
+  outerPeak = scopePeak;
+  outerSite = currentSite;
+  scopePeak = top;
+  currentSite = findSite(site);
+  depth++;
+}
+
+ArenaScope::~ArenaScope() {
+  if (currentSite >= 0) {
+    ArenaSite& site = sites[currentSite];
+    site.calls++;
+    uint16_t held = scopePeak - mark;
+    if (held > site.peak) {
+      site.peak = held;
+    }
+  }
+  top = mark;
+  last = markLast;
+  if (outerPeak > scopePeak) {
+    scopePeak = outerPeak;
+  }
+  currentSite = outerSite;
+  depth--;
+}
+
+// ========================================
+// ALLOCATION
+// ========================================
+
+static void* heapSpill(size_t size) {
+  void* ptr = malloc(size);
+  if (!ptr) {
+    failures++;
+    return nullptr;
+  }
+  spills++;
+  spillBytes += size;
+  if (currentSite >= 0) {
+    sites[currentSite].spills++;
+  }
+  return ptr;
+}
+
+void* arenaAlloc(size_t size) {
+  size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  size_t needed = sizeof(ArenaBlockHeader) + aligned;
+  if (depth == 0 || size == 0 || needed > (size_t)(JSON_ARENA_SIZE - top)) {
+    return heapSpill(size);
+  }
+
+  uint16_t offset = top + sizeof(ArenaBlockHeader);
+  ArenaBlockHeader* header = headerOf(offset);
+  header->size = aligned;
+  header->prev = last;
+  last = offset;
+  top = offset + aligned;
+  if (top > scopePeak) {
+    scopePeak = top;
+  }
+  if (top > highWater) {
+    highWater = top;
+  }
+  return arena + offset;
+}
+
+void arenaFree(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  if (!inArena(ptr)) {
+    free(ptr);
+    return;
+  }
+  uint16_t offset = (uint8_t*)ptr - arena;
+  if (offset == last) {
+    top = offset - sizeof(ArenaBlockHeader);
+    last = headerOf(offset)->prev;
+  }
+}
+
+void* arenaRealloc(void* ptr, size_t size) {
+  if (!ptr) {
+    return arenaAlloc(size);
+  }
+  if (!inArena(ptr)) {
+    return realloc(ptr, size);
+  }
+
+  uint16_t offset = (uint8_t*)ptr - arena;
+  ArenaBlockHeader* header = headerOf(offset);
+  size_t aligned = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+  if (aligned <= header->size) {
+    if (offset == last) {
+      header->size = aligned;
+      top = offset + aligned;
+    }
+    return ptr;
+  }
+  // The newest block grows in place when there is room
+  if (offset == last && offset + aligned <= JSON_ARENA_SIZE) {
+    header->size = aligned;
+    top = offset + aligned;
+    if (top > scopePeak) {
+      scopePeak = top;
+    }
+    if (top > highWater) {
+      highWater = top;
+    }
+    return ptr;
+  }
+
+  void* moved = arenaAlloc(size);
+  if (moved) {
+    memcpy(moved, ptr, header->size);
+  }
+  return moved;
+}
+
+// ========================================
+// BUFFERS
+// ========================================
+
+static char emptyBuffer[1] = { '\0' };
+
+ArenaBuffer::ArenaBuffer(size_t capacity) : used(0) {
+  buffer = (char*)arenaAlloc(capacity);
+  size = buffer ? capacity : 0;
+  if (!buffer) {
+    buffer = emptyBuffer;
+  }
+}
+
+ArenaBuffer::ArenaBuffer(const JsonDocument& doc) : ArenaBuffer(measureJson(doc) + 1) {
+  if (size > 0) {
+    used = serializeJson(doc, buffer, size);
+  }
+}
+
+ArenaBuffer::~ArenaBuffer() {
+  if (buffer != emptyBuffer) {
+    arenaFree(buffer);
+  }
+}
+
+ArenaChunkWriter::ArenaChunkWriter(ESP8266WebServer& server)
+  : server(server), chunk(ARENA_CHUNK_SIZE), filled(0) {}
+
+size_t ArenaChunkWriter::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t ArenaChunkWriter::write(const uint8_t* data, size_t length) {
+  if (chunk.capacity() == 0) {
+    server.sendContent((const char*)data, length);
+    return length;
+  }
+  for (size_t done = 0; done < length;) {
+    size_t room = chunk.capacity() - filled;
+    size_t part = length - done < room ? length - done : room;
+    memcpy(chunk.data() + filled, data + done, part);
+    filled += part;
+    done += part;
+    if (filled == chunk.capacity()) {
+      flush();
+    }
+  }
+  return length;
+}
+
+void ArenaChunkWriter::flush() {
+  if (filled > 0) {
+    server.sendContent(chunk.data(), filled);
+    filled = 0;
+  }
+}
+
+void arenaSendJson(ESP8266WebServer& server, int code, const JsonDocument& doc) {
+  server.setContentLength(measureJson(doc));
+  server.send(code, "application/json", "");
+  ArenaChunkWriter writer(server);
+  serializeJson(doc, writer);
+  writer.flush();
+}
+
+// Passes on a serialized object without its outer braces
+class ArenaMemberWriter : public Print {
+public:
+  ArenaMemberWriter(Print& out, size_t length) : out(out), length(length), pos(0) {}
+
+  size_t write(uint8_t c) override {
+    if (pos != 0 && pos != length - 1) {
+      out.write(c);
+    }
+    pos++;
+    return 1;
+  }
+
+private:
+  Print& out;
+  size_t length;
+  size_t pos;
+};
+
+ArenaJsonStream::ArenaJsonStream(ESP8266WebServer& server, int code)
+  : server(server), writer(server), first(true) {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(code, "application/json", "");
+  writer.write('{');
+}
+
+ArenaJsonStream::~ArenaJsonStream() {
+  writer.write('}');
+  writer.flush();
+  server.sendContent("");
+}
+
+void ArenaJsonStream::add(const JsonDocument& members) {
+  size_t length = measureJson(members);
+  if (!members.is<JsonObjectConst>() || length <= 2) {
+    return;
+  }
+  if (!first) {
+    writer.write(',');
+  }
+  first = false;
+  ArenaMemberWriter inner(writer, length);
+  serializeJson(members, inner);
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void arenaToJson(JsonObject out) {
+  out["size"] = JSON_ARENA_SIZE;
+  out["used"] = top;
+  out["highWater"] = highWater;
+  out["spills"] = spills;
+  out["spillBytes"] = spillBytes;
+  out["failures"] = failures;
+
+  JsonArray list = out.createNestedArray("sites");
+  for (uint8_t i = 0; i < siteCount; i++) {
+    JsonObject entry = list.createNestedObject();
+    entry["site"] = sites[i].name;
+    entry["calls"] = sites[i].calls;
+    entry["peak"] = sites[i].peak;
+    entry["spills"] = sites[i].spills;
+  }
+}
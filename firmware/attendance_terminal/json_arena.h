@@ -0,0 +1,120 @@
+/*
+ * Static arena for JSON documents and HTTP buffers - Attendee Attendance Terminal v2.0
+ *
+ *   ArenaScope arena("tap-post");
+ *   ArenaJsonDocument doc(200);
+ *   doc["rfidTag"] = rfidTag;
+ *   ArenaBuffer payload(doc);
+ *   http.POST((const uint8_t*)payload.data(), payload.length());
+ *
+ * JSON documents and request/response text are carved from one buffer of
+ * JSON_ARENA_SIZE bytes reserved at link time. They no longer sit on the
+ * 4 KB CONT stack, and they no longer churn the heap through String.
+ *
+ * An ArenaScope is a checkpoint. Everything allocated after it is released
+ * when it goes out of scope. A block freed while it is the newest one is
+ * returned at once, so a loop that builds and drops one document per
+ * pass does not grow. Scopes nest. Each scope names its call site, and
+ * the site records the most arena bytes it held at once.
+ *
+ * When the arena is full, or there is no open scope, an allocation falls
+ * back to the heap and is counted as a spill against the site. Declare the
+ * scope before the documents and buffers that use it, so they are
+ * destroyed first.
+ */
+
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESP8266WebServer.h>
+
+// Checkpoint for one call site; the name must be a string literal
+class ArenaScope {
+public:
+  explicit ArenaScope(const char* site);
+  ~ArenaScope();
+
+private:
+  uint16_t mark;                // Arena top when the scope opened
+  uint16_t markLast;            // Newest block when the scope opened
+  uint16_t outerPeak;           // Enclosing scope's peak, restored on close
+  int8_t outerSite;
+};
+
+void* arenaAlloc(size_t size);
+void* arenaRealloc(void* ptr, size_t size);
+void arenaFree(void* ptr);
+
+// ArduinoJson allocator backed by the arena
+struct ArenaAllocator {
+  void* allocate(size_t size) { return arenaAlloc(size); }
+  void deallocate(void* ptr) { arenaFree(ptr); }
+  void* reallocate(void* ptr, size_t size) { return arenaRealloc(ptr, size); }
+};
+
+typedef BasicJsonDocument<ArenaAllocator> ArenaJsonDocument;
+
+// Byte buffer from the arena, released when it goes out of scope
+class ArenaBuffer {
+public:
+  explicit ArenaBuffer(size_t capacity);
+  explicit ArenaBuffer(const JsonDocument& doc);    // The document serialized, NUL-terminated
+  ~ArenaBuffer();
+
+  char* data() { return buffer; }
+  size_t capacity() const { return size; }
+  size_t length() const { return used; }
+
+private:
+  ArenaBuffer(const ArenaBuffer&);
+  ArenaBuffer& operator=(const ArenaBuffer&);
+
+  char* buffer;
+  size_t size;
+  size_t used;
+};
+
+// Collects serializeJson() output and passes it on in ARENA_CHUNK_SIZE pieces
+class ArenaChunkWriter : public Print {
+public:
+  explicit ArenaChunkWriter(ESP8266WebServer& server);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t length) override;
+  void flush() override;
+
+private:
+  ESP8266WebServer& server;
+  ArenaBuffer chunk;
+  size_t filled;
+};
+
+// Sends the document with a Content-Length, in ARENA_CHUNK_SIZE pieces
+void arenaSendJson(ESP8266WebServer& server, int code, const JsonDocument& doc);
+
+// One JSON object sent in sections, for responses larger than the arena.
+// Each add() merges the members of an object document into the response,
+// so a section's document can be dropped before the next one is built.
+// The response is chunked and ends when the stream goes out of scope.
+class ArenaJsonStream {
+public:
+  ArenaJsonStream(ESP8266WebServer& server, int code);
+  ~ArenaJsonStream();
+
+  void add(const JsonDocument& members);
+
+private:
+  ArenaJsonStream(const ArenaJsonStream&);
+  ArenaJsonStream& operator=(const ArenaJsonStream&);
+
+  ESP8266WebServer& server;
+  ArenaChunkWriter writer;
+  bool first;
+};
+
+// Status: fill, high-water mark, spills, and the peak per call site
+void arenaToJson(JsonObject out);
+
+#endif // JSON_ARENA_H
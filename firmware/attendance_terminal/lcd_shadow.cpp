@@ -0,0 +1,245 @@
+/*
+ * Shadow-buffer 1602 LCD driver - Attendee Attendance Terminal v2.0
+ *
+ * PCF8574 backpack wiring: P0 = RS, P1 = RW, P2 = EN, P3 = backlight,
+ * P4-P7 = D4-D7. Each nibble is two expander bytes, EN high then EN low;
+ * the HD44780 latches on the falling edge. One HD44780 byte is therefore
+ * four I2C bytes, and the next byte's first latch comes two I2C bytes
+ * (18 bit times, 45 us at 400 kHz) after the previous one, past the 37 us
+ * a write takes, so no busy polling or delays are needed between
+ * characters.
+ */
+
+#include "config.h"
+#if DISPLAY_LCD_FITTED
+
+#include <Wire.h>
+#include "lcd_shadow.h"
+#include "i2c_bus.h"
+
+#define LCD_RS 0x01
+#define LCD_EN 0x04
+
+#define LCD_CMD_CLEAR 0x01
+#define LCD_CMD_ENTRY_MODE 0x06         // Increment, no shift
+#define LCD_CMD_DISPLAY_ON 0x0C         // Display on, cursor and blink off
+#define LCD_CMD_FUNCTION_SET 0x28       // 4-bit, 2 lines, 5x8 font
+#define LCD_CMD_SET_CGRAM 0x40
+#define LCD_CMD_SET_DDRAM 0x80
+
+// LiquidCrystal_I2C sends every nibble as expander write + EN high + EN
+// low, three transactions of address + data: 12 bytes per HD44780 byte
+#define STOCK_BYTES_PER_WRITE 12
+
+static const uint8_t ROW_OFFSETS[] = { 0x00, 0x40 };
+
+static const uint8_t GLYPHS[][8] = {
+  { 0x00, 0x0E, 0x11, 0x04, 0x0A, 0x00, 0x04, 0x00 },  // LCD_GLYPH_WIFI
+  { 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x00, 0x04, 0x00 },  // LCD_GLYPH_NO_WIFI
+  { 0x1F, 0x11, 0x1F, 0x11, 0x1F, 0x11, 0x1F, 0x00 },  // LCD_GLYPH_QUEUE
+};
+
+// ========================================
+// BUS
+// ========================================
+
+void ShadowLcd::sendQueued() {
+  if (_outLen == 0) {
+    return;
+  }
+  unsigned long start = micros();
+  Wire.beginTransmission(_address);
+  Wire.write(_out, _outLen);
+  uint8_t error = Wire.endTransmission();
+  if (error != 0) {
+    _stats.busErrors++;
+    _glassAddress = -1;
+    _writeFailed = true;
+  }
+  _stats.busMicros += micros() - start;
+  _stats.busBytes += _outLen + 1;
+  _stats.busTransactions++;
+  _outLen = 0;
+  i2cBusResult(error);
+}
+
+void ShadowLcd::queueNibble(uint8_t nibble, uint8_t mode) {
+  if (_outLen + 2 > sizeof(_out)) {
+    sendQueued();
+  }
+  uint8_t value = (nibble & 0xF0) | mode | _backlight;
+  _out[_outLen++] = value | LCD_EN;
+  _out[_outLen++] = value;
+}
+
+void ShadowLcd::queueByte(uint8_t value, bool isData) {
+  // Both nibbles in the same transaction
+  if (_outLen + 4 > sizeof(_out)) {
+    sendQueued();
+  }
+  uint8_t mode = isData ? LCD_RS : 0;
+  queueNibble(value & 0xF0, mode);
+  queueNibble(value << 4, mode);
+}
+
+void ShadowLcd::command(uint8_t value) {
+  queueByte(value, false);
+  sendQueued();
+}
+
+// ========================================
+// SETUP
+// ========================================
+
+void ShadowLcd::init() {
+  // Power-on reset sequence into 4-bit mode (datasheet figure 24)
+  delay(50);
+  queueNibble(0x30, 0);
+  sendQueued();
+  delayMicroseconds(4500);
+  queueNibble(0x30, 0);
+  sendQueued();
+  delayMicroseconds(4500);
+  queueNibble(0x30, 0);
+  sendQueued();
+  delayMicroseconds(150);
+  queueNibble(0x20, 0);
+  sendQueued();
+
+  command(LCD_CMD_FUNCTION_SET);
+  command(LCD_CMD_DISPLAY_ON);
+  command(LCD_CMD_CLEAR);
+  delayMicroseconds(2000);
+  command(LCD_CMD_ENTRY_MODE);
+  uploadGlyphs();
+
+  memset(_glass, ' ', sizeof(_glass));
+  _glassAddress = -1;               // CGRAM writes left the address counter there
+  clear();
+}
+
+void ShadowLcd::uploadGlyphs() {
+  queueByte(LCD_CMD_SET_CGRAM | (LCD_GLYPH_WIFI << 3), false);
+  for (uint8_t g = 0; g < sizeof(GLYPHS) / sizeof(GLYPHS[0]); g++) {
+    for (uint8_t line = 0; line < 8; line++) {
+      queueByte(GLYPHS[g][line], true);
+    }
+  }
+  sendQueued();
+}
+
+void ShadowLcd::backlight() {
+  _backlight = 0x08;
+  _out[_outLen++] = _backlight;
+  sendQueued();
+}
+
+void ShadowLcd::noBacklight() {
+  _backlight = 0x00;
+  _out[_outLen++] = _backlight;
+  sendQueued();
+}
+
+// ========================================
+// DRAWING
+// ========================================
+
+void ShadowLcd::clear() {
+  memset(_shadow, ' ', sizeof(_shadow));
+  _col = 0;
+  _row = 0;
+  _stats.stockBytes += STOCK_BYTES_PER_WRITE;
+}
+
+void ShadowLcd::setCursor(uint8_t col, uint8_t row) {
+  _col = col;
+  _row = row < LCD_ROWS ? row : LCD_ROWS - 1;
+  _stats.stockBytes += STOCK_BYTES_PER_WRITE;
+}
+
+size_t ShadowLcd::write(uint8_t c) {
+  // Past the last column the HD44780 writes off-screen DDRAM; drop it here
+  if (_col < LCD_COLS) {
+    _shadow[_row][_col] = c;
+  }
+  _col++;
+  _stats.stockBytes += STOCK_BYTES_PER_WRITE;
+  return 1;
+}
+
+void ShadowLcd::invalidate() {
+  // No cell can match; the next refresh rewrites all of them
+  memset(_glass, 0xFF, sizeof(_glass));
+  _glassAddress = -1;
+  _needsRewrite = true;
+}
+
+void ShadowLcd::refresh() {
+  _stats.refreshes++;
+  bool changed = false;
+
+  for (uint8_t row = 0; row < LCD_ROWS; row++) {
+    uint8_t col = 0;
+    while (col < LCD_COLS) {
+      if (_shadow[row][col] == _glass[row][col]) {
+        col++;
+        continue;
+      }
+      // A run ends at two unchanged cells in a row; one is cheaper to
+      // rewrite (4 bytes) than to skip with a cursor move (also 4)
+      uint8_t end = col + 1;
+      while (end < LCD_COLS &&
+             (_shadow[row][end] != _glass[row][end] ||
+              (end + 1 < LCD_COLS && _shadow[row][end + 1] != _glass[row][end + 1]))) {
+        end++;
+      }
+
+      uint8_t address = ROW_OFFSETS[row] + col;
+      if (_glassAddress != address) {
+        queueByte(LCD_CMD_SET_DDRAM | address, false);
+        _stats.cursorMoves++;
+      }
+      for (uint8_t c = col; c < end; c++) {
+        queueByte(_shadow[row][c], true);
+        _glass[row][c] = _shadow[row][c];
+        _stats.charsWritten++;
+      }
+      _glassAddress = ROW_OFFSETS[row] + end;
+      changed = true;
+      col = end;
+    }
+  }
+
+  if (changed) {
+    sendQueued();
+  } else {
+    _stats.idleRefreshes++;
+  }
+
+  // Cells are marked written as they are queued; after a failed
+  // transaction neither they nor the address counter can be trusted
+  if (_writeFailed) {
+    _writeFailed = false;
+    invalidate();
+  } else {
+    _needsRewrite = false;
+  }
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void ShadowLcd::toJson(JsonObject out) const {
+  out["refreshes"] = _stats.refreshes;
+  out["idleRefreshes"] = _stats.idleRefreshes;
+  out["charsWritten"] = _stats.charsWritten;
+  out["cursorMoves"] = _stats.cursorMoves;
+  out["busBytes"] = _stats.busBytes;
+  out["busTransactions"] = _stats.busTransactions;
+  out["busMicros"] = _stats.busMicros;
+  out["busErrors"] = _stats.busErrors;
+  out["stockBytes"] = _stats.stockBytes;
+}
+
+#endif // DISPLAY_LCD_FITTED
@@ -0,0 +1,90 @@
+/*
+ * Shadow-buffer 1602 LCD driver
+ * Attendee Attendance Terminal v2.0
+ *
+ * Drop-in for LiquidCrystal_I2C on the PCF8574 backpack. clear(),
+ * setCursor() and print() only draw into a RAM copy of the 16x2 screen;
+ * refresh() compares it with what is on the glass and sends just the
+ * changed runs, moving the cursor only where a run does not continue
+ * from the last write. Nibble strobes of consecutive bytes are packed
+ * into one I2C transaction instead of LiquidCrystal_I2C's three per
+ * nibble, and clear() never reaches the controller (no 1.5 ms wait).
+ *
+ * The Wi-Fi and queue status icons are uploaded to CGRAM once by init()
+ * and printed with write(LCD_GLYPH_*).
+ *
+ * stats() counts what went over the bus, and what LiquidCrystal_I2C
+ * would have sent for the same calls, for /api/status.
+ */
+
+#ifndef LCD_SHADOW_H
+#define LCD_SHADOW_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+// CGRAM glyphs (slot 0 is left free so a glyph never ends a C string)
+#define LCD_GLYPH_WIFI 1
+#define LCD_GLYPH_NO_WIFI 2
+#define LCD_GLYPH_QUEUE 3
+
+struct LcdBusStats {
+  uint32_t refreshes;
+  uint32_t idleRefreshes;       // Nothing had changed, nothing sent
+  uint32_t charsWritten;
+  uint32_t cursorMoves;
+  uint32_t busBytes;            // Including each transaction's address byte
+  uint32_t busTransactions;
+  uint32_t busMicros;           // Time spent in Wire transactions
+  uint32_t busErrors;           // Transactions not acknowledged
+  uint32_t stockBytes;          // LiquidCrystal_I2C equivalent of the same calls
+};
+
+class ShadowLcd : public Print {
+public:
+  explicit ShadowLcd(uint8_t address) : _address(address) {}
+
+  // Wire must already be started
+  void init();
+  void backlight();
+  void noBacklight();
+
+  // Drawing, into the shadow buffer only
+  void clear();
+  void setCursor(uint8_t col, uint8_t row);
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  // Send what changed since the last refresh
+  void refresh();
+  // Rewrite every cell on the next refresh (after a glitch on the bus);
+  // a refresh with a failed transaction does this itself
+  void invalidate();
+  bool needsRewrite() const { return _needsRewrite; }
+
+  const LcdBusStats& stats() const { return _stats; }
+  void toJson(JsonObject out) const;
+
+private:
+  void queueByte(uint8_t value, bool isData);
+  void queueNibble(uint8_t nibble, uint8_t mode);
+  void sendQueued();
+  void command(uint8_t value);
+  void uploadGlyphs();
+
+  uint8_t _address;
+  uint8_t _backlight = 0x08;
+  char _shadow[LCD_ROWS][LCD_COLS];
+  char _glass[LCD_ROWS][LCD_COLS];
+  uint8_t _col = 0;
+  uint8_t _row = 0;
+  int _glassAddress = -1;       // DDRAM address the controller will write next, -1 unknown
+  bool _writeFailed = false;    // A transaction failed since the last refresh
+  bool _needsRewrite = false;   // _glass is unknown until a refresh goes through
+  uint8_t _out[32];
+  uint8_t _outLen = 0;
+  LcdBusStats _stats = LcdBusStats();
+};
+
+#endif // LCD_SHADOW_H
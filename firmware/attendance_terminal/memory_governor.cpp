@@ -0,0 +1,165 @@
+/*
+ * Memory-pressure governor - Attendee Attendance Terminal v2.0
+ *
+ * The largest free block matters as much as the total: a BearSSL
+ * handshake fails on a fragmented heap that still shows plenty free.
+ * Features are shed in apply(); most consumers read the level through
+ * the gates when they next run.
+ */
+
+#include "config.h"
+#include "debug_log.h"
+#include "memory_governor.h"
+#if DISPLAY_OLED_FITTED
+#include "oled_anim.h"
+#endif
+
+// External references from main file
+extern WiFiClientSecure wifiClientSecure;
+
+struct MemThreshold {
+  uint32_t freeHeap;
+  uint32_t maxBlock;
+};
+
+// Indexed by MemLevel; NORMAL has no threshold
+static const MemThreshold THRESHOLDS[MEM_LEVEL_COUNT] = {
+  { 0, 0 },
+  { MEM_TIGHT_FREE, MEM_TIGHT_BLOCK },
+  { MEM_LOW_FREE, MEM_LOW_BLOCK },
+  { MEM_CRITICAL_FREE, MEM_CRITICAL_BLOCK },
+};
+
+static const char* const LEVEL_NAMES[MEM_LEVEL_COUNT] = { "normal", "tight", "low", "critical" };
+
+struct MemGovernorStats {
+  uint32_t transitions;
+  uint32_t entered[MEM_LEVEL_COUNT];
+  uint32_t minFreeHeap;
+  uint32_t minMaxBlock;
+};
+
+static MemLevel level = MEM_LEVEL_NORMAL;
+static bool easing = false;
+static unsigned long easingSince = 0;
+static unsigned long levelSince = 0;
+static uint32_t lastFreeHeap = 0;
+static uint32_t lastMaxBlock = 0;
+static MemGovernorStats stats = { 0, { 0 }, UINT32_MAX, UINT32_MAX };
+
+// Highest level whose threshold, raised by margin, the sample is under
+static MemLevel levelFor(uint32_t freeHeap, uint32_t maxBlock, uint32_t margin) {
+  for (uint8_t i = MEM_LEVEL_COUNT - 1; i > MEM_LEVEL_NORMAL; i--) {
+    if (freeHeap < THRESHOLDS[i].freeHeap + margin || maxBlock < THRESHOLDS[i].maxBlock + margin) {
+      return (MemLevel)i;
+    }
+  }
+  return MEM_LEVEL_NORMAL;
+}
+
+static void apply(MemLevel from, MemLevel to) {
+  // An idle keep-alive session holds the engine and both buffers; the next
+  // request reconnects with the smaller ones
+  if (to >= MEM_LEVEL_TIGHT && from < MEM_LEVEL_TIGHT && wifiClientSecure.connected()) {
+    wifiClientSecure.stop();
+  }
+#if DISPLAY_OLED_FITTED
+  animSetEnabled(to < MEM_LEVEL_LOW);
+#endif
+}
+
+static void setLevel(MemLevel to) {
+  MemLevel from = level;
+  level = to;
+  levelSince = millis();
+  stats.transitions++;
+  stats.entered[to]++;
+  apply(from, to);
+
+  if (to > from) {
+    LOG_WARN("Memory %s -> %s: free %lu, largest block %lu", LEVEL_NAMES[from], LEVEL_NAMES[to],
+             (unsigned long)lastFreeHeap, (unsigned long)lastMaxBlock);
+  } else {
+    LOG_INFO("Memory %s -> %s: free %lu, largest block %lu", LEVEL_NAMES[from], LEVEL_NAMES[to],
+             (unsigned long)lastFreeHeap, (unsigned long)lastMaxBlock);
+  }
+}
+
+// ========================================
+// SAMPLING
+// ========================================
+
+void serviceMemoryGovernor() {
+  lastFreeHeap = ESP.getFreeHeap();
+  lastMaxBlock = ESP.getMaxFreeBlockSize();
+  if (lastFreeHeap < stats.minFreeHeap) {
+    stats.minFreeHeap = lastFreeHeap;
+  }
+  if (lastMaxBlock < stats.minMaxBlock) {
+    stats.minMaxBlock = lastMaxBlock;
+  }
+
+  MemLevel pressure = levelFor(lastFreeHeap, lastMaxBlock, 0);
+  if (pressure > level) {
+    easing = false;
+    setLevel(pressure);
+    return;
+  }
+
+  if (levelFor(lastFreeHeap, lastMaxBlock, MEM_HYSTERESIS_BYTES) >= level) {
+    easing = false;
+    return;
+  }
+  unsigned long now = millis();
+  if (!easing) {
+    easing = true;
+    easingSince = now;
+  } else if (now - easingSince >= MEM_RESTORE_MS) {
+    // The next step down needs its own quiet period
+    easingSince = now;
+    setLevel((MemLevel)(level - 1));
+  }
+}
+
+// ========================================
+// GATES
+// ========================================
+
+MemLevel memLevel() {
+  return level;
+}
+
+const char* memLevelName(MemLevel value) {
+  return value < MEM_LEVEL_COUNT ? LEVEL_NAMES[value] : "unknown";
+}
+
+bool memNetworkAllowed() {
+  return level < MEM_LEVEL_CRITICAL;
+}
+
+int memSyncBatchLimit() {
+  return level >= MEM_LEVEL_LOW ? MEM_SYNC_BATCH_LOW : SYNC_SLICE_MAX_RECORDS;
+}
+
+void memConfigureTls(WiFiClientSecure& client) {
+  client.setBufferSizes(level >= MEM_LEVEL_TIGHT ? MEM_TLS_RX_BUFFER_MIN : MEM_TLS_RX_BUFFER,
+                        MEM_TLS_TX_BUFFER);
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void memGovernorToJson(JsonObject out) {
+  out["level"] = LEVEL_NAMES[level];
+  out["levelMs"] = millis() - levelSince;
+  out["freeHeap"] = lastFreeHeap;
+  out["maxBlock"] = lastMaxBlock;
+  out["minFreeHeap"] = stats.minFreeHeap;
+  out["minMaxBlock"] = stats.minMaxBlock;
+  out["transitions"] = stats.transitions;
+  JsonObject entered = out.createNestedObject("entered");
+  for (uint8_t i = MEM_LEVEL_TIGHT; i < MEM_LEVEL_COUNT; i++) {
+    entered[LEVEL_NAMES[i]] = stats.entered[i];
+  }
+}
@@ -0,0 +1,49 @@
+/*
+ * Memory-pressure governor for Attendee Attendance Terminal v2.0
+ *
+ * BearSSL, String building and JSON documents share about 40 KB of heap.
+ * The governor samples the free heap and the largest free block, and
+ * sheds features in steps as either runs low:
+ *
+ *   NORMAL    everything on
+ *   TIGHT     smaller TLS receive buffers; the idle TLS connection is closed
+ *   LOW       also no OLED animations, and sync slices of MEM_SYNC_BATCH_LOW
+ *   CRITICAL  also offline-only: taps are stored, and heartbeat, sync and
+ *             backend probes wait
+ *
+ * A level is entered as soon as a sample crosses its threshold. It is left
+ * one step at a time, once the samples have cleared the thresholds by
+ * MEM_HYSTERESIS_BYTES for MEM_RESTORE_MS. Transitions are logged and
+ * counted, and the counts go out with the heartbeat.
+ */
+
+#ifndef MEMORY_GOVERNOR_H
+#define MEMORY_GOVERNOR_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFiClientSecure.h>
+
+enum MemLevel : uint8_t {
+  MEM_LEVEL_NORMAL = 0,
+  MEM_LEVEL_TIGHT,
+  MEM_LEVEL_LOW,
+  MEM_LEVEL_CRITICAL,
+  MEM_LEVEL_COUNT
+};
+
+// Scheduled task; also called right before a tap is sent
+void serviceMemoryGovernor();
+
+MemLevel memLevel();
+const char* memLevelName(MemLevel level);
+
+// Feature gates
+bool memNetworkAllowed();                       // False at CRITICAL: offline-only
+int memSyncBatchLimit();                        // Records per sync slice
+void memConfigureTls(WiFiClientSecure& client); // Buffer sizes for the next connect
+
+// Status and heartbeat: level, heap samples and transition counts
+void memGovernorToJson(JsonObject out);
+
+#endif // MEMORY_GOVERNOR_H
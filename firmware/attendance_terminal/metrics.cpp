@@ -0,0 +1,275 @@
+/*
+ * Prometheus metrics for Attendee Attendance Terminal v2.0
+ *
+ * Histograms store per-bucket (non-cumulative) counts; writeMetrics() turns
+ * them into the cumulative "le" series Prometheus expects while streaming.
+ * Latencies are kept in integer milliseconds/microseconds and printed as
+ * seconds without floating point.
+ */
+
+#include <ESP8266WiFi.h>
+#include <stdarg.h>
+#include "config.h"
+#include "metrics.h"
+#include "circuit_breaker.h"
+#include "event_stream.h"
+#include "offline_staging.h"
+
+// External references from main file
+extern String deviceId;
+extern bool isOnline;
+extern int offlineLogsCount;
+
+// ========================================
+// COUNTERS
+// ========================================
+
+static const char* const TAP_OUTCOMES[] = { "entry", "exit", "complete", "ok", "error", "offline", "queued", "duplicate" };
+#define TAP_OUTCOME_COUNT (sizeof(TAP_OUTCOMES) / sizeof(TAP_OUTCOMES[0]))
+
+static const char* const HTTP_TARGET_NAMES[METRIC_HTTP_TARGET_COUNT] = {
+  "attendance", "sync", "heartbeat", "health"
+};
+
+// Upper bounds in ms; the +Inf bucket is the total count
+static const uint16_t HTTP_BUCKETS_MS[] = { 100, 250, 500, 1000, 2500, 5000 };
+#define HTTP_BUCKET_COUNT (sizeof(HTTP_BUCKETS_MS) / sizeof(HTTP_BUCKETS_MS[0]))
+
+// Upper bounds in us
+static const uint32_t LOOP_BUCKETS_US[] = { 1000, 5000, 10000, 50000, 100000, 500000, 1000000 };
+#define LOOP_BUCKET_COUNT (sizeof(LOOP_BUCKETS_US) / sizeof(LOOP_BUCKETS_US[0]))
+
+struct HttpHistogram {
+  uint32_t buckets[HTTP_BUCKET_COUNT];
+  uint32_t count;
+  uint32_t errors;
+  uint32_t sumMs;
+};
+
+static uint32_t tapCounts[TAP_OUTCOME_COUNT];
+static HttpHistogram httpLatency[METRIC_HTTP_TARGET_COUNT];
+static uint32_t loopBuckets[LOOP_BUCKET_COUNT];
+static uint32_t loopCount = 0;
+static uint64_t loopSumUs = 0;
+static uint32_t loopMaxUs = 0;
+static uint32_t syncedRecords = 0;
+static uint32_t deferredRecords = 0;
+static uint32_t wifiReconnects = 0;
+static uint32_t rfidResets = 0;
+
+void metricsCountTap(const char* outcome) {
+  for (size_t i = 0; i < TAP_OUTCOME_COUNT; i++) {
+    if (strcmp(outcome, TAP_OUTCOMES[i]) == 0) {
+      tapCounts[i]++;
+      return;
+    }
+  }
+}
+
+// Transport errors (code <= 0) and 5xx are counted as errors; their time
+// to failure still goes into the histogram.
+void metricsObserveHttp(MetricsHttpTarget target, unsigned long latencyMs, int httpCode) {
+  HttpHistogram& h = httpLatency[target];
+  for (size_t i = 0; i < HTTP_BUCKET_COUNT; i++) {
+    if (latencyMs <= HTTP_BUCKETS_MS[i]) {
+      h.buckets[i]++;
+      break;
+    }
+  }
+  h.count++;
+  h.sumMs += latencyMs;
+  if (httpCode <= 0 || httpCode >= 500) {
+    h.errors++;
+  }
+}
+
+void metricsCountSyncRecord(bool synced) {
+  if (synced) {
+    syncedRecords++;
+  } else {
+    deferredRecords++;
+  }
+}
+
+void metricsCountWiFiReconnect() {
+  wifiReconnects++;
+}
+
+void metricsCountRFIDReset() {
+  rfidResets++;
+}
+
+void metricsObserveLoop(unsigned long loopMicros) {
+  for (size_t i = 0; i < LOOP_BUCKET_COUNT; i++) {
+    if (loopMicros <= LOOP_BUCKETS_US[i]) {
+      loopBuckets[i]++;
+      break;
+    }
+  }
+  loopCount++;
+  loopSumUs += loopMicros;
+  if (loopMicros > loopMaxUs) {
+    loopMaxUs = loopMicros;
+  }
+}
+
+// ========================================
+// EXPOSITION
+// ========================================
+
+static ESP8266WebServer* metricsServer = nullptr;
+static char metricsChunk[METRICS_CHUNK_SIZE];
+static size_t metricsChunkLen = 0;
+
+static void flushMetrics() {
+  if (metricsChunkLen > 0) {
+    metricsServer->sendContent(metricsChunk, metricsChunkLen);
+    metricsChunkLen = 0;
+  }
+}
+
+// Append one formatted line, sending the chunk first if it would not fit
+static void emit(PGM_P format, ...) {
+  for (int attempt = 0; attempt < 2; attempt++) {
+    size_t room = sizeof(metricsChunk) - metricsChunkLen;
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf_P(metricsChunk + metricsChunkLen, room, format, args);
+    va_end(args);
+
+    if (len < 0) {
+      return;
+    }
+    if ((size_t)len < room) {
+      metricsChunkLen += len;
+      return;
+    }
+    flushMetrics();
+  }
+}
+
+static void emitHeader(PGM_P name, PGM_P type, PGM_P help) {
+  emit(PSTR("# HELP %S %S\n# TYPE %S %S\n"), name, help, name, type);
+}
+
+static void emitHttpHistograms() {
+  static const char name[] PROGMEM = "attendee_http_request_duration_seconds";
+  emitHeader(name, PSTR("histogram"), PSTR("Backend HTTP request latency, including failed requests"));
+
+  for (int t = 0; t < METRIC_HTTP_TARGET_COUNT; t++) {
+    const HttpHistogram& h = httpLatency[t];
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i < HTTP_BUCKET_COUNT; i++) {
+      cumulative += h.buckets[i];
+      emit(PSTR("%S_bucket{target=\"%s\",le=\"%u.%03u\"} %lu\n"), name, HTTP_TARGET_NAMES[t],
+           HTTP_BUCKETS_MS[i] / 1000, HTTP_BUCKETS_MS[i] % 1000, (unsigned long)cumulative);
+    }
+    emit(PSTR("%S_bucket{target=\"%s\",le=\"+Inf\"} %lu\n"), name, HTTP_TARGET_NAMES[t], (unsigned long)h.count);
+    emit(PSTR("%S_sum{target=\"%s\"} %lu.%03lu\n"), name, HTTP_TARGET_NAMES[t],
+         (unsigned long)(h.sumMs / 1000), (unsigned long)(h.sumMs % 1000));
+    emit(PSTR("%S_count{target=\"%s\"} %lu\n"), name, HTTP_TARGET_NAMES[t], (unsigned long)h.count);
+  }
+
+  emitHeader(PSTR("attendee_http_request_errors_total"), PSTR("counter"),
+             PSTR("Backend requests that failed in transport or returned 5xx"));
+  for (int t = 0; t < METRIC_HTTP_TARGET_COUNT; t++) {
+    emit(PSTR("attendee_http_request_errors_total{target=\"%s\"} %lu\n"),
+         HTTP_TARGET_NAMES[t], (unsigned long)httpLatency[t].errors);
+  }
+}
+
+static void emitLoopHistogram() {
+  static const char name[] PROGMEM = "attendee_loop_duration_seconds";
+  emitHeader(name, PSTR("histogram"), PSTR("Time between consecutive loop() iterations"));
+
+  uint32_t cumulative = 0;
+  for (size_t i = 0; i < LOOP_BUCKET_COUNT; i++) {
+    cumulative += loopBuckets[i];
+    emit(PSTR("%S_bucket{le=\"%lu.%06lu\"} %lu\n"), name,
+         (unsigned long)(LOOP_BUCKETS_US[i] / 1000000), (unsigned long)(LOOP_BUCKETS_US[i] % 1000000),
+         (unsigned long)cumulative);
+  }
+  emit(PSTR("%S_bucket{le=\"+Inf\"} %lu\n"), name, (unsigned long)loopCount);
+  emit(PSTR("%S_sum %lu.%06lu\n"), name,
+       (unsigned long)(loopSumUs / 1000000), (unsigned long)(loopSumUs % 1000000));
+  emit(PSTR("%S_count %lu\n"), name, (unsigned long)loopCount);
+
+  emitHeader(PSTR("attendee_loop_duration_max_seconds"), PSTR("gauge"), PSTR("Longest loop() iteration since boot"));
+  emit(PSTR("attendee_loop_duration_max_seconds %lu.%06lu\n"),
+       (unsigned long)(loopMaxUs / 1000000), (unsigned long)(loopMaxUs % 1000000));
+}
+
+void writeMetrics(ESP8266WebServer& server) {
+  metricsServer = &server;
+  metricsChunkLen = 0;
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4; charset=utf-8", "");
+
+  emitHeader(PSTR("attendee_build_info"), PSTR("gauge"), PSTR("Firmware version and device id"));
+  emit(PSTR("attendee_build_info{firmware=\"%s\",device_id=\"%s\"} 1\n"), FIRMWARE_VERSION, deviceId.c_str());
+
+  emitHeader(PSTR("attendee_uptime_seconds"), PSTR("gauge"), PSTR("Seconds since boot"));
+  emit(PSTR("attendee_uptime_seconds %lu\n"), millis() / 1000);
+
+  // Taps
+  emitHeader(PSTR("attendee_taps_total"), PSTR("counter"), PSTR("Card taps by outcome"));
+  for (size_t i = 0; i < TAP_OUTCOME_COUNT; i++) {
+    emit(PSTR("attendee_taps_total{outcome=\"%s\"} %lu\n"), TAP_OUTCOMES[i], (unsigned long)tapCounts[i]);
+  }
+
+  emitHttpHistograms();
+
+  // Offline queue and sync
+  emitHeader(PSTR("attendee_offline_queue_depth"), PSTR("gauge"), PSTR("Attendance records waiting to sync"));
+  emit(PSTR("attendee_offline_queue_depth %d\n"), offlineLogsCount);
+
+  emitHeader(PSTR("attendee_sync_records_total"), PSTR("counter"), PSTR("Offline records processed by the sync job"));
+  emit(PSTR("attendee_sync_records_total{result=\"synced\"} %lu\n"), (unsigned long)syncedRecords);
+  emit(PSTR("attendee_sync_records_total{result=\"deferred\"} %lu\n"), (unsigned long)deferredRecords);
+
+  const OfflineStagingStats& staging = getOfflineStagingStats();
+  emitHeader(PSTR("attendee_offline_staged_records"), PSTR("gauge"), PSTR("Offline taps in RTC memory awaiting a group commit"));
+  emit(PSTR("attendee_offline_staged_records %d\n"), getStagedRecordCount());
+  emitHeader(PSTR("attendee_offline_flash_commits_total"), PSTR("counter"), PSTR("LittleFS appends of offline records"));
+  emit(PSTR("attendee_offline_flash_commits_total %lu\n"), (unsigned long)staging.flashCommits);
+  emitHeader(PSTR("attendee_offline_tap_write_max_seconds"), PSTR("gauge"), PSTR("Slowest per-tap offline write"));
+  emit(PSTR("attendee_offline_tap_write_max_seconds %lu.%06lu\n"),
+       (unsigned long)(staging.maxStageMicros / 1000000), (unsigned long)(staging.maxStageMicros % 1000000));
+
+  // Memory
+  emitHeader(PSTR("attendee_heap_free_bytes"), PSTR("gauge"), PSTR("Free heap"));
+  emit(PSTR("attendee_heap_free_bytes %lu\n"), (unsigned long)ESP.getFreeHeap());
+  emitHeader(PSTR("attendee_heap_max_block_bytes"), PSTR("gauge"), PSTR("Largest allocatable heap block"));
+  emit(PSTR("attendee_heap_max_block_bytes %lu\n"), (unsigned long)ESP.getMaxFreeBlockSize());
+
+  // Connectivity
+  emitHeader(PSTR("attendee_online"), PSTR("gauge"), PSTR("1 when WiFi is connected"));
+  emit(PSTR("attendee_online %d\n"), isOnline ? 1 : 0);
+  emitHeader(PSTR("attendee_wifi_rssi_dbm"), PSTR("gauge"), PSTR("WiFi signal strength"));
+  emit(PSTR("attendee_wifi_rssi_dbm %d\n"), isOnline ? (int)WiFi.RSSI() : 0);
+  emitHeader(PSTR("attendee_wifi_reconnects_total"), PSTR("counter"), PSTR("WiFi reconnections after a drop"));
+  emit(PSTR("attendee_wifi_reconnects_total %lu\n"), (unsigned long)wifiReconnects);
+
+  const BreakerStats& breaker = getBreakerStats();
+  emitHeader(PSTR("attendee_backend_breaker_state"), PSTR("gauge"), PSTR("0 closed, 1 open, 2 half-open"));
+  emit(PSTR("attendee_backend_breaker_state %d\n"), (int)breaker.state);
+  emitHeader(PSTR("attendee_backend_breaker_opens_total"), PSTR("counter"), PSTR("Times the backend breaker opened"));
+  emit(PSTR("attendee_backend_breaker_opens_total %lu\n"), (unsigned long)breaker.openCount);
+  emitHeader(PSTR("attendee_backend_srtt_seconds"), PSTR("gauge"), PSTR("Smoothed backend round-trip time"));
+  emit(PSTR("attendee_backend_srtt_seconds %lu.%03lu\n"),
+       (unsigned long)(breaker.srttMs / 1000), (unsigned long)(breaker.srttMs % 1000));
+
+  // RFID and scheduler
+  emitHeader(PSTR("attendee_rfid_resets_total"), PSTR("counter"), PSTR("RC522 soft resets (maintenance and idle recovery)"));
+  emit(PSTR("attendee_rfid_resets_total %lu\n"), (unsigned long)rfidResets);
+
+  emitLoopHistogram();
+
+  emitHeader(PSTR("attendee_event_subscribers"), PSTR("gauge"), PSTR("Open /api/events streams"));
+  emit(PSTR("attendee_event_subscribers %d\n"), getEventSubscriberCount());
+
+  flushMetrics();
+  server.sendContent("");
+  metricsServer = nullptr;
+}
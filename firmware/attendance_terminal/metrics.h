@@ -0,0 +1,39 @@
+/*
+ * Prometheus metrics for Attendee Attendance Terminal v2.0
+ *
+ * Counters and fixed-bucket histograms kept in plain static arrays, served
+ * at GET /metrics in the Prometheus text exposition format. The response
+ * is streamed in small chunks straight from the counters, with no JSON
+ * document or full-body String, so a fleet-wide scrape costs a few
+ * milliseconds and a few hundred bytes of RAM per terminal.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+
+#define METRICS_CHUNK_SIZE 512          // Bytes buffered before each chunk is sent
+
+// Backend calls with their own latency histogram
+enum MetricsHttpTarget {
+  METRIC_HTTP_ATTENDANCE,
+  METRIC_HTTP_SYNC,
+  METRIC_HTTP_HEARTBEAT,
+  METRIC_HTTP_HEALTH,
+  METRIC_HTTP_TARGET_COUNT
+};
+
+// Recording (cheap enough to call on every event)
+void metricsCountTap(const char* outcome);
+void metricsObserveHttp(MetricsHttpTarget target, unsigned long latencyMs, int httpCode);
+void metricsCountSyncRecord(bool synced);
+void metricsCountWiFiReconnect();
+void metricsCountRFIDReset();
+void metricsObserveLoop(unsigned long loopMicros);
+
+// GET /metrics
+void writeMetrics(ESP8266WebServer& server);
+
+#endif // METRICS_H
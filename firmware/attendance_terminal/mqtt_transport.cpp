@@ -0,0 +1,614 @@
+/*
+ * MQTT transport for Attendee Attendance Terminal v2.0
+ *
+ * Packets are assembled in one buffer and written with a single
+ * client.write(), and the receive side is parsed from whatever bytes are
+ * available, so serviceMqttTransport() never waits on the broker except
+ * for the TCP connect itself (rate limited by MQTT_RECONNECT_MS).
+ */
+
+#include <ESP8266WiFi.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "json_arena.h"
+#include "mqtt_transport.h"
+#include "offline_staging.h"
+#include "api_jobs.h"
+#include "event_stream.h"
+#include "rfid_lanes.h"
+#include "stall_profiler.h"
+
+// External references from main file
+extern String deviceId;
+extern int offlineLogsCount;
+
+// Function declarations from main file
+extern void showMqttTapResult(const String& name, const String& message, bool ok);
+
+// MQTT 3.1.1 control packet types (upper nibble of the fixed header)
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_SUBSCRIBE 0x82             // Reserved flags 0010
+#define MQTT_SUBACK 0x90
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+
+enum MqttState {
+  MQTT_DISABLED,
+  MQTT_IDLE,                    // Waiting for the next connection attempt
+  MQTT_AWAIT_CONNACK,
+  MQTT_READY
+};
+
+struct InflightTap {
+  uint16_t packetId;            // 0 = free slot
+  uint32_t seq;
+  unsigned long sentAt;
+  uint8_t attempts;
+  uint8_t lane;                 // RFID_LANE_*
+  char rfidTag[21];
+  char timestamp[20];
+};
+
+static WiFiClient mqttClient;
+static MqttState state = MQTT_DISABLED;
+static String brokerHost;
+static uint16_t brokerPort = MQTT_DEFAULT_PORT;
+static String topicBase;                // attendee/<deviceId>
+static unsigned long lastAttempt = 0;
+static unsigned long connackDeadline = 0;
+static unsigned long lastSent = 0;
+static uint16_t nextPacketId = 1;
+static bool sessionPresent = false;
+static bool pingOutstanding = false;
+
+static InflightTap inflight[MQTT_INFLIGHT_MAX];
+static uint8_t inflightCount = 0;
+
+static uint8_t txBuffer[MQTT_TX_BUFFER];
+static uint8_t rxBuffer[MQTT_RX_BUFFER];
+static uint16_t rxLength = 0;
+
+static uint32_t tapsPublished = 0;
+static uint32_t tapsAcked = 0;
+static uint32_t tapsResent = 0;
+static uint32_t tapsHandedOffline = 0;
+static uint32_t connects = 0;
+
+// ========================================
+// PACKET ENCODING
+// ========================================
+
+static uint16_t allocPacketId() {
+  uint16_t id = nextPacketId++;
+  if (nextPacketId == 0) {
+    nextPacketId = 1;
+  }
+  return id;
+}
+
+// Fixed header at the start of txBuffer; returns its length or 0 if the
+// packet does not fit
+static uint8_t putFixedHeader(uint8_t type, size_t remaining, size_t* total) {
+  uint8_t header[5];
+  uint8_t len = 0;
+  header[len++] = type;
+  size_t value = remaining;
+  do {
+    uint8_t digit = value % 128;
+    value /= 128;
+    header[len++] = digit | (value > 0 ? 0x80 : 0);
+  } while (value > 0 && len < 5);
+
+  if (len + remaining > MQTT_TX_BUFFER) {
+    return 0;
+  }
+  // Shift the body (already written after a 5 byte gap) up to the header
+  memmove(txBuffer + len, txBuffer + 5, remaining);
+  memcpy(txBuffer, header, len);
+  *total = len + remaining;
+  return len;
+}
+
+static size_t putString(size_t pos, const char* str, size_t len) {
+  txBuffer[pos++] = len >> 8;
+  txBuffer[pos++] = len & 0xFF;
+  memcpy(txBuffer + pos, str, len);
+  return pos + len;
+}
+
+// Body is written from txBuffer + 5; send() adds the fixed header
+static bool send(uint8_t type, size_t bodyLen) {
+  if (5 + bodyLen > MQTT_TX_BUFFER) {
+    return false;
+  }
+  size_t total;
+  if (putFixedHeader(type, bodyLen, &total) == 0) {
+    return false;
+  }
+  if (mqttClient.write(txBuffer, total) != total) {
+    return false;
+  }
+  lastSent = millis();
+  return true;
+}
+
+static bool sendPublish(const String& topic, const char* payload, size_t payloadLen,
+                        uint8_t qos, bool retain, bool dup, uint16_t packetId) {
+  size_t pos = 5;
+  if (pos + 2 + topic.length() + 2 + payloadLen > MQTT_TX_BUFFER) {
+    LOG_ERROR("MQTT publish too large for %s", topic.c_str());
+    return false;
+  }
+  pos = putString(pos, topic.c_str(), topic.length());
+  if (qos > 0) {
+    txBuffer[pos++] = packetId >> 8;
+    txBuffer[pos++] = packetId & 0xFF;
+  }
+  memcpy(txBuffer + pos, payload, payloadLen);
+  pos += payloadLen;
+
+  uint8_t type = MQTT_PUBLISH | (qos << 1) | (retain ? 0x01 : 0) | (dup ? 0x08 : 0);
+  return send(type, pos - 5);
+}
+
+static bool sendPuback(uint16_t packetId) {
+  txBuffer[5] = packetId >> 8;
+  txBuffer[6] = packetId & 0xFF;
+  return send(MQTT_PUBACK, 2);
+}
+
+// ========================================
+// CONNECTION
+// ========================================
+
+static String statusPayload(bool online) {
+  return "{\"deviceId\":\"" + deviceId + "\",\"online\":" + (online ? "true" : "false") +
+         ",\"firmware\":\"" + FIRMWARE_VERSION + "\"}";
+}
+
+static bool sendConnect() {
+  String willTopic = topicBase + "/status";
+  String willPayload = statusPayload(false);
+
+  size_t pos = 5;
+  pos = putString(pos, "MQTT", 4);
+  txBuffer[pos++] = 4;                          // Protocol level 3.1.1
+  txBuffer[pos++] = 0x04 | 0x08 | 0x20;         // Will flag, will QoS 1, will retain; cleanSession = 0
+  txBuffer[pos++] = MQTT_KEEPALIVE_S >> 8;
+  txBuffer[pos++] = MQTT_KEEPALIVE_S & 0xFF;
+  pos = putString(pos, deviceId.c_str(), deviceId.length());
+  pos = putString(pos, willTopic.c_str(), willTopic.length());
+  pos = putString(pos, willPayload.c_str(), willPayload.length());
+  return send(MQTT_CONNECT, pos - 5);
+}
+
+static bool sendSubscribe() {
+  String cmdTopic = topicBase + "/cmd";
+  String resultTopic = topicBase + "/result";
+  uint16_t packetId = allocPacketId();
+
+  size_t pos = 5;
+  txBuffer[pos++] = packetId >> 8;
+  txBuffer[pos++] = packetId & 0xFF;
+  pos = putString(pos, cmdTopic.c_str(), cmdTopic.length());
+  txBuffer[pos++] = 1;
+  pos = putString(pos, resultTopic.c_str(), resultTopic.length());
+  txBuffer[pos++] = 1;
+  return send(MQTT_SUBSCRIBE, pos - 5);
+}
+
+// Same JSON as POST /attendance; dup marks a resend of an unacknowledged tap
+static bool publishTap(const InflightTap& tap, bool dup) {
+  ArenaScope arena("mqtt-tap");
+  ArenaJsonDocument doc(200);
+  doc["rfidTag"] = tap.rfidTag;
+  doc["timestamp"] = tap.timestamp;
+  doc["deviceId"] = deviceId;
+  doc["firmware"] = FIRMWARE_VERSION;
+  doc["seq"] = tap.seq;
+  if (const char* direction = rfidLaneDirection(tap.lane)) {
+    doc["direction"] = direction;
+  }
+
+  ArenaBuffer payload(doc);
+  return sendPublish(topicBase + "/tap", payload.data(), payload.length(), 1, false, dup, tap.packetId);
+}
+
+// Unacknowledged taps go to offline staging; the HTTP sync will deliver
+// them and the backend drops any the broker did forward
+static void handInflightToOffline() {
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+    InflightTap& tap = inflight[i];
+    if (tap.packetId == 0) {
+      continue;
+    }
+    if (stageOfflineRecord(tap.rfidTag, tap.timestamp, tap.seq, tap.lane)) {
+      offlineLogsCount++;
+      tapsHandedOffline++;
+    } else {
+      LOG_ERROR("Lost MQTT tap seq %lu", (unsigned long)tap.seq);
+    }
+    tap.packetId = 0;
+  }
+  inflightCount = 0;
+}
+
+static void dropConnection(const char* reason) {
+  bool wasReady = state == MQTT_READY;
+  if (mqttClient.connected()) {
+    send(MQTT_DISCONNECT, 0);
+  }
+  mqttClient.stop();
+  rxLength = 0;
+  state = MQTT_IDLE;
+  lastAttempt = millis();
+  handInflightToOffline();
+
+  LOG_INFO("MQTT disconnected: %s", reason);
+  if (wasReady) {
+    publishConnectivityEvent(false, "mqtt-disconnected");
+  }
+}
+
+static void startConnect() {
+  lastAttempt = millis();
+  StallScope net("mqtt-conn", STALL_NET);
+  if (!mqttClient.connect(brokerHost.c_str(), brokerPort)) {
+    LOG_DEBUG("MQTT broker unreachable: %s:%u", brokerHost.c_str(), brokerPort);
+    return;
+  }
+  mqttClient.setNoDelay(true);
+  rxLength = 0;
+  if (!sendConnect()) {
+    mqttClient.stop();
+    return;
+  }
+  state = MQTT_AWAIT_CONNACK;
+  connackDeadline = millis() + MQTT_CONNACK_TIMEOUT_MS;
+}
+
+static void onConnected() {
+  state = MQTT_READY;
+  pingOutstanding = false;
+  connects++;
+  sendSubscribe();
+
+  String status = statusPayload(true);
+  sendPublish(topicBase + "/status", status.c_str(), status.length(), 1, true, false, allocPacketId());
+
+  LOG_INFO("MQTT connected to %s%s", brokerHost.c_str(), sessionPresent ? " (session resumed)" : "");
+  publishConnectivityEvent(true, "mqtt-connected");
+}
+
+// ========================================
+// INCOMING PACKETS
+// ========================================
+
+static void handleCommand(const char* payload, size_t len) {
+  ArenaScope arena("mqtt-cmd");
+  ArenaJsonDocument doc(128);
+  if (deserializeJson(doc, payload, len)) {
+    LOG_WARN("Ignoring malformed MQTT command");
+    return;
+  }
+  String command = doc["command"] | "";
+  LOG_INFO("MQTT command: %s", command.c_str());
+
+  // Same background jobs as the configuration API actions
+  if (command == "sync") {
+    createApiJob(JOB_SYNC);
+  } else if (command == "heartbeat") {
+    createApiJob(JOB_HEARTBEAT);
+  } else if (command == "restart") {
+    createApiJob(JOB_RESTART);
+  }
+}
+
+static void handleResult(const char* payload, size_t len) {
+  ArenaScope arena("mqtt-result");
+  ArenaJsonDocument doc(256);
+  if (deserializeJson(doc, payload, len)) {
+    return;
+  }
+  bool ok = doc["success"] | false;
+  showMqttTapResult(doc["name"] | "", doc["message"] | (ok ? "Attendance OK" : "Rejected"), ok);
+}
+
+static void handlePublish(uint8_t flags, const uint8_t* body, size_t len) {
+  if (len < 2) {
+    return;
+  }
+  uint16_t topicLen = (body[0] << 8) | body[1];
+  size_t pos = 2 + topicLen;
+  uint8_t qos = (flags >> 1) & 0x03;
+  uint16_t packetId = 0;
+  if (qos > 0) {
+    if (pos + 2 > len) {
+      return;
+    }
+    packetId = (body[pos] << 8) | body[pos + 1];
+    pos += 2;
+  }
+  if (pos > len) {
+    return;
+  }
+
+  String topic;
+  topic.concat((const char*)body + 2, topicLen);
+  const char* payload = (const char*)body + pos;
+  size_t payloadLen = len - pos;
+
+  if (topic.endsWith("/cmd")) {
+    handleCommand(payload, payloadLen);
+  } else if (topic.endsWith("/result")) {
+    handleResult(payload, payloadLen);
+  }
+
+  if (qos == 1) {
+    sendPuback(packetId);
+  }
+}
+
+static void handlePuback(uint16_t packetId) {
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+    if (inflight[i].packetId == packetId) {
+      inflight[i].packetId = 0;
+      inflightCount--;
+      tapsAcked++;
+      return;
+    }
+  }
+  // Status publishes are QoS 1 but not tracked
+}
+
+static void handlePacket(uint8_t header, const uint8_t* body, size_t len) {
+  switch (header & 0xF0) {
+    case MQTT_CONNACK:
+      if (state == MQTT_AWAIT_CONNACK && len >= 2 && body[1] == 0) {
+        sessionPresent = body[0] & 0x01;
+        onConnected();
+      } else {
+        dropConnection("connection refused");
+      }
+      break;
+    case MQTT_PUBLISH:
+      handlePublish(header & 0x0F, body, len);
+      break;
+    case MQTT_PUBACK:
+      if (len >= 2) {
+        handlePuback((body[0] << 8) | body[1]);
+      }
+      break;
+    case MQTT_PINGRESP:
+      pingOutstanding = false;
+      break;
+    default:
+      break; // SUBACK
+  }
+}
+
+// Parse every complete packet in rxBuffer
+static void readPackets() {
+  while (mqttClient.available() && rxLength < MQTT_RX_BUFFER) {
+    int n = mqttClient.read(rxBuffer + rxLength, MQTT_RX_BUFFER - rxLength);
+    if (n <= 0) {
+      break;
+    }
+    rxLength += n;
+  }
+
+  while (rxLength >= 2) {
+    size_t remaining = 0;
+    uint8_t multiplier = 0;
+    size_t pos = 1;
+    bool complete = false;
+    while (pos < rxLength && pos <= 4) {
+      uint8_t digit = rxBuffer[pos++];
+      remaining |= (size_t)(digit & 0x7F) << (7 * multiplier++);
+      if (!(digit & 0x80)) {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete) {
+      if (pos > 4) {
+        dropConnection("malformed packet");
+      }
+      return;
+    }
+    if (pos + remaining > MQTT_RX_BUFFER) {
+      dropConnection("packet too large");
+      return;
+    }
+    if (pos + remaining > rxLength) {
+      return; // Wait for the rest
+    }
+
+    handlePacket(rxBuffer[0], rxBuffer + pos, remaining);
+    if (state == MQTT_IDLE) {
+      return; // Connection was dropped while handling
+    }
+    size_t consumed = pos + remaining;
+    memmove(rxBuffer, rxBuffer + consumed, rxLength - consumed);
+    rxLength -= consumed;
+  }
+}
+
+// ========================================
+// SETUP AND LOOP HOOKS
+// ========================================
+
+// broker is "host" or "host:port"; empty keeps taps on HTTP
+void beginMqttTransport(const String& broker) {
+  if (state == MQTT_READY) {
+    // A clean DISCONNECT suppresses the will, so clear the retained status
+    String status = statusPayload(false);
+    sendPublish(topicBase + "/status", status.c_str(), status.length(), 0, true, false, 0);
+  }
+  if (state != MQTT_DISABLED) {
+    dropConnection("reconfigured");
+  }
+  if (broker.length() == 0) {
+    state = MQTT_DISABLED;
+    return;
+  }
+
+  int colon = broker.indexOf(':');
+  brokerHost = colon < 0 ? broker : broker.substring(0, colon);
+  brokerPort = colon < 0 ? MQTT_DEFAULT_PORT : broker.substring(colon + 1).toInt();
+  topicBase = String(MQTT_TOPIC_ROOT) + "/" + deviceId;
+  state = MQTT_IDLE;
+  lastAttempt = millis() - MQTT_RECONNECT_MS; // Connect on the next service call
+}
+
+void serviceMqttTransport() {
+  if (state == MQTT_DISABLED || WiFi.status() != WL_CONNECTED) {
+    if (state != MQTT_DISABLED && state != MQTT_IDLE) {
+      dropConnection("WiFi lost");
+    }
+    return;
+  }
+
+  if (state == MQTT_IDLE) {
+    if (millis() - lastAttempt >= MQTT_RECONNECT_MS) {
+      startConnect();
+    }
+    return;
+  }
+
+  if (!mqttClient.connected()) {
+    dropConnection("broker closed connection");
+    return;
+  }
+
+  readPackets();
+  if (state == MQTT_IDLE) {
+    return;
+  }
+
+  unsigned long now = millis();
+  if (state == MQTT_AWAIT_CONNACK) {
+    if ((long)(now - connackDeadline) > 0) {
+      dropConnection("no CONNACK");
+    }
+    return;
+  }
+
+  // Resend taps whose PUBACK is overdue; a second miss means the link is dead
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+    InflightTap& tap = inflight[i];
+    if (tap.packetId == 0 || now - tap.sentAt < MQTT_ACK_TIMEOUT_MS) {
+      continue;
+    }
+    if (tap.attempts >= 2) {
+      dropConnection("PUBACK timeout");
+      return;
+    }
+    publishTap(tap, true);
+    tap.sentAt = now;
+    tap.attempts++;
+    tapsResent++;
+  }
+
+  // Ping at half the keepalive; a ping still unanswered by the next one
+  // means the broker is gone even if TCP has not noticed yet
+  if (now - lastSent >= (MQTT_KEEPALIVE_S * 1000UL) / 2) {
+    if (pingOutstanding) {
+      dropConnection("no PINGRESP");
+      return;
+    }
+    pingOutstanding = send(MQTT_PINGREQ, 0);
+  }
+}
+
+// ========================================
+// PUBLISHING
+// ========================================
+
+bool mqttTransportEnabled() {
+  return state != MQTT_DISABLED;
+}
+
+bool mqttConnected() {
+  return state == MQTT_READY;
+}
+
+uint32_t mqttInflightSeqFloor() {
+  uint32_t lowest = 0;
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+    if (inflight[i].packetId != 0 && inflight[i].seq != 0 && (lowest == 0 || inflight[i].seq < lowest)) {
+      lowest = inflight[i].seq;
+    }
+  }
+  return lowest;
+}
+
+// Returns false when the tap was not queued (not connected or window
+// full); the caller then takes the HTTP or offline path
+bool mqttPublishTap(const String& rfidTag, const String& timestamp, uint32_t seq, uint8_t lane) {
+  if (state != MQTT_READY || inflightCount >= MQTT_INFLIGHT_MAX) {
+    return false;
+  }
+
+  InflightTap* slot = nullptr;
+  for (uint8_t i = 0; i < MQTT_INFLIGHT_MAX; i++) {
+    if (inflight[i].packetId == 0) {
+      slot = &inflight[i];
+      break;
+    }
+  }
+  if (slot == nullptr) {
+    return false;
+  }
+
+  slot->seq = seq;
+  slot->lane = lane;
+  strlcpy(slot->rfidTag, rfidTag.c_str(), sizeof(slot->rfidTag));
+  strlcpy(slot->timestamp, timestamp.c_str(), sizeof(slot->timestamp));
+  slot->packetId = allocPacketId();
+  slot->attempts = 1;
+  slot->sentAt = millis();
+
+  if (!publishTap(*slot, false)) {
+    slot->packetId = 0;
+    dropConnection("write failed");
+    return false;
+  }
+  inflightCount++;
+  tapsPublished++;
+  return true;
+}
+
+// Heartbeat as the retained status message
+bool mqttPublishStatus(const char* payload, size_t length) {
+  if (state != MQTT_READY) {
+    return false;
+  }
+  return sendPublish(topicBase + "/status", payload, length, 1, true, false, allocPacketId());
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void mqttTransportToJson(JsonObject out) {
+  static const char* const STATE_NAMES[] = { "disabled", "idle", "connecting", "connected" };
+  out["state"] = STATE_NAMES[state];
+  if (state == MQTT_DISABLED) {
+    return;
+  }
+  out["broker"] = brokerHost + ":" + String(brokerPort);
+  out["sessionPresent"] = sessionPresent;
+  out["inflight"] = inflightCount;
+  out["published"] = tapsPublished;
+  out["acked"] = tapsAcked;
+  out["resent"] = tapsResent;
+  out["handedOffline"] = tapsHandedOffline;
+  out["connects"] = connects;
+}
@@ -0,0 +1,45 @@
+/*
+ * MQTT transport for taps and heartbeats
+ * Attendee Attendance Terminal v2.0
+ *
+ * When an MQTT broker is configured, taps are published QoS 1 to
+ * attendee/<deviceId>/tap over one persistent session (cleanSession = 0)
+ * instead of one HTTP request each. Up to MQTT_INFLIGHT_MAX taps may be
+ * waiting for their PUBACK at once, so a queue of students is never held
+ * up by the round trip. Heartbeats become retained messages on
+ * attendee/<deviceId>/status (the will marks the device offline), and
+ * commands arrive on attendee/<deviceId>/cmd. The backend bridge posts
+ * each tap to /attendance and answers on attendee/<deviceId>/result.
+ *
+ * Minimal MQTT 3.1.1 client on a plain WiFiClient: CONNECT, PUBLISH QoS
+ * 0/1, PUBACK, SUBSCRIBE, PINGREQ. Taps still unacknowledged when the
+ * connection drops are handed to offline staging with their sequence
+ * numbers, so a tap the broker did receive is deduped by the backend.
+ */
+
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define MQTT_TX_BUFFER 768              // Largest outgoing packet (the heartbeat status message)
+#define MQTT_RX_BUFFER 256              // Largest incoming packet; bigger ones drop the connection
+
+// Setup and loop hooks
+void beginMqttTransport(const String& broker);
+void serviceMqttTransport();
+
+// State
+bool mqttTransportEnabled();
+bool mqttConnected();
+uint32_t mqttInflightSeqFloor();        // Lowest unacknowledged tap seq, 0 if none
+
+// Publishing
+bool mqttPublishTap(const String& rfidTag, const String& timestamp, uint32_t seq, uint8_t lane);
+bool mqttPublishStatus(const char* payload, size_t length);
+
+// Status
+void mqttTransportToJson(JsonObject out);
+
+#endif // MQTT_TRANSPORT_H
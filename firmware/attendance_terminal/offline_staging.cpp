@@ -0,0 +1,266 @@
+/*
+ * RTC-memory staging of offline attendance records
+ * Attendee Attendance Terminal v2.0
+ *
+ * Layout in RTC user memory (from STAGING_RTC_BLOCK_OFFSET):
+ *   header  magic, count, crc32 of the staged records
+ *   records STAGING_CAPACITY x 20 bytes (local unix time, seq, UID bytes, lane)
+ *
+ * A tap writes its record slot first and the header last, so a reset in
+ * between leaves the previous, still consistent, header. A group commit
+ * appends the records to the offline block store in one open/close;
+ * LittleFS makes the whole append visible at close, so boot recovery can
+ * tell whether a commit that was cut short landed by comparing the
+ * store's last record.
+ */
+
+#include <coredecls.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "offline_staging.h"
+#include "offline_store.h"
+#include "offline_sync.h"
+
+// External references from main file
+extern int offlineLogsCount;
+
+#define STAGING_MAGIC 0x53544732UL      // "STG2"
+#define STAGING_RETRY_MS 5000UL         // Wait after a failed group commit
+
+struct StagingHeader {
+  uint32_t magic;
+  uint16_t count;
+  uint16_t reserved;
+  uint32_t crc;
+};
+
+static_assert(sizeof(OfflineRecord) == 20, "Staging slots are 20 bytes");
+static_assert(sizeof(OfflineRecord) % 4 == 0, "RTC memory is written in 4-byte blocks");
+static_assert(sizeof(StagingHeader) % 4 == 0, "RTC memory is written in 4-byte blocks");
+static_assert(STAGING_RTC_BLOCK_OFFSET * 4 + sizeof(StagingHeader) + STAGING_CAPACITY * sizeof(OfflineRecord) <= 512,
+              "Staging area exceeds RTC user memory");
+
+#define HEADER_BLOCK STAGING_RTC_BLOCK_OFFSET
+#define RECORD_BLOCK(i) (STAGING_RTC_BLOCK_OFFSET + (sizeof(StagingHeader) + (i) * sizeof(OfflineRecord)) / 4)
+
+static OfflineRecord staged[STAGING_CAPACITY];
+static StagingHeader header = { STAGING_MAGIC, 0, 0, 0 };
+static unsigned long oldestStagedAt = 0;
+static unsigned long lastVccCheck = 0;
+static unsigned long lastCommitFailure = 0;
+static OfflineStagingStats stats = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// ========================================
+// RTC MEMORY
+// ========================================
+
+static uint32_t stagedCrc(uint16_t count) {
+  return crc32(staged, count * sizeof(OfflineRecord));
+}
+
+static void writeHeader() {
+  header.magic = STAGING_MAGIC;
+  header.crc = stagedCrc(header.count);
+  ESP.rtcUserMemoryWrite(HEADER_BLOCK, (uint32_t*)&header, sizeof(header));
+}
+
+static bool readStagingArea() {
+  if (!ESP.rtcUserMemoryRead(HEADER_BLOCK, (uint32_t*)&header, sizeof(header))) {
+    return false;
+  }
+  if (header.magic != STAGING_MAGIC || header.count > STAGING_CAPACITY) {
+    return false;
+  }
+  if (header.count > 0 &&
+      !ESP.rtcUserMemoryRead(RECORD_BLOCK(0), (uint32_t*)staged, header.count * sizeof(OfflineRecord))) {
+    return false;
+  }
+  return header.crc == stagedCrc(header.count);
+}
+
+// ========================================
+// GROUP COMMIT
+// ========================================
+
+bool flushOfflineStaging(const char* reason) {
+  if (header.count == 0) {
+    return true;
+  }
+
+  unsigned long start = millis();
+  uint16_t count = header.count;
+  uint32_t seqFloor = getStagedSeqFloor();
+  if (!offlineStoreAppend(OFFLINE_STORE_MAIN, staged, count)) {
+    lastCommitFailure = millis();
+    LOG_ERROR("Offline group commit failed - records kept in RTC memory");
+    return false;
+  }
+  lastCommitFailure = 0;
+  // Staging order is not seq order (MQTT handoffs, timed-out online taps)
+  noteOfflineSyncAppended(seqFloor);
+
+  header.count = 0;
+  writeHeader();
+
+  stats.flashCommits++;
+  stats.committedRecords += count;
+  stats.lastCommitMs = millis() - start;
+  if (stats.lastCommitMs > stats.maxCommitMs) {
+    stats.maxCommitMs = stats.lastCommitMs;
+  }
+  LOG_DEBUG("Group commit (%s): %u records in %lums", reason, (unsigned)count,
+            (unsigned long)stats.lastCommitMs);
+  return true;
+}
+
+// ========================================
+// SETUP AND LOOP HOOKS
+// ========================================
+
+// Call after LittleFS is mounted and legacy logs are migrated, before the
+// offline log count is computed.
+void beginOfflineStaging() {
+  if (!readStagingArea()) {
+    // Power-on (RTC memory is random) or a torn header: start empty
+    header.count = 0;
+    writeHeader();
+    return;
+  }
+  if (header.count == 0) {
+    return;
+  }
+
+  uint16_t count = header.count;
+  OfflineRecord last;
+  if (offlineStoreLast(OFFLINE_STORE_MAIN, last) &&
+      memcmp(&last, &staged[count - 1], sizeof(OfflineRecord)) == 0) {
+    // The reset hit between the file commit and the header update
+    LOG_INFO("Staged offline records were already committed");
+    header.count = 0;
+    writeHeader();
+    return;
+  }
+
+  if (flushOfflineStaging("replay")) {
+    stats.replayedRecords += count;
+    LOG_INFO("Recovered %u staged offline records", (unsigned)count);
+  }
+}
+
+void serviceOfflineStaging() {
+  if (header.count == 0) {
+    return;
+  }
+
+  unsigned long now = millis();
+  if (lastCommitFailure != 0 && now - lastCommitFailure < STAGING_RETRY_MS) {
+    return;
+  }
+  if (header.count >= OFFLINE_GROUP_COMMIT_COUNT) {
+    flushOfflineStaging("count");
+    return;
+  }
+  if (now - oldestStagedAt >= OFFLINE_GROUP_COMMIT_AGE_MS) {
+    flushOfflineStaging("age");
+    return;
+  }
+
+  if (now - lastVccCheck >= OFFLINE_VCC_CHECK_MS) {
+    lastVccCheck = now;
+    if (ESP.getVcc() < OFFLINE_FLUSH_VCC_MV) {
+      stats.lowVoltageFlushes++;
+      flushOfflineStaging("low voltage");
+    }
+  }
+}
+
+// ========================================
+// WRITE PATH
+// ========================================
+
+// Called per offline tap. Costs two small RTC memory writes; the flash
+// append happens later from serviceOfflineStaging().
+bool stageOfflineRecord(const String& rfidTag, const String& timestamp, uint32_t seq, uint8_t lane) {
+  unsigned long start = micros();
+
+  OfflineRecord record;
+  if (!offlineRecordFromStrings(rfidTag, timestamp, seq, lane, record)) {
+    LOG_ERROR("Offline record not representable: %s %s", rfidTag.c_str(), timestamp.c_str());
+    return false;
+  }
+
+  if (header.count >= STAGING_CAPACITY && !flushOfflineStaging("full")) {
+    return false;
+  }
+
+  uint16_t slot = header.count;
+  staged[slot] = record;
+  ESP.rtcUserMemoryWrite(RECORD_BLOCK(slot), (uint32_t*)&staged[slot], sizeof(OfflineRecord));
+  header.count = slot + 1;
+  writeHeader();
+
+  if (slot == 0) {
+    oldestStagedAt = millis();
+  }
+
+  stats.stagedRecords++;
+  stats.lastStageMicros = micros() - start;
+  stats.totalStageMicros += stats.lastStageMicros;
+  if (stats.lastStageMicros > stats.maxStageMicros) {
+    stats.maxStageMicros = stats.lastStageMicros;
+  }
+  return true;
+}
+
+void clearOfflineStaging() {
+  header.count = 0;
+  writeHeader();
+}
+
+int getStagedRecordCount() {
+  return header.count;
+}
+
+uint32_t getStagedSeqFloor() {
+  uint32_t lowest = 0;
+  for (uint16_t i = 0; i < header.count; i++) {
+    if (staged[i].seq != 0 && (lowest == 0 || staged[i].seq < lowest)) {
+      lowest = staged[i].seq;
+    }
+  }
+  return lowest;
+}
+
+uint32_t getStagedSeqCeiling() {
+  uint32_t highest = 0;
+  for (uint16_t i = 0; i < header.count; i++) {
+    if (staged[i].seq > highest) {
+      highest = staged[i].seq;
+    }
+  }
+  return highest;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+const OfflineStagingStats& getOfflineStagingStats() {
+  return stats;
+}
+
+void offlineStagingToJson(JsonObject out) {
+  out["staged"] = header.count;
+  out["capacity"] = STAGING_CAPACITY;
+  out["stagedTotal"] = stats.stagedRecords;
+  out["flashCommits"] = stats.flashCommits;
+  out["committedRecords"] = stats.committedRecords;
+  out["replayedRecords"] = stats.replayedRecords;
+  out["lowVoltageFlushes"] = stats.lowVoltageFlushes;
+  out["lastStageUs"] = stats.lastStageMicros;
+  out["maxStageUs"] = stats.maxStageMicros;
+  out["avgStageUs"] = stats.stagedRecords > 0 ? (uint32_t)(stats.totalStageMicros / stats.stagedRecords) : 0;
+  out["lastCommitMs"] = stats.lastCommitMs;
+  out["maxCommitMs"] = stats.maxCommitMs;
+}
@@ -0,0 +1,51 @@
+/*
+ * RTC-memory staging of offline attendance records
+ * Attendee Attendance Terminal v2.0
+ *
+ * Offline taps are written to ESP8266 RTC user memory (survives soft
+ * resets and watchdog resets, not power loss) and appended to the offline
+ * block store in group commits: when enough records are staged, when
+ * the oldest one is old enough, when the supply voltage sags, or before a
+ * sync pass. Records still staged at boot are replayed into the file.
+ */
+
+#ifndef OFFLINE_STAGING_H
+#define OFFLINE_STAGING_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define STAGING_RTC_BLOCK_OFFSET 32     // First 128 bytes of RTC user memory belong to the OTA bootloader
+#define STAGING_CAPACITY 10             // Records held in RTC memory (20 bytes each); stall_profiler.h follows
+
+// Write path instrumentation (compare with one LittleFS commit per tap)
+struct OfflineStagingStats {
+  uint32_t stagedRecords;       // Taps written to RTC memory
+  uint32_t flashCommits;        // File appends (one LittleFS commit each)
+  uint32_t committedRecords;    // Records moved from RTC memory to flash
+  uint32_t replayedRecords;     // Records recovered at boot
+  uint32_t lowVoltageFlushes;
+  uint32_t lastStageMicros;     // Per-tap write latency
+  uint32_t maxStageMicros;
+  uint64_t totalStageMicros;
+  uint32_t lastCommitMs;        // Group commit latency
+  uint32_t maxCommitMs;
+};
+
+// Setup and loop hooks
+void beginOfflineStaging();
+void serviceOfflineStaging();
+
+// Write path
+bool stageOfflineRecord(const String& rfidTag, const String& timestamp, uint32_t seq, uint8_t lane);
+bool flushOfflineStaging(const char* reason);
+void clearOfflineStaging();
+int getStagedRecordCount();
+uint32_t getStagedSeqFloor();   // Lowest staged seq, 0 if nothing is staged
+uint32_t getStagedSeqCeiling(); // Highest staged seq, 0 if nothing is staged
+
+// Status
+const OfflineStagingStats& getOfflineStagingStats();
+void offlineStagingToJson(JsonObject out);
+
+#endif // OFFLINE_STAGING_H
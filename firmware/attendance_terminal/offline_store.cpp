@@ -0,0 +1,705 @@
+/*
+ * Compact offline attendance storage for Attendee Attendance Terminal v2.0
+ *
+ * Appends rewrite the partially filled tail block in place and add new
+ * blocks after it, all through one open file handle, so a group commit is
+ * still a single LittleFS commit. Blocks whose CRC does not match are
+ * skipped (and counted) by the reader instead of aborting the sync.
+ */
+
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <RTClib.h>
+#include <coredecls.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "json_arena.h"
+#include "offline_store.h"
+#include "event_seq.h"
+#include "rfid_lanes.h"
+
+// External references from main file
+extern String deviceId;
+
+#define BLOCK_MAGIC 0xB10D
+#define BLOCK_HEADER_SIZE 16
+#define BLOCK_PAYLOAD_MAX (OFFLINE_BLOCK_SIZE - BLOCK_HEADER_SIZE)
+#define BLOCK_MAX_RECORDS 255
+#define BLOCK_FLAG_LANES 0x01           // uidIndex field carries the record's lane in its low 2 bits
+#define DICT_ENTRY_SIZE (1 + OFFLINE_UID_MAX)
+#define APPEND_CHUNK 32                 // Records interned and encoded per pass
+
+const OfflineStoreFiles OFFLINE_STORE_MAIN = { OFFLINE_LOGS_FILE, OFFLINE_UIDS_FILE };
+const OfflineStoreFiles OFFLINE_STORE_DEFER = { OFFLINE_DEFER_FILE, OFFLINE_DEFER_UIDS_FILE };
+
+static uint32_t corruptBlocks = 0;
+
+// ========================================
+// ENCODING HELPERS
+// ========================================
+
+static void put16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static uint16_t get16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = (v >> (8 * i)) & 0xFF;
+  }
+}
+
+static uint32_t get32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t putVarint(uint8_t* out, uint32_t value) {
+  uint8_t len = 0;
+  while (value >= 0x80) {
+    out[len++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  out[len++] = value;
+  return len;
+}
+
+static bool getVarint(const uint8_t* buf, uint16_t end, uint16_t& pos, uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35 && pos < end; shift += 7) {
+    uint8_t b = buf[pos++];
+    value |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint32_t zigzag(int32_t n) {
+  return ((uint32_t)n << 1) ^ (uint32_t)(n >> 31);
+}
+
+static int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// ========================================
+// BLOCKS
+// ========================================
+
+// CRC over header (crc field zeroed) and payload
+static uint32_t blockCrc(uint8_t* block) {
+  uint32_t stored = get32(block + 12);
+  put32(block + 12, 0);
+  uint32_t crc = crc32(block, BLOCK_HEADER_SIZE + get16(block + 4));
+  put32(block + 12, stored);
+  return crc;
+}
+
+static bool blockValid(uint8_t* block) {
+  return get16(block) == BLOCK_MAGIC &&
+         get16(block + 4) <= BLOCK_PAYLOAD_MAX &&
+         get32(block + 12) == blockCrc(block);
+}
+
+static void initBlock(uint8_t* block, uint32_t baseTime) {
+  memset(block, 0, OFFLINE_BLOCK_SIZE);
+  put16(block, BLOCK_MAGIC);
+  block[3] = BLOCK_FLAG_LANES;
+  put32(block + 8, baseTime);
+}
+
+static void sealBlock(uint8_t* block) {
+  put32(block + 12, blockCrc(block));
+}
+
+// Encode one record; prevSeq is ignored for the first record of a block
+static uint8_t encodeRecord(uint8_t* out, uint16_t uidIndex, const OfflineRecord& record,
+                            uint32_t prevTime, uint32_t prevSeq, bool first) {
+  uint8_t len = putVarint(out, ((uint32_t)uidIndex << 2) | (record.lane & 0x03));
+  len += putVarint(out + len, zigzag((int32_t)(record.unixTime - prevTime)));
+  if (first) {
+    len += putVarint(out + len, record.seq);
+  } else {
+    len += putVarint(out + len, zigzag((int32_t)(record.seq - prevSeq - 1)));
+  }
+  return len;
+}
+
+// Decode the record at pos, advancing time and seq from the previous record
+static bool decodeRecord(const uint8_t* block, uint16_t& pos, bool first,
+                         uint32_t& uidIndex, uint8_t& lane, uint32_t& time, uint32_t& seq) {
+  uint16_t end = BLOCK_HEADER_SIZE + get16(block + 4);
+  uint32_t delta;
+  uint32_t seqValue;
+  if (!getVarint(block, end, pos, uidIndex) ||
+      !getVarint(block, end, pos, delta) ||
+      !getVarint(block, end, pos, seqValue)) {
+    return false;
+  }
+  time += unzigzag(delta);
+  seq = first ? seqValue : seq + 1 + unzigzag(seqValue);
+  lane = 0;
+  if (block[3] & BLOCK_FLAG_LANES) {
+    lane = uidIndex & 0x03;
+    uidIndex >>= 2;
+  }
+  return true;
+}
+
+// Time and seq of the last record in a valid block
+static void blockLast(const uint8_t* block, uint32_t& time, uint32_t& seq) {
+  uint16_t pos = BLOCK_HEADER_SIZE;
+  uint32_t uidIndex;
+  uint8_t lane;
+  time = get32(block + 8);
+  seq = 0;
+  for (uint8_t i = 0; i < block[2]; i++) {
+    if (!decodeRecord(block, pos, i == 0, uidIndex, lane, time, seq)) {
+      break;
+    }
+  }
+}
+
+// ========================================
+// UID DICTIONARY
+// ========================================
+
+struct UidCacheEntry {
+  uint8_t len;
+  uint8_t uid[OFFLINE_UID_MAX];
+  uint16_t index;
+};
+
+static UidCacheEntry uidCache[OFFLINE_UID_CACHE];
+static uint8_t uidCacheCount = 0;
+static uint8_t uidCacheNext = 0;
+static const char* uidCachePath = nullptr;
+
+static void resetUidCache(const char* dictPath) {
+  uidCacheCount = 0;
+  uidCacheNext = 0;
+  uidCachePath = dictPath;
+}
+
+static bool sameUid(const OfflineRecord& record, uint8_t len, const uint8_t* uid) {
+  return record.uidLen == len && memcmp(record.uid, uid, len) == 0;
+}
+
+static int32_t cachedUidIndex(const OfflineRecord& record) {
+  for (uint8_t i = 0; i < uidCacheCount; i++) {
+    if (sameUid(record, uidCache[i].len, uidCache[i].uid)) {
+      return uidCache[i].index;
+    }
+  }
+  return -1;
+}
+
+static void cacheUid(const OfflineRecord& record, uint16_t index) {
+  UidCacheEntry& entry = uidCache[uidCacheNext];
+  entry.len = record.uidLen;
+  memcpy(entry.uid, record.uid, record.uidLen);
+  entry.index = index;
+  uidCacheNext = (uidCacheNext + 1) % OFFLINE_UID_CACHE;
+  if (uidCacheCount < OFFLINE_UID_CACHE) {
+    uidCacheCount++;
+  }
+}
+
+// Resolve each record's UID to a dictionary index, adding new UIDs at the
+// end. Cache misses cost one sequential scan of the dictionary per batch.
+static bool internUids(const OfflineStoreFiles& store, const OfflineRecord* records, int count, uint16_t* indices) {
+  if (uidCachePath != store.dictPath) {
+    resetUidCache(store.dictPath);
+  }
+
+  int misses = 0;
+  for (int i = 0; i < count; i++) {
+    int32_t index = cachedUidIndex(records[i]);
+    indices[i] = index < 0 ? 0xFFFF : (uint16_t)index;
+    if (index < 0) {
+      misses++;
+    }
+  }
+  if (misses == 0) {
+    return true;
+  }
+
+  uint32_t entries = 0;
+  File dict = LittleFS.open(store.dictPath, "r");
+  if (dict) {
+    uint8_t entry[DICT_ENTRY_SIZE];
+    while (misses > 0 && dict.read(entry, DICT_ENTRY_SIZE) == DICT_ENTRY_SIZE) {
+      for (int i = 0; i < count; i++) {
+        if (indices[i] == 0xFFFF && sameUid(records[i], entry[0], entry + 1)) {
+          indices[i] = entries;
+          cacheUid(records[i], entries);
+          misses--;
+        }
+      }
+      entries++;
+    }
+    entries = dict.size() / DICT_ENTRY_SIZE;
+    dict.close();
+  }
+  if (misses == 0) {
+    return true;
+  }
+
+  File out = LittleFS.open(store.dictPath, "a");
+  if (!out) {
+    return false;
+  }
+  for (int i = 0; i < count; i++) {
+    if (indices[i] != 0xFFFF) {
+      continue;
+    }
+    if (entries >= 0xFFFF) {
+      out.close();
+      return false;
+    }
+    uint8_t entry[DICT_ENTRY_SIZE] = { 0 };
+    entry[0] = records[i].uidLen;
+    memcpy(entry + 1, records[i].uid, records[i].uidLen);
+    out.write(entry, DICT_ENTRY_SIZE);
+
+    // Later records in the batch with the same UID share the new entry
+    for (int j = i; j < count; j++) {
+      if (indices[j] == 0xFFFF && sameUid(records[j], records[i].uidLen, records[i].uid)) {
+        indices[j] = entries;
+      }
+    }
+    cacheUid(records[i], entries);
+    entries++;
+  }
+  out.close();
+  return true;
+}
+
+static bool lookupUid(File& dict, uint32_t index, OfflineRecord& record) {
+  uint8_t entry[DICT_ENTRY_SIZE];
+  if (!dict || !dict.seek(index * DICT_ENTRY_SIZE, SeekSet) ||
+      dict.read(entry, DICT_ENTRY_SIZE) != DICT_ENTRY_SIZE || entry[0] > OFFLINE_UID_MAX) {
+    return false;
+  }
+  record.uidLen = entry[0];
+  memcpy(record.uid, entry + 1, OFFLINE_UID_MAX);
+  return true;
+}
+
+// ========================================
+// WRITING
+// ========================================
+
+static bool appendChunk(const OfflineStoreFiles& store, const OfflineRecord* records, int count) {
+  static uint8_t block[OFFLINE_BLOCK_SIZE];
+  uint16_t indices[APPEND_CHUNK];
+
+  if (!internUids(store, records, count, indices)) {
+    LOG_ERROR("Offline UID dictionary write failed");
+    return false;
+  }
+
+  File data = LittleFS.exists(store.dataPath) ? LittleFS.open(store.dataPath, "r+")
+                                              : LittleFS.open(store.dataPath, "w");
+  if (!data) {
+    return false;
+  }
+
+  // Continue the tail block if it is intact, has room and stores lanes
+  uint32_t blockIndex = data.size() / OFFLINE_BLOCK_SIZE;
+  bool haveBlock = false;
+  uint32_t prevTime = 0;
+  uint32_t prevSeq = 0;
+  if (blockIndex > 0) {
+    data.seek((blockIndex - 1) * OFFLINE_BLOCK_SIZE, SeekSet);
+    if (data.read(block, OFFLINE_BLOCK_SIZE) == OFFLINE_BLOCK_SIZE && blockValid(block) &&
+        block[2] < BLOCK_MAX_RECORDS && get16(block + 4) < BLOCK_PAYLOAD_MAX &&
+        (block[3] & BLOCK_FLAG_LANES)) {
+      blockIndex--;
+      blockLast(block, prevTime, prevSeq);
+      haveBlock = true;
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (!haveBlock) {
+      initBlock(block, records[i].unixTime);
+      prevTime = records[i].unixTime;
+      haveBlock = true;
+    }
+
+    uint8_t encoded[16];
+    uint8_t len = encodeRecord(encoded, indices[i], records[i], prevTime, prevSeq, block[2] == 0);
+
+    uint16_t payloadLen = get16(block + 4);
+    if (payloadLen + len > BLOCK_PAYLOAD_MAX || block[2] >= BLOCK_MAX_RECORDS) {
+      sealBlock(block);
+      data.seek(blockIndex * OFFLINE_BLOCK_SIZE, SeekSet);
+      data.write(block, OFFLINE_BLOCK_SIZE);
+      blockIndex++;
+
+      initBlock(block, records[i].unixTime);
+      prevTime = records[i].unixTime;
+      len = encodeRecord(encoded, indices[i], records[i], prevTime, prevSeq, true);
+      payloadLen = 0;
+    }
+
+    memcpy(block + BLOCK_HEADER_SIZE + payloadLen, encoded, len);
+    put16(block + 4, payloadLen + len);
+    block[2]++;
+    prevTime = records[i].unixTime;
+    prevSeq = records[i].seq;
+  }
+
+  sealBlock(block);
+  data.seek(blockIndex * OFFLINE_BLOCK_SIZE, SeekSet);
+  size_t written = data.write(block, OFFLINE_BLOCK_SIZE);
+  data.close();
+  return written == OFFLINE_BLOCK_SIZE;
+}
+
+bool offlineStoreAppend(const OfflineStoreFiles& store, const OfflineRecord* records, int count) {
+  for (int offset = 0; offset < count; offset += APPEND_CHUNK) {
+    if (!appendChunk(store, records + offset, min(APPEND_CHUNK, count - offset))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool offlineStoreRemove(const OfflineStoreFiles& store) {
+  if (uidCachePath == store.dictPath) {
+    resetUidCache(nullptr);
+  }
+  bool removed = LittleFS.remove(store.dataPath);
+  LittleFS.remove(store.dictPath);
+  return removed;
+}
+
+bool offlineStoreRename(const OfflineStoreFiles& from, const OfflineStoreFiles& to) {
+  offlineStoreRemove(to);
+  resetUidCache(nullptr);
+  if (!LittleFS.exists(from.dataPath)) {
+    return false;
+  }
+  return LittleFS.rename(from.dataPath, to.dataPath) && LittleFS.rename(from.dictPath, to.dictPath);
+}
+
+// ========================================
+// READING
+// ========================================
+
+static bool loadBlock(OfflineStoreReader& reader) {
+  while (true) {
+    if (!reader.data.seek(reader.block * OFFLINE_BLOCK_SIZE, SeekSet) ||
+        reader.data.read(reader.buffer, OFFLINE_BLOCK_SIZE) != OFFLINE_BLOCK_SIZE) {
+      return false; // End of log
+    }
+    if (blockValid(reader.buffer)) {
+      break;
+    }
+    corruptBlocks++;
+    LOG_ERROR("Offline log block %lu failed CRC, skipped", (unsigned long)reader.block);
+    reader.block++;
+  }
+
+  reader.count = reader.buffer[2];
+  reader.pos = BLOCK_HEADER_SIZE;
+  reader.prevTime = get32(reader.buffer + 8);
+  reader.prevSeq = 0;
+  reader.decoded = 0;
+  reader.loaded = true;
+  return true;
+}
+
+// Decode the next record's uid index, time and seq without touching the
+// dictionary
+static bool decodeNext(OfflineStoreReader& reader, uint32_t& uidIndex, uint8_t& lane, uint32_t& time, uint32_t& seq) {
+  while (true) {
+    if (!reader.loaded && !loadBlock(reader)) {
+      return false;
+    }
+    if (reader.decoded >= reader.count) {
+      reader.block++;
+      reader.loaded = false;
+      continue;
+    }
+
+    if (!decodeRecord(reader.buffer, reader.pos, reader.decoded == 0,
+                      uidIndex, lane, reader.prevTime, reader.prevSeq)) {
+      // CRC matched but the payload is short; drop the rest of the block
+      corruptBlocks++;
+      reader.block++;
+      reader.loaded = false;
+      continue;
+    }
+    time = reader.prevTime;
+    seq = reader.prevSeq;
+    reader.decoded++;
+    return true;
+  }
+}
+
+bool offlineStoreOpen(OfflineStoreReader& reader, const OfflineStoreFiles& store, uint32_t cursor) {
+  reader.data = LittleFS.open(store.dataPath, "r");
+  if (!reader.data) {
+    return false;
+  }
+  reader.dict = LittleFS.open(store.dictPath, "r");
+  reader.block = cursor >> 8;
+  reader.loaded = false;
+  reader.decoded = 0;
+  reader.count = 0;
+
+  uint8_t skip = cursor & 0xFF;
+  if (skip > 0 && loadBlock(reader) && reader.block == (cursor >> 8)) {
+    uint32_t uidIndex, time, seq;
+    uint8_t lane;
+    while (reader.decoded < skip && reader.decoded < reader.count && decodeNext(reader, uidIndex, lane, time, seq)) {
+    }
+  }
+  return true;
+}
+
+bool offlineStoreNext(OfflineStoreReader& reader, OfflineRecord& record) {
+  uint32_t uidIndex;
+  uint8_t lane;
+  uint32_t time;
+  uint32_t seq;
+  while (decodeNext(reader, uidIndex, lane, time, seq)) {
+    memset(&record, 0, sizeof(record));
+    record.unixTime = time;
+    record.seq = seq;
+    record.lane = lane;
+    if (lookupUid(reader.dict, uidIndex, record)) {
+      return true;
+    }
+    corruptBlocks++;
+    LOG_ERROR("Offline record references missing UID %u, skipped", (unsigned)uidIndex);
+  }
+  return false;
+}
+
+// Position just after the last record returned. This stays inside the
+// block even once it is exhausted, because the tail block keeps growing
+// while a sync pass is paused.
+uint32_t offlineStoreCursor(const OfflineStoreReader& reader) {
+  return (reader.block << 8) | reader.decoded;
+}
+
+void offlineStoreClose(OfflineStoreReader& reader) {
+  if (reader.data) {
+    reader.data.close();
+  }
+  if (reader.dict) {
+    reader.dict.close();
+  }
+}
+
+int offlineStoreCount(const OfflineStoreFiles& store, uint32_t fromCursor) {
+  static uint8_t block[OFFLINE_BLOCK_SIZE];
+  File data = LittleFS.open(store.dataPath, "r");
+  if (!data) {
+    return 0;
+  }
+
+  uint32_t firstBlock = fromCursor >> 8;
+  uint8_t skip = fromCursor & 0xFF;
+  int count = 0;
+  data.seek(firstBlock * OFFLINE_BLOCK_SIZE, SeekSet);
+  for (uint32_t index = firstBlock; data.read(block, OFFLINE_BLOCK_SIZE) == OFFLINE_BLOCK_SIZE; index++) {
+    if (!blockValid(block)) {
+      continue;
+    }
+    int records = block[2];
+    if (index == firstBlock) {
+      records = max(0, records - skip);
+    }
+    count += records;
+  }
+  data.close();
+  return count;
+}
+
+bool offlineStoreLast(const OfflineStoreFiles& store, OfflineRecord& record) {
+  File data = LittleFS.open(store.dataPath, "r");
+  if (!data) {
+    return false;
+  }
+  uint32_t blocks = data.size() / OFFLINE_BLOCK_SIZE;
+  data.close();
+  if (blocks == 0) {
+    return false;
+  }
+
+  static OfflineStoreReader reader;
+  if (!offlineStoreOpen(reader, store, (blocks - 1) << 8)) {
+    return false;
+  }
+  bool found = false;
+  OfflineRecord next;
+  while (reader.block == blocks - 1 && offlineStoreNext(reader, next)) {
+    record = next;
+    found = true;
+  }
+  offlineStoreClose(reader);
+  return found;
+}
+
+uint32_t offlineStoreBytes(const OfflineStoreFiles& store) {
+  uint32_t bytes = 0;
+  File data = LittleFS.open(store.dataPath, "r");
+  if (data) {
+    bytes += data.size();
+    data.close();
+  }
+  File dict = LittleFS.open(store.dictPath, "r");
+  if (dict) {
+    bytes += dict.size();
+    dict.close();
+  }
+  return bytes;
+}
+
+uint32_t offlineStoreCorruptBlocks() {
+  return corruptBlocks;
+}
+
+// ========================================
+// RECORD CONVERSION
+// ========================================
+
+// rfidTag is the uppercase hex UID built in handleRFIDScan(); timestamp is
+// getCurrentTimestamp() format
+bool offlineRecordFromStrings(const String& rfidTag, const String& timestamp, uint32_t seq, uint8_t lane,
+                              OfflineRecord& record) {
+  memset(&record, 0, sizeof(record));
+  record.seq = seq;
+  record.lane = lane;
+
+  unsigned int len = rfidTag.length();
+  if (len == 0 || len % 2 != 0 || len / 2 > OFFLINE_UID_MAX) {
+    return false;
+  }
+  record.uidLen = len / 2;
+  for (unsigned int i = 0; i < record.uidLen; i++) {
+    char byteHex[3] = { rfidTag.charAt(i * 2), rfidTag.charAt(i * 2 + 1), '\0' };
+    char* end;
+    record.uid[i] = (uint8_t)strtoul(byteHex, &end, 16);
+    if (*end != '\0') {
+      return false;
+    }
+  }
+
+  int year, month, day, hour, minute, second;
+  if (sscanf(timestamp.c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) != 6) {
+    return false;
+  }
+  record.unixTime = DateTime(year, month, day, hour, minute, second).unixtime();
+  return true;
+}
+
+// The JSON body posted by the sync job; same fields as an online tap
+String offlineRecordToJson(const OfflineRecord& record) {
+  char tag[OFFLINE_UID_MAX * 2 + 1];
+  for (uint8_t i = 0; i < record.uidLen; i++) {
+    sprintf(tag + i * 2, "%02X", record.uid[i]);
+  }
+  tag[record.uidLen * 2] = '\0';
+
+  DateTime time(record.unixTime);
+  char timestamp[25];
+  sprintf(timestamp, "%04d-%02d-%02dT%02d:%02d:%02d",
+          time.year(), time.month(), time.day(),
+          time.hour(), time.minute(), time.second());
+
+  ArenaScope arena("sync-record");
+  ArenaJsonDocument doc(200);
+  doc["rfidTag"] = tag;
+  doc["timestamp"] = timestamp;
+  doc["deviceId"] = deviceId;
+  doc["firmware"] = FIRMWARE_VERSION;
+  doc["seq"] = record.seq;
+  if (const char* direction = rfidLaneDirection(record.lane)) {
+    doc["direction"] = direction;
+  }
+
+  String jsonLine;
+  serializeJson(doc, jsonLine);
+  return jsonLine;
+}
+
+// ========================================
+// LEGACY MIGRATION
+// ========================================
+
+static int migrateLegacyFile(const char* path, uint32_t fromOffset) {
+  File legacy = LittleFS.open(path, "r");
+  if (!legacy) {
+    return 0;
+  }
+  if (fromOffset > 0 && fromOffset <= legacy.size()) {
+    legacy.seek(fromOffset, SeekSet);
+  }
+
+  static OfflineRecord batch[APPEND_CHUNK];
+  int batched = 0;
+  int migrated = 0;
+  while (legacy.available()) {
+    String line = legacy.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0) {
+      continue;
+    }
+
+    StaticJsonDocument<256> doc;
+    // Legacy lines predate sequence numbers; they get fresh ones in file order
+    if (deserializeJson(doc, line) ||
+        !offlineRecordFromStrings(doc["rfidTag"] | "", doc["timestamp"] | "", nextEventSeq(),
+                                 RFID_LANE_NONE, batch[batched])) {
+      LOG_WARN("Dropping unreadable legacy offline log line");
+      continue;
+    }
+    if (++batched == APPEND_CHUNK) {
+      offlineStoreAppend(OFFLINE_STORE_MAIN, batch, batched);
+      migrated += batched;
+      batched = 0;
+    }
+  }
+  legacy.close();
+
+  if (batched > 0) {
+    offlineStoreAppend(OFFLINE_STORE_MAIN, batch, batched);
+    migrated += batched;
+  }
+  return migrated;
+}
+
+// Converts offline logs written by firmware that stored JSON lines. The old
+// sync cursor is a byte offset into that file and is honoured once.
+void migrateLegacyOfflineLogs() {
+  if (!LittleFS.exists(OFFLINE_LEGACY_LOGS_FILE) && !LittleFS.exists(OFFLINE_LEGACY_DEFER_FILE)) {
+    return;
+  }
+
+  uint32_t legacyCursor = 0;
+  File cursorFile = LittleFS.open(SYNC_CURSOR_FILE, "r");
+  if (cursorFile) {
+    legacyCursor = cursorFile.parseInt();
+    cursorFile.close();
+  }
+
+  int migrated = migrateLegacyFile(OFFLINE_LEGACY_LOGS_FILE, legacyCursor) +
+                 migrateLegacyFile(OFFLINE_LEGACY_DEFER_FILE, 0);
+
+  LittleFS.remove(OFFLINE_LEGACY_LOGS_FILE);
+  LittleFS.remove(OFFLINE_LEGACY_DEFER_FILE);
+  LittleFS.remove(SYNC_CURSOR_FILE);
+  LOG_INFO("Migrated %d offline logs to the block store", migrated);
+}
@@ -0,0 +1,89 @@
+/*
+ * Compact offline attendance storage
+ * Attendee Attendance Terminal v2.0
+ *
+ * Offline records are kept in a binary log of fixed-size blocks instead of
+ * one ~120 byte JSON line per tap. Each UID is stored once in a per-log
+ * dictionary file and referenced by index; timestamps and event sequence
+ * numbers are varint deltas from the previous record in the block. A
+ * typical record takes 4-6 bytes, so tens of thousands fit where 1000 JSON
+ * lines used to.
+ *
+ * Block layout (OFFLINE_BLOCK_SIZE bytes):
+ *   magic u16 | count u8 | flags u8 | payloadLen u16 | reserved u16 |
+ *   baseTime u32 | crc32 u32 | payload: count x (varint uidIndex,
+ *   zigzag varint timeDelta, seq) where seq is a varint for the first
+ *   record of the block and zigzag(seq - previous seq - 1) after that.
+ *   Blocks with the lanes flag store (uidIndex << 2) | lane in place of
+ *   uidIndex; older blocks read back with lane RFID_LANE_NONE.
+ *
+ * Readers address records with a cursor of (block << 8) | recordInBlock.
+ */
+
+#ifndef OFFLINE_STORE_H
+#define OFFLINE_STORE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "rfid_lanes.h"
+
+#define OFFLINE_BLOCK_SIZE 256          // Bytes per block, header included
+#define OFFLINE_UID_MAX 10              // Longest ISO 14443 UID
+#define OFFLINE_UID_CACHE 32            // Recently interned UIDs kept in RAM
+
+// One attendance record (also the RTC-memory staging slot)
+struct OfflineRecord {
+  uint32_t unixTime;            // Local time, as kept by the DS3231
+  uint32_t seq;                 // Event sequence number, see event_seq.h
+  uint8_t uidLen;
+  uint8_t uid[OFFLINE_UID_MAX];
+  uint8_t lane;                 // RFID_LANE_*, see rfid_lanes.h
+};
+
+// A block log and its UID dictionary
+struct OfflineStoreFiles {
+  const char* dataPath;
+  const char* dictPath;
+};
+
+extern const OfflineStoreFiles OFFLINE_STORE_MAIN;    // Records waiting for sync
+extern const OfflineStoreFiles OFFLINE_STORE_DEFER;   // Records deferred during a sync pass
+
+// Streaming decoder state; one block is buffered at a time
+struct OfflineStoreReader {
+  File data;
+  File dict;
+  uint32_t block;
+  uint8_t decoded;              // Records already returned from this block
+  uint8_t count;
+  uint16_t pos;
+  uint32_t prevTime;
+  uint32_t prevSeq;
+  bool loaded;
+  uint8_t buffer[OFFLINE_BLOCK_SIZE];
+};
+
+// Writing
+bool offlineStoreAppend(const OfflineStoreFiles& store, const OfflineRecord* records, int count);
+bool offlineStoreRemove(const OfflineStoreFiles& store);
+bool offlineStoreRename(const OfflineStoreFiles& from, const OfflineStoreFiles& to);
+
+// Reading
+bool offlineStoreOpen(OfflineStoreReader& reader, const OfflineStoreFiles& store, uint32_t cursor);
+bool offlineStoreNext(OfflineStoreReader& reader, OfflineRecord& record);
+uint32_t offlineStoreCursor(const OfflineStoreReader& reader);
+void offlineStoreClose(OfflineStoreReader& reader);
+int offlineStoreCount(const OfflineStoreFiles& store, uint32_t fromCursor);
+bool offlineStoreLast(const OfflineStoreFiles& store, OfflineRecord& record);
+uint32_t offlineStoreBytes(const OfflineStoreFiles& store);
+uint32_t offlineStoreCorruptBlocks();
+
+// Record conversion
+bool offlineRecordFromStrings(const String& rfidTag, const String& timestamp, uint32_t seq, uint8_t lane,
+                              OfflineRecord& record);
+String offlineRecordToJson(const OfflineRecord& record);
+
+// One-time conversion of the old JSON-lines files
+void migrateLegacyOfflineLogs();
+
+#endif // OFFLINE_STORE_H
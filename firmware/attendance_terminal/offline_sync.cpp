@@ -0,0 +1,384 @@
+/*
+ * Resumable offline log sync job for Attendee Attendance Terminal v2.0
+ *
+ * A pass walks the offline block store from the persisted cursor. Each call to
+ * serviceOfflineSync() submits at most SYNC_SLICE_MAX_RECORDS records (fewer
+ * under memory pressure, memory_governor.h) or runs for SYNC_SLICE_BUDGET_MS,
+ * whichever comes first, and gives the loop back as soon as a card shows
+ * up on the reader. A slice's records are
+ * pipelined on one connection (sync_pipeline.h); records at or below the
+ * backend's high-water mark are already there and are skipped, which is
+ * also how a slice whose responses were lost finds out what landed.
+ * The X-Seq-Floor sent with a slice is the lowest seq still held anywhere
+ * on the device (main store past the cursor, defer store, RTC staging,
+ * unacknowledged MQTT taps). The main store is not in seq order, so its
+ * part is found by a scan at the start of each pass and lowered as records
+ * are appended.
+ *
+ * Records the backend rejects are collected per slice, appended to the
+ * defer store in one write, and the defer store becomes the new log once
+ * the pass reaches the end, which matches the old "rewrite file with
+ * failed logs" behaviour without holding the whole log in RAM.
+ */
+
+#include <LittleFS.h>
+#include <FS.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "offline_sync.h"
+#include "circuit_breaker.h"
+#include "event_stream.h"
+#include "metrics.h"
+#include "offline_staging.h"
+#include "offline_store.h"
+#include "sync_pipeline.h"
+#include "memory_governor.h"
+#include "display_frontend.h"
+#include "event_seq.h"
+#include "mqtt_transport.h"
+
+// External references from main file
+extern bool isOnline;
+extern int offlineLogsCount;
+extern unsigned long lastSyncAttempt;
+
+// Function declarations from main file
+extern bool pollForPendingCard();
+
+static OfflineSyncStatus syncStatus = { false, 0, 0, 0, 0, 0, 0 };
+static int consecutiveSyncFailures = 0;
+static bool highWaterFetched = false;
+static uint32_t deferFloor = 0;         // Lowest seq in the defer store, 0 if empty
+static uint32_t mainFloor = 0;          // Lowest seq in the main store at or past the cursor, 0 if none
+static bool mainFloorKnown = false;     // Scanned this pass; may lag behind the cursor, never ahead
+static OfflineStoreReader syncReader;
+static OfflineRecord batch[SYNC_SLICE_MAX_RECORDS];
+static uint32_t batchCursor[SYNC_SLICE_MAX_RECORDS];
+static OfflineRecord deferred[SYNC_SLICE_MAX_RECORDS];
+static int deferredInSlice = 0;
+
+// ========================================
+// CURSOR PERSISTENCE
+// ========================================
+
+static void saveSyncCursor() {
+  File file = LittleFS.open(SYNC_CURSOR_FILE, "w");
+  if (!file) {
+    LOG_DEBUG("Failed to persist sync cursor");
+    return;
+  }
+  file.print(syncStatus.cursor);
+  file.close();
+}
+
+void loadOfflineSyncState() {
+  syncStatus.cursor = 0;
+
+  // Records deferred earlier in an interrupted pass are still pending
+  deferFloor = 0;
+  OfflineRecord first;
+  if (offlineStoreOpen(syncReader, OFFLINE_STORE_DEFER, 0)) {
+    if (offlineStoreNext(syncReader, first)) {
+      deferFloor = first.seq;
+    }
+    offlineStoreClose(syncReader);
+  }
+
+  File file = LittleFS.open(SYNC_CURSOR_FILE, "r");
+  if (!file) {
+    return;
+  }
+  uint32_t cursor = file.parseInt();
+  file.close();
+
+  // A cursor past the end means the log was replaced underneath us
+  File logs = LittleFS.open(OFFLINE_LOGS_FILE, "r");
+  if (logs && (cursor >> 8) * OFFLINE_BLOCK_SIZE < logs.size()) {
+    syncStatus.cursor = cursor;
+  }
+  if (logs) {
+    logs.close();
+  }
+  LOG_DEBUG("Sync cursor restored at block %lu record %lu",
+            (unsigned long)(syncStatus.cursor >> 8), (unsigned long)(syncStatus.cursor & 0xFF));
+}
+
+void resetOfflineSyncState() {
+  syncStatus.active = false;
+  syncStatus.cursor = 0;
+  deferFloor = 0;
+  mainFloorKnown = false;
+  LittleFS.remove(SYNC_CURSOR_FILE);
+  offlineStoreRemove(OFFLINE_STORE_DEFER);
+}
+
+// ========================================
+// SEQ FLOOR
+// ========================================
+
+static void lowerSeqFloor(uint32_t& floorSeq, uint32_t seq) {
+  if (seq != 0 && seq < floorSeq) {
+    floorSeq = seq;
+  }
+}
+
+static void scanMainFloor() {
+  mainFloor = 0;
+  mainFloorKnown = true;
+  if (!offlineStoreOpen(syncReader, OFFLINE_STORE_MAIN, syncStatus.cursor)) {
+    return;
+  }
+  OfflineRecord record;
+  while (offlineStoreNext(syncReader, record)) {
+    if (record.seq != 0 && (mainFloor == 0 || record.seq < mainFloor)) {
+      mainFloor = record.seq;
+    }
+  }
+  offlineStoreClose(syncReader);
+}
+
+void noteOfflineSyncAppended(uint32_t lowestSeq) {
+  if (mainFloorKnown && lowestSeq != 0 && (mainFloor == 0 || lowestSeq < mainFloor)) {
+    mainFloor = lowestSeq;
+  }
+}
+
+// Lowest seq this device still holds. Everything below it has reached the
+// backend or never will, so the backend may close the gaps under it.
+static uint32_t heldSeqFloor() {
+  uint32_t floorSeq = peekEventSeq();
+  lowerSeqFloor(floorSeq, mainFloor);
+  lowerSeqFloor(floorSeq, deferFloor);
+  lowerSeqFloor(floorSeq, getStagedSeqFloor());
+  lowerSeqFloor(floorSeq, mqttInflightSeqFloor());
+  return floorSeq;
+}
+
+// ========================================
+// JOB CONTROL
+// ========================================
+
+void startOfflineSync() {
+  lastSyncAttempt = millis();
+
+  if (syncStatus.active || offlineLogsCount <= 0 || !isOnline) {
+    return;
+  }
+
+  // Staged taps join this pass
+  flushOfflineStaging("sync");
+
+  syncStatus.active = true;
+  syncStatus.syncedCount = 0;
+  syncStatus.deferredCount = 0;
+  syncStatus.initialCount = offlineLogsCount;
+  consecutiveSyncFailures = 0;
+  highWaterFetched = false;
+  mainFloorKnown = false;
+
+  LOG_INFO("Sync job started: %d offline logs at cursor %lu", offlineLogsCount, (unsigned long)syncStatus.cursor);
+  publishSyncEvent("started", 0, syncStatus.initialCount);
+}
+
+bool isOfflineSyncActive() {
+  return syncStatus.active;
+}
+
+const OfflineSyncStatus& getOfflineSyncStatus() {
+  return syncStatus;
+}
+
+static void deferLogEntry(const OfflineRecord& record) {
+  deferred[deferredInSlice++] = record;
+  syncStatus.deferredCount++;
+  metricsCountSyncRecord(false);
+  if (deferFloor == 0 || record.seq < deferFloor) {
+    deferFloor = record.seq;
+  }
+}
+
+// A record the backend has processed, now or before
+static void acknowledgeRecord() {
+  syncStatus.syncedCount++;
+  metricsCountSyncRecord(true);
+  if (offlineLogsCount > 0) {
+    offlineLogsCount--;
+  }
+}
+
+static void noteHighWater(int32_t highWater) {
+  if (highWater >= 0 && (uint32_t)highWater > syncStatus.highWater) {
+    syncStatus.highWater = highWater;
+  }
+}
+
+// One defer store write per slice instead of one per failed record
+static void flushDeferred() {
+  if (deferredInSlice == 0) {
+    return;
+  }
+  if (!offlineStoreAppend(OFFLINE_STORE_DEFER, deferred, deferredInSlice)) {
+    LOG_ERROR("Failed to keep %d deferred offline logs", deferredInSlice);
+  }
+  deferredInSlice = 0;
+}
+
+static void completeSyncPass() {
+  offlineStoreRemove(OFFLINE_STORE_MAIN);
+  LittleFS.remove(SYNC_CURSOR_FILE);
+  offlineStoreRename(OFFLINE_STORE_DEFER, OFFLINE_STORE_MAIN);
+
+  syncStatus.active = false;
+  syncStatus.cursor = 0;
+  deferFloor = 0;
+  mainFloorKnown = false;
+  offlineLogsCount = offlineStoreCount(OFFLINE_STORE_MAIN, 0) + getStagedRecordCount();
+
+  LOG_INFO("Synced %d/%d logs", syncStatus.syncedCount, syncStatus.initialCount);
+  publishSyncEvent("complete", syncStatus.syncedCount, syncStatus.initialCount);
+
+  Display::replaceStatus(LCD_SYNC_PROGRESS, LCD_SYNC_COMPLETE,
+                         String(syncStatus.syncedCount) + "/" + String(syncStatus.initialCount));
+}
+
+static void pauseSyncPass(const String& reason) {
+  syncStatus.active = false;
+  lastSyncAttempt = millis();
+  LOG_INFO("Sync job paused (%s) at cursor %lu", reason.c_str(), (unsigned long)syncStatus.cursor);
+  publishSyncEvent("paused", syncStatus.syncedCount, syncStatus.initialCount);
+
+  Display::replaceStatus(LCD_SYNC_PROGRESS, LCD_SYNC_COMPLETE,
+                         String(syncStatus.syncedCount) + "/" + String(syncStatus.initialCount));
+}
+
+// Run one slice of the sync job. Returns true while the job is still active.
+bool serviceOfflineSync() {
+  if (!syncStatus.active) {
+    return false;
+  }
+
+  if (!isOnline) {
+    pauseSyncPass("offline");
+    return false;
+  }
+
+  if (!memNetworkAllowed()) {
+    pauseSyncPass("low memory");
+    return false;
+  }
+
+  // Wait for the breaker's half-open probe instead of deferring records
+  if (!breakerAllowRequest()) {
+    pauseSyncPass("circuit open");
+    return false;
+  }
+
+  // Stop before the next HTTP round trip if a student is at the reader
+  if (pollForPendingCard()) {
+    syncStatus.yieldedToTaps++;
+    return true;
+  }
+
+  // Once per pass, learn what the backend already has (after a reboot,
+  // a pause, or responses lost on the last attempt)
+  if (!highWaterFetched) {
+    highWaterFetched = true;
+    scanMainFloor();
+    uint32_t highWater;
+    if (fetchSyncWatermark(0, highWater)) {
+      noteHighWater(highWater);
+    }
+  }
+
+  if (!offlineStoreOpen(syncReader, OFFLINE_STORE_MAIN, syncStatus.cursor)) {
+    completeSyncPass();
+    return false;
+  }
+
+  unsigned long sliceStart = millis();
+  int batched = 0;
+  bool cursorMoved = false;
+  bool reachedEnd = false;
+
+  int batchLimit = memSyncBatchLimit();
+  while (batched < batchLimit &&
+         millis() - sliceStart < SYNC_SLICE_BUDGET_MS) {
+    OfflineRecord record;
+    if (!offlineStoreNext(syncReader, record)) {
+      reachedEnd = true;
+      break;
+    }
+
+    if (record.seq != 0 && record.seq <= syncStatus.highWater) {
+      // Landed earlier; the response was lost to a timeout or reboot
+      acknowledgeRecord();
+      syncStatus.cursor = offlineStoreCursor(syncReader);
+      cursorMoved = true;
+      continue;
+    }
+    batch[batched] = record;
+    batchCursor[batched] = offlineStoreCursor(syncReader);
+    batched++;
+  }
+  offlineStoreClose(syncReader);
+
+  if (batched > 0) {
+    String bodies[SYNC_SLICE_MAX_RECORDS];
+    for (int i = 0; i < batched; i++) {
+      bodies[i] = offlineRecordToJson(batch[i]);
+    }
+    uint32_t seqFloor = heldSeqFloor();
+
+    PipelineResponse responses[SYNC_SLICE_MAX_RECORDS];
+    int answered = postPipelined(bodies, batched, seqFloor, responses);
+
+    for (int i = 0; i < answered; i++) {
+      noteHighWater(responses[i].highWater);
+      if (responses[i].code == 200 || responses[i].code == 201) {
+        acknowledgeRecord();
+        consecutiveSyncFailures = 0;
+      } else {
+        deferLogEntry(batch[i]);
+        consecutiveSyncFailures++;
+      }
+      syncStatus.cursor = batchCursor[i];
+      cursorMoved = true;
+    }
+
+    if (answered < batched) {
+      // Outcome of the rest is unknown; whatever the backend has is at or
+      // below its high-water mark, everything else is resent next slice
+      consecutiveSyncFailures++;
+      reachedEnd = false;
+      uint32_t highWater;
+      if (fetchSyncWatermark(seqFloor, highWater)) {
+        noteHighWater(highWater);
+      }
+      for (int i = answered; i < batched && batch[i].seq != 0 && batch[i].seq <= syncStatus.highWater; i++) {
+        acknowledgeRecord();
+        syncStatus.cursor = batchCursor[i];
+        cursorMoved = true;
+      }
+    }
+  }
+  flushDeferred();
+
+  if (reachedEnd) {
+    completeSyncPass();
+    return false;
+  }
+
+  if (cursorMoved) {
+    saveSyncCursor();
+    publishSyncEvent("progress", syncStatus.syncedCount, syncStatus.initialCount);
+  }
+
+  if (consecutiveSyncFailures >= SYNC_MAX_CONSECUTIVE_FAILURES ||
+      getBreakerStats().state != BREAKER_CLOSED) {
+    pauseSyncPass("backend failures");
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * Resumable offline log sync job
+ * Attendee Attendance Terminal v2.0
+ *
+ * Sync runs as a job that submits a bounded slice of records per loop()
+ * iteration and keeps its position in SYNC_CURSOR_FILE, so a large backlog
+ * never stops the reader from serving card taps.
+ */
+
+#ifndef OFFLINE_SYNC_H
+#define OFFLINE_SYNC_H
+
+#include <Arduino.h>
+
+// Sync job progress (counters are for the current/last pass)
+struct OfflineSyncStatus {
+  bool active;                  // Job is armed and will run on the next slice
+  uint32_t cursor;              // Record cursor into the offline block store
+  int syncedCount;              // Records accepted by the backend this pass
+  int deferredCount;            // Records that failed and were moved to the defer store
+  int initialCount;             // offlineLogsCount when the pass started
+  unsigned long yieldedToTaps;  // Slices cut short by a card on the reader
+  uint32_t highWater;           // Backend's last reported high-water mark for this device
+};
+
+// Job control
+void loadOfflineSyncState();
+void startOfflineSync();
+bool serviceOfflineSync();
+bool isOfflineSyncActive();
+const OfflineSyncStatus& getOfflineSyncStatus();
+
+// Storage helpers
+void resetOfflineSyncState();
+void noteOfflineSyncAppended(uint32_t lowestSeq);   // Records added to the main store
+
+#endif // OFFLINE_SYNC_H
@@ -0,0 +1,150 @@
+/*
+ * OLED keyframe animation engine - Attendee Attendance Terminal v2.0
+ *
+ * One animation plays at a time; the engine keeps a RAM copy of the
+ * current keyframe and the step it is on.
+ */
+
+#include "config.h"
+#if DISPLAY_OLED_FITTED
+
+#include "display_utils.h"
+#include "oled_anim.h"
+
+// round(256 * sin(i * 90 / 64 degrees)), i = 0..64
+static const uint16_t QUARTER_SINE[65] PROGMEM = {
+    0,   6,  13,  19,  25,  31,  38,  44,  50,  56,  62,  68,  74,
+   80,  86,  92,  98, 104, 109, 115, 121, 126, 132, 137, 142, 147,
+  152, 157, 162, 167, 172, 177, 181, 185, 190, 194, 198, 202, 206,
+  209, 213, 216, 220, 223, 226, 229, 231, 234, 237, 239, 241, 243,
+  245, 247, 248, 250, 251, 252, 253, 254, 255, 255, 256, 256, 256,
+};
+
+struct AnimStats {
+  uint32_t started;
+  uint32_t frames;
+  uint32_t cancelled;
+  uint32_t suppressed;          // animStart() calls while disabled
+  uint32_t maxLateMs;           // Worst delay of a frame past its due time
+};
+
+static const Animation* current = nullptr;
+static AnimKeyframe keyframe;
+static uint8_t keyIndex = 0;
+static uint8_t step = 0;
+static unsigned long shownAt = 0;
+static bool enabled = true;
+static AnimStats stats;
+
+int16_t animSin(uint8_t angle) {
+  uint8_t quarter = angle & 0x3F;
+  uint8_t index = (angle & 0x40) ? 64 - quarter : quarter;
+  int16_t value = pgm_read_word(&QUARTER_SINE[index]);
+  return (angle & 0x80) ? -value : value;
+}
+
+static void loadKeyframe(uint8_t index) {
+  memcpy_P(&keyframe, &current->keyframes[index], sizeof(keyframe));
+  keyIndex = index;
+  step = keyframe.from;
+}
+
+static void showFrame() {
+  if (!(keyframe.flags & ANIM_OVERLAY)) {
+    oledDisplay.clearDisplay();
+  }
+  if (keyframe.draw) {
+    keyframe.draw(step);
+  }
+  presentFrame(current->priority);
+  shownAt = millis();
+  stats.frames++;
+}
+
+// Move to the next step; false when a non-looping animation is over
+static bool advance() {
+  if (step != keyframe.to) {
+    step += keyframe.to > keyframe.from ? 1 : -1;
+    return true;
+  }
+  if (keyIndex + 1 < current->count) {
+    loadKeyframe(keyIndex + 1);
+    return true;
+  }
+  if (current->flags & ANIM_LOOP) {
+    loadKeyframe(0);
+    return true;
+  }
+  return false;
+}
+
+void animStart(const Animation& anim) {
+  if (!enabled) {
+    stats.suppressed++;
+    return;
+  }
+  if (current) {
+    stats.cancelled++;
+  }
+  current = &anim;
+  loadKeyframe(0);
+  stats.started++;
+  showFrame();
+}
+
+void animCancel() {
+  if (current) {
+    stats.cancelled++;
+    current = nullptr;
+  }
+}
+
+void animSetEnabled(bool on) {
+  enabled = on;
+  if (!on) {
+    animCancel();
+  }
+}
+
+bool animIsPlaying(const Animation& anim) {
+  return current == &anim;
+}
+
+bool animActive() {
+  return current != nullptr;
+}
+
+void serviceAnimation() {
+  if (!current) {
+    return;
+  }
+  unsigned long elapsed = millis() - shownAt;
+  if (elapsed < keyframe.frameMs) {
+    return;
+  }
+  unsigned long late = elapsed - keyframe.frameMs;
+  if (!advance()) {
+    current = nullptr;          // The last frame stays up
+    return;
+  }
+  if (late > stats.maxLateMs) {
+    stats.maxLateMs = late;
+  }
+  showFrame();
+}
+
+void animToJson(JsonObject out) {
+  if (current) {
+    out["playing"] = current->name;
+  } else {
+    out["playing"] = nullptr;
+  }
+  out["started"] = stats.started;
+  out["frames"] = stats.frames;
+  out["cancelled"] = stats.cancelled;
+  out["enabled"] = enabled;
+  out["suppressed"] = stats.suppressed;
+  out["maxLateMs"] = stats.maxLateMs;
+}
+
+#endif // DISPLAY_OLED_FITTED
@@ -0,0 +1,74 @@
+/*
+ * OLED keyframe animation engine for Attendee Attendance Terminal v2.0
+ *
+ * An animation is a table of keyframes. Each keyframe names a draw
+ * function and a range of steps, from one value to another in either
+ * direction, and how long each step stays on screen. The draw function
+ * is called with the step number and redraws that frame. By default the
+ * frame is cleared first; ANIM_OVERLAY draws over what is already there,
+ * for transitions that move the current screen.
+ *
+ * Nothing blocks. animStart() shows the first frame. serviceAnimation(),
+ * called from loop() and from the tap feedback pauses, shows the next
+ * frame once the current one has been up long enough. A non-looping
+ * animation stops on its last frame. Any show*Screen() and every new tap
+ * cancel what is playing.
+ *
+ * Angles are binary: 256 steps per turn. animSin()/animCos() read a
+ * quarter-wave table and return 1/256 units, because the ESP8266 has no
+ * FPU.
+ */
+
+#ifndef OLED_ANIM_H
+#define OLED_ANIM_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "i2c_bus.h"
+
+// Draws frame `step` of a keyframe
+typedef void (*AnimDraw)(uint8_t step);
+
+#define ANIM_OVERLAY 0x01       // Keyframe: draw over the current frame
+#define ANIM_LOOP 0x01          // Animation: restart after the last keyframe
+
+struct AnimKeyframe {
+  AnimDraw draw;                // nullptr: a blank frame
+  uint8_t from;                 // Step range, either direction, inclusive
+  uint8_t to;
+  uint16_t frameMs;             // Time each step stays up
+  uint8_t flags;
+};
+
+// Keyframe tables live in PROGMEM
+struct Animation {
+  const char* name;
+  const AnimKeyframe* keyframes;
+  uint8_t count;
+  uint8_t flags;
+  I2cPriority priority;         // Of its frame transfers
+};
+
+// Table and count for an Animation initializer
+#define ANIM_KEYFRAMES(table) table, (uint8_t)(sizeof(table) / sizeof(table[0]))
+
+// Restart `anim` from its first frame, replacing whatever is playing
+void animStart(const Animation& anim);
+void animCancel();
+
+// Off: animStart() does nothing and the static screen stays (memory governor)
+void animSetEnabled(bool enabled);
+bool animIsPlaying(const Animation& anim);
+bool animActive();
+
+// Loop hook: shows the next frame when it is due
+void serviceAnimation();
+
+// Fixed-point trig: binary angle in, 1/256 units out
+int16_t animSin(uint8_t angle);
+inline int16_t animCos(uint8_t angle) { return animSin(angle + 64); }
+
+// Status
+void animToJson(JsonObject out);
+
+#endif // OLED_ANIM_H
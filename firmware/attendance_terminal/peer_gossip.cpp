@@ -0,0 +1,198 @@
+/*
+ * LAN peer gossip transport for Attendee Attendance Terminal v2.0
+ *
+ * WiFiUDP multicast around the portable ledger. Packets are read without
+ * blocking in servicePeerGossip(); a tap is sent the moment it is recorded
+ * and repeated every PEER_RESEND_MS while it still has sends left.
+ */
+
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "peer_gossip.h"
+#include "soft_clock.h"
+
+static WiFiUDP peerUdp;
+static IPAddress groupAddress;
+static bool joined = false;
+static uint32_t selfId = 0;
+static unsigned long lastSend = 0;
+
+static uint32_t packetsSent = 0;
+static uint32_t packetsReceived = 0;
+static uint32_t packetsRejected = 0;
+static uint32_t duplicatesResolved = 0;
+
+// ========================================
+// TRANSPORT
+// ========================================
+
+static void joinGroup() {
+  if (!groupAddress.fromString(PEER_MULTICAST_GROUP) ||
+      !peerUdp.beginMulticast(WiFi.localIP(), groupAddress, PEER_MULTICAST_PORT)) {
+    LOG_ERROR("Peer gossip: could not join " PEER_MULTICAST_GROUP);
+    return;
+  }
+  joined = true;
+  LOG_INFO("Peer gossip on " PEER_MULTICAST_GROUP ":%d", PEER_MULTICAST_PORT);
+}
+
+static void sendOutbox() {
+  PeerTapEvent events[PEER_OUTBOX_SIZE];
+  uint8_t count = peerOutboxCollect(events, PEER_OUTBOX_SIZE);
+  if (count == 0) {
+    return;
+  }
+
+  uint8_t packet[PEER_PACKET_MAX];
+  size_t length = peerEncodePacket(packet, sizeof(packet), selfId, events, count);
+  if (length == 0) {
+    return;
+  }
+  peerUdp.beginPacketMulticast(groupAddress, PEER_MULTICAST_PORT, WiFi.localIP());
+  peerUdp.write(packet, length);
+  if (peerUdp.endPacket()) {
+    packetsSent++;
+  }
+  lastSend = millis();
+}
+
+static void receivePackets() {
+  // Bounded per loop so a chatty subnet cannot starve the reader
+  for (uint8_t n = 0; n < 4; n++) {
+    int size = peerUdp.parsePacket();
+    if (size <= 0) {
+      return;
+    }
+
+    uint8_t packet[PEER_PACKET_MAX];
+    if (size > (int)sizeof(packet)) {
+      packetsRejected++;
+      continue; // The next parsePacket() discards the rest
+    }
+    int length = peerUdp.read(packet, sizeof(packet));
+
+    uint32_t sender;
+    PeerTapEvent events[PEER_OUTBOX_SIZE];
+    int count = length > 0 ? peerDecodePacket(packet, length, sender, events, PEER_OUTBOX_SIZE) : -1;
+    if (count < 0) {
+      packetsRejected++;
+      continue;
+    }
+    if (sender == selfId) {
+      continue; // Our own packet looped back
+    }
+
+    packetsReceived++;
+    if (!clockIsValid()) {
+      continue; // Cannot tell a skewed tap from a current one
+    }
+    uint32_t now = clockNowUnix();
+    for (int i = 0; i < count; i++) {
+      peerLedgerMerge(events[i], now);
+    }
+  }
+}
+
+// ========================================
+// SETUP AND LOOP HOOKS
+// ========================================
+
+void beginPeerGossip(const String& key) {
+  selfId = ESP.getChipId();
+  peerLedgerReset();
+  peerGossipSetKey(key);
+  if (PEER_GOSSIP_ENABLED && peerHasKey() && WiFi.status() == WL_CONNECTED) {
+    joinGroup();
+  }
+}
+
+void servicePeerGossip() {
+  if (!PEER_GOSSIP_ENABLED || !peerHasKey()) {
+    return;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    joined = false; // Membership is lost with the association
+    return;
+  }
+  if (!joined) {
+    joinGroup();
+    return;
+  }
+
+  receivePackets();
+  if (millis() - lastSend >= PEER_RESEND_MS && peerOutboxPending()) {
+    sendOutbox();
+  }
+}
+
+// Packets are tagged with the device key; without one gossip stays off
+void peerGossipSetKey(const String& key) {
+  peerSetKey(key.c_str());
+  if (PEER_GOSSIP_ENABLED && !peerHasKey()) {
+    LOG_WARN("Peer gossip off: no device key configured");
+  }
+}
+
+// ========================================
+// TAP HANDLING
+// ========================================
+
+// True when this student tapped at any gate within the duplicate window,
+// going the same way
+bool peerGossipFindDuplicate(const String& rfidTag, uint8_t lane, PeerTapEvent& last) {
+  if (!PEER_GOSSIP_ENABLED || !peerHasKey() || !clockIsValid()) {
+    return false;
+  }
+  if (!peerLedgerFindRecent(peerUidHash(rfidTag.c_str()), lane, clockNowUnix(), last)) {
+    return false;
+  }
+  duplicatesResolved++;
+  return true;
+}
+
+// Share a completed tap; failed taps are not recorded so the student can retry
+void peerGossipRecordTap(const String& rfidTag, uint8_t lane, const char* outcome) {
+  uint8_t type = peerTapTypeFromOutcome(outcome);
+  if (!PEER_GOSSIP_ENABLED || !peerHasKey() || type == PEER_TAP_NONE || !clockIsValid()) {
+    return;
+  }
+
+  PeerTapEvent event;
+  event.uidHash = peerUidHash(rfidTag.c_str());
+  event.time = clockNowUnix();
+  event.origin = selfId;
+  event.type = type;
+  event.lane = lane;
+  peerLedgerMerge(event, event.time);
+  peerOutboxAdd(event);
+
+  if (joined) {
+    sendOutbox();
+  }
+}
+
+bool peerGossipIsOwnTap(const PeerTapEvent& event) {
+  return event.origin == selfId;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void peerGossipToJson(JsonObject out) {
+  const PeerLedgerStats& stats = peerLedgerStats();
+  out["enabled"] = PEER_GOSSIP_ENABLED;
+  out["keyed"] = peerHasKey();
+  out["joined"] = joined;
+  out["students"] = stats.entries;
+  out["merged"] = stats.merged;
+  out["evictions"] = stats.evictions;
+  out["future"] = stats.future;
+  out["sent"] = packetsSent;
+  out["received"] = packetsReceived;
+  out["rejected"] = packetsRejected;
+  out["duplicatesResolved"] = duplicatesResolved;
+}
@@ -0,0 +1,38 @@
+/*
+ * LAN peer gossip of taps between terminals
+ * Attendee Attendance Terminal v2.0
+ *
+ * Terminals on the same subnet multicast every tap they take (UID hash,
+ * type, lane, time) to PEER_MULTICAST_GROUP and merge what they hear into the
+ * daily ledger (peer_ledger.h). A student who tapped at another gate less
+ * than PEER_DUPLICATE_WINDOW_S ago in the same direction is answered locally, with no backend
+ * round trip and no second offline record. Each tap is repeated in the
+ * next PEER_EVENT_SENDS packets instead of being acknowledged, so a lost
+ * packet costs nothing but a later duplicate check.
+ *
+ * A duplicate only changes the feedback at the gate: the tap itself is
+ * still queued for the backend, which dedupes it. Gossip stays off until
+ * a device key is configured, since packets are tagged with it.
+ */
+
+#ifndef PEER_GOSSIP_H
+#define PEER_GOSSIP_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "peer_ledger.h"
+
+// Setup and loop hooks
+void beginPeerGossip(const String& key);
+void servicePeerGossip();
+void peerGossipSetKey(const String& key);
+
+// Tap handling
+bool peerGossipFindDuplicate(const String& rfidTag, uint8_t lane, PeerTapEvent& last);
+void peerGossipRecordTap(const String& rfidTag, uint8_t lane, const char* outcome);
+bool peerGossipIsOwnTap(const PeerTapEvent& event);
+
+// Status
+void peerGossipToJson(JsonObject out);
+
+#endif // PEER_GOSSIP_H
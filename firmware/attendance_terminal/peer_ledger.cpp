@@ -0,0 +1,328 @@
+/*
+ * Cross-gate tap ledger for Attendee Attendance Terminal v2.0
+ *
+ * PEER_LEDGER_SIZE entries in 4-way buckets indexed by UID hash. A full
+ * bucket evicts its oldest tap, which is the one least likely to matter
+ * for the duplicate window. The whole ledger is cleared when an event or
+ * lookup for a later day arrives.
+ *
+ * Packet tags are SipHash-2-4, which is built for short messages and
+ * cheap on the ESP8266. The 128-bit key is derived from the shared secret
+ * by hashing it under two fixed keys.
+ */
+
+#include <string.h>
+#include "peer_ledger.h"
+
+#define PEER_WAYS 4
+#define PEER_BUCKETS (PEER_LEDGER_SIZE / PEER_WAYS)
+#define SECONDS_PER_DAY 86400UL
+
+static PeerTapEvent ledger[PEER_BUCKETS][PEER_WAYS];   // uidHash 0 = empty slot
+static uint32_t ledgerDay = 0;
+static PeerLedgerStats stats = { 0, 0, 0, 0, 0 };
+static uint64_t tagKey[2] = { 0, 0 };
+static bool keyed = false;
+
+struct OutboxEntry {
+  PeerTapEvent event;
+  uint8_t sendsLeft;
+};
+
+static OutboxEntry outbox[PEER_OUTBOX_SIZE];
+static uint8_t outboxNext = 0;
+
+// ========================================
+// LEDGER
+// ========================================
+
+uint32_t peerUidHash(const char* rfidTag) {
+  uint32_t hash = 2166136261UL;
+  for (const char* p = rfidTag; *p; p++) {
+    hash ^= (uint8_t)*p;
+    hash *= 16777619UL;
+  }
+  return hash != 0 ? hash : 1;
+}
+
+void peerLedgerReset() {
+  memset(ledger, 0, sizeof(ledger));
+  stats.entries = 0;
+}
+
+// Returns false for events from a day that is already over
+static bool enterDay(uint32_t time) {
+  uint32_t day = time / SECONDS_PER_DAY;
+  if (day < ledgerDay) {
+    return false;
+  }
+  if (day > ledgerDay) {
+    peerLedgerReset();
+    ledgerDay = day;
+  }
+  return true;
+}
+
+// Later tap wins; the origin breaks ties so every terminal picks the same one
+static bool isNewer(const PeerTapEvent& a, const PeerTapEvent& b) {
+  return a.time > b.time || (a.time == b.time && a.origin > b.origin);
+}
+
+bool peerLedgerMerge(const PeerTapEvent& event, uint32_t now) {
+  // Checked before enterDay() so a forged next-day tap cannot wipe the ledger
+  if (event.time > now + PEER_MAX_SKEW_S) {
+    stats.future++;
+    return false;
+  }
+  if (event.uidHash == 0 || !enterDay(event.time)) {
+    stats.stale++;
+    return false;
+  }
+
+  PeerTapEvent* bucket = ledger[event.uidHash % PEER_BUCKETS];
+  PeerTapEvent* slot = nullptr;
+  for (uint8_t i = 0; i < PEER_WAYS; i++) {
+    if (bucket[i].uidHash == event.uidHash) {
+      if (!isNewer(event, bucket[i])) {
+        stats.stale++;
+        return false;
+      }
+      bucket[i] = event;
+      stats.merged++;
+      return true;
+    }
+    if (slot == nullptr || (slot->uidHash != 0 && (bucket[i].uidHash == 0 || bucket[i].time < slot->time))) {
+      slot = &bucket[i];
+    }
+  }
+
+  if (slot->uidHash == 0) {
+    stats.entries++;
+  } else {
+    stats.evictions++;
+  }
+  *slot = event;
+  stats.merged++;
+  return true;
+}
+
+bool peerLedgerFindRecent(uint32_t uidHash, uint8_t lane, uint32_t now, PeerTapEvent& last) {
+  if (!enterDay(now)) {
+    return false;
+  }
+  const PeerTapEvent* bucket = ledger[uidHash % PEER_BUCKETS];
+  for (uint8_t i = 0; i < PEER_WAYS; i++) {
+    if (bucket[i].uidHash == uidHash) {
+      // A tap slightly "from the future" is clock skew between gates; still recent
+      if (bucket[i].time > now + PEER_MAX_SKEW_S ||
+          bucket[i].time + PEER_DUPLICATE_WINDOW_S <= now) {
+        return false;
+      }
+      // Entry then exit (or back) is two events, not a repeat
+      if (lane != RFID_LANE_NONE && bucket[i].lane != RFID_LANE_NONE && bucket[i].lane != lane) {
+        return false;
+      }
+      last = bucket[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+const PeerLedgerStats& peerLedgerStats() {
+  return stats;
+}
+
+// ========================================
+// OUTBOX
+// ========================================
+
+void peerOutboxAdd(const PeerTapEvent& event) {
+  outbox[outboxNext].event = event;
+  outbox[outboxNext].sendsLeft = PEER_EVENT_SENDS;
+  outboxNext = (outboxNext + 1) % PEER_OUTBOX_SIZE;
+}
+
+uint8_t peerOutboxCollect(PeerTapEvent* out, uint8_t max) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < PEER_OUTBOX_SIZE && count < max; i++) {
+    if (outbox[i].sendsLeft > 0) {
+      out[count++] = outbox[i].event;
+      outbox[i].sendsLeft--;
+    }
+  }
+  return count;
+}
+
+bool peerOutboxPending() {
+  for (uint8_t i = 0; i < PEER_OUTBOX_SIZE; i++) {
+    if (outbox[i].sendsLeft > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// ========================================
+// PACKET KEY
+// ========================================
+
+#define SIP_ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIP_ROUND(v0, v1, v2, v3) do { \
+    v0 += v1; v1 = SIP_ROTL(v1, 13); v1 ^= v0; v0 = SIP_ROTL(v0, 32); \
+    v2 += v3; v3 = SIP_ROTL(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = SIP_ROTL(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = SIP_ROTL(v1, 17); v1 ^= v2; v2 = SIP_ROTL(v2, 32); \
+  } while (0)
+
+static uint64_t get64(const uint8_t* p) {
+  uint64_t value = 0;
+  for (int i = 7; i >= 0; i--) {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+static uint64_t sipHash24(const uint64_t key[2], const uint8_t* data, size_t length) {
+  uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+  uint64_t v1 = 0x646f72616e646f6dULL ^ key[1];
+  uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+  uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+
+  const uint8_t* end = data + (length & ~(size_t)7);
+  for (; data != end; data += 8) {
+    uint64_t m = get64(data);
+    v3 ^= m;
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+    v0 ^= m;
+  }
+
+  uint64_t last = (uint64_t)length << 56;
+  for (size_t i = 0; i < (length & 7); i++) {
+    last |= (uint64_t)data[i] << (8 * i);
+  }
+  v3 ^= last;
+  SIP_ROUND(v0, v1, v2, v3);
+  SIP_ROUND(v0, v1, v2, v3);
+  v0 ^= last;
+
+  v2 ^= 0xff;
+  for (uint8_t i = 0; i < 4; i++) {
+    SIP_ROUND(v0, v1, v2, v3);
+  }
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+void peerSetKey(const char* secret) {
+  static const uint64_t DERIVE[2][2] = {
+    { 0x6761746570656572ULL, 0x6b65792d30000000ULL },
+    { 0x6761746570656572ULL, 0x6b65792d31000000ULL }
+  };
+  size_t length = strlen(secret);
+  keyed = length > 0;
+  tagKey[0] = keyed ? sipHash24(DERIVE[0], (const uint8_t*)secret, length) : 0;
+  tagKey[1] = keyed ? sipHash24(DERIVE[1], (const uint8_t*)secret, length) : 0;
+}
+
+bool peerHasKey() {
+  return keyed;
+}
+
+// ========================================
+// WIRE FORMAT (little endian)
+// ========================================
+
+static void put32(uint8_t* p, uint32_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+  p[2] = value >> 16;
+  p[3] = value >> 24;
+}
+
+static uint32_t get32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t peerEncodePacket(uint8_t* buffer, size_t capacity, uint32_t sender,
+                        const PeerTapEvent* events, uint8_t count) {
+  size_t length = PEER_PACKET_HEADER + (size_t)count * PEER_EVENT_WIRE_SIZE;
+  if (!keyed || length + PEER_PACKET_TAG > capacity) {
+    return 0;
+  }
+  buffer[0] = PEER_PACKET_MAGIC & 0xFF;
+  buffer[1] = PEER_PACKET_MAGIC >> 8;
+  buffer[2] = PEER_PACKET_VERSION;
+  buffer[3] = count;
+  put32(buffer + 4, sender);
+
+  uint8_t* p = buffer + PEER_PACKET_HEADER;
+  for (uint8_t i = 0; i < count; i++, p += PEER_EVENT_WIRE_SIZE) {
+    put32(p, events[i].uidHash);
+    put32(p + 4, events[i].time);
+    p[8] = events[i].type;
+    p[9] = events[i].lane;
+  }
+
+  uint64_t tag = sipHash24(tagKey, buffer, length);
+  put32(p, (uint32_t)tag);
+  put32(p + 4, (uint32_t)(tag >> 32));
+  return length + PEER_PACKET_TAG;
+}
+
+// Returns the number of events, or -1 for anything that is not a valid,
+// correctly tagged packet
+int peerDecodePacket(const uint8_t* buffer, size_t length, uint32_t& sender,
+                     PeerTapEvent* events, uint8_t max) {
+  if (!keyed || length < PEER_PACKET_HEADER ||
+      buffer[0] != (PEER_PACKET_MAGIC & 0xFF) || buffer[1] != (PEER_PACKET_MAGIC >> 8) ||
+      buffer[2] != PEER_PACKET_VERSION) {
+    return -1;
+  }
+  uint8_t count = buffer[3];
+  size_t body = PEER_PACKET_HEADER + (size_t)count * PEER_EVENT_WIRE_SIZE;
+  if (count > max || length != body + PEER_PACKET_TAG) {
+    return -1;
+  }
+
+  // Compare every byte so the time taken does not reveal a matching prefix
+  uint64_t expected = sipHash24(tagKey, buffer, body);
+  uint8_t diff = 0;
+  for (uint8_t i = 0; i < PEER_PACKET_TAG; i++) {
+    diff |= buffer[body + i] ^ (uint8_t)(expected >> (8 * i));
+  }
+  if (diff != 0) {
+    return -1;
+  }
+  sender = get32(buffer + 4);
+
+  const uint8_t* p = buffer + PEER_PACKET_HEADER;
+  for (uint8_t i = 0; i < count; i++, p += PEER_EVENT_WIRE_SIZE) {
+    events[i].uidHash = get32(p);
+    events[i].time = get32(p + 4);
+    events[i].type = p[8];
+    events[i].lane = p[9];
+    events[i].origin = sender;
+  }
+  return count;
+}
+
+// ========================================
+// NAMES
+// ========================================
+
+static const char* const TYPE_NAMES[] = { "none", "entry", "exit", "complete", "ok", "offline", "queued" };
+
+const char* peerTapTypeName(uint8_t type) {
+  return type < sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]) ? TYPE_NAMES[type] : "none";
+}
+
+// Tap outcomes as reported to /metrics; errors are not taps worth sharing
+uint8_t peerTapTypeFromOutcome(const char* outcome) {
+  for (uint8_t i = 1; i < sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]); i++) {
+    if (strcmp(outcome, TYPE_NAMES[i]) == 0) {
+      return i;
+    }
+  }
+  return PEER_TAP_NONE;
+}
@@ -0,0 +1,92 @@
+/*
+ * Cross-gate tap ledger and gossip packet format
+ * Attendee Attendance Terminal v2.0
+ *
+ * Each terminal keeps one entry per student per day: the latest tap seen
+ * at any gate (UID hash, time, type, lane, terminal). Merging keeps whichever
+ * tap is later, so applying the same event twice or in any order gives the
+ * same state. Lost or repeated gossip packets are therefore harmless.
+ *
+ * Packets carry a SipHash-2-4 tag keyed from the shared device key, so a
+ * host on the LAN without the key cannot inject taps. Taps more than
+ * PEER_MAX_SKEW_S ahead of the local clock are neither merged nor matched.
+ *
+ * A recent tap only counts as a duplicate in the same direction: an exit
+ * shortly after an entry is a new event. Taps from single-reader
+ * terminals have no direction and match either lane.
+ *
+ * No Arduino dependencies: peer_gossip.cpp carries this over WiFiUDP on the
+ * terminal, and test_peer_gossip_host.cpp carries it over POSIX sockets
+ * so several instances can be run on one Linux machine.
+ */
+
+#ifndef PEER_LEDGER_H
+#define PEER_LEDGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+#include "rfid_lanes.h"
+
+enum PeerTapType {
+  PEER_TAP_NONE = 0,
+  PEER_TAP_ENTRY,
+  PEER_TAP_EXIT,
+  PEER_TAP_COMPLETE,
+  PEER_TAP_OK,
+  PEER_TAP_OFFLINE,
+  PEER_TAP_QUEUED
+};
+
+struct PeerTapEvent {
+  uint32_t uidHash;
+  uint32_t time;                // Unix seconds from the terminal's clock
+  uint32_t origin;              // Terminal that took the tap
+  uint8_t type;                 // PeerTapType
+  uint8_t lane;                 // RFID_LANE_* of the reader that took it
+};
+
+struct PeerLedgerStats {
+  uint16_t entries;
+  uint32_t merged;              // Events that changed the ledger
+  uint32_t stale;               // Events older than what was already known
+  uint32_t future;              // Events too far ahead of the local clock
+  uint32_t evictions;
+};
+
+#define PEER_PACKET_MAGIC 0x4741        // "AG"
+#define PEER_PACKET_VERSION 3
+#define PEER_PACKET_HEADER 8            // magic u16, version u8, count u8, sender u32
+#define PEER_EVENT_WIRE_SIZE 10         // uidHash u32, time u32, type u8, lane u8
+#define PEER_PACKET_TAG 8               // SipHash-2-4 over header and events
+#define PEER_PACKET_MAX (PEER_PACKET_HEADER + PEER_OUTBOX_SIZE * PEER_EVENT_WIRE_SIZE + PEER_PACKET_TAG)
+
+// UID hashing (FNV-1a over the hex tag; the raw UID never leaves the terminal)
+uint32_t peerUidHash(const char* rfidTag);
+
+// Ledger
+void peerLedgerReset();
+bool peerLedgerMerge(const PeerTapEvent& event, uint32_t now);
+bool peerLedgerFindRecent(uint32_t uidHash, uint8_t lane, uint32_t now, PeerTapEvent& last);
+const PeerLedgerStats& peerLedgerStats();
+
+// Outbox of own taps, each handed out PEER_EVENT_SENDS times
+void peerOutboxAdd(const PeerTapEvent& event);
+uint8_t peerOutboxCollect(PeerTapEvent* out, uint8_t max);
+bool peerOutboxPending();
+
+// Packet key (an empty secret disables encoding and decoding)
+void peerSetKey(const char* secret);
+bool peerHasKey();
+
+// Wire format
+size_t peerEncodePacket(uint8_t* buffer, size_t capacity, uint32_t sender,
+                        const PeerTapEvent* events, uint8_t count);
+int peerDecodePacket(const uint8_t* buffer, size_t length, uint32_t& sender,
+                     PeerTapEvent* events, uint8_t max);
+
+// Names for logs and JSON
+const char* peerTapTypeName(uint8_t type);
+uint8_t peerTapTypeFromOutcome(const char* outcome);
+
+#endif // PEER_LEDGER_H
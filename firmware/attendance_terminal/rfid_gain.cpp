@@ -0,0 +1,220 @@
+/*
+ * Adaptive RC522 antenna gain for Attendee Attendance Terminal v2.0
+ *
+ * RFCfgReg RxGain codes 000/010 and 001/011 are the same 18 dB and 23 dB,
+ * so the controller steps along the distinct gains only.
+ */
+
+#include <LittleFS.h>
+#include <MFRC522v2.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "rfid_gain.h"
+
+static const uint8_t GAIN_CODES[] = { 0x00, 0x01, 0x04, 0x05, 0x06, 0x07 };
+static const uint8_t GAIN_DB[] = { 18, 23, 33, 38, 43, 48 };
+#define GAIN_STEPS (sizeof(GAIN_CODES) / sizeof(GAIN_CODES[0]))
+
+static RfidGainStats gainStats[GAIN_STEPS];
+static uint8_t step = 0;
+static bool loaded = false;             // RFID is initialized before LittleFS is mounted
+
+// Current window
+static uint16_t windowAttempts = 0;
+static uint16_t windowWeak = 0;
+static uint16_t windowPhantom = 0;
+static uint16_t windowCollisions = 0;
+static uint16_t windowCrcErrors = 0;
+
+// Failed reads waiting to be called weak or phantom
+static uint8_t pendingFailures = 0;
+static unsigned long pendingSince = 0;
+
+static uint32_t gainChanges = 0;
+
+// ========================================
+// GAIN STEPS
+// ========================================
+
+static int stepForGain(uint8_t gain) {
+  for (uint8_t i = 0; i < GAIN_STEPS; i++) {
+    if (GAIN_CODES[i] == gain && gain >= RFID_GAIN_MIN && gain <= RFID_GAIN_MAX) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static bool stepAllowed(int index) {
+  return index >= 0 && index < (int)GAIN_STEPS &&
+         GAIN_CODES[index] >= RFID_GAIN_MIN && GAIN_CODES[index] <= RFID_GAIN_MAX;
+}
+
+static void persistGain() {
+  File file = LittleFS.open(RFID_GAIN_FILE, "w");
+  if (!file) {
+    LOG_DEBUG("Failed to persist RFID gain");
+    return;
+  }
+  file.print(GAIN_CODES[step]);
+  file.close();
+}
+
+static void applyStep(uint8_t index, const char* reason) {
+  LOG_INFO("RFID gain %u dB -> %u dB (%s)", GAIN_DB[step], GAIN_DB[index], reason);
+  step = index;
+  gainChanges++;
+  setRFIDGain(GAIN_CODES[step]);
+  persistGain();
+}
+
+// ========================================
+// DECISIONS
+// ========================================
+
+static void resetWindow() {
+  windowAttempts = 0;
+  windowWeak = 0;
+  windowPhantom = 0;
+  windowCollisions = 0;
+  windowCrcErrors = 0;
+}
+
+static void resolvePending(bool phantom) {
+  if (pendingFailures == 0) {
+    return;
+  }
+  if (phantom) {
+    windowPhantom += pendingFailures;
+    gainStats[step].phantom += pendingFailures;
+  } else {
+    windowWeak += pendingFailures;
+    gainStats[step].weak += pendingFailures;
+  }
+  pendingFailures = 0;
+}
+
+static void judgeWindow() {
+  if (windowAttempts < RFID_GAIN_WINDOW || pendingFailures > 0) {
+    return;
+  }
+
+  uint16_t failures = windowWeak + windowPhantom + windowCollisions + windowCrcErrors;
+  int8_t failPct = (int8_t)(failures * 100UL / windowAttempts);
+  gainStats[step].lastFailPct = failPct;
+
+  if (failPct > RFID_GAIN_TARGET_FAIL_PCT) {
+    // Weak reads want more gain; noise, collisions and CRC errors want less
+    bool tooHigh = windowPhantom + windowCollisions + windowCrcErrors > windowWeak;
+    int candidate = tooHigh ? step - 1 : step + 1;
+    if (stepAllowed(candidate) &&
+        (gainStats[candidate].lastFailPct < 0 || gainStats[candidate].lastFailPct < failPct)) {
+      applyStep(candidate, tooHigh ? "phantom/collision/CRC errors" : "weak reads");
+    }
+  }
+  resetWindow();
+}
+
+// ========================================
+// SETUP AND LOOP HOOKS
+// ========================================
+
+// Call after LittleFS is mounted
+void beginRfidGain() {
+  for (uint8_t i = 0; i < GAIN_STEPS; i++) {
+    gainStats[i] = RfidGainStats();
+    gainStats[i].lastFailPct = -1;
+  }
+
+  int stored = -1;
+  File file = LittleFS.open(RFID_GAIN_FILE, "r");
+  if (file) {
+    stored = stepForGain(file.parseInt());
+    file.close();
+  }
+  step = stored >= 0 ? stored : stepForGain(RFID_DEFAULT_GAIN);
+  if (!stepAllowed(step)) {
+    step = 0;
+    while (!stepAllowed(step) && step < GAIN_STEPS - 1) {
+      step++;
+    }
+  }
+  loaded = true;
+  setRFIDGain(GAIN_CODES[step]);
+  LOG_INFO("RFID gain %u dB%s", GAIN_DB[step], stored >= 0 ? " (saved)" : "");
+}
+
+void serviceRfidGain() {
+  if (pendingFailures > 0 && millis() - pendingSince > RFID_PHANTOM_MS) {
+    resolvePending(true);
+    judgeWindow();
+  }
+}
+
+// ========================================
+// READ OUTCOMES
+// ========================================
+
+void rfidGainRecordRead(uint8_t status) {
+  windowAttempts++;
+  gainStats[step].attempts++;
+
+  switch (status) {
+    case MFRC522::STATUS_OK:
+      gainStats[step].ok++;
+      resolvePending(false); // Same card, read fine once it was held there
+      break;
+    case MFRC522::STATUS_COLLISION:
+      windowCollisions++;
+      gainStats[step].collisions++;
+      break;
+    case MFRC522::STATUS_CRC_WRONG:
+      windowCrcErrors++;
+      gainStats[step].crcErrors++;
+      break;
+    default:
+      if (pendingFailures == 0) {
+        pendingSince = millis();
+      }
+      if (pendingFailures < 255) {
+        pendingFailures++;
+      }
+      break;
+  }
+  judgeWindow();
+}
+
+uint8_t rfidGainCurrent() {
+  return loaded ? GAIN_CODES[step] : RFID_DEFAULT_GAIN;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void rfidGainToJson(JsonObject out) {
+  out["gain"] = GAIN_CODES[step];
+  out["gainDb"] = GAIN_DB[step];
+  out["gainChanges"] = gainChanges;
+  out["windowAttempts"] = windowAttempts;
+
+  JsonArray steps = out.createNestedArray("gains");
+  for (uint8_t i = 0; i < GAIN_STEPS; i++) {
+    if (!stepAllowed(i)) {
+      continue;
+    }
+    const RfidGainStats& stats = gainStats[i];
+    JsonObject entry = steps.createNestedObject();
+    entry["gainDb"] = GAIN_DB[i];
+    entry["attempts"] = stats.attempts;
+    entry["ok"] = stats.ok;
+    entry["weak"] = stats.weak;
+    entry["phantom"] = stats.phantom;
+    entry["collisions"] = stats.collisions;
+    entry["crcErrors"] = stats.crcErrors;
+    if (stats.lastFailPct >= 0) {
+      entry["lastFailPct"] = stats.lastFailPct;
+    }
+  }
+}
@@ -0,0 +1,46 @@
+/*
+ * Closed-loop antenna gain control for the RC522
+ * Attendee Attendance Terminal v2.0
+ *
+ * Every card read attempt is classified: good read, weak read (failed but
+ * the card read fine within RFID_PHANTOM_MS, so the student was holding
+ * it there), phantom (failed with no card following it), collision or CRC
+ * error. After RFID_GAIN_WINDOW attempts with more than
+ * RFID_GAIN_TARGET_FAIL_PCT failures the gain moves one step: up when weak
+ * reads dominate, down when phantoms, collisions and CRC errors do. It
+ * never moves to a gain that did worse the last time it was tried.
+ *
+ * The chosen gain persists in RFID_GAIN_FILE and is applied again by
+ * every RFID re-init.
+ */
+
+#ifndef RFID_GAIN_H
+#define RFID_GAIN_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+struct RfidGainStats {
+  uint32_t attempts;
+  uint32_t ok;
+  uint32_t weak;
+  uint32_t phantom;
+  uint32_t collisions;
+  uint32_t crcErrors;
+  int8_t lastFailPct;           // Failure rate of the last full window, -1 if never judged
+};
+
+// Setup and loop hooks
+void beginRfidGain();
+void serviceRfidGain();
+
+// Read outcomes (MFRC522::StatusCode of PICC_Select)
+void rfidGainRecordRead(uint8_t status);
+
+// Current gain (RFID_GAIN_MIN..RFID_GAIN_MAX)
+uint8_t rfidGainCurrent();
+
+// Status
+void rfidGainToJson(JsonObject out);
+
+#endif // RFID_GAIN_H
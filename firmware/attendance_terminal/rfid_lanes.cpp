@@ -0,0 +1,169 @@
+/*
+ * Reader lanes for Attendee Attendance Terminal v2.0
+ *
+ * Debounce times are millis() values; unsigned subtraction keeps the
+ * comparison right across the 49-day wrap.
+ */
+
+#include <string.h>
+#include "rfid_lanes.h"
+
+struct RfidLane {
+  bool enabled;
+  bool latched;
+  bool scanned;                 // lastScanMs is valid
+  uint8_t consecutiveFailures;
+  uint32_t lastScanMs;
+  RfidLaneStats stats;
+};
+
+static RfidLane lanes[RFID_MAX_READERS];
+static uint8_t laneCount = 1;
+static uint8_t nextPoll = 0;
+static uint8_t lastServed = 0;
+static int serving = -1;        // Reader whose tap is being processed
+
+// ========================================
+// SETUP
+// ========================================
+
+void rfidLanesReset(uint8_t readerCount) {
+  memset(lanes, 0, sizeof(lanes));
+  laneCount = readerCount < 1 ? 1 : (readerCount > RFID_MAX_READERS ? RFID_MAX_READERS : readerCount);
+  for (uint8_t i = 0; i < laneCount; i++) {
+    lanes[i].enabled = true;
+  }
+  nextPoll = 0;
+  lastServed = laneCount - 1;   // Reader 0 is served first
+  serving = -1;
+}
+
+uint8_t rfidLanesCount() {
+  return laneCount;
+}
+
+void rfidLanesSetEnabled(uint8_t index, bool enabled) {
+  if (index < laneCount) {
+    lanes[index].enabled = enabled;
+    lanes[index].latched = lanes[index].latched && enabled;
+  }
+}
+
+bool rfidLanesEnabled(uint8_t index) {
+  return index < laneCount && lanes[index].enabled;
+}
+
+// ========================================
+// SCHEDULING
+// ========================================
+
+int rfidLanesNextPoll() {
+  for (uint8_t n = 0; n < laneCount; n++) {
+    uint8_t index = nextPoll;
+    nextPoll = (nextPoll + 1) % laneCount;
+    if (lanes[index].enabled && index != serving) {
+      lanes[index].stats.polls++;
+      return index;
+    }
+  }
+  return -1;
+}
+
+void rfidLanesLatch(uint8_t index) {
+  if (rfidLanesEnabled(index) && !lanes[index].latched) {
+    lanes[index].latched = true;
+    lanes[index].stats.detections++;
+  }
+}
+
+bool rfidLanesIsLatched(uint8_t index) {
+  return index < laneCount && lanes[index].latched;
+}
+
+bool rfidLanesAnyLatched() {
+  for (uint8_t i = 0; i < laneCount; i++) {
+    if (lanes[i].latched) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int rfidLanesTakeLatched() {
+  for (uint8_t n = 1; n <= laneCount; n++) {
+    uint8_t index = (lastServed + n) % laneCount;
+    if (lanes[index].latched) {
+      lanes[index].latched = false;
+      lastServed = index;
+      return index;
+    }
+  }
+  return -1;
+}
+
+void rfidLanesBeginServing(uint8_t index) {
+  serving = index;
+}
+
+void rfidLanesEndServing() {
+  serving = -1;
+}
+
+// ========================================
+// READ OUTCOMES
+// ========================================
+
+bool rfidLanesAccept(uint8_t index, uint32_t nowMs) {
+  if (index >= laneCount) {
+    return false;
+  }
+  RfidLane& lane = lanes[index];
+  if (lane.scanned && nowMs - lane.lastScanMs < CARD_READ_DELAY) {
+    lane.stats.debounced++;
+    return false;
+  }
+  lane.scanned = true;
+  lane.lastScanMs = nowMs;
+  lane.stats.taps++;
+  return true;
+}
+
+uint8_t rfidLanesReadFailed(uint8_t index) {
+  if (index >= laneCount) {
+    return 0;
+  }
+  lanes[index].stats.readFailures++;
+  if (lanes[index].consecutiveFailures < 255) {
+    lanes[index].consecutiveFailures++;
+  }
+  return lanes[index].consecutiveFailures;
+}
+
+void rfidLanesClearFailures(uint8_t index) {
+  if (index < laneCount) {
+    lanes[index].consecutiveFailures = 0;
+  }
+}
+
+// ========================================
+// TAGS AND COUNTERS
+// ========================================
+
+uint8_t rfidLaneOf(uint8_t index) {
+  if (laneCount < 2) {
+    return RFID_LANE_NONE;
+  }
+  return index == 0 ? RFID_LANE_ENTRY : RFID_LANE_EXIT;
+}
+
+const char* rfidLaneDirection(uint8_t lane) {
+  switch (lane) {
+    case RFID_LANE_ENTRY: return "entry";
+    case RFID_LANE_EXIT:  return "exit";
+  }
+  return nullptr;
+}
+
+const RfidLaneStats& rfidLanesStats(uint8_t index) {
+  return lanes[index < laneCount ? index : 0].stats;
+}
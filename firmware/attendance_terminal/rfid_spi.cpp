@@ -0,0 +1,329 @@
+/*
+ * Burst SPI driver for the RC522 - Attendee Attendance Terminal v2.0
+ *
+ * Register addressing follows datasheet section 8.1.2.3: address in bits
+ * 1-6, bit 7 set for reads. A multi-byte read clocks out the address once
+ * per byte and a trailing 0x00; the reply to each byte is the previous
+ * address's data. The RC522 FIFO holds 64 bytes, which is also the most
+ * one ESP8266 HSPI transaction carries, so bursts never need splitting.
+ */
+
+#include <SPI.h>
+#include <MFRC522v2.h>
+#include <MFRC522DriverSPI.h>
+#include <MFRC522DriverPinSimple.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "rfid_spi.h"
+
+// External references from main file
+extern MFRC522 mfrc522;
+extern MFRC522DriverFastSPI rfidDriver;
+
+#define RFID_FIFO_SIZE 64
+#define RFID_DEFAULT_TIMER_RELOAD 0x03E8        // What PCD_Init() writes (25 ms)
+
+// Clocks the HSPI divider reaches exactly from 80 MHz, fastest first
+static const uint32_t CLOCK_STEPS[] = { 10000000UL, 8000000UL, 5000000UL, 4000000UL };
+
+// Clock HSPI is set to; readers sharing the bus may have tuned to different ones
+static uint32_t busClockHz = 0;
+
+// ========================================
+// REGISTER ACCESS
+// ========================================
+
+static inline uint8_t writeAddress(uint8_t reg) {
+  return (reg << 1) & 0x7E;
+}
+
+static inline uint8_t readAddress(uint8_t reg) {
+  return 0x80 | ((reg << 1) & 0x7E);
+}
+
+void MFRC522DriverFastSPI::select() {
+  if (busClockHz != _clockHz) {
+    setClock(_clockHz);
+  }
+  if (_csPin < 16) {
+    GPOC = 1UL << _csPin;
+  } else {
+    digitalWrite(_csPin, LOW);
+  }
+}
+
+void MFRC522DriverFastSPI::deselect() {
+  if (_csPin < 16) {
+    GPOS = 1UL << _csPin;
+  } else {
+    digitalWrite(_csPin, HIGH);
+  }
+}
+
+void MFRC522DriverFastSPI::setClock(uint32_t hz) {
+  // endTransaction() is a no-op on the ESP8266; only RC522s share HSPI
+  SPI.beginTransaction(SPISettings(hz, MSBFIRST, SPI_MODE0));
+  _clockHz = hz;
+  busClockHz = hz;
+}
+
+bool MFRC522DriverFastSPI::init() {
+  pinMode(_csPin, OUTPUT);
+  deselect();
+  SPI.begin();
+  setClock(_clockHz);
+  return true;
+}
+
+void MFRC522DriverFastSPI::PCD_WriteRegister(PCD_Register reg, byte value) {
+  uint8_t out[2] = { writeAddress(reg), value };
+  select();
+  SPI.writeBytes(out, sizeof(out));
+  deselect();
+}
+
+void MFRC522DriverFastSPI::PCD_WriteRegister(PCD_Register reg, byte count, byte* values) {
+  uint8_t out[RFID_FIFO_SIZE + 1];
+  if (count > RFID_FIFO_SIZE) {
+    count = RFID_FIFO_SIZE;
+  }
+  out[0] = writeAddress(reg);
+  memcpy(out + 1, values, count);
+  select();
+  SPI.writeBytes(out, count + 1);
+  deselect();
+}
+
+byte MFRC522DriverFastSPI::PCD_ReadRegister(PCD_Register reg) {
+  uint8_t out[2] = { readAddress(reg), 0 };
+  uint8_t in[2];
+  select();
+  SPI.transferBytes(out, in, sizeof(out));
+  deselect();
+  return in[1];
+}
+
+void MFRC522DriverFastSPI::PCD_ReadRegister(PCD_Register reg, byte count, byte* values, byte rxAlign) {
+  if (count == 0) {
+    return;
+  }
+  if (count > RFID_FIFO_SIZE) {
+    count = RFID_FIFO_SIZE;
+  }
+
+  uint8_t out[RFID_FIFO_SIZE + 1];
+  uint8_t in[RFID_FIFO_SIZE + 1];
+  memset(out, readAddress(reg), count);
+  out[count] = 0;
+  select();
+  SPI.transferBytes(out, in, count + 1);
+  deselect();
+
+  // Only bit positions rxAlign..7 of the first byte are updated
+  uint8_t mask = (0xFF << rxAlign) & 0xFF;
+  values[0] = (values[0] & ~mask) | (in[1] & mask);
+  memcpy(values + 1, in + 2, count - 1);
+}
+
+// ========================================
+// CLOCK AND TIMEOUT TUNING
+// ========================================
+
+// Round-trips patterns through the FIFO; any bit error shows up here
+bool MFRC522DriverFastSPI::loopbackPasses() {
+  uint8_t version = PCD_ReadRegister(PCD_Register::VersionReg);
+  if (version == 0x00 || version == 0xFF) {
+    return false;
+  }
+
+  uint8_t pattern[32];
+  uint8_t readBack[32];
+  for (uint8_t round = 0; round < RFID_SPI_VERIFY_ROUNDS; round++) {
+    for (uint8_t i = 0; i < sizeof(pattern); i++) {
+      pattern[i] = (round & 1) ? (i & 1 ? 0x55 : 0xAA) : (uint8_t)(i * 37 + round * 91);
+    }
+    PCD_WriteRegister(PCD_Register::CommandReg, 0x00);       // Idle, FIFO not in use
+    PCD_WriteRegister(PCD_Register::FIFOLevelReg, 0x80);     // Flush
+    PCD_WriteRegister(PCD_Register::FIFODataReg, sizeof(pattern), pattern);
+    bool intact = (PCD_ReadRegister(PCD_Register::FIFOLevelReg) & 0x7F) == sizeof(pattern);
+    if (intact) {
+      PCD_ReadRegister(PCD_Register::FIFODataReg, sizeof(readBack), readBack);
+      intact = memcmp(pattern, readBack, sizeof(pattern)) == 0;
+    }
+    PCD_WriteRegister(PCD_Register::FIFOLevelReg, 0x80);
+    if (!intact) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void MFRC522DriverFastSPI::setTimeout() {
+  // PCD_Init() leaves TPrescaler at 25 us per tick; only the reload changes
+  PCD_WriteRegister(PCD_Register::TReloadRegH, RFID_TIMER_RELOAD >> 8);
+  PCD_WriteRegister(PCD_Register::TReloadRegL, RFID_TIMER_RELOAD & 0xFF);
+}
+
+bool MFRC522DriverFastSPI::tune() {
+  uint32_t previous = _clockHz;
+  _verified = false;
+
+  for (uint8_t i = 0; i < sizeof(CLOCK_STEPS) / sizeof(CLOCK_STEPS[0]); i++) {
+    if (CLOCK_STEPS[i] > RFID_SPI_MAX_HZ || CLOCK_STEPS[i] < RFID_SPI_SAFE_HZ) {
+      continue;
+    }
+    setClock(CLOCK_STEPS[i]);
+    if (loopbackPasses()) {
+      _verified = true;
+      break;
+    }
+  }
+
+  if (!_verified) {
+    setClock(RFID_SPI_SAFE_HZ);
+    LOG_ERROR("RFID SPI loopback failed at every clock, check wiring");
+    return false;
+  }
+  if (_clockHz != previous) {
+    LOG_INFO("RFID SPI at %lu kHz", (unsigned long)(_clockHz / 1000));
+  }
+  setTimeout();
+  return true;
+}
+
+void MFRC522DriverFastSPI::reclaimBus() {
+  setClock(_clockHz);
+  setTimeout();
+}
+
+// ========================================
+// BENCHMARK
+// ========================================
+
+// The stock driver on the same chip select, for comparison only
+static MFRC522DriverPinSimple benchPin(RFID_SS_PIN);
+static MFRC522DriverSPI stockDriver(benchPin);
+static MFRC522 stockReader(stockDriver);
+
+static RfidBenchResult benchResult;
+static bool benchActive = false;
+static bool benchRan = false;
+static unsigned long phaseStart = 0;
+static uint32_t phasePolls = 0;
+
+#define RFID_BENCH_SLICE_MS 20          // Longest a benchmark slice holds up loop()
+
+static void useDriver(bool fast) {
+  if (fast) {
+    rfidDriver.reclaimBus();
+    return;
+  }
+  // Stock conditions: 4 MHz per-access transactions and the 25 ms timeout
+  busClockHz = 0; // The stock driver sets its own clock on every access
+  stockDriver.PCD_WriteRegister(MFRC522Driver::PCD_Register::TReloadRegH, RFID_DEFAULT_TIMER_RELOAD >> 8);
+  stockDriver.PCD_WriteRegister(MFRC522Driver::PCD_Register::TReloadRegL, RFID_DEFAULT_TIMER_RELOAD & 0xFF);
+}
+
+void rfidBenchBegin() {
+  benchResult = RfidBenchResult();
+  benchResult.fastClockHz = rfidDriver.clockHz();
+  benchActive = true;
+  phaseStart = 0;
+  stockDriver.init();
+}
+
+bool rfidBenchPolls(bool fast) {
+  MFRC522& reader = fast ? mfrc522 : stockReader;
+  if (phaseStart == 0) {
+    useDriver(fast);
+    phaseStart = millis();
+    phasePolls = 0;
+  }
+
+  unsigned long sliceStart = millis();
+  while (millis() - sliceStart < RFID_BENCH_SLICE_MS) {
+    reader.PICC_IsNewCardPresent();
+    phasePolls++;
+  }
+
+  unsigned long elapsed = millis() - phaseStart;
+  if (elapsed < RFID_BENCH_PHASE_MS) {
+    return false;
+  }
+  uint32_t pollsPerSec = phasePolls * 1000UL / elapsed;
+  if (fast) {
+    benchResult.fastPollsPerSec = pollsPerSec;
+  } else {
+    benchResult.stockPollsPerSec = pollsPerSec;
+  }
+  phaseStart = 0;
+  return true;
+}
+
+// WUPA + anticollision/select, then HLTA so the next WUPA wakes it again
+bool rfidBenchReads(bool fast) {
+  MFRC522& reader = fast ? mfrc522 : stockReader;
+  useDriver(fast);
+
+  uint32_t totalUs = 0;
+  uint8_t reads = 0;
+  for (uint8_t i = 0; i < RFID_BENCH_READS; i++) {
+    byte atqa[2];
+    byte atqaSize = sizeof(atqa);
+    unsigned long start = micros();
+    MFRC522::StatusCode status = reader.PICC_WakeupA(atqa, &atqaSize);
+    if (status == MFRC522::STATUS_OK) {
+      status = reader.PICC_Select(&reader.uid);
+    }
+    unsigned long elapsed = micros() - start;
+    reader.PICC_HaltA();
+    if (status == MFRC522::STATUS_OK) {
+      totalUs += elapsed;
+      reads++;
+    } else if (reads == 0) {
+      return false;
+    }
+    yield();
+  }
+
+  uint32_t meanUs = totalUs / reads;
+  if (fast) {
+    benchResult.fastReadUs = meanUs;
+  } else {
+    benchResult.stockReadUs = meanUs;
+  }
+  return true;
+}
+
+void rfidBenchEnd() {
+  rfidDriver.reclaimBus();
+  benchActive = false;
+  benchRan = true;
+}
+
+bool rfidBenchActive() {
+  return benchActive;
+}
+
+const RfidBenchResult& rfidBenchResult() {
+  return benchResult;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void rfidSpiToJson(JsonObject out) {
+  out["clockHz"] = rfidDriver.clockHz();
+  out["verified"] = rfidDriver.verified();
+  out["timeoutUs"] = RFID_TIMER_RELOAD * 25UL;
+  if (benchRan) {
+    JsonObject bench = out.createNestedObject("benchmark");
+    bench["stockPollsPerSec"] = benchResult.stockPollsPerSec;
+    bench["fastPollsPerSec"] = benchResult.fastPollsPerSec;
+    bench["stockReadUs"] = benchResult.stockReadUs;
+    bench["fastReadUs"] = benchResult.fastReadUs;
+    bench["fastClockHz"] = benchResult.fastClockHz;
+  }
+}
@@ -0,0 +1,80 @@
+/*
+ * Burst SPI driver for the RC522
+ * Attendee Attendance Terminal v2.0
+ *
+ * Drop-in MFRC522Driver for the ESP8266 HSPI port. Every register access,
+ * single or multi-byte, is one transaction through the 64-byte hardware
+ * FIFO (SPI.transferBytes) with chip select driven through the GPIO
+ * set/clear registers. Only RC522s share the bus, so the clock and mode
+ * are set once, and again only when another reader tuned to a different
+ * clock.
+ *
+ * tune() runs after every PCD_Init(): it keeps the fastest clock from
+ * RFID_SPI_MAX_HZ down to RFID_SPI_SAFE_HZ at which FIFO loopback patterns
+ * read back intact, and shortens the RC522 timer to RFID_TIMER_RELOAD so a
+ * REQA with no card answering fails in 2 ms instead of 25 ms.
+ *
+ * The benchmark (POST /api/actions/rfid-benchmark) compares it against
+ * the stock MFRC522DriverSPI on the same reader: polls per second with no
+ * card, and UID read latency (WUPA + select) with a card held in place.
+ */
+
+#ifndef RFID_SPI_H
+#define RFID_SPI_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <MFRC522v2.h>
+#include "config.h"
+
+class MFRC522DriverFastSPI : public MFRC522Driver {
+public:
+  explicit MFRC522DriverFastSPI(uint8_t chipSelectPin) : _csPin(chipSelectPin) {}
+
+  bool init() override;
+  void PCD_WriteRegister(PCD_Register reg, byte value) override;
+  void PCD_WriteRegister(PCD_Register reg, byte count, byte* values) override;
+  byte PCD_ReadRegister(PCD_Register reg) override;
+  void PCD_ReadRegister(PCD_Register reg, byte count, byte* values, byte rxAlign = 0) override;
+
+  // Call after PCD_Init(); false when even RFID_SPI_SAFE_HZ fails loopback
+  bool tune();
+  // Put back the tuned clock and timeout after another driver used the bus
+  void reclaimBus();
+
+  uint32_t clockHz() const { return _clockHz; }
+  bool verified() const { return _verified; }
+
+private:
+  void select();
+  void deselect();
+  void setClock(uint32_t hz);
+  void setTimeout();
+  bool loopbackPasses();
+
+  uint8_t _csPin;
+  uint32_t _clockHz = RFID_SPI_SAFE_HZ;
+  bool _verified = false;
+};
+
+struct RfidBenchResult {
+  uint32_t stockPollsPerSec;
+  uint32_t fastPollsPerSec;
+  uint32_t stockReadUs;         // Mean UID read, 0 without a card
+  uint32_t fastReadUs;
+  uint32_t fastClockHz;
+};
+
+// Benchmark phases, advanced one slice per loop() by the API job.
+// Card scanning is paused while it runs so the test card is not logged.
+void rfidBenchBegin();
+bool rfidBenchPolls(bool fast);         // True once the phase has run RFID_BENCH_PHASE_MS
+bool rfidBenchReads(bool fast);         // False when no card answered
+void rfidBenchEnd();
+bool rfidBenchActive();
+const RfidBenchResult& rfidBenchResult();
+
+// Status
+void rfidSpiToJson(JsonObject out);
+
+#endif // RFID_SPI_H
@@ -0,0 +1,437 @@
+/*
+ * Software wall clock for Attendee Attendance Terminal v2.0
+ *
+ * Time is kept as local epoch milliseconds at an anchor millis() value:
+ *
+ *   now = anchorMs + elapsed + elapsed * millisPpm / 1e6
+ *
+ * The anchor is moved forward once per CLOCK_TICK_MS, and that is where
+ * pending corrections are slewed in (at most CLOCK_MAX_SLEW_PPM).
+ *
+ * References:
+ * - DS3231: read at a seconds edge, from the SQW interrupt when
+ *   RTC_SQW_PIN is wired, otherwise by polling the seconds register for a
+ *   few hundred ms. Successive RTC samples measure the ESP crystal drift.
+ * - SNTP: the core's background client; settimeofday_cb() flags each
+ *   update. While NTP is fresh it disciplines the clock, the RTC's own
+ *   drift is measured against it and trimmed through the DS3231 aging
+ *   register, and the RTC is rewritten on a second boundary when it has
+ *   wandered off.
+ */
+
+#include <Wire.h>
+#include <coredecls.h>
+#include <sys/time.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "soft_clock.h"
+#include "i2c_bus.h"
+#include "task_sched.h"
+
+// External references from main file
+extern RTC_DS3231 rtc;
+
+#define DS3231_ADDRESS 0x68
+#define DS3231_AGING_REG 0x10
+#define MIN_VALID_UNIX 1609459200UL     // 2021-01-01; anything earlier means the RTC lost power
+
+enum ClockSource {
+  CLOCK_SOURCE_NONE,
+  CLOCK_SOURCE_RTC,
+  CLOCK_SOURCE_NTP
+};
+
+// Clock state
+static int64_t anchorMs = 0;
+static uint32_t anchorMillis = 0;
+static int32_t millisPpm = 0;           // + means millis() runs slow
+static int32_t pendingSlewMs = 0;
+static bool clockValid = false;
+static ClockSource clockSource = CLOCK_SOURCE_NONE;
+static uint32_t stepCount = 0;
+
+// ESP crystal drift reference (RTC samples)
+static bool haveRateRef = false;
+static int64_t rateRefMs = 0;
+static uint32_t rateRefMillis = 0;
+
+// DS3231 sampling
+static uint32_t lastRtcResync = 0;
+static bool rtcWindowOpen = false;
+static uint32_t rtcWindowStart = 0;
+static uint32_t rtcWindowLastPoll = 0;
+static int rtcWindowSecond = -1;
+static bool haveRtcSample = false;
+static int64_t lastRtcMs = 0;
+static uint32_t lastRtcMillis = 0;
+static volatile bool sqwEdge = false;
+static volatile SchedTaskId edgeTask = -1;    // Woken by the SQW edge
+static volatile uint32_t sqwEdgeMillis = 0;
+
+// DS3231 drift against NTP
+static bool haveRtcError = false;
+static int32_t rtcErrorBaseMs = 0;
+static uint32_t rtcErrorBaseMillis = 0;
+static float rtcDriftPpm = 0;
+static int8_t rtcAging = 0;
+static bool rtcWritePending = false;
+
+// SNTP
+static volatile bool ntpUpdated = false;
+static bool haveNtp = false;
+static uint32_t lastNtpMillis = 0;
+
+// ========================================
+// CLOCK ARITHMETIC
+// ========================================
+
+static int64_t softNowAt(uint32_t atMillis) {
+  int32_t elapsed = (int32_t)(atMillis - anchorMillis);
+  return anchorMs + elapsed + (int64_t)elapsed * millisPpm / 1000000;
+}
+
+static bool ntpFresh() {
+  return haveNtp && millis() - lastNtpMillis < CLOCK_NTP_FRESH_MS;
+}
+
+// Move the anchor to now, slewing in part of any pending correction
+static void advanceAnchor(uint32_t now) {
+  uint32_t elapsed = now - anchorMillis;
+  int64_t current = softNowAt(now);
+
+  int32_t maxStep = (int32_t)((uint64_t)elapsed * CLOCK_MAX_SLEW_PPM / 1000000);
+  int32_t step = constrain(pendingSlewMs, -maxStep, maxStep);
+  pendingSlewMs -= step;
+
+  anchorMs = current + step;
+  anchorMillis = now;
+}
+
+static void applyReference(int64_t refMs, uint32_t refMillis, ClockSource source) {
+  clockSource = source;
+
+  if (!clockValid) {
+    anchorMs = refMs;
+    anchorMillis = refMillis;
+    pendingSlewMs = 0;
+    clockValid = true;
+    return;
+  }
+
+  int64_t offset = refMs - softNowAt(refMillis);
+  if (offset > CLOCK_STEP_THRESHOLD_MS || offset < -CLOCK_STEP_THRESHOLD_MS) {
+    anchorMs += offset;
+    pendingSlewMs = 0;
+    stepCount++;
+    LOG_INFO("Clock stepped by %ld ms", (long)offset);
+  } else {
+    pendingSlewMs = (int32_t)offset;
+  }
+}
+
+// ESP crystal drift from two reference samples CLOCK_RTC_RESYNC_MS apart
+static void updateMillisRate(int64_t refMs, uint32_t refMillis) {
+  if (haveRateRef) {
+    uint32_t interval = refMillis - rateRefMillis;
+    if (interval < CLOCK_RTC_RESYNC_MS / 2) {
+      return;
+    }
+    int64_t observed = ((refMs - rateRefMs) - (int64_t)interval) * 1000000 / interval;
+    if (observed <= CLOCK_MAX_DRIFT_PPM && observed >= -CLOCK_MAX_DRIFT_PPM) {
+      millisPpm = (7 * millisPpm + (int32_t)observed) / 8;
+    }
+  }
+  haveRateRef = true;
+  rateRefMs = refMs;
+  rateRefMillis = refMillis;
+}
+
+// ========================================
+// DS3231
+// ========================================
+
+static void IRAM_ATTR onRtcSquareWave() {
+  sqwEdgeMillis = millis();
+  sqwEdge = true;
+  schedSignal(edgeTask);
+}
+
+static void writeRtcAging(int8_t value) {
+  Wire.beginTransmission(DS3231_ADDRESS);
+  Wire.write(DS3231_AGING_REG);
+  Wire.write((uint8_t)value);
+  i2cBusResult(Wire.endTransmission());
+  rtcAging = value;
+}
+
+static int8_t readRtcAging() {
+  Wire.beginTransmission(DS3231_ADDRESS);
+  Wire.write(DS3231_AGING_REG);
+  uint8_t error = Wire.endTransmission();
+  i2cBusResult(error);
+  if (error != 0 || Wire.requestFrom((uint8_t)DS3231_ADDRESS, (uint8_t)1) != 1) {
+    return 0;
+  }
+  return (int8_t)Wire.read();
+}
+
+// Compare the RTC against the NTP-disciplined clock over several hours and
+// nudge the aging register, a few tenths of a ppm at a time.
+static void trackRtcDrift(int32_t rtcErrorMs, uint32_t atMillis) {
+  if (!haveRtcError) {
+    haveRtcError = true;
+    rtcErrorBaseMs = rtcErrorMs;
+    rtcErrorBaseMillis = atMillis;
+    return;
+  }
+
+  uint32_t interval = atMillis - rtcErrorBaseMillis;
+  if (interval < CLOCK_RTC_DRIFT_MIN_INTERVAL_MS) {
+    return;
+  }
+
+  float observed = (float)(rtcErrorMs - rtcErrorBaseMs) * 1000000.0f / interval;
+  rtcDriftPpm = observed;
+  haveRtcError = false;
+
+  // Positive aging values slow the oscillator (about 0.1 ppm per LSB)
+  int trim = constrain((int)lroundf(observed * 10.0f), -CLOCK_AGING_MAX_STEP, CLOCK_AGING_MAX_STEP);
+  if (trim != 0) {
+    int aging = constrain((int)rtcAging + trim, -127, 127);
+    writeRtcAging((int8_t)aging);
+    LOG_INFO("RTC drift %.2f ppm, aging offset now %d", (double)observed, aging);
+  }
+}
+
+static void onRtcSample(uint32_t rtcUnix, uint32_t atMillis) {
+  if (rtcUnix < MIN_VALID_UNIX) {
+    rtcWritePending = ntpFresh();
+    return;
+  }
+
+  int64_t rtcMs = (int64_t)rtcUnix * 1000;
+  haveRtcSample = true;
+  lastRtcMs = rtcMs;
+  lastRtcMillis = atMillis;
+  updateMillisRate(rtcMs, atMillis);
+
+  if (!ntpFresh()) {
+    applyReference(rtcMs, atMillis, CLOCK_SOURCE_RTC);
+    return;
+  }
+
+  int32_t rtcErrorMs = (int32_t)(rtcMs - softNowAt(atMillis));
+  trackRtcDrift(rtcErrorMs, atMillis);
+  if (abs(rtcErrorMs) > CLOCK_RTC_WRITE_THRESHOLD_MS) {
+    rtcWritePending = true;
+  }
+}
+
+// Find the next seconds edge without blocking: the SQW interrupt marks it,
+// or the seconds register is polled every CLOCK_RTC_POLL_MS until it ticks.
+static void serviceRtcWindow(uint32_t now) {
+  if (!rtcWindowOpen) {
+    if (now - lastRtcResync < CLOCK_RTC_RESYNC_MS) {
+      return;
+    }
+    rtcWindowOpen = true;
+    rtcWindowStart = now;
+    rtcWindowSecond = -1;
+    sqwEdge = false;
+  }
+
+  if (now - rtcWindowStart > CLOCK_RTC_WINDOW_MS) {
+    // Loop was too busy to catch an edge; try again next period
+    rtcWindowOpen = false;
+    lastRtcResync = now;
+    return;
+  }
+
+#if RTC_SQW_PIN >= 0
+  if (!sqwEdge) {
+    return;
+  }
+  uint32_t edgeMillis = sqwEdgeMillis;
+  sqwEdge = false;
+  if (now - edgeMillis > 500) {
+    return; // Seconds register may already have moved on
+  }
+  uint32_t rtcUnix = rtc.now().unixtime();
+#else
+  if (now - rtcWindowLastPoll < CLOCK_RTC_POLL_MS) {
+    return;
+  }
+  bool pollGap = rtcWindowSecond >= 0 && now - rtcWindowLastPoll > 3 * CLOCK_RTC_POLL_MS;
+  rtcWindowLastPoll = now;
+
+  DateTime rtcNow = rtc.now();
+  int second = rtcNow.second();
+  if (rtcWindowSecond < 0 || pollGap || second == rtcWindowSecond) {
+    // Baseline (again if the loop stalled between polls)
+    rtcWindowSecond = second;
+    return;
+  }
+  uint32_t edgeMillis = now - CLOCK_RTC_POLL_MS / 2;
+  uint32_t rtcUnix = rtcNow.unixtime();
+#endif
+
+  rtcWindowOpen = false;
+  lastRtcResync = now;
+  onRtcSample(rtcUnix, edgeMillis);
+}
+
+// The DS3231 restarts its countdown chain when the seconds register is
+// written, so the write is made right after a soft-clock second boundary.
+static void serviceRtcWrite(uint32_t now) {
+  if (!rtcWritePending || !clockValid || !ntpFresh()) {
+    return;
+  }
+  int64_t nowMs = softNowAt(now);
+  if (nowMs % 1000 > 30) {
+    return;
+  }
+
+  rtc.adjust(DateTime((uint32_t)(nowMs / 1000)));
+  rtcWritePending = false;
+  haveRateRef = false;
+  haveRtcError = false;
+  LOG_INFO("RTC updated from NTP");
+}
+
+// ========================================
+// SNTP
+// ========================================
+
+static void serviceNtp(uint32_t now) {
+  if (!ntpUpdated) {
+    return;
+  }
+  ntpUpdated = false;
+
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec < (time_t)MIN_VALID_UNIX) {
+    return;
+  }
+
+  int64_t ntpMs = ((int64_t)tv.tv_sec + IST_OFFSET) * 1000 + tv.tv_usec / 1000;
+  haveNtp = true;
+  lastNtpMillis = now;
+  applyReference(ntpMs, now, CLOCK_SOURCE_NTP);
+
+  if (!haveRtcSample) {
+    rtcWritePending = true;
+  } else {
+    int64_t rtcEstimate = lastRtcMs + (int64_t)(now - lastRtcMillis) * (1000000 + millisPpm) / 1000000;
+    int64_t rtcErrorMs = rtcEstimate - ntpMs;
+    if (rtcErrorMs > CLOCK_RTC_WRITE_THRESHOLD_MS || rtcErrorMs < -CLOCK_RTC_WRITE_THRESHOLD_MS) {
+      rtcWritePending = true;
+    }
+  }
+  LOG_INFO("NTP time sync successful");
+}
+
+// Starts (or restarts) the core's background SNTP client; returns at once
+void clockRequestNtpSync() {
+  static bool callbackInstalled = false;
+  if (!callbackInstalled) {
+    settimeofday_cb([](bool fromSntp) {
+      if (fromSntp) {
+        ntpUpdated = true;
+      }
+    });
+    callbackInstalled = true;
+  }
+  configTime(IST_OFFSET, DAYLIGHT_OFFSET_SEC, NTP_SERVER);
+}
+
+// ========================================
+// SETUP AND LOOP HOOKS
+// ========================================
+
+// rtc.begin() must have succeeded. One plain read seeds the clock; the
+// first precise edge sample follows from serviceSoftClock().
+void clockBegin() {
+  uint32_t now = millis();
+  uint32_t rtcUnix = rtc.now().unixtime();
+
+  anchorMs = (int64_t)rtcUnix * 1000;
+  anchorMillis = now;
+  clockValid = rtcUnix >= MIN_VALID_UNIX;
+  clockSource = clockValid ? CLOCK_SOURCE_RTC : CLOCK_SOURCE_NONE;
+  if (!clockValid) {
+    LOG_WARN("RTC time invalid - waiting for NTP");
+  }
+
+  rtcAging = readRtcAging();
+  lastRtcResync = now - CLOCK_RTC_RESYNC_MS;
+
+#if RTC_SQW_PIN >= 0
+  rtc.writeSqwPinMode(DS3231_SquareWave1Hz);
+  pinMode(RTC_SQW_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(RTC_SQW_PIN), onRtcSquareWave, FALLING);
+#endif
+}
+
+void clockWakeOnEdge(SchedTaskId task) {
+  edgeTask = task;
+}
+
+void serviceSoftClock() {
+  uint32_t now = millis();
+
+  if (now - anchorMillis >= CLOCK_TICK_MS) {
+    advanceAnchor(now);
+  }
+  serviceNtp(now);
+  serviceRtcWindow(now);
+  serviceRtcWrite(now);
+}
+
+// ========================================
+// READING THE CLOCK
+// ========================================
+
+uint32_t clockNowUnix() {
+  return (uint32_t)(softNowAt(millis()) / 1000);
+}
+
+DateTime clockNow() {
+  return DateTime(clockNowUnix());
+}
+
+bool clockIsValid() {
+  return clockValid;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+const char* clockSourceName() {
+  if (clockSource == CLOCK_SOURCE_NTP && ntpFresh()) {
+    return "ntp";
+  }
+  if (clockValid) {
+    return "rtc";
+  }
+  return "none";
+}
+
+void clockStatusToJson(JsonObject out) {
+  out["valid"] = clockValid;
+  out["source"] = clockSourceName();
+  out["millisDriftPpm"] = millisPpm;
+  out["rtcDriftPpm"] = rtcDriftPpm;
+  out["rtcAging"] = rtcAging;
+  out["pendingSlewMs"] = pendingSlewMs;
+  out["steps"] = stepCount;
+  out["sqw"] = RTC_SQW_PIN >= 0;
+  if (haveNtp) {
+    out["lastNtpSyncAgoMs"] = millis() - lastNtpMillis;
+  }
+  if (haveRtcSample) {
+    out["lastRtcReadAgoMs"] = millis() - lastRtcMillis;
+  }
+}
@@ -0,0 +1,37 @@
+/*
+ * Software wall clock for Attendee Attendance Terminal v2.0
+ *
+ * Keeps local time (IST, like the DS3231) in RAM, advanced by millis() and
+ * corrected for the ESP crystal's measured drift. The DS3231 is read only
+ * every CLOCK_RTC_RESYNC_MS and SNTP runs in the background, so timestamp
+ * reads never touch I2C and reconnects never wait for NTP.
+ *
+ * Offsets below CLOCK_STEP_THRESHOLD_MS are slewed out gradually so the
+ * clock never runs backwards; larger ones are stepped.
+ */
+
+#ifndef SOFT_CLOCK_H
+#define SOFT_CLOCK_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <RTClib.h>
+#include "task_sched.h"
+
+// Setup and loop hooks
+void clockBegin();
+void serviceSoftClock();
+void clockRequestNtpSync();
+// The task running serviceSoftClock(), woken on each SQW edge
+void clockWakeOnEdge(SchedTaskId task);
+
+// Reading the clock (RAM only)
+DateTime clockNow();
+uint32_t clockNowUnix();
+bool clockIsValid();
+
+// Status
+const char* clockSourceName();
+void clockStatusToJson(JsonObject out);
+
+#endif // SOFT_CLOCK_H
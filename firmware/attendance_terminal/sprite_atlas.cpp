@@ -0,0 +1,78 @@
+/*
+ * OLED sprite atlas - Attendee Attendance Terminal v2.0
+ */
+
+#include "config.h"
+#if DISPLAY_OLED_FITTED
+
+#include <string.h>
+#include "sprite_atlas.h"
+
+#ifdef ARDUINO_ARCH_ESP8266
+#include <pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define memcpy_P memcpy
+#endif
+
+#include "sprite_atlas_data.h"
+
+#define FRAME_PAGES (SPRITE_FRAME_HEIGHT / 8)
+
+SpriteInfo spriteInfo(SpriteId id) {
+  SpriteInfo info;
+  memcpy_P(&info, &SPRITE_ATLAS_INFO[id < SPRITE_COUNT ? id : 0], sizeof(info));
+  return info;
+}
+
+void spriteBlit(uint8_t* frame, SpriteId id) {
+  SpriteInfo info = spriteInfo(id);
+  const uint8_t* bits = SPRITE_ATLAS_BITS + info.offset;
+  uint8_t* row = frame + (info.y / 8) * SPRITE_FRAME_WIDTH + info.x;
+
+  // The generator only emits boxes inside the frame: no clipping
+  for (uint8_t page = 0; page < info.pages; page++) {
+    for (uint8_t col = 0; col < info.width; col++) {
+      row[col] |= pgm_read_byte(bits + col);
+    }
+    bits += info.width;
+    row += SPRITE_FRAME_WIDTH;
+  }
+}
+
+void spriteBlitAt(uint8_t* frame, SpriteId id, int16_t x, int16_t y) {
+  SpriteInfo info = spriteInfo(id);
+  int16_t firstCol = x < 0 ? -x : 0;
+  int16_t endCol = SPRITE_FRAME_WIDTH - x < info.width ? SPRITE_FRAME_WIDTH - x : info.width;
+  if (firstCol >= endCol) {
+    return;
+  }
+
+  int16_t topPage = y >= 0 ? y / 8 : (y - 7) / 8;
+  uint8_t shift = y & 7;
+  const uint8_t* bits = SPRITE_ATLAS_BITS + info.offset;
+
+  for (uint8_t page = 0; page < info.pages; page++, bits += info.width) {
+    int16_t upper = topPage + page;
+    int16_t lower = upper + 1;
+    bool upperIn = upper >= 0 && upper < FRAME_PAGES;
+    bool lowerIn = shift != 0 && lower >= 0 && lower < FRAME_PAGES;
+    if (!upperIn && !lowerIn) {
+      continue;
+    }
+    uint8_t* upperRow = frame + upper * SPRITE_FRAME_WIDTH + x;
+    uint8_t* lowerRow = upperRow + SPRITE_FRAME_WIDTH;
+    for (int16_t col = firstCol; col < endCol; col++) {
+      uint8_t b = pgm_read_byte(bits + col);
+      if (upperIn) {
+        upperRow[col] |= b << shift;
+      }
+      if (lowerIn) {
+        lowerRow[col] |= b >> (8 - shift);
+      }
+    }
+  }
+}
+
+#endif // DISPLAY_OLED_FITTED
@@ -0,0 +1,42 @@
+/*
+ * OLED sprite atlas for Attendee Attendance Terminal v2.0
+ *
+ * Emojis and status icons are pre-rendered into PROGMEM in the SSD1306
+ * page layout (one byte = 8 vertical pixels, LSB on top), each cropped to
+ * the page rows and columns it covers. A blit ORs whole bytes into the
+ * framebuffer, one contiguous run per page, instead of redrawing circles
+ * and lines pixel by pixel.
+ *
+ * sprite_atlas_data.h and sprite_ids.h are generated from
+ * ../sprite_shapes.h by ../gen_sprite_atlas_host.cpp; do not edit them.
+ *
+ * No Arduino dependencies beyond pgmspace: test_sprite_atlas_host.cpp
+ * benchmarks the blits against the primitive drawings.
+ */
+
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include <stdint.h>
+#include "sprite_ids.h"
+
+#define SPRITE_FRAME_WIDTH 128
+#define SPRITE_FRAME_HEIGHT 64
+
+struct SpriteInfo {
+  uint16_t offset;              // Into the atlas bits
+  uint8_t x;                    // Where the shape was drawn: left column
+  uint8_t y;                    // and top of its first page (multiple of 8)
+  uint8_t width;
+  uint8_t pages;
+};
+
+SpriteInfo spriteInfo(SpriteId id);
+
+// Blit where the shape was drawn
+void spriteBlit(uint8_t* frame, SpriteId id);
+// Blit with the sprite's box at (x, y), clipped to the frame. A y that
+// is not a multiple of 8 splits each byte across two pages.
+void spriteBlitAt(uint8_t* frame, SpriteId id, int16_t x, int16_t y);
+
+#endif // SPRITE_ATLAS_H
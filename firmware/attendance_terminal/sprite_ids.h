@@ -0,0 +1,35 @@
+// Generated by gen_sprite_atlas_host.cpp from sprite_shapes.h - do not edit
+
+#ifndef SPRITE_IDS_H
+#define SPRITE_IDS_H
+
+#include <stdint.h>
+
+enum SpriteId : uint8_t {
+  SPRITE_HAPPY_EMOJI,
+  SPRITE_SAD_EMOJI,
+  SPRITE_VERY_SAD_EMOJI,
+  SPRITE_NEUTRAL_EMOJI,
+  SPRITE_WINK_EMOJI,
+  SPRITE_THINKING_EMOJI,
+  SPRITE_SLEEPY_EMOJI,
+  SPRITE_CONFUSED_EMOJI,
+  SPRITE_COOL_EMOJI,
+  SPRITE_WIFI_ON,
+  SPRITE_WIFI_OFF,
+  SPRITE_BATTERY_FRAME,
+  SPRITE_CARD,
+  SPRITE_SWIPE_CARD,
+  SPRITE_CHECKMARK,
+  SPRITE_CROSS,
+  SPRITE_THUMBS_UP,
+  SPRITE_THUMBS_DOWN,
+  SPRITE_HEART,
+  SPRITE_LOCK_CLOSED,
+  SPRITE_LOCK_OPEN,
+  SPRITE_CLOCK,
+  SPRITE_GEAR,
+  SPRITE_COUNT
+};
+
+#endif // SPRITE_IDS_H
@@ -0,0 +1,374 @@
+/*
+ * Loop stall profiler - Attendee Attendance Terminal v2.0
+ *
+ * Layout in RTC user memory (from STALL_RTC_BLOCK_OFFSET):
+ *   area  magic, boot count, crc32, pass histogram, top stalls
+ *   open  uptime the current pass started, innermost tag (not in the crc)
+ *
+ * Each tag's self time is counted, excluding the scopes nested inside it.
+ * The tag charged to a pass is the one with the most self time. A pass
+ * held by one slow HTTP request is charged to that request, not to the
+ * task around it.
+ */
+
+#include <coredecls.h>
+#include "config.h"
+#include "stall_profiler.h"
+#include "offline_staging.h"
+#include "offline_store.h"
+
+#define STALL_MAGIC 0x5354             // "ST"
+#define STALL_FLAG_RESET 0x01           // The pass ended in a watchdog reset
+#define STALL_SOFT_WDT_MS 3200          // The soft watchdog fires after at least this long
+
+// Upper bounds of the pass histogram buckets; the last bucket is open
+static const uint32_t STALL_BUCKETS_MS[] = { 10, 50, 100, 250, 500, 1000, 5000 };
+#define STALL_BUCKET_COUNT (sizeof(STALL_BUCKETS_MS) / sizeof(STALL_BUCKETS_MS[0]) + 1)
+
+struct StallRecord {
+  uint32_t ms;                  // Pass length; a lower bound for a reset
+  uint32_t atSec;               // Uptime the pass started, in its boot
+  uint16_t delayMs;             // Of which in delay()
+  uint16_t netMs;               // Of which in blocking network calls
+  uint16_t boot;                // StallArea.boots when it happened
+  uint8_t flags;
+  uint8_t reserved;
+  char tag[STALL_TAG_LEN];
+};
+
+struct StallArea {
+  uint16_t magic;
+  uint16_t boots;
+  uint32_t crc;                 // Of everything below
+  uint32_t buckets[STALL_BUCKET_COUNT];
+  StallRecord top[STALL_TOP_COUNT];
+};
+
+struct StallOpen {
+  uint32_t sinceMs;
+  char tag[STALL_TAG_LEN];      // Empty between passes
+};
+
+static_assert(sizeof(StallRecord) % 4 == 0, "RTC memory is written in 4-byte blocks");
+static_assert(sizeof(StallArea) % 4 == 0, "RTC memory is written in 4-byte blocks");
+static_assert(sizeof(StallOpen) % 4 == 0, "RTC memory is written in 4-byte blocks");
+// 12: the staging header in offline_staging.cpp
+static_assert(STALL_RTC_BLOCK_OFFSET * 4 >= STAGING_RTC_BLOCK_OFFSET * 4 + 12 + STAGING_CAPACITY * sizeof(OfflineRecord),
+              "Stall area overlaps the offline staging area");
+static_assert(STALL_RTC_BLOCK_OFFSET * 4 + sizeof(StallArea) + sizeof(StallOpen) <= 512,
+              "Stall area exceeds RTC user memory");
+
+#define AREA_BLOCK STALL_RTC_BLOCK_OFFSET
+#define OPEN_BLOCK (STALL_RTC_BLOCK_OFFSET + sizeof(StallArea) / 4)
+#define OPEN_TAG_BLOCK (OPEN_BLOCK + 1)
+
+struct StallFrame {
+  const char* tag;
+  StallKind kind;
+  uint32_t startMicros;
+  uint32_t selfMicros;
+};
+
+struct StallTotals {
+  uint32_t passes;
+  uint32_t stalls;              // Passes of STALL_THRESHOLD_MS or more
+  uint32_t maxPassMicros;
+  uint32_t delayCalls;
+  uint64_t delayMicros;
+  uint32_t netCalls;
+  uint64_t netMicros;
+  uint32_t scopeOverflows;      // Scopes nested deeper than STALL_MAX_DEPTH, not tagged
+};
+
+static StallArea area;
+static StallOpen openPass;
+static StallFrame frames[STALL_MAX_DEPTH];
+static uint8_t depth = 0;
+static uint8_t netDepth = 0;
+static StallTotals totals;
+static bool begun = false;
+static bool inPass = false;
+static bool areaDirty = false;
+static unsigned long lastPersist = 0;
+
+// The pass in progress
+static uint32_t passStartMicros = 0;
+static uint32_t passStartMillis = 0;
+static uint32_t lastMark = 0;
+static uint32_t rootSelfMicros = 0;
+static uint32_t passDelayMicros = 0;
+static uint32_t passNetMicros = 0;
+static const char* worstTag = "loop";
+static uint32_t worstSelfMicros = 0;
+
+// ========================================
+// RTC MEMORY
+// ========================================
+
+static uint32_t areaCrc() {
+  return crc32(area.buckets, sizeof(area) - offsetof(StallArea, buckets));
+}
+
+static void persistArea() {
+  area.magic = STALL_MAGIC;
+  area.crc = areaCrc();
+  ESP.rtcUserMemoryWrite(AREA_BLOCK, (uint32_t*)&area, sizeof(area));
+  areaDirty = false;
+  lastPersist = millis();
+}
+
+static void copyTag(char* dest, const char* tag) {
+  strncpy(dest, tag, STALL_TAG_LEN - 1);
+  dest[STALL_TAG_LEN - 1] = '\0';
+}
+
+// Only the tag words change within a pass
+static void writeOpenTag(const char* tag) {
+  if (!begun) {
+    return;
+  }
+  copyTag(openPass.tag, tag);
+  ESP.rtcUserMemoryWrite(OPEN_TAG_BLOCK, (uint32_t*)openPass.tag, sizeof(openPass.tag));
+}
+
+static void writeOpen(uint32_t sinceMs, const char* tag) {
+  openPass.sinceMs = sinceMs;
+  copyTag(openPass.tag, tag);
+  ESP.rtcUserMemoryWrite(OPEN_BLOCK, (uint32_t*)&openPass, sizeof(openPass));
+}
+
+// ========================================
+// TOP STALLS
+// ========================================
+
+// Replaces the shortest kept stall if this one is longer
+static void recordStall(uint32_t ms, uint32_t atSec, uint32_t delayMs, uint32_t netMs,
+                        const char* tag, uint8_t flags) {
+  uint8_t slot = 0;
+  for (uint8_t i = 1; i < STALL_TOP_COUNT; i++) {
+    if (area.top[i].ms < area.top[slot].ms) {
+      slot = i;
+    }
+  }
+  if (area.top[slot].ms >= ms) {
+    return;
+  }
+  StallRecord& record = area.top[slot];
+  record.ms = ms;
+  record.atSec = atSec;
+  record.delayMs = delayMs > 0xFFFF ? 0xFFFF : delayMs;
+  record.netMs = netMs > 0xFFFF ? 0xFFFF : netMs;
+  record.boot = area.boots;
+  record.flags = flags;
+  record.reserved = 0;
+  copyTag(record.tag, tag);
+  persistArea();
+}
+
+// ========================================
+// SETUP
+// ========================================
+
+void stallProfilerBegin() {
+  bool valid = ESP.rtcUserMemoryRead(AREA_BLOCK, (uint32_t*)&area, sizeof(area)) &&
+               area.magic == STALL_MAGIC && area.crc == areaCrc();
+  if (!valid) {
+    memset(&area, 0, sizeof(area));
+  }
+  area.boots++;
+
+  // A pass that was still open when a watchdog reset the chip
+  if (valid && ESP.rtcUserMemoryRead(OPEN_BLOCK, (uint32_t*)&openPass, sizeof(openPass)) &&
+      openPass.tag[0] != '\0' && memchr(openPass.tag, '\0', sizeof(openPass.tag)) != nullptr) {
+    uint32_t reason = ESP.getResetInfoPtr()->reason;
+    if (reason == REASON_WDT_RST || reason == REASON_SOFT_WDT_RST) {
+      recordStall(STALL_SOFT_WDT_MS, openPass.sinceMs / 1000, 0, 0, openPass.tag, STALL_FLAG_RESET);
+    }
+  }
+
+  writeOpen(0, "");
+  persistArea();
+  begun = true;
+}
+
+// ========================================
+// PASSES AND SCOPES
+// ========================================
+
+// Charges the time since the last mark to the innermost scope
+static void charge(uint32_t now) {
+  if (depth > 0) {
+    frames[depth - 1].selfMicros += now - lastMark;
+  } else {
+    rootSelfMicros += now - lastMark;
+  }
+  lastMark = now;
+}
+
+void stallLoopStart() {
+  uint32_t now = micros();
+  inPass = true;
+  passStartMicros = now;
+  passStartMillis = millis();
+  lastMark = now;
+  rootSelfMicros = 0;
+  passDelayMicros = 0;
+  passNetMicros = 0;
+  worstTag = "loop";
+  worstSelfMicros = 0;
+  if (begun) {
+    writeOpen(passStartMillis, "loop");
+  }
+}
+
+void stallLoopEnd() {
+  uint32_t now = micros();
+  charge(now);
+  if (rootSelfMicros > worstSelfMicros) {
+    worstTag = "loop";
+  }
+  inPass = false;
+
+  uint32_t passMicros = now - passStartMicros;
+  uint32_t passMs = passMicros / 1000;
+  totals.passes++;
+  if (passMicros > totals.maxPassMicros) {
+    totals.maxPassMicros = passMicros;
+  }
+  uint8_t bucket = 0;
+  while (bucket < STALL_BUCKET_COUNT - 1 && passMs > STALL_BUCKETS_MS[bucket]) {
+    bucket++;
+  }
+  area.buckets[bucket]++;
+  areaDirty = true;
+
+  if (passMs >= STALL_THRESHOLD_MS) {
+    totals.stalls++;
+    recordStall(passMs, passStartMillis / 1000, passDelayMicros / 1000, passNetMicros / 1000, worstTag, 0);
+  }
+
+  if (begun) {
+    writeOpenTag("");
+    if (areaDirty && millis() - lastPersist >= STALL_PERSIST_MS) {
+      persistArea();
+    }
+  }
+}
+
+StallScope::StallScope(const char* tag, StallKind kind) : pushed(false) {
+  if (depth >= STALL_MAX_DEPTH) {
+    totals.scopeOverflows++;
+    return;
+  }
+  uint32_t now = micros();
+  charge(now);
+  frames[depth++] = { tag, kind, now, 0 };
+  if (kind == STALL_NET) {
+    netDepth++;
+  }
+  pushed = true;
+  if (inPass) {
+    writeOpenTag(tag);
+  }
+}
+
+StallScope::~StallScope() {
+  if (!pushed) {
+    return;
+  }
+  uint32_t now = micros();
+  charge(now);
+  StallFrame& frame = frames[--depth];
+  if (frame.kind == STALL_NET && --netDepth == 0) {
+    uint32_t elapsed = now - frame.startMicros;
+    totals.netCalls++;
+    totals.netMicros += elapsed;
+    passNetMicros += elapsed;
+  }
+  if (inPass) {
+    if (frame.selfMicros > worstSelfMicros) {
+      worstSelfMicros = frame.selfMicros;
+      worstTag = frame.tag;
+    }
+    writeOpenTag(depth > 0 ? frames[depth - 1].tag : "loop");
+  }
+}
+
+// ========================================
+// DELAY
+// ========================================
+
+// The core's delay() is a weak alias of __delay(); this one replaces it.
+// The scheduler's sleep between passes is idle time, and a delay() inside
+// a network scope is already counted as network time.
+extern "C" void __delay(unsigned long ms);
+
+void delay(unsigned long ms) {
+  bool idle = begun && !inPass && totals.passes > 0;
+  if (ms == 0 || idle || netDepth > 0) {
+    __delay(ms);
+    return;
+  }
+  uint32_t start = micros();
+  __delay(ms);
+  uint32_t elapsed = micros() - start;
+  totals.delayCalls++;
+  totals.delayMicros += elapsed;
+  if (inPass) {
+    passDelayMicros += elapsed;
+  }
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+void stallProfilerToJson(JsonObject out) {
+  out["boots"] = area.boots;
+  out["passes"] = totals.passes;
+  out["stalls"] = totals.stalls;
+  out["thresholdMs"] = STALL_THRESHOLD_MS;
+  out["maxPassMicros"] = totals.maxPassMicros;
+  out["delayCalls"] = totals.delayCalls;
+  out["delayMs"] = (uint32_t)(totals.delayMicros / 1000);
+  out["netCalls"] = totals.netCalls;
+  out["netMs"] = (uint32_t)(totals.netMicros / 1000);
+  out["scopeOverflows"] = totals.scopeOverflows;
+
+  // Pass lengths since the RTC area was created, keyed by upper bound
+  JsonObject histogram = out.createNestedObject("histogramMs");
+  for (uint8_t i = 0; i < STALL_BUCKET_COUNT; i++) {
+    if (i < STALL_BUCKET_COUNT - 1) {
+      histogram[String(STALL_BUCKETS_MS[i])] = area.buckets[i];
+    } else {
+      histogram["+Inf"] = area.buckets[i];
+    }
+  }
+
+  // Longest first
+  bool listed[STALL_TOP_COUNT] = { false };
+  JsonArray top = out.createNestedArray("top");
+  for (uint8_t n = 0; n < STALL_TOP_COUNT; n++) {
+    int8_t best = -1;
+    for (uint8_t i = 0; i < STALL_TOP_COUNT; i++) {
+      if (!listed[i] && area.top[i].ms > 0 && (best < 0 || area.top[i].ms > area.top[best].ms)) {
+        best = i;
+      }
+    }
+    if (best < 0) {
+      break;
+    }
+    listed[best] = true;
+    const StallRecord& record = area.top[best];
+    JsonObject entry = top.createNestedObject();
+    entry["ms"] = record.ms;
+    entry["tag"] = record.tag;
+    entry["delayMs"] = record.delayMs;
+    entry["netMs"] = record.netMs;
+    entry["atSec"] = record.atSec;
+    entry["bootsAgo"] = (uint16_t)(area.boots - record.boot);
+    if (record.flags & STALL_FLAG_RESET) {
+      entry["reset"] = true;
+    }
+  }
+}
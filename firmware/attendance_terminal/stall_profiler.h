@@ -0,0 +1,57 @@
+/*
+ * Loop stall profiler for Attendee Attendance Terminal v2.0
+ *
+ * Times every loop() pass from stallLoopStart() to stallLoopEnd(), which
+ * is the part that runs tasks; the scheduler's sleep is not counted.
+ * Passes go into a histogram. The STALL_TOP_COUNT longest passes are
+ * kept, each with the subsystem tag that held the loop longest.
+ *
+ * Tags come from StallScope objects. The scheduler opens one per task,
+ * named after the task. Known blocking calls open their own inside it:
+ * HTTP requests, connects and WiFi waits. Those scopes are STALL_NET,
+ * and time spent in them is counted as blocking network time. The sketch
+ * replaces the core's weak delay(), so time in delay() outside a network
+ * scope is counted as well.
+ *
+ * The histogram and the top stalls are kept in RTC user memory, after
+ * the offline staging area. They survive soft and watchdog resets, but
+ * not power loss. The innermost open tag is also written there. After a
+ * watchdog or exception reset, the pass that never finished becomes a
+ * stall marked "reset", under the tag it died in.
+ */
+
+#ifndef STALL_PROFILER_H
+#define STALL_PROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define STALL_RTC_BLOCK_OFFSET 85       // Right after the offline staging area (offline_staging.h)
+#define STALL_TAG_LEN 12                // Including the terminator; longer tags are cut
+
+enum StallKind : uint8_t {
+  STALL_CPU = 0,
+  STALL_NET                     // A blocking network call
+};
+
+// Setup hook, before anything that may block
+void stallProfilerBegin();
+
+// Loop hooks around the task runs
+void stallLoopStart();
+void stallLoopEnd();
+
+// Tags the enclosing block. Nests up to STALL_MAX_DEPTH deep.
+class StallScope {
+public:
+  StallScope(const char* tag, StallKind kind = STALL_CPU);
+  ~StallScope();
+
+private:
+  bool pushed;                  // False past STALL_MAX_DEPTH
+};
+
+// Status: histogram, top stalls, delay() and network totals
+void stallProfilerToJson(JsonObject out);
+
+#endif // STALL_PROFILER_H
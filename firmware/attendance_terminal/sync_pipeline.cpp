@@ -0,0 +1,280 @@
+/*
+ * Pipelined attendance submission for Attendee Attendance Terminal v2.0
+ *
+ * Node's HTTP server (Express) answers pipelined requests in order. If the
+ * connection drops or times out part way, the caller only learns the
+ * outcomes read so far and asks the backend for its high-water mark to
+ * find out which of the rest landed.
+ */
+
+#include <ESP8266HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include <ArduinoJson.h>
+#include "config.h"
+#include "utils.h"
+#include "debug_log.h"
+#include "json_arena.h"
+#include "memory_governor.h"
+#include "sync_pipeline.h"
+#include "circuit_breaker.h"
+#include "metrics.h"
+#include "stall_profiler.h"
+
+// External references from main file
+extern WiFiClient wifiClient;
+extern WiFiClientSecure wifiClientSecure;
+extern HTTPClient http;
+extern String deviceId;
+extern String deviceKey;
+
+// Function declarations from main file
+extern String getAttendanceEndpointUrl();
+
+// ========================================
+// URL AND CONNECTION
+// ========================================
+
+struct EndpointParts {
+  bool https;
+  String host;
+  uint16_t port;
+  String path;
+};
+
+static bool parseEndpoint(const String& url, EndpointParts& parts) {
+  int schemeEnd = url.indexOf("://");
+  if (schemeEnd < 0) {
+    return false;
+  }
+  parts.https = url.startsWith("https");
+  int hostStart = schemeEnd + 3;
+  int pathStart = url.indexOf('/', hostStart);
+  String authority = pathStart < 0 ? url.substring(hostStart) : url.substring(hostStart, pathStart);
+  parts.path = pathStart < 0 ? "/" : url.substring(pathStart);
+
+  int colon = authority.indexOf(':');
+  if (colon >= 0) {
+    parts.host = authority.substring(0, colon);
+    parts.port = authority.substring(colon + 1).toInt();
+  } else {
+    parts.host = authority;
+    parts.port = parts.https ? 443 : 80;
+  }
+  return parts.host.length() > 0 && parts.port > 0;
+}
+
+static WiFiClient& endpointClient(const EndpointParts& parts) {
+  WiFiClient& client = parts.https ? (WiFiClient&)wifiClientSecure : wifiClient;
+  if (parts.https) {
+    wifiClientSecure.setInsecure();
+    memConfigureTls(wifiClientSecure);
+  }
+  client.setTimeout(breakerTimeoutMs()); // Derived from observed backend RTT
+  return client;
+}
+
+// ========================================
+// RESPONSE PARSING
+// ========================================
+
+static bool readResponse(WiFiClient& client, PipelineResponse& response, bool& connectionClose) {
+  String statusLine = client.readStringUntil('\n');
+  if (!statusLine.startsWith("HTTP/1.")) {
+    return false; // Timeout or connection closed
+  }
+  response.code = statusLine.substring(9, 12).toInt();
+  response.duplicate = false;
+  response.highWater = -1;
+
+  int contentLength = -1;
+  while (true) {
+    String header = client.readStringUntil('\n');
+    header.trim();
+    if (header.length() == 0) {
+      break;
+    }
+    header.toLowerCase();
+    if (header.startsWith("content-length:")) {
+      contentLength = header.substring(15).toInt();
+    } else if (header.startsWith("connection:") && header.indexOf("close") > 0) {
+      connectionClose = true;
+    } else if (header.startsWith("transfer-encoding:")) {
+      return false; // Backend always sends Content-Length for JSON
+    }
+  }
+  if (contentLength < 0) {
+    return false;
+  }
+
+  // Keep the start of the body for parsing, drain the rest
+  ArenaScope arena("sync-reply");
+  ArenaBuffer body(PIPELINE_BODY_MAX + 1);
+  int wanted = min(contentLength, (int)body.capacity() - 1);
+  if (wanted < 0) {
+    return false;
+  }
+  size_t kept = client.readBytes(body.data(), wanted);
+  body.data()[kept] = '\0';
+  if ((int)kept < wanted) {
+    return false;
+  }
+  char sink[64];
+  for (int remaining = contentLength - kept; remaining > 0;) {
+    size_t drained = client.readBytes(sink, min(remaining, (int)sizeof(sink)));
+    if (drained == 0) {
+      return false;
+    }
+    remaining -= drained;
+  }
+
+  ArenaJsonDocument doc(384);
+  if (!deserializeJson(doc, body.data(), kept)) {
+    response.duplicate = doc["duplicate"] | false;
+    response.highWater = doc["highWater"] | -1;
+  }
+  return true;
+}
+
+// ========================================
+// PIPELINED POST
+// ========================================
+
+static int exchange(WiFiClient& client, const EndpointParts& parts, const String* bodies, int count,
+                    uint32_t seqFloor, PipelineResponse* responses, unsigned long start) {
+  StallScope net("sync-post", STALL_NET);
+  if (!client.connected() && !client.connect(parts.host.c_str(), parts.port)) {
+    return 0;
+  }
+
+  // Each request is assembled in the arena and written in one piece
+  ArenaScope arena("sync-post");
+  for (int i = 0; i < count; i++) {
+    static const char HEAD_FORMAT[] = "POST %s HTTP/1.1\r\n"
+                                      "Host: %s\r\n"
+                                      "User-Agent: ESP8266-Attendance-Terminal/2.0\r\n"
+                                      "Content-Type: application/json\r\n"
+                                      "Connection: keep-alive\r\n"
+                                      "X-Device-Key: %s\r\n"
+                                      "X-Seq-Floor: %lu\r\n"
+                                      "Content-Length: %u\r\n\r\n";
+    size_t bodyLength = bodies[i].length();
+    int headLength = snprintf(nullptr, 0, HEAD_FORMAT, parts.path.c_str(), parts.host.c_str(),
+                              deviceKey.c_str(), (unsigned long)seqFloor, (unsigned)bodyLength);
+    ArenaBuffer request(headLength + bodyLength + 1);
+    if (request.capacity() == 0) {
+      break;
+    }
+    snprintf(request.data(), headLength + 1, HEAD_FORMAT, parts.path.c_str(), parts.host.c_str(),
+             deviceKey.c_str(), (unsigned long)seqFloor, (unsigned)bodyLength);
+    memcpy(request.data() + headLength, bodies[i].c_str(), bodyLength);
+    size_t total = headLength + bodyLength;
+    if (client.write((const uint8_t*)request.data(), total) != total) {
+      break;
+    }
+  }
+
+  int answered = 0;
+  bool connectionClose = false;
+  while (answered < count && !connectionClose) {
+    if (!readResponse(client, responses[answered], connectionClose)) {
+      break;
+    }
+    unsigned long latency = millis() - start;
+    int code = responses[answered].code;
+    metricsObserveHttp(METRIC_HTTP_SYNC, latency, code);
+    if (code >= 500) {
+      breakerRecordFailure();
+    } else {
+      breakerRecordSuccess(latency);
+    }
+    answered++;
+  }
+
+  if (connectionClose) {
+    client.stop();
+  }
+  return answered;
+}
+
+int postPipelined(const String* bodies, int count, uint32_t seqFloor, PipelineResponse* responses) {
+  EndpointParts parts;
+  if (count <= 0 || !parseEndpoint(getAttendanceEndpointUrl(), parts)) {
+    return 0;
+  }
+
+  WiFiClient& client = endpointClient(parts);
+  unsigned long start = millis();
+
+  // A keep-alive connection to the previous backend is no use after a failover
+  static String connectedTo;
+  String authority = parts.host + ":" + String(parts.port);
+  if (authority != connectedTo) {
+    client.stop();
+    connectedTo = authority;
+  }
+
+  // The keep-alive connection from the previous slice is reused; if the
+  // backend has since closed it, nothing comes back and one fresh
+  // connection is tried
+  bool reused = client.connected();
+  int answered = exchange(client, parts, bodies, count, seqFloor, responses, start);
+  if (answered == 0 && reused) {
+    client.stop();
+    answered = exchange(client, parts, bodies, count, seqFloor, responses, start);
+  }
+
+  if (answered < count) {
+    client.stop();
+    if (answered == 0) {
+      metricsObserveHttp(METRIC_HTTP_SYNC, millis() - start, 0);
+    }
+    breakerRecordFailure();
+    LOG_DEBUG("Pipelined sync got %d/%d responses", answered, count);
+  }
+  return answered;
+}
+
+// ========================================
+// HIGH-WATER MARK
+// ========================================
+
+bool fetchSyncWatermark(uint32_t seqFloor, uint32_t& highWater, uint32_t* lastSeq) {
+  String url = getAttendanceEndpointUrl() + "/device/" + deviceId + "/watermark?floor=" + String(seqFloor);
+  if (url.startsWith("https://")) {
+    wifiClientSecure.setInsecure();
+    memConfigureTls(wifiClientSecure);
+    http.begin(wifiClientSecure, url);
+  } else {
+    http.begin(wifiClient, url);
+  }
+  http.addHeader("X-Device-Key", deviceKey);
+  http.setTimeout(breakerTimeoutMs());
+
+  unsigned long requestStartTime = millis();
+  int httpResponseCode;
+  {
+    StallScope net("sync-get", STALL_NET);
+    httpResponseCode = http.GET();
+  }
+  metricsObserveHttp(METRIC_HTTP_SYNC, millis() - requestStartTime, httpResponseCode);
+  if (httpResponseCode <= 0 || httpResponseCode >= 500) {
+    breakerRecordFailure();
+  } else {
+    breakerRecordSuccess(millis() - requestStartTime);
+  }
+
+  bool ok = false;
+  if (httpResponseCode == 200) {
+    ArenaScope arena("sync-mark");
+    ArenaJsonDocument doc(128);
+    if (!deserializeJson(doc, http.getString()) && doc.containsKey("highWater")) {
+      highWater = doc["highWater"];
+      if (lastSeq) {
+        *lastSeq = doc["lastSeq"] | highWater;
+      }
+      ok = true;
+    }
+  }
+  http.end();
+  return ok;
+}
@@ -0,0 +1,32 @@
+/*
+ * Pipelined attendance submission for the offline sync job
+ * Attendee Attendance Terminal v2.0
+ *
+ * Writes several POST /attendance requests back to back on one keep-alive
+ * connection (HTTP/1.1 pipelining) and then reads the responses in order,
+ * so a slice of records costs one round trip instead of one per record.
+ * HTTPClient cannot do this, so requests and responses are handled on the
+ * raw WiFiClient / WiFiClientSecure.
+ */
+
+#ifndef SYNC_PIPELINE_H
+#define SYNC_PIPELINE_H
+
+#include <Arduino.h>
+
+#define PIPELINE_BODY_MAX 512           // Response body bytes kept for parsing
+
+struct PipelineResponse {
+  int code;                     // HTTP status
+  bool duplicate;               // Backend had already processed this seq
+  int32_t highWater;            // Backend high-water mark, -1 if not reported
+};
+
+// Returns how many responses were read; the rest have unknown outcome
+int postPipelined(const String* bodies, int count, uint32_t seqFloor, PipelineResponse* responses);
+
+// GET the backend high-water mark for this device, and optionally the
+// highest seq the backend has seen from it
+bool fetchSyncWatermark(uint32_t seqFloor, uint32_t& highWater, uint32_t* lastSeq = nullptr);
+
+#endif // SYNC_PIPELINE_H
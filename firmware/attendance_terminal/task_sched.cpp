@@ -0,0 +1,319 @@
+/*
+ * Cooperative task scheduler - Attendee Attendance Terminal v2.0
+ *
+ * The wheel counts ticks rather than reading millis() directly, so the
+ * millis() wrap needs no special case. A slot holds a singly linked list
+ * of task indices. Level 0 is indexed by the due tick. Level 1 is indexed
+ * by the due tick / 64, level 2 by / 4096. When level 0 wraps, the level 1
+ * slot for the next 64 ticks is cascaded down; level 2 likewise every
+ * 4096 ticks. A task further out than level 2 reaches is parked in its
+ * last slot and re-placed when that slot cascades.
+ *
+ * A task that is due is taken off the wheel and flagged. It is armed
+ * again after it runs.
+ */
+
+#include "config.h"
+#include "task_sched.h"
+#include "stall_profiler.h"
+
+#define SCHED_WHEEL_LEVELS 3
+#define SCHED_WHEEL_BITS 6
+#define SCHED_WHEEL_SLOTS (1 << SCHED_WHEEL_BITS)
+#define SCHED_WHEEL_MASK (SCHED_WHEEL_SLOTS - 1)
+
+struct SchedTask {
+  const char* name;
+  SchedFn fn;
+  uint32_t periodTicks;         // 0: event-only
+  uint32_t deadlineMs;
+  TaskPriority priority;
+  uint32_t dueTick;
+  int8_t next;                  // Next task in the same wheel slot
+  bool due;                     // Off the wheel, waiting to run
+
+  uint32_t runs;
+  uint32_t wakes;               // Runs from schedWake()/schedSignal()
+  uint32_t lateRuns;            // Started more than deadlineMs after falling due
+  uint32_t skipped;             // Periods missed while running late
+  uint32_t maxLateMs;
+  uint32_t maxMicros;
+  uint64_t totalMicros;
+};
+
+static SchedTask tasks[SCHED_MAX_TASKS];
+static uint8_t taskCount = 0;
+static int8_t wheel[SCHED_WHEEL_LEVELS][SCHED_WHEEL_SLOTS];
+static bool wheelReady = false;
+static uint32_t currentTick = 0;
+static unsigned long tickMillis = 0;    // millis() at the start of currentTick
+static unsigned long startMillis = 0;
+static volatile uint32_t signalled = 0; // Task bits set by schedWake()/schedSignal()
+static uint32_t passes = 0;
+static uint64_t idleMicros = 0;
+
+static void wheelBegin() {
+  memset(wheel, -1, sizeof(wheel));
+  tickMillis = millis();
+  startMillis = tickMillis;
+  wheelReady = true;
+}
+
+// ========================================
+// WHEEL
+// ========================================
+
+static void wheelInsert(uint8_t index) {
+  SchedTask& task = tasks[index];
+  int32_t delta = (int32_t)(task.dueTick - currentTick);
+  if (delta <= 0) {
+    task.due = true;
+    return;
+  }
+
+  uint8_t level;
+  uint32_t slot;
+  uint32_t block1 = (task.dueTick >> SCHED_WHEEL_BITS) - (currentTick >> SCHED_WHEEL_BITS);
+  if (delta < SCHED_WHEEL_SLOTS) {
+    level = 0;
+    slot = task.dueTick;
+  } else if (block1 < SCHED_WHEEL_SLOTS) {
+    level = 1;
+    slot = task.dueTick >> SCHED_WHEEL_BITS;
+  } else {
+    uint32_t current2 = currentTick >> (2 * SCHED_WHEEL_BITS);
+    uint32_t block2 = (task.dueTick >> (2 * SCHED_WHEEL_BITS)) - current2;
+    level = 2;
+    slot = current2 + (block2 < SCHED_WHEEL_SLOTS ? block2 : SCHED_WHEEL_SLOTS - 1);
+  }
+  slot &= SCHED_WHEEL_MASK;
+  task.next = wheel[level][slot];
+  wheel[level][slot] = index;
+}
+
+// Re-place every task in a slot; those now due get flagged
+static void wheelCascade(uint8_t level, uint32_t slot) {
+  int8_t index = wheel[level][slot];
+  wheel[level][slot] = -1;
+  while (index >= 0) {
+    int8_t next = tasks[index].next;
+    wheelInsert(index);
+    index = next;
+  }
+}
+
+static void wheelAdvance() {
+  unsigned long now = millis();
+  while (now - tickMillis >= SCHED_TICK_MS) {
+    tickMillis += SCHED_TICK_MS;
+    currentTick++;
+    if ((currentTick & SCHED_WHEEL_MASK) == 0) {
+      if (((currentTick >> SCHED_WHEEL_BITS) & SCHED_WHEEL_MASK) == 0) {
+        wheelCascade(2, (currentTick >> (2 * SCHED_WHEEL_BITS)) & SCHED_WHEEL_MASK);
+      }
+      wheelCascade(1, (currentTick >> SCHED_WHEEL_BITS) & SCHED_WHEEL_MASK);
+    }
+    wheelCascade(0, currentTick & SCHED_WHEEL_MASK);
+  }
+}
+
+// ========================================
+// REGISTRATION AND WAKE-UPS
+// ========================================
+
+SchedTaskId schedAdd(const char* name, SchedFn fn, uint32_t periodMs,
+                     TaskPriority priority, uint32_t deadlineMs) {
+  if (taskCount >= SCHED_MAX_TASKS || !fn) {
+    return -1;
+  }
+  if (!wheelReady) {
+    wheelBegin();
+  }
+  SchedTask& task = tasks[taskCount];
+  memset(&task, 0, sizeof(task));
+  task.name = name;
+  task.fn = fn;
+  task.periodTicks = periodMs == 0 ? 0 : (periodMs + SCHED_TICK_MS - 1) / SCHED_TICK_MS;
+  task.deadlineMs = deadlineMs != 0 ? deadlineMs : periodMs;
+  task.priority = priority;
+  task.next = -1;
+  if (task.periodTicks > 0) {
+    task.dueTick = currentTick;
+    task.due = true;
+  }
+  return taskCount++;
+}
+
+void schedWake(SchedTaskId id) {
+  if (id < 0 || id >= taskCount) {
+    return;
+  }
+  noInterrupts();
+  signalled |= 1UL << id;
+  interrupts();
+}
+
+void IRAM_ATTR schedSignal(SchedTaskId id) {
+  if (id >= 0 && id < SCHED_MAX_TASKS) {
+    signalled |= 1UL << id;
+  }
+}
+
+// ========================================
+// RUNNING
+// ========================================
+
+// Highest-priority task that is due or signalled and has not run this pass
+static int8_t nextReady(uint32_t wakes, uint32_t ran) {
+  int8_t best = -1;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    bool ready = tasks[i].due || (wakes & (1UL << i));
+    if (ready && !(ran & (1UL << i)) &&
+        (best < 0 || tasks[i].priority < tasks[best].priority)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+static void runTask(uint8_t index, bool fromWheel) {
+  SchedTask& task = tasks[index];
+  if (fromWheel) {
+    uint32_t lateMs = (currentTick - task.dueTick) * SCHED_TICK_MS + (millis() - tickMillis);
+    if (lateMs > task.deadlineMs) {
+      task.lateRuns++;
+    }
+    if (lateMs > task.maxLateMs) {
+      task.maxLateMs = lateMs;
+    }
+  } else {
+    task.wakes++;
+  }
+
+  unsigned long start = micros();
+  {
+    StallScope scope(task.name);
+    task.fn();
+  }
+  uint32_t elapsed = micros() - start;
+  task.runs++;
+  task.totalMicros += elapsed;
+  if (elapsed > task.maxMicros) {
+    task.maxMicros = elapsed;
+  }
+
+  if (fromWheel) {
+    task.due = false;
+    task.dueTick += task.periodTicks;
+    wheelAdvance();
+    if ((int32_t)(task.dueTick - currentTick) <= 0) {
+      uint32_t behind = currentTick - task.dueTick;
+      task.skipped += behind / task.periodTicks + 1;
+      task.dueTick = currentTick + task.periodTicks;
+    }
+    wheelInsert(index);
+  }
+}
+
+void schedRunDue() {
+  if (!wheelReady) {
+    return;
+  }
+  passes++;
+  uint32_t ran = 0;
+  while (true) {
+    wheelAdvance();
+    noInterrupts();
+    uint32_t wakes = signalled;
+    interrupts();
+
+    int8_t index = nextReady(wakes, ran);
+    if (index < 0) {
+      return;
+    }
+    noInterrupts();
+    signalled &= ~(1UL << index);
+    interrupts();
+    ran |= 1UL << index;
+    runTask(index, tasks[index].due);
+  }
+}
+
+uint32_t schedMsUntilNext() {
+  if (!wheelReady) {
+    return 0;
+  }
+  wheelAdvance();
+  if (signalled) {
+    return 0;
+  }
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (tasks[i].due) {
+      return 0;
+    }
+  }
+
+  // The nearest occupied level 0 slot, or the next cascade if that is sooner
+  uint32_t ticks = SCHED_WHEEL_SLOTS - (currentTick & SCHED_WHEEL_MASK);
+  for (uint32_t k = 1; k < ticks; k++) {
+    if (wheel[0][(currentTick + k) & SCHED_WHEEL_MASK] >= 0) {
+      ticks = k;
+      break;
+    }
+  }
+  uint32_t ms = ticks * SCHED_TICK_MS;
+  uint32_t into = millis() - tickMillis;
+  return ms > into ? ms - into : 0;
+}
+
+// delay(1) steps keep the WiFi stack running and notice a signal within 1 ms
+void schedSleep() {
+  uint32_t ms = schedMsUntilNext();
+  if (ms == 0) {
+    return;
+  }
+  unsigned long start = micros();
+  while (ms-- > 0 && !signalled) {
+    delay(1);
+  }
+  idleMicros += micros() - start;
+}
+
+// ========================================
+// STATUS
+// ========================================
+
+static const char* priorityName(TaskPriority priority) {
+  switch (priority) {
+    case TASK_PRIO_HIGH: return "high";
+    case TASK_PRIO_NORMAL: return "normal";
+    default: return "low";
+  }
+}
+
+void schedToJson(JsonObject out) {
+  uint64_t spanMicros = (uint64_t)(millis() - startMillis) * 1000;
+  if (spanMicros == 0) {
+    spanMicros = 1;
+  }
+  out["tickMs"] = SCHED_TICK_MS;
+  out["passes"] = passes;
+  out["idlePct"] = (uint32_t)(idleMicros * 1000 / spanMicros) / 10.0;
+
+  JsonArray list = out.createNestedArray("tasks");
+  for (uint8_t i = 0; i < taskCount; i++) {
+    const SchedTask& task = tasks[i];
+    JsonObject entry = list.createNestedObject();
+    entry["name"] = task.name;
+    entry["priority"] = priorityName(task.priority);
+    entry["periodMs"] = task.periodTicks * SCHED_TICK_MS;
+    entry["runs"] = task.runs;
+    entry["wakes"] = task.wakes;
+    entry["cpuPct"] = (uint32_t)(task.totalMicros * 10000 / spanMicros) / 100.0;
+    entry["avgMicros"] = task.runs > 0 ? (uint32_t)(task.totalMicros / task.runs) : 0;
+    entry["maxMicros"] = task.maxMicros;
+    entry["late"] = task.lateRuns;
+    entry["skipped"] = task.skipped;
+    entry["maxLateMs"] = task.maxLateMs;
+  }
+}
@@ -0,0 +1,60 @@
+/*
+ * Cooperative task scheduler for Attendee Attendance Terminal v2.0
+ *
+ * Every periodic job in the sketch is a task. A task has a name, a
+ * function, a period, a priority and a deadline. loop() asks the
+ * scheduler to run whatever is due. Then it sleeps until the next task
+ * falls due or an interrupt signals one. There is no fixed loop delay.
+ *
+ * Due times sit on a hierarchical timer wheel of SCHED_TICK_MS ticks.
+ * There are three levels of 64 slots each, covering 320 ms, 20 s and
+ * 22 min. Arming a task and finding the next deadline both take time
+ * independent of the number of tasks.
+ *
+ * When several tasks are due, higher priorities run first. After each
+ * task the wheel is checked again, so a HIGH task that fell due meanwhile
+ * runs before the next NORMAL one. Each task still runs at most once per
+ * schedRunDue() call. That call always returns, so the WiFi stack is
+ * never starved. A task that falls behind skips the periods it missed
+ * rather than running once for each.
+ *
+ * Each task is charged the time it runs. A run that starts later than
+ * its deadline after falling due counts as late. The deadline defaults
+ * to the period. /api/status shows the table.
+ */
+
+#ifndef TASK_SCHED_H
+#define TASK_SCHED_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+enum TaskPriority : uint8_t {
+  TASK_PRIO_HIGH = 0,           // Card reads and display feedback
+  TASK_PRIO_NORMAL,
+  TASK_PRIO_LOW,                // Housekeeping that may wait behind the others
+  TASK_PRIO_COUNT
+};
+
+typedef void (*SchedFn)();
+typedef int8_t SchedTaskId;     // -1: not registered
+
+// Register a task. Its first run is on the next schedRunDue(). Period 0
+// registers an event-only task, which runs only when woken or signalled.
+// The deadline is counted from the due time; 0 means the period.
+SchedTaskId schedAdd(const char* name, SchedFn fn, uint32_t periodMs,
+                     TaskPriority priority, uint32_t deadlineMs = 0);
+
+// Run a task on the next pass, outside its period. The loop-context and ISR forms
+void schedWake(SchedTaskId id);
+void schedSignal(SchedTaskId id);
+
+// Loop hooks
+void schedRunDue();
+void schedSleep();
+uint32_t schedMsUntilNext();
+
+// Status: per-task run counts, CPU share, worst run time and lateness
+void schedToJson(JsonObject out);
+
+#endif // TASK_SCHED_H
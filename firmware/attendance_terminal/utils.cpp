@@ -8,7 +8,6 @@
 #include <WiFiClient.h>
 #include <ArduinoJson.h>
 #include <Wire.h>
-#include <LiquidCrystal_I2C.h>
 #include <RTClib.h>
 #include <EEPROM.h>          // DEPRECATED: No longer used, kept for migration compatibility
 #include <LittleFS.h>
@@ -19,20 +18,36 @@
 #include <MFRC522Debug.h>
 #include "config.h"
 #include "utils.h"
+#include "debug_log.h"
+#include "json_arena.h"
+#include "backend_pool.h"
+#include "offline_sync.h"
+#include "metrics.h"
+#include "soft_clock.h"
+#include "offline_staging.h"
+#include "offline_store.h"
+#include "rfid_spi.h"
+#include "rfid_gain.h"
+#include "rfid_lanes.h"
 
 // External references from main file
-extern LiquidCrystal_I2C lcd;
 extern WiFiClient wifiClient;
 extern HTTPClient http;
 extern String backendUrl;
 extern String deviceId;
+extern String mqttBroker;
+extern String deviceKey;
 extern bool isOnline;
 extern int offlineLogsCount;
 extern MFRC522 mfrc522;
+extern MFRC522DriverFastSPI rfidDriver;
+#if RFID_READER_COUNT > 1
+extern MFRC522 mfrc522Exit;
+extern MFRC522DriverFastSPI rfidExitDriver;
+#endif
 extern RTC_DS3231 rtc;
 
 // Function declarations from main file
-extern bool syncSingleLog(String logEntry);
 
 // Static variables for uptime tracking
 static unsigned long bootTime = 0;
@@ -123,30 +138,36 @@ bool isValidRfidTag(String tag) {
 // ========================================
 
 bool saveConfiguration() {
-  StaticJsonDocument<512> config;
+  ArenaScope arena("cfg-save");
+  ArenaJsonDocument config(768);
   config["backendUrl"] = backendUrl;
+  JsonArray urls = config.createNestedArray("backendUrls");
+  for (uint8_t i = 0; i < backendPoolCount(); i++) {
+    urls.add(backendPoolUrl(i));
+  }
   config["deviceId"] = deviceId;
+  config["mqttBroker"] = mqttBroker;
   config["firmware"] = FIRMWARE_VERSION;
   config["lastUpdate"] = millis();
   
   File file = LittleFS.open(CONFIG_FILE, "w");
   if (!file) {
-    DEBUG_PRINTLN("Failed to open config file for writing");
+    LOG_ERROR("Failed to open config file for writing");
     return false;
   }
   
   serializeJson(config, file);
   file.close();
-  DEBUG_PRINTLN("Configuration saved successfully");
+  LOG_DEBUG("Configuration saved successfully");
   return true;
 }
 
 bool loadJsonConfiguration() {
-  DEBUG_PRINTLN("Attempting to load configuration from LittleFS...");
+  LOG_DEBUG("Attempting to load configuration from LittleFS...");
   
   File file = LittleFS.open(CONFIG_FILE, "r");
   if (!file) {
-    DEBUG_PRINTLN("Config file not found, using defaults");
+    LOG_INFO("Config file not found, using defaults");
     // Ensure defaults are always set
     if (backendUrl.length() == 0) {
       backendUrl = DEFAULT_BACKEND_URL;
@@ -157,13 +178,13 @@ bool loadJsonConfiguration() {
     return false;
   }
   
-  StaticJsonDocument<512> config;
+  ArenaScope arena("cfg-load");
+  ArenaJsonDocument config(768);
   DeserializationError error = deserializeJson(config, file);
   file.close();
   
   if (error) {
-    DEBUG_PRINTLN("Failed to parse config file, using defaults");
-    DEBUG_PRINTLN("JSON Error: " + String(error.c_str()));
+    LOG_ERROR("Failed to parse config file, using defaults: %s", error.c_str());
     // Ensure defaults are always set even on parse error
     if (backendUrl.length() == 0) {
       backendUrl = DEFAULT_BACKEND_URL;
@@ -180,29 +201,86 @@ bool loadJsonConfiguration() {
     if (isValidUrl(loadedUrl)) {
       backendUrl = loadedUrl;
     } else {
-      DEBUG_PRINTLN("Invalid URL in config, using default");
+      LOG_WARN("Invalid URL in config, using default");
       backendUrl = DEFAULT_BACKEND_URL;
     }
   } else {
     backendUrl = DEFAULT_BACKEND_URL;
   }
   
+  // Ordered endpoint list; older configs only have backendUrl
+  String urls[BACKEND_MAX_ENDPOINTS];
+  uint8_t urlCount = 0;
+  for (JsonVariant url : config["backendUrls"].as<JsonArray>()) {
+    String candidate = url.as<String>();
+    if (urlCount < BACKEND_MAX_ENDPOINTS && isValidUrl(candidate)) {
+      urls[urlCount++] = candidate;
+    }
+  }
+  if (urlCount == 0) {
+    urls[urlCount++] = backendUrl;
+  }
+  backendUrl = urls[0];
+  backendPoolSetUrls(urls, urlCount);
+  
   if (config.containsKey("deviceId") && config["deviceId"].as<String>().length() > 0) {
     deviceId = config["deviceId"].as<String>();
   } else {
     deviceId = "ESP_" + formatMacAddress(WiFi.macAddress());
   }
   
-  DEBUG_PRINTLN("Configuration loaded successfully");
-  DEBUG_PRINTLN("Backend URL: " + backendUrl);
-  DEBUG_PRINTLN("Device ID: " + deviceId);
+  // Optional; empty keeps taps on HTTP
+  mqttBroker = config["mqttBroker"] | "";
+  
+  // Earlier builds kept the device key here, where /api/firmware/download
+  // serves it; move it to its own file and rewrite the config without it
+  if (config.containsKey("deviceKey")) {
+    String legacyKey = config["deviceKey"] | "";
+    if (legacyKey.length() > 0 && !LittleFS.exists(DEVICE_KEY_FILE)) {
+      deviceKey = legacyKey;
+      saveDeviceKey();
+    }
+    if (saveConfiguration()) {
+      LOG_INFO("Device key moved out of config.json");
+    }
+  }
+  
+  LOG_DEBUG("Configuration loaded: backend %s, device %s", backendUrl.c_str(), deviceId.c_str());
+  return true;
+}
+
+// The device key is a backend credential and the gossip MAC key, so it
+// lives in DEVICE_KEY_FILE, which no HTTP handler serves
+bool saveDeviceKey() {
+  if (deviceKey.length() == 0) {
+    return !LittleFS.exists(DEVICE_KEY_FILE) || LittleFS.remove(DEVICE_KEY_FILE);
+  }
+  File file = LittleFS.open(DEVICE_KEY_FILE, "w");
+  if (!file) {
+    LOG_ERROR("Failed to open device key file for writing");
+    return false;
+  }
+  file.print(deviceKey);
+  file.close();
   return true;
 }
 
+void loadDeviceKey() {
+  File file = LittleFS.open(DEVICE_KEY_FILE, "r");
+  if (!file) {
+    return;
+  }
+  deviceKey = file.readString();
+  deviceKey.trim();
+  file.close();
+}
+
 bool clearOfflineLogs() {
-  if (LittleFS.remove(OFFLINE_LOGS_FILE)) {
+  clearOfflineStaging();
+  if (offlineStoreRemove(OFFLINE_STORE_MAIN)) {
+    resetOfflineSyncState();
     offlineLogsCount = 0;
-    DEBUG_PRINTLN("Offline logs cleared");
+    LOG_INFO("Offline logs cleared");
     return true;
   }
   return false;
@@ -215,14 +293,14 @@ bool clearOfflineLogs() {
 bool validateBackendConnection() {
   if (!isOnline) return false;
   
-  http.begin(wifiClient, backendUrl + "/health");
+  http.begin(wifiClient, backendPoolActiveUrl() + "/health");
   http.setTimeout(5000);
   
   int httpResponseCode = http.GET();
   bool isValid = (httpResponseCode == 200);
   
   http.end();
-  DEBUG_PRINTLN("Backend validation: " + String(isValid ? "OK" : "FAILED"));
+  LOG_DEBUG("Backend validation: %s", isValid ? "OK" : "FAILED");
   return isValid;
 }
 
@@ -259,32 +337,77 @@ String getMACAddress() {
 // RFID UTILITY FUNCTIONS (MFRC522v2)
 // ========================================
 
+static MFRC522DriverFastSPI& rfidReaderDriver(uint8_t index) {
+#if RFID_READER_COUNT > 1
+  if (index == 1) {
+    return rfidExitDriver;
+  }
+#endif
+  return rfidDriver;
+}
+
+// Reader 0 is the entry lane (or the only reader), reader 1 the exit lane
+MFRC522& rfidReader(uint8_t index) {
+#if RFID_READER_COUNT > 1
+  if (index == 1) {
+    return mfrc522Exit;
+  }
+#endif
+  return mfrc522;
+}
+
 void initializeRFID() {
-  mfrc522.PCD_Init();
-  // Ensure antenna is on and set gain
-  mfrc522.PCD_AntennaOn();
-  setRFIDGain(RFID_DEFAULT_GAIN);
+  rfidLanesReset(RFID_READER_COUNT);
+  // Every chip select goes high before the first transfer on the shared bus
+  for (uint8_t i = 0; i < RFID_READER_COUNT; i++) {
+    rfidReaderDriver(i).init();
+  }
+  for (uint8_t i = 0; i < RFID_READER_COUNT; i++) {
+    MFRC522& reader = rfidReader(i);
+    reader.PCD_Init();
+    bool found = rfidReaderDriver(i).tune();
+    // Ensure antenna is on
+    reader.PCD_AntennaOn();
+    if (i > 0 && !found) {
+      rfidLanesSetEnabled(i, false);
+      LOG_ERROR("Exit lane reader not responding - running entry lane only");
+    }
+  }
+  setRFIDGain(rfidGainCurrent());
 }
 
 void softResetRFID() {
-  // Try graceful halt and soft reset
-  mfrc522.PICC_HaltA();
-  delay(5);
-  mfrc522.PCD_SoftPowerDown();
-  delay(10);
-  mfrc522.PCD_SoftPowerUp();
-  delay(25);
-  mfrc522.PCD_Init();
-  mfrc522.PCD_AntennaOn();
-  setRFIDGain(RFID_DEFAULT_GAIN);
+  metricsCountRFIDReset();
+  for (uint8_t i = 0; i < RFID_READER_COUNT; i++) {
+    if (!rfidLanesEnabled(i)) {
+      continue;
+    }
+    MFRC522& reader = rfidReader(i);
+    // Try graceful halt and soft reset
+    reader.PICC_HaltA();
+    delay(5);
+    reader.PCD_SoftPowerDown();
+    delay(10);
+    reader.PCD_SoftPowerUp();
+    delay(25);
+    reader.PCD_Init();
+    rfidReaderDriver(i).tune();
+    reader.PCD_AntennaOn();
+    rfidLanesClearFailures(i);
+  }
+  setRFIDGain(rfidGainCurrent());
 }
 
+// Gain is the 3-bit RxGain code; the library expects it in bits 4-6 of RFCfgReg.
+// Both lanes share one gain, they face the same crowd.
 void setRFIDGain(byte gain) {
-  mfrc522.PCD_SetAntennaGain(gain);
+  for (uint8_t i = 0; i < RFID_READER_COUNT; i++) {
+    rfidReader(i).PCD_SetAntennaGain((gain & 0x07) << 4);
+  }
 }
 
 byte getRFIDGain() {
-  return mfrc522.PCD_GetAntennaGain();
+  return mfrc522.PCD_GetAntennaGain() >> 4;
 }
 
 bool isRFIDCardPresent() {
@@ -337,8 +460,7 @@ void blinkLED(bool green, bool red, int times) {
 // ========================================
 
 bool isTimeValid() {
-  DateTime now = rtc.now();
-  return (now.year() > 2020); // Assume any year > 2020 is valid
+  return clockIsValid(); // RTC or NTP has supplied a year > 2020
 }
 
 String getFormattedUptime() {
@@ -369,24 +491,24 @@ unsigned long getUptime() {
 // ========================================
 
 bool initializeFileSystem() {
-  DEBUG_PRINTLN("Initializing LittleFS...");
+  LOG_DEBUG("Initializing LittleFS...");
   
   if (!LittleFS.begin()) {
-    DEBUG_PRINTLN("LittleFS initialization failed, attempting format...");
+    LOG_WARN("LittleFS initialization failed, attempting format...");
     
     if (LittleFS.format()) {
-      DEBUG_PRINTLN("LittleFS formatted successfully");
+      LOG_INFO("LittleFS formatted successfully");
       if (LittleFS.begin()) {
-        DEBUG_PRINTLN("LittleFS initialized after format");
+        LOG_INFO("LittleFS initialized after format");
         return true;
       }
     }
     
-    DEBUG_PRINTLN("LittleFS initialization completely failed");
+    LOG_ERROR("LittleFS initialization completely failed");
     return false;
   }
   
-  DEBUG_PRINTLN("LittleFS initialized successfully");
+  LOG_DEBUG("LittleFS initialized successfully");
   return true;
 }
 
@@ -412,37 +534,13 @@ bool cleanupOldLogs() {
   return true;
 }
 
-// ========================================
-// ERROR HANDLING AND LOGGING
-// ========================================
-
-void logError(String error) {
-  #if DEBUG_ENABLED
-  Serial.print("[ERROR] ");
-  Serial.println(error);
-  #endif
-}
-
-void logInfo(String info) {
-  #if DEBUG_ENABLED
-  Serial.print("[INFO] ");
-  Serial.println(info);
-  #endif
-}
-
-void logDebug(String debug) {
-  #if DEBUG_ENABLED
-  Serial.print("[DEBUG] ");
-  Serial.println(debug);
-  #endif
-}
-
 // ========================================
 // TIME AND NTP FUNCTIONS
 // ========================================
 
+// Formatted from the RAM clock; no I2C traffic
 String getCurrentTimestamp() {
-  DateTime now = rtc.now();
+  DateTime now = clockNow();
   char buffer[25];
   sprintf(buffer, "%04d-%02d-%02dT%02d:%02d:%02d", 
           now.year(), now.month(), now.day(),
@@ -450,43 +548,11 @@ String getCurrentTimestamp() {
   return String(buffer);
 }
 
+// Kicks the background SNTP client; the result is picked up by
+// serviceSoftClock(), which also corrects the DS3231.
 void syncTimeWithNTP() {
-  Serial.println("Syncing time with NTP...");
-  
-  // Get IST directly from NTP
-  configTime(IST_OFFSET, 0, NTP_SERVER);
-
-  struct tm timeinfo;
-  int attempts = 0;
-  while (!getLocalTime(&timeinfo) && attempts < 20) {
-    delay(500);
-    attempts++;
-  }
-
-  if (attempts < 20) {
-    Serial.println("Time synced successfully");
-
-    // Convert tm → epoch → DateTime
-    time_t now;
-    time(&now);
-    Serial.println(ctime(&now));
-    struct tm timeinfo;
-    if (getLocalTime(&timeinfo)) {
-        // Serial.println(&timeinfo, "%a %b %d %H:%M:%S %Y"); 
-        rtc.adjust(DateTime(
-          timeinfo.tm_year + 1900,
-          timeinfo.tm_mon + 1,
-          timeinfo.tm_mday,
-          timeinfo.tm_hour,
-          timeinfo.tm_min,
-          timeinfo.tm_sec
-        ));        
-      }
-    logInfo("NTP time sync successful");
-  } else {
-    Serial.println("Time sync failed");
-    logError("NTP time sync failed");
-  }
+  LOG_INFO("Requesting NTP time sync...");
+  clockRequestNtpSync();
 }
 
 // ========================================
@@ -10,7 +10,6 @@
 #include <Arduino.h>
 #include <RTClib.h>
 #include <MFRC522v2.h>
-#endif
 
 // ========================================
 // UTILITY FUNCTION DECLARATIONS
@@ -32,6 +31,8 @@ bool isValidRfidTag(String tag);
 // Configuration management
 bool saveConfiguration();
 bool loadJsonConfiguration();
+bool saveDeviceKey();
+void loadDeviceKey();
 bool clearOfflineLogs();
 
 // Backend connectivity
@@ -41,6 +42,7 @@ bool testInternetConnection();
 // RFID utility functions (MFRC522v2 specific)
 void initializeRFID();
 void softResetRFID();
+MFRC522& rfidReader(uint8_t index);
 byte getRFIDGain();
 void setRFIDGain(byte gain);
 bool isRFIDCardPresent();
@@ -119,7 +121,4 @@ size_t getFileSystemUsed();
 size_t getFileSystemTotal();
 bool cleanupOldLogs();
 
-// Error handling
-void logError(String error);
-void logInfo(String info);
-void logDebug(String debug);
+#endif // UTILS_H
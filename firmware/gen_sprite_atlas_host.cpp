@@ -0,0 +1,123 @@
+/*
+ * Generates the terminal's OLED sprite atlas
+ *
+ * Renders every shape in sprite_shapes.h on a host canvas, crops it to
+ * the SSD1306 pages and columns it covers, and writes
+ * attendance_terminal/sprite_ids.h and attendance_terminal/sprite_atlas_data.h.
+ * Run it after editing a shape and commit the output.
+ *
+ * Build:
+ *   g++ -std=c++11 -Wall -o gen_sprite_atlas gen_sprite_atlas_host.cpp
+ *
+ * Usage: ./gen_sprite_atlas [output-dir]      (default attendance_terminal)
+ */
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "host_canvas.h"
+#include "sprite_shapes.h"
+
+struct Shape {
+  const char* name;
+  void (*draw)(HostCanvas&);
+};
+
+#define SHAPE_ENTRY(name, fn) { #name, fn<HostCanvas> },
+static const Shape SHAPES[] = { SPRITE_SHAPE_LIST(SHAPE_ENTRY) };
+static const size_t SHAPE_COUNT = sizeof(SHAPES) / sizeof(SHAPES[0]);
+
+static const char* BANNER = "// Generated by gen_sprite_atlas_host.cpp from sprite_shapes.h - do not edit\n";
+
+struct Sprite {
+  int offset, x, y, width, pages;
+};
+
+static bool crop(const HostCanvas& canvas, Sprite& sprite) {
+  int minX = HostCanvas::WIDTH, maxX = -1, minY = HostCanvas::HEIGHT, maxY = -1;
+  for (int y = 0; y < HostCanvas::HEIGHT; y++) {
+    for (int x = 0; x < HostCanvas::WIDTH; x++) {
+      if (canvas.pixel(x, y)) {
+        minX = x < minX ? x : minX;
+        maxX = x > maxX ? x : maxX;
+        minY = y < minY ? y : minY;
+        maxY = y > maxY ? y : maxY;
+      }
+    }
+  }
+  if (maxX < 0) {
+    return false;
+  }
+  sprite.x = minX;
+  sprite.y = minY / 8 * 8;
+  sprite.width = maxX - minX + 1;
+  sprite.pages = maxY / 8 - minY / 8 + 1;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  std::string dir = argc > 1 ? argv[1] : "attendance_terminal";
+  std::vector<Sprite> sprites;
+  std::vector<uint8_t> bits;
+
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    HostCanvas canvas;
+    SHAPES[i].draw(canvas);
+    Sprite sprite;
+    if (!crop(canvas, sprite)) {
+      fprintf(stderr, "shape %s draws nothing\n", SHAPES[i].name);
+      return 1;
+    }
+    sprite.offset = (int)bits.size();
+    for (int page = 0; page < sprite.pages; page++) {
+      const uint8_t* row = canvas.buffer + (sprite.y / 8 + page) * HostCanvas::WIDTH + sprite.x;
+      bits.insert(bits.end(), row, row + sprite.width);
+    }
+    sprites.push_back(sprite);
+  }
+
+  std::string idsPath = dir + "/sprite_ids.h";
+  FILE* ids = fopen(idsPath.c_str(), "w");
+  if (!ids) {
+    perror(idsPath.c_str());
+    return 1;
+  }
+  fputs(BANNER, ids);
+  fputs("\n#ifndef SPRITE_IDS_H\n#define SPRITE_IDS_H\n\n#include <stdint.h>\n\n", ids);
+  fputs("enum SpriteId : uint8_t {\n", ids);
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    fprintf(ids, "  SPRITE_%s,\n", SHAPES[i].name);
+  }
+  fputs("  SPRITE_COUNT\n};\n\n#endif // SPRITE_IDS_H\n", ids);
+  fclose(ids);
+
+  std::string dataPath = dir + "/sprite_atlas_data.h";
+  FILE* data = fopen(dataPath.c_str(), "w");
+  if (!data) {
+    perror(dataPath.c_str());
+    return 1;
+  }
+  fputs(BANNER, data);
+  fprintf(data, "// %u sprites, %u bytes; included by sprite_atlas.cpp only\n\n",
+          (unsigned)SHAPE_COUNT, (unsigned)bits.size());
+  fputs("static const uint8_t SPRITE_ATLAS_BITS[] PROGMEM = {\n", data);
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    const Sprite& s = sprites[i];
+    fprintf(data, "  // SPRITE_%s: %dx%d at %d,%d\n", SHAPES[i].name, s.width, s.pages * 8, s.x, s.y);
+    for (int b = 0; b < s.width * s.pages; b++) {
+      fprintf(data, "%s0x%02X,%s", b % 16 == 0 ? "  " : "", bits[s.offset + b],
+              (b % 16 == 15 || b == s.width * s.pages - 1) ? "\n" : " ");
+    }
+  }
+  fputs("};\n\n", data);
+  fputs("static const SpriteInfo SPRITE_ATLAS_INFO[SPRITE_COUNT] PROGMEM = {\n", data);
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    const Sprite& s = sprites[i];
+    fprintf(data, "  { %d, %d, %d, %d, %d },   // SPRITE_%s\n", s.offset, s.x, s.y, s.width, s.pages, SHAPES[i].name);
+  }
+  fputs("};\n", data);
+  fclose(data);
+
+  printf("Wrote %u sprites (%u bytes) to %s\n", (unsigned)SHAPE_COUNT, (unsigned)bits.size(), dir.c_str());
+  return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * 128x64 monochrome canvas for host programs
+ *
+ * The subset of Adafruit_GFX the terminal's icons are drawn with, using
+ * the library's own algorithms, writing the SSD1306 page layout (one byte
+ * = 8 vertical pixels, LSB on top). gen_sprite_atlas_host.cpp renders
+ * sprite_shapes.h with it; test_sprite_atlas_host.cpp times it.
+ */
+
+#ifndef HOST_CANVAS_H
+#define HOST_CANVAS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+class HostCanvas {
+public:
+  static const int16_t WIDTH = 128;
+  static const int16_t HEIGHT = 64;
+
+  uint8_t buffer[WIDTH * HEIGHT / 8];
+
+  HostCanvas() { clearDisplay(); }
+
+  void clearDisplay() { memset(buffer, 0, sizeof(buffer)); }
+  uint8_t* getBuffer() { return buffer; }
+
+  bool pixel(int16_t x, int16_t y) const {
+    return x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT && (buffer[x + (y / 8) * WIDTH] & (1 << (y & 7)));
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t) {
+    if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
+      buffer[x + (y / 8) * WIDTH] |= 1 << (y & 7);
+    }
+  }
+
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+    for (int16_t i = 0; i < h; i++) {
+      drawPixel(x, y + i, color);
+    }
+  }
+
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    for (int16_t i = 0; i < w; i++) {
+      drawPixel(x + i, y, color);
+    }
+  }
+
+  void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+    if (x0 == x1) {
+      if (y0 > y1) swap(y0, y1);
+      drawFastVLine(x0, y0, y1 - y0 + 1, color);
+      return;
+    }
+    if (y0 == y1) {
+      if (x0 > x1) swap(x0, x1);
+      drawFastHLine(x0, y0, x1 - x0 + 1, color);
+      return;
+    }
+    bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) {
+      swap(x0, y0);
+      swap(x1, y1);
+    }
+    if (x0 > x1) {
+      swap(x0, x1);
+      swap(y0, y1);
+    }
+    int16_t dx = x1 - x0;
+    int16_t dy = abs(y1 - y0);
+    int16_t err = dx / 2;
+    int16_t ystep = y0 < y1 ? 1 : -1;
+    for (; x0 <= x1; x0++) {
+      if (steep) {
+        drawPixel(y0, x0, color);
+      } else {
+        drawPixel(x0, y0, color);
+      }
+      err -= dy;
+      if (err < 0) {
+        y0 += ystep;
+        err += dx;
+      }
+    }
+  }
+
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+  }
+
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    for (int16_t i = x; i < x + w; i++) {
+      drawFastVLine(i, y, h, color);
+    }
+  }
+
+  void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    drawPixel(x0, y0 + r, color);
+    drawPixel(x0, y0 - r, color);
+    drawPixel(x0 + r, y0, color);
+    drawPixel(x0 - r, y0, color);
+    while (x < y) {
+      if (f >= 0) {
+        y--;
+        ddF_y += 2;
+        f += ddF_y;
+      }
+      x++;
+      ddF_x += 2;
+      f += ddF_x;
+      drawPixel(x0 + x, y0 + y, color);
+      drawPixel(x0 - x, y0 + y, color);
+      drawPixel(x0 + x, y0 - y, color);
+      drawPixel(x0 - x, y0 - y, color);
+      drawPixel(x0 + y, y0 + x, color);
+      drawPixel(x0 - y, y0 + x, color);
+      drawPixel(x0 + y, y0 - x, color);
+      drawPixel(x0 - y, y0 - x, color);
+    }
+  }
+
+  void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color) {
+    drawFastVLine(x0, y0 - r, 2 * r + 1, color);
+    fillCircleHelper(x0, y0, r, 3, 0, color);
+  }
+
+  void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    int16_t maxRadius = (w < h ? w : h) / 2;
+    if (r > maxRadius) r = maxRadius;
+    drawFastHLine(x + r, y, w - 2 * r, color);
+    drawFastHLine(x + r, y + h - 1, w - 2 * r, color);
+    drawFastVLine(x, y + r, h - 2 * r, color);
+    drawFastVLine(x + w - 1, y + r, h - 2 * r, color);
+    drawCircleHelper(x + r, y + r, r, 1, color);
+    drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
+    drawCircleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+    drawCircleHelper(x + r, y + h - r - 1, r, 8, color);
+  }
+
+private:
+  static void swap(int16_t& a, int16_t& b) {
+    int16_t t = a;
+    a = b;
+    b = t;
+  }
+
+  void drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corner, uint16_t color) {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    while (x < y) {
+      if (f >= 0) {
+        y--;
+        ddF_y += 2;
+        f += ddF_y;
+      }
+      x++;
+      ddF_x += 2;
+      f += ddF_x;
+      if (corner & 4) {
+        drawPixel(x0 + x, y0 + y, color);
+        drawPixel(x0 + y, y0 + x, color);
+      }
+      if (corner & 2) {
+        drawPixel(x0 + x, y0 - y, color);
+        drawPixel(x0 + y, y0 - x, color);
+      }
+      if (corner & 8) {
+        drawPixel(x0 - y, y0 + x, color);
+        drawPixel(x0 - x, y0 + y, color);
+      }
+      if (corner & 1) {
+        drawPixel(x0 - y, y0 - x, color);
+        drawPixel(x0 - x, y0 - y, color);
+      }
+    }
+  }
+
+  void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color) {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r, px = x, py = y;
+    delta++;
+    while (x < y) {
+      if (f >= 0) {
+        y--;
+        ddF_y += 2;
+        f += ddF_y;
+      }
+      x++;
+      ddF_x += 2;
+      f += ddF_x;
+      if (x < (y + 1)) {
+        if (corners & 1) drawFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
+        if (corners & 2) drawFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
+      }
+      if (y != py) {
+        if (corners & 1) drawFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
+        if (corners & 2) drawFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
+        py = y;
+      }
+      px = x;
+    }
+  }
+};
+
+#endif // HOST_CANVAS_H
@@ -0,0 +1,51 @@
+/*
+ * Minimal Arduino core for host tests
+ *
+ * Just enough of String and the timing calls for firmware modules that
+ * are compiled on the host by the test_*_host.cpp files. millis() reads
+ * hostMillis, which the test advances.
+ */
+
+#ifndef HOST_STUBS_ARDUINO_H
+#define HOST_STUBS_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+extern unsigned long hostMillis;
+
+inline unsigned long millis() { return hostMillis; }
+inline unsigned long micros() { return hostMillis * 1000UL; }
+
+class String {
+public:
+  String() {}
+  String(const char* text) : value(text ? text : "") {}
+  String(const std::string& text) : value(text) {}
+  explicit String(int number) : value(std::to_string(number)) {}
+  explicit String(unsigned int number) : value(std::to_string(number)) {}
+  explicit String(long number) : value(std::to_string(number)) {}
+  explicit String(unsigned long number) : value(std::to_string(number)) {}
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return value.length(); }
+  bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+  void trim() {
+    size_t first = value.find_first_not_of(" \t\r\n");
+    size_t last = value.find_last_not_of(" \t\r\n");
+    value = first == std::string::npos ? "" : value.substr(first, last - first + 1);
+  }
+
+  String& operator+=(const String& other) { value += other.value; return *this; }
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator!=(const String& other) const { return value != other.value; }
+  friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+
+private:
+  std::string value;
+};
+
+#endif // HOST_STUBS_ARDUINO_H
@@ -0,0 +1,51 @@
+/*
+ * Minimal File for host tests; see Arduino.h. Files are in-memory strings.
+ */
+
+#ifndef HOST_STUBS_FS_H
+#define HOST_STUBS_FS_H
+
+#include <map>
+#include "Arduino.h"
+
+class File {
+public:
+  File() : contents(nullptr), pos(0) {}
+  explicit File(std::string* contents) : contents(contents), pos(0) {}
+
+  explicit operator bool() const { return contents != nullptr; }
+  size_t size() const { return contents ? contents->size() : 0; }
+  void close() { contents = nullptr; }
+  size_t print(uint32_t number) { return print(std::to_string(number)); }
+  size_t print(const std::string& text) {
+    contents->append(text);
+    return text.size();
+  }
+  long parseInt() {
+    long number = strtol(contents->c_str() + pos, nullptr, 10);
+    pos = contents->size();
+    return number;
+  }
+
+private:
+  std::string* contents;
+  size_t pos;
+};
+
+class HostFS {
+public:
+  File open(const char* path, const char* mode) {
+    if (mode[0] == 'w') {
+      files[path].clear();
+      return File(&files[path]);
+    }
+    auto found = files.find(path);
+    return found == files.end() ? File() : File(&found->second);
+  }
+  bool exists(const char* path) { return files.count(path) > 0; }
+  bool remove(const char* path) { return files.erase(path) > 0; }
+
+  std::map<std::string, std::string> files;
+};
+
+#endif // HOST_STUBS_FS_H
@@ -0,0 +1,12 @@
+/*
+ * LittleFS for host tests; see Arduino.h
+ */
+
+#ifndef HOST_STUBS_LITTLEFS_H
+#define HOST_STUBS_LITTLEFS_H
+
+#include "FS.h"
+
+extern HostFS LittleFS;
+
+#endif // HOST_STUBS_LITTLEFS_H
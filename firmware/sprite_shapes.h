@@ -0,0 +1,246 @@
+/*
+ * Source drawings of the terminal's OLED sprites
+ *
+ * Each shape is the primitive-drawn icon display_utils.cpp used to redraw
+ * on every frame, at its screen position. gen_sprite_atlas_host.cpp renders
+ * them once into attendance_terminal/sprite_atlas_data.h; the firmware
+ * only blits the result. test_sprite_atlas_host.cpp keeps them to compare
+ * against. Edit a shape here, then regenerate the atlas.
+ *
+ * Canvas is anything with the Adafruit_GFX drawing calls used below.
+ */
+
+#ifndef SPRITE_SHAPES_H
+#define SPRITE_SHAPES_H
+
+#include <math.h>
+
+#define SHAPE_ON 1
+#define SHAPE_PI 3.14159265359
+
+// ----- Emojis (face centred at 64,24) -----
+
+template <class Canvas> void shapeFace(Canvas& c) {
+  c.drawCircle(64, 24, 20, SHAPE_ON);
+}
+
+template <class Canvas> void shapeOpenEyes(Canvas& c) {
+  c.fillCircle(56, 17, 3, SHAPE_ON);
+  c.fillCircle(72, 17, 3, SHAPE_ON);
+}
+
+template <class Canvas> void shapeHappyEmoji(Canvas& c) {
+  shapeFace(c);
+  shapeOpenEyes(c);
+  for (int i = 0; i < 15; i++) {
+    c.drawPixel(56 + i, 28 + sin((i - 7) * 0.3) * 3, SHAPE_ON);
+  }
+}
+
+template <class Canvas> void shapeSadEmoji(Canvas& c) {
+  shapeFace(c);
+  shapeOpenEyes(c);
+  for (int i = 0; i < 15; i++) {
+    c.drawPixel(56 + i, 32 - sin((i - 7) * 0.3) * 3, SHAPE_ON);
+  }
+}
+
+template <class Canvas> void shapeVerySadEmoji(Canvas& c) {
+  shapeFace(c);
+  shapeOpenEyes(c);
+  for (int i = 0; i < 15; i++) {
+    c.drawPixel(56 + i, 35 - sin((i - 7) * 0.4) * 5, SHAPE_ON);
+  }
+  // Tears
+  c.drawLine(53, 20, 53, 28, SHAPE_ON);
+  c.drawLine(75, 20, 75, 28, SHAPE_ON);
+}
+
+template <class Canvas> void shapeNeutralEmoji(Canvas& c) {
+  shapeFace(c);
+  shapeOpenEyes(c);
+  c.drawLine(56, 32, 72, 32, SHAPE_ON);
+}
+
+template <class Canvas> void shapeWinkEmoji(Canvas& c) {
+  shapeFace(c);
+  c.drawLine(54, 17, 58, 17, SHAPE_ON);
+  c.fillCircle(72, 17, 3, SHAPE_ON);
+  for (int i = 0; i < 15; i++) {
+    c.drawPixel(56 + i, 28 + sin((i - 7) * 0.3) * 3, SHAPE_ON);
+  }
+}
+
+template <class Canvas> void shapeThinkingEmoji(Canvas& c) {
+  shapeFace(c);
+  shapeOpenEyes(c);
+  // Thinking bubble
+  c.drawCircle(84, 14, 3, SHAPE_ON);
+  c.drawCircle(80, 18, 2, SHAPE_ON);
+  c.drawCircle(76, 20, 1, SHAPE_ON);
+  c.drawLine(58, 32, 70, 32, SHAPE_ON);
+}
+
+template <class Canvas> void shapeSleepyEmoji(Canvas& c) {
+  shapeFace(c);
+  // Closed eyes
+  c.drawLine(54, 17, 58, 17, SHAPE_ON);
+  c.drawLine(70, 17, 74, 17, SHAPE_ON);
+  // Z
+  c.drawLine(84, 14, 88, 14, SHAPE_ON);
+  c.drawLine(88, 14, 84, 18, SHAPE_ON);
+  c.drawLine(84, 18, 88, 18, SHAPE_ON);
+  for (int i = 0; i < 15; i++) {
+    c.drawPixel(56 + i, 28 + sin((i - 7) * 0.2) * 2, SHAPE_ON);
+  }
+}
+
+template <class Canvas> void shapeConfusedEmoji(Canvas& c) {
+  shapeFace(c);
+  shapeOpenEyes(c);
+  for (int i = 0; i < 10; i++) {
+    c.drawPixel(59 + i, 32 + sin(i * 0.6) * 2, SHAPE_ON);
+  }
+  // Question mark
+  c.drawCircle(84, 14, 2, SHAPE_ON);
+  c.drawPixel(84, 18, SHAPE_ON);
+}
+
+template <class Canvas> void shapeCoolEmoji(Canvas& c) {
+  shapeFace(c);
+  // Sunglasses
+  c.fillRect(52, 15, 8, 4, SHAPE_ON);
+  c.fillRect(68, 15, 8, 4, SHAPE_ON);
+  c.drawLine(60, 17, 68, 17, SHAPE_ON);
+  for (int i = 0; i < 12; i++) {
+    c.drawPixel(58 + i, 30 + (i < 6 ? 0 : 2), SHAPE_ON);
+  }
+}
+
+// ----- Status symbols -----
+
+template <class Canvas> void shapeWiFiOn(Canvas& c) {
+  for (int i = 16; i >= 4; i -= 6) {
+    c.drawCircle(64, 32, i, SHAPE_ON);
+  }
+  c.fillCircle(64, 32, 2, SHAPE_ON);
+}
+
+template <class Canvas> void shapeWiFiOff(Canvas& c) {
+  c.drawCircle(64, 32, 16, SHAPE_ON);
+  c.drawLine(48, 48, 80, 16, SHAPE_ON);
+}
+
+// Outline and terminal; the charge level is filled in at run time
+template <class Canvas> void shapeBatteryFrame(Canvas& c) {
+  c.drawRect(44, 12, 32, 16, SHAPE_ON);
+  c.fillRect(76, 16, 4, 8, SHAPE_ON);
+}
+
+template <class Canvas> void shapeCard(Canvas& c) {
+  c.drawRoundRect(44, 12, 40, 25, 3, SHAPE_ON);
+  c.drawLine(54, 22, 74, 22, SHAPE_ON);
+  c.drawLine(54, 27, 74, 27, SHAPE_ON);
+}
+
+// The card of the swipe animations, at x 0; blitted at each x step
+template <class Canvas> void shapeSwipeCard(Canvas& c) {
+  c.drawRoundRect(0, 22, 30, 20, 2, SHAPE_ON);
+  c.drawLine(5, 32, 25, 32, SHAPE_ON);
+}
+
+template <class Canvas> void shapeCheckmark(Canvas& c) {
+  c.drawLine(45, 32, 55, 42, SHAPE_ON);
+  c.drawLine(55, 42, 85, 22, SHAPE_ON);
+}
+
+template <class Canvas> void shapeCross(Canvas& c) {
+  c.drawLine(45, 22, 85, 42, SHAPE_ON);
+  c.drawLine(45, 42, 85, 22, SHAPE_ON);
+}
+
+template <class Canvas> void shapeThumbsUp(Canvas& c) {
+  c.drawLine(60, 22, 60, 42, SHAPE_ON);
+  c.drawLine(60, 42, 68, 42, SHAPE_ON);
+  c.drawLine(68, 42, 68, 32, SHAPE_ON);
+  c.drawLine(68, 32, 60, 32, SHAPE_ON);
+  c.fillCircle(64, 22, 4, SHAPE_ON);
+}
+
+template <class Canvas> void shapeThumbsDown(Canvas& c) {
+  c.drawLine(60, 22, 60, 42, SHAPE_ON);
+  c.drawLine(60, 22, 68, 22, SHAPE_ON);
+  c.drawLine(68, 22, 68, 32, SHAPE_ON);
+  c.drawLine(68, 32, 60, 32, SHAPE_ON);
+  c.fillCircle(64, 42, 4, SHAPE_ON);
+}
+
+template <class Canvas> void shapeHeart(Canvas& c) {
+  for (int i = -6; i < 7; i++) {
+    for (int j = -6; j < 7; j++) {
+      float x = i / 6.0;
+      float y = j / 6.0;
+      if ((x*x + y*y - 1)*(x*x + y*y - 1)*(x*x + y*y - 1) - x*x*y*y*y <= 0) {
+        c.drawPixel(64 + i*2, 32 + j*2, SHAPE_ON);
+      }
+    }
+  }
+}
+
+template <class Canvas> void shapeLockClosed(Canvas& c) {
+  c.drawRoundRect(58, 24, 12, 16, 2, SHAPE_ON);
+  c.drawRoundRect(54, 14, 20, 12, 6, SHAPE_ON);
+}
+
+template <class Canvas> void shapeLockOpen(Canvas& c) {
+  c.drawRoundRect(58, 24, 12, 16, 2, SHAPE_ON);
+  c.drawRoundRect(68, 14, 20, 12, 6, SHAPE_ON);
+}
+
+template <class Canvas> void shapeClock(Canvas& c) {
+  c.drawCircle(64, 32, 16, SHAPE_ON);
+  c.drawLine(64, 32, 64, 20, SHAPE_ON);
+  c.drawLine(64, 32, 72, 32, SHAPE_ON);
+  c.fillCircle(64, 32, 2, SHAPE_ON);
+}
+
+template <class Canvas> void shapeGear(Canvas& c) {
+  for (int i = 0; i < 8; i++) {
+    float angle = i * SHAPE_PI / 4;
+    int x1 = 64 + cos(angle) * 12;
+    int y1 = 32 + sin(angle) * 12;
+    int x2 = 64 + cos(angle) * 16;
+    int y2 = 32 + sin(angle) * 16;
+    c.drawLine(x1, y1, x2, y2, SHAPE_ON);
+  }
+  c.drawCircle(64, 32, 12, SHAPE_ON);
+  c.drawCircle(64, 32, 6, SHAPE_ON);
+}
+
+// Atlas order; SpriteId values follow it
+#define SPRITE_SHAPE_LIST(X) \
+  X(HAPPY_EMOJI, shapeHappyEmoji) \
+  X(SAD_EMOJI, shapeSadEmoji) \
+  X(VERY_SAD_EMOJI, shapeVerySadEmoji) \
+  X(NEUTRAL_EMOJI, shapeNeutralEmoji) \
+  X(WINK_EMOJI, shapeWinkEmoji) \
+  X(THINKING_EMOJI, shapeThinkingEmoji) \
+  X(SLEEPY_EMOJI, shapeSleepyEmoji) \
+  X(CONFUSED_EMOJI, shapeConfusedEmoji) \
+  X(COOL_EMOJI, shapeCoolEmoji) \
+  X(WIFI_ON, shapeWiFiOn) \
+  X(WIFI_OFF, shapeWiFiOff) \
+  X(BATTERY_FRAME, shapeBatteryFrame) \
+  X(CARD, shapeCard) \
+  X(SWIPE_CARD, shapeSwipeCard) \
+  X(CHECKMARK, shapeCheckmark) \
+  X(CROSS, shapeCross) \
+  X(THUMBS_UP, shapeThumbsUp) \
+  X(THUMBS_DOWN, shapeThumbsDown) \
+  X(HEART, shapeHeart) \
+  X(LOCK_CLOSED, shapeLockClosed) \
+  X(LOCK_OPEN, shapeLockOpen) \
+  X(CLOCK, shapeClock) \
+  X(GEAR, shapeGear)
+
+#endif // SPRITE_SHAPES_H
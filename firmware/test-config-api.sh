@@ -0,0 +1,121 @@
+#!/bin/bash
+
+# Load test for the terminal's configuration API
+# Hammers /api/status while background jobs run and simulated cards are
+# tapped, then reports response times. Every request should stay well
+# under a second; a multi-second outlier means a handler blocked loop().
+#
+# Taps are injected through POST /api/test/tap, which only exists in
+# firmware built with TEST_TAP_INJECTION true in config.h.
+#
+# Usage: ./test-config-api.sh <device-ip> [requests] [parallel] [taps]
+
+DEVICE_IP="${1:?Usage: $0 <device-ip> [requests] [parallel] [taps]}"
+REQUESTS="${2:-200}"
+PARALLEL="${3:-4}"
+TAPS="${4:-10}"
+API_BASE="http://$DEVICE_IP"
+TIMINGS_FILE=$(mktemp)
+TAPS_FILE=$(mktemp)
+
+# Sum of attendee_taps_total over all outcomes
+count_taps() {
+  curl -s "$API_BASE/metrics" | awk '/^attendee_taps_total\{/ { sum += $2 } END { print sum + 0 }'
+}
+
+# Inject $TAPS taps with distinct UIDs, alternating entry and exit, each
+# once the previous one has been picked up (409 = still processing)
+inject_taps() {
+  for i in $(seq 1 "$TAPS"); do
+    TAG=$(printf "F0%06X" "$i")
+    DIRECTION=$([ $((i % 2)) -eq 1 ] && echo entry || echo exit)
+    for attempt in $(seq 1 50); do
+      CODE=$(curl -s -o /dev/null -w "%{http_code}" --max-time 5 -X POST \
+        -H "Content-Type: application/json" \
+        -d "{\"rfidTag\":\"$TAG\",\"direction\":\"$DIRECTION\"}" "$API_BASE/api/test/tap")
+      [ "$CODE" != "409" ] && break
+      sleep 0.2
+    done
+    echo "$CODE" >> "$TAPS_FILE"
+    sleep 0.5
+  done
+}
+
+echo "🧪 Testing Attendee Terminal - Non-blocking Configuration API"
+echo "=========================================================="
+echo "Device: $API_BASE  Requests: $REQUESTS  Parallel: $PARALLEL  Taps: $TAPS"
+echo ""
+
+# Test 0: Tap injection is built in
+echo "📝 Test 0: Checking for the tap injection endpoint..."
+PROBE=$(curl -s -o /dev/null -w "%{http_code}" -X POST -H "Content-Type: application/json" -d '{}' "$API_BASE/api/test/tap")
+if [ "$PROBE" = "404" ]; then
+  echo "❌ /api/test/tap not found: build the firmware with TEST_TAP_INJECTION true"
+  exit 1
+fi
+TAPS_BEFORE=$(count_taps)
+echo "Endpoint present (HTTP $PROBE for an empty tap), $TAPS_BEFORE taps counted so far"
+echo ""
+
+# Test 1: Start background jobs (all must answer 202 immediately)
+echo "📝 Test 1: Starting sync and heartbeat jobs..."
+SYNC_RESPONSE=$(curl -s -w " HTTP %{http_code} in %{time_total}s" -X POST "$API_BASE/api/actions/sync")
+echo "Sync Response: $SYNC_RESPONSE"
+HEARTBEAT_RESPONSE=$(curl -s -w " HTTP %{http_code} in %{time_total}s" -X POST "$API_BASE/api/actions/heartbeat")
+echo "Heartbeat Response: $HEARTBEAT_RESPONSE"
+SYNC_JOB_ID=$(echo "$SYNC_RESPONSE" | sed -n 's/.*"jobId":\([0-9]*\).*/\1/p')
+echo ""
+
+# Test 2: Hammer /api/status while taps are injected
+echo "📝 Test 2: Sending $REQUESTS status requests ($PARALLEL in parallel) and $TAPS taps..."
+inject_taps &
+INJECT_PID=$!
+seq "$REQUESTS" | xargs -P "$PARALLEL" -I{} \
+  curl -s -o /dev/null -w "%{http_code} %{time_total}\n" --max-time 10 "$API_BASE/api/status" >> "$TIMINGS_FILE"
+wait "$INJECT_PID"
+
+awk '
+  $1 != 200 { errors++ }
+  { t = $2 * 1000; sum += t; if (t > max) max = t; times[NR] = t }
+  END {
+    n = asort(times)
+    printf "Requests: %d  Errors: %d\n", NR, errors
+    printf "Avg: %.0f ms  p95: %.0f ms  Max: %.0f ms\n", sum / NR, times[int(n * 0.95)], max
+  }' "$TIMINGS_FILE"
+echo ""
+
+# Test 3: Poll the sync job until it finishes
+if [ -n "$SYNC_JOB_ID" ]; then
+  echo "📝 Test 3: Polling sync job $SYNC_JOB_ID..."
+  for i in $(seq 1 30); do
+    JOB_RESPONSE=$(curl -s "$API_BASE/api/jobs/$SYNC_JOB_ID")
+    echo "Job: $JOB_RESPONSE"
+    if echo "$JOB_RESPONSE" | grep -q '"state":"\(done\|failed\)"'; then
+      break
+    fi
+    sleep 1
+  done
+fi
+echo ""
+
+# Test 4: Unknown job ids are rejected
+echo "📝 Test 4: Polling an unknown job (should be 404)..."
+curl -s -w " HTTP %{http_code}\n" "$API_BASE/api/jobs/65000"
+echo ""
+
+# Test 5: Every injected tap was accepted and reached an outcome
+echo "📝 Test 5: Checking the injected taps..."
+ACCEPTED=$(grep -c '^202$' "$TAPS_FILE")
+for i in $(seq 1 20); do
+  TAPS_AFTER=$(count_taps)
+  [ $((TAPS_AFTER - TAPS_BEFORE)) -ge "$ACCEPTED" ] && break
+  sleep 1
+done
+echo "Accepted: $ACCEPTED/$TAPS  Outcomes counted: $((TAPS_AFTER - TAPS_BEFORE))"
+if [ "$ACCEPTED" -ne "$TAPS" ] || [ $((TAPS_AFTER - TAPS_BEFORE)) -lt "$TAPS" ]; then
+  echo "❌ Some injected taps were rejected or never processed"
+fi
+
+rm -f "$TIMINGS_FILE" "$TAPS_FILE"
+echo ""
+echo "✅ Configuration API load test complete"
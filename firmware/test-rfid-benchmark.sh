@@ -0,0 +1,48 @@
+#!/bin/bash
+
+# RC522 driver micro-benchmark
+# Starts the on-device benchmark job, which measures the stock
+# MFRC522DriverSPI against the burst driver on the same reader: REQA
+# polls per second with no card present, then mean UID read latency
+# (WUPA + select) once a card is held on the reader.
+#
+# Usage: ./test-rfid-benchmark.sh <device-ip>
+
+DEVICE_IP="${1:?Usage: $0 <device-ip>}"
+API_BASE="http://$DEVICE_IP"
+
+echo "🧪 Testing Attendee Terminal - RC522 driver benchmark"
+echo "===================================================="
+echo ""
+echo "👉 Keep cards away from the reader until the job asks for one."
+echo ""
+
+START_RESPONSE=$(curl -s -X POST "$API_BASE/api/actions/rfid-benchmark")
+echo "Start Response: $START_RESPONSE"
+JOB_ID=$(echo "$START_RESPONSE" | sed -n 's/.*"jobId":\([0-9]*\).*/\1/p')
+if [ -z "$JOB_ID" ]; then
+  echo "❌ Benchmark job was not accepted"
+  exit 1
+fi
+echo ""
+
+LAST_MESSAGE=""
+for i in $(seq 1 40); do
+  JOB_RESPONSE=$(curl -s "$API_BASE/api/jobs/$JOB_ID")
+  MESSAGE=$(echo "$JOB_RESPONSE" | sed -n 's/.*"message":"\([^"]*\)".*/\1/p')
+  if [ "$MESSAGE" != "$LAST_MESSAGE" ]; then
+    echo "Job $JOB_ID: $MESSAGE"
+    LAST_MESSAGE="$MESSAGE"
+  fi
+  if echo "$JOB_RESPONSE" | grep -q '"state":"\(done\|failed\)"'; then
+    break
+  fi
+  sleep 0.5
+done
+echo ""
+
+echo "📝 SPI status:"
+curl -s "$API_BASE/api/status" | sed -n 's/.*"spi":\({[^}]*}[^}]*}\).*/\1/p'
+
+echo ""
+echo "✅ RC522 driver benchmark complete"
@@ -0,0 +1,333 @@
+/*
+ * Host test of the resumable offline sync job
+ *
+ * Runs the firmware's serviceOfflineSync() (offline_sync.cpp) on a
+ * simulated clock, against an in-memory block store, a pipelined backend
+ * with a fixed round trip, and a card reader that students walk up to
+ * while the backlog drains. A tap is served by the next loop pass after
+ * the sync slice in progress returns, so its latency is bounded by one
+ * slice whatever the size of the backlog.
+ *
+ * The firmware headers that need the ESP8266 core are replaced by the
+ * fakes below; their include guards are defined first so the real ones
+ * are skipped. host_stubs/ provides Arduino.h, FS.h and LittleFS.h.
+ *
+ * Build:
+ *   g++ -std=c++11 -Wall -Ihost_stubs -Iattendance_terminal -o offline_sync_host \
+ *       test_offline_sync_host.cpp
+ *
+ * Usage: ./offline_sync_host    (exit status 0 when every check passes)
+ */
+
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <Arduino.h>
+#include <LittleFS.h>
+
+unsigned long hostMillis = 0;
+HostFS LittleFS;
+
+// ---- Fakes for the modules offline_sync.cpp calls ----
+
+#define UTILS_H
+#define DEBUG_LOG_H
+#define EVENT_STREAM_H
+#define METRICS_H
+#define OFFLINE_STAGING_H
+#define MEMORY_GOVERNOR_H
+#define DISPLAY_FRONTEND_H
+#define MQTT_TRANSPORT_H
+
+#define LOG_ERROR(...) do { } while (0)
+#define LOG_WARN(...) do { } while (0)
+#define LOG_INFO(...) do { } while (0)
+#define LOG_DEBUG(...) do { } while (0)
+
+enum LCDState { LCD_SYNC_PROGRESS, LCD_SYNC_COMPLETE };
+struct Display {
+  static void replaceStatus(LCDState showing, LCDState state, const String& param1 = "") {}
+};
+
+#include "config.h"
+#include "circuit_breaker.h"
+#include "event_seq.h"
+#include "offline_store.h"
+#include "sync_pipeline.h"
+
+void publishSyncEvent(const char* phase, int synced, int total) {}
+void metricsCountSyncRecord(bool synced) {}
+bool flushOfflineStaging(const char* reason) { return true; }
+int getStagedRecordCount() { return 0; }
+uint32_t getStagedSeqFloor() { return 0; }
+bool memNetworkAllowed() { return true; }
+int memSyncBatchLimit() { return SYNC_SLICE_MAX_RECORDS; }
+uint32_t mqttInflightSeqFloor() { return 0; }
+
+static uint32_t nextSeq = 1;
+uint32_t peekEventSeq() { return nextSeq; }
+
+static BreakerStats breaker = { BREAKER_CLOSED, 0, 0, 0, 0, 0, 0, 0 };
+bool breakerAllowRequest() { return true; }
+const BreakerStats& getBreakerStats() { return breaker; }
+
+// ---- In-memory block store; cursors are record indexes ----
+
+const OfflineStoreFiles OFFLINE_STORE_MAIN = { "/main.bin", "/main_uids.bin" };
+const OfflineStoreFiles OFFLINE_STORE_DEFER = { "/defer.bin", "/defer_uids.bin" };
+
+static std::map<std::string, std::vector<OfflineRecord> > stores;
+static std::map<const OfflineStoreReader*, std::vector<OfflineRecord>*> openReaders;
+
+bool offlineStoreAppend(const OfflineStoreFiles& store, const OfflineRecord* records, int count) {
+  std::vector<OfflineRecord>& log = stores[store.dataPath];
+  log.insert(log.end(), records, records + count);
+  return true;
+}
+
+bool offlineStoreRemove(const OfflineStoreFiles& store) {
+  return stores.erase(store.dataPath) > 0;
+}
+
+bool offlineStoreRename(const OfflineStoreFiles& from, const OfflineStoreFiles& to) {
+  stores[to.dataPath] = stores[from.dataPath];
+  stores.erase(from.dataPath);
+  return true;
+}
+
+bool offlineStoreOpen(OfflineStoreReader& reader, const OfflineStoreFiles& store, uint32_t cursor) {
+  auto found = stores.find(store.dataPath);
+  if (found == stores.end() || cursor >= found->second.size()) {
+    return false;
+  }
+  openReaders[&reader] = &found->second;
+  reader.block = cursor;
+  return true;
+}
+
+bool offlineStoreNext(OfflineStoreReader& reader, OfflineRecord& record) {
+  std::vector<OfflineRecord>* log = openReaders[&reader];
+  if (reader.block >= log->size()) {
+    return false;
+  }
+  record = (*log)[reader.block++];
+  return true;
+}
+
+uint32_t offlineStoreCursor(const OfflineStoreReader& reader) {
+  return reader.block;
+}
+
+void offlineStoreClose(OfflineStoreReader& reader) {
+  openReaders.erase(&reader);
+}
+
+int offlineStoreCount(const OfflineStoreFiles& store, uint32_t fromCursor) {
+  auto found = stores.find(store.dataPath);
+  return found == stores.end() || fromCursor >= found->second.size() ? 0 : found->second.size() - fromCursor;
+}
+
+String offlineRecordToJson(const OfflineRecord& record) {
+  return String("{\"seq\":") + String((unsigned long)record.seq) + "}";
+}
+
+// ---- Backend: one round trip per slice plus a little per record ----
+
+#define RTT_MS 250
+#define PER_RECORD_MS 20
+
+static std::vector<uint32_t> received;          // seq of every record the backend took
+static std::vector<uint32_t> floorsSent;        // X-Seq-Floor of every slice
+
+int postPipelined(const String* bodies, int count, uint32_t seqFloor, PipelineResponse* responses) {
+  hostMillis += RTT_MS + PER_RECORD_MS * count;
+  floorsSent.push_back(seqFloor);
+  for (int i = 0; i < count; i++) {
+    received.push_back(strtoul(bodies[i].c_str() + strlen("{\"seq\":"), nullptr, 10));
+    responses[i].code = 201;
+    responses[i].duplicate = false;
+    responses[i].highWater = -1;
+  }
+  return count;
+}
+
+bool fetchSyncWatermark(uint32_t seqFloor, uint32_t& highWater, uint32_t* lastSeq) {
+  hostMillis += RTT_MS;
+  highWater = 0;
+  return true;
+}
+
+// ---- Sketch globals and the card reader ----
+
+bool isOnline = true;
+int offlineLogsCount = 0;
+unsigned long lastSyncAttempt = 0;
+
+static std::vector<unsigned long> arrivals;     // Students reach the reader
+static size_t nextArrival = 0;
+
+bool pollForPendingCard() {
+  return nextArrival < arrivals.size() && hostMillis >= arrivals[nextArrival];
+}
+
+#include "offline_sync.cpp"
+
+// ---- Test driver ----
+
+#define TAP_MS 1000                     // Feedback and backend round trip of one tap
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+  } while (0)
+
+struct DrainResult {
+  unsigned long drainMs;
+  std::vector<unsigned long> latencies;         // Per tap, in arrival order
+  unsigned long yielded;
+};
+
+static void reset(const std::vector<uint32_t>& seqs) {
+  hostMillis = 0;
+  stores.clear();
+  received.clear();
+  floorsSent.clear();
+  arrivals.clear();
+  nextArrival = 0;
+  resetOfflineSyncState();
+
+  std::vector<OfflineRecord> records(seqs.size());
+  for (size_t i = 0; i < seqs.size(); i++) {
+    memset(&records[i], 0, sizeof(OfflineRecord));
+    records[i].seq = seqs[i];
+  }
+  offlineStoreAppend(OFFLINE_STORE_MAIN, records.data(), records.size());
+  offlineLogsCount = records.size();
+  nextSeq = *std::max_element(seqs.begin(), seqs.end()) + 1;
+}
+
+// Drains `backlog` records while a student walks up every 1.5-3.5 s
+static DrainResult drain(uint32_t backlog) {
+  std::vector<uint32_t> seqs;
+  for (uint32_t seq = 1; seq <= backlog; seq++) {
+    seqs.push_back(seq);
+  }
+  reset(seqs);
+
+  unsigned seed = 12345;
+  for (unsigned long t = 700; t < backlog * 200UL + 60000UL; ) {
+    arrivals.push_back(t);
+    seed = seed * 1103515245 + 12345;
+    t += 1500 + (seed >> 16) % 2000;
+  }
+
+  // The "rfid" and "sync" tasks on their scheduler periods
+  DrainResult result;
+  unsigned long nextRfid = 0;
+  unsigned long nextSync = 0;
+  startOfflineSync();
+  while (isOfflineSyncActive()) {
+    if (hostMillis >= nextRfid) {
+      if (pollForPendingCard()) {
+        result.latencies.push_back(hostMillis - arrivals[nextArrival]);
+        nextArrival++;
+        hostMillis += TAP_MS;
+      }
+      nextRfid = hostMillis + SCHED_RFID_MS;
+    }
+    if (hostMillis >= nextSync) {
+      serviceOfflineSync();
+      nextSync = hostMillis + SCHED_JOBS_MS;
+    }
+    hostMillis += SCHED_TICK_MS;
+  }
+  result.drainMs = hostMillis;
+  result.yielded = getOfflineSyncStatus().yieldedToTaps;
+  return result;
+}
+
+static unsigned long maxOf(const std::vector<unsigned long>& values, size_t from, size_t to) {
+  unsigned long most = 0;
+  for (size_t i = from; i < to; i++) {
+    most = std::max(most, values[i]);
+  }
+  return most;
+}
+
+static double meanOf(const std::vector<unsigned long>& values, size_t from, size_t to) {
+  double sum = 0;
+  for (size_t i = from; i < to; i++) {
+    sum += values[i];
+  }
+  return to > from ? sum / (to - from) : 0;
+}
+
+static void testBacklogDrains() {
+  DrainResult result = drain(2000);
+  CHECK(received.size() == 2000, "backend received %u of 2000 records", (unsigned)received.size());
+  CHECK(offlineLogsCount == 0, "%d records left", offlineLogsCount);
+  CHECK(offlineStoreCount(OFFLINE_STORE_MAIN, 0) == 0, "main store not emptied");
+  CHECK(result.yielded > 0, "no slice yielded to a waiting card");
+}
+
+static void testTapLatencyFlat() {
+  // Worst case: the card arrives just after a full slice started
+  const unsigned long sliceMs = RTT_MS + PER_RECORD_MS * SYNC_SLICE_MAX_RECORDS;
+
+  DrainResult small = drain(200);
+  DrainResult large = drain(10000);
+  size_t n = large.latencies.size();
+  CHECK(n >= 40, "only %u taps during the drain", (unsigned)n);
+
+  unsigned long worstSmall = maxOf(small.latencies, 0, small.latencies.size());
+  unsigned long worstLarge = maxOf(large.latencies, 0, n);
+  double early = meanOf(large.latencies, 0, n / 4);
+  double late = meanOf(large.latencies, n - n / 4, n);
+  printf("Tap latency while draining: 200 records worst %lums; 10000 records worst %lums, "
+         "mean first quarter %.0fms, last quarter %.0fms; drain took %lus\n",
+         worstSmall, worstLarge, early, late, large.drainMs / 1000);
+
+  CHECK(worstLarge <= sliceMs + SCHED_RFID_MS, "worst tap latency %lums exceeds one slice (%lums)",
+        worstLarge, sliceMs + SCHED_RFID_MS);
+  CHECK(worstLarge <= worstSmall + SCHED_RFID_MS, "worst latency grew with the backlog: %lums vs %lums",
+        worstLarge, worstSmall);
+  // Arrival phase against the slices moves the mean a little either way
+  CHECK(late <= early + sliceMs / 4 && early <= late + sliceMs / 4,
+        "mean latency drifted during the drain: %.0fms then %.0fms", early, late);
+}
+
+static void testFloorCoversOutOfOrderRecords() {
+  // An MQTT tap handed to offline after newer taps had been stored
+  std::vector<uint32_t> seqs;
+  for (uint32_t seq = 10; seq < 30; seq++) {
+    seqs.push_back(seq);
+  }
+  seqs.push_back(5);
+  reset(seqs);
+
+  startOfflineSync();
+  while (isOfflineSyncActive()) {
+    serviceOfflineSync();
+    hostMillis += SCHED_JOBS_MS;
+  }
+  CHECK(std::find(received.begin(), received.end(), 5u) != received.end(), "seq 5 was never sent");
+  size_t sentAt = std::find(received.begin(), received.end(), 5u) - received.begin();
+  for (size_t slice = 0; slice < floorsSent.size() && slice * SYNC_SLICE_MAX_RECORDS <= sentAt; slice++) {
+    CHECK(floorsSent[slice] <= 5, "slice %u claimed nothing below %lu is held while seq 5 was",
+          (unsigned)slice, (unsigned long)floorsSent[slice]);
+  }
+}
+
+int main() {
+  testBacklogDrains();
+  testTapLatencyFlat();
+  testFloorCoversOutOfOrderRecords();
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All offline sync checks passed\n");
+  return 0;
+}
@@ -0,0 +1,191 @@
+/*
+ * Host build of the terminal's cross-gate tap gossip
+ *
+ * Runs the same ledger and packet code as the firmware (peer_ledger.cpp)
+ * over POSIX multicast sockets, so several "gates" can be started on one
+ * Linux machine. Type a card UID and Enter to tap it at that gate; add
+ * " in" or " out" to tap it at that gate's entry or exit lane.
+ *
+ * Build:
+ *   g++ -std=c++11 -Wall -Iattendance_terminal -o peer_gossip_host \
+ *       test_peer_gossip_host.cpp attendance_terminal/peer_ledger.cpp
+ *
+ * Usage: ./peer_gossip_host <gate-id> [loss-percent] [key]
+ *
+ * Try: start gates 1 and 2 in two terminals, tap A1B2C3D4 at gate 1, then
+ * at gate 2 (duplicate, "at gate 1"). With a loss percent of 50 or so the
+ * second tap is still caught, because each tap rides in PEER_EVENT_SENDS
+ * packets. Tapping A1B2C3D4 in at gate 1 and then A1B2C3D4 out at gate 2
+ * is accepted at both. Gates started with a different key ignore each
+ * other.
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include "peer_ledger.h"
+
+static int sock = -1;
+static sockaddr_in group;
+static uint32_t gateId = 0;
+static int lossPercent = 0;
+
+static unsigned long nowMs() {
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  return tv.tv_sec * 1000UL + tv.tv_usec / 1000;
+}
+
+static bool openSocket() {
+  sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    perror("socket");
+    return false;
+  }
+  int on = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef SO_REUSEPORT
+  setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+#endif
+
+  sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family = AF_INET;
+  local.sin_port = htons(PEER_MULTICAST_PORT);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(sock, (sockaddr*)&local, sizeof(local)) < 0) {
+    perror("bind");
+    return false;
+  }
+
+  ip_mreq membership;
+  membership.imr_multiaddr.s_addr = inet_addr(PEER_MULTICAST_GROUP);
+  membership.imr_interface.s_addr = htonl(INADDR_ANY);
+  if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+    perror("IP_ADD_MEMBERSHIP");
+    return false;
+  }
+  unsigned char loop = 1; // Other instances on this host must hear us
+  setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+  memset(&group, 0, sizeof(group));
+  group.sin_family = AF_INET;
+  group.sin_port = htons(PEER_MULTICAST_PORT);
+  group.sin_addr.s_addr = inet_addr(PEER_MULTICAST_GROUP);
+  return true;
+}
+
+static void sendOutbox() {
+  PeerTapEvent events[PEER_OUTBOX_SIZE];
+  uint8_t count = peerOutboxCollect(events, PEER_OUTBOX_SIZE);
+  if (count == 0) {
+    return;
+  }
+  uint8_t packet[PEER_PACKET_MAX];
+  size_t length = peerEncodePacket(packet, sizeof(packet), gateId, events, count);
+  if (rand() % 100 < lossPercent) {
+    printf("  (dropped outgoing packet with %u taps)\n", count);
+    return;
+  }
+  sendto(sock, packet, length, 0, (sockaddr*)&group, sizeof(group));
+}
+
+static void receivePacket() {
+  uint8_t packet[PEER_PACKET_MAX + 1];
+  ssize_t length = recv(sock, packet, sizeof(packet), 0);
+  uint32_t sender;
+  PeerTapEvent events[PEER_OUTBOX_SIZE];
+  int count = length > 0 ? peerDecodePacket(packet, length, sender, events, PEER_OUTBOX_SIZE) : -1;
+  if (count < 0 || sender == gateId) {
+    return;
+  }
+  for (int i = 0; i < count; i++) {
+    if (peerLedgerMerge(events[i], time(nullptr))) {
+      printf("  merged %s of %08x from gate %u\n", peerTapTypeName(events[i].type),
+             (unsigned)events[i].uidHash, (unsigned)sender);
+    }
+  }
+}
+
+static void tap(char* line) {
+  uint8_t lane = RFID_LANE_NONE;
+  char* direction = strchr(line, ' ');
+  if (direction) {
+    *direction++ = '\0';
+    lane = strcmp(direction, "in") == 0 ? RFID_LANE_ENTRY : strcmp(direction, "out") == 0 ? RFID_LANE_EXIT : RFID_LANE_NONE;
+  }
+  const char* rfidTag = line;
+  uint32_t now = time(nullptr);
+  uint32_t uidHash = peerUidHash(rfidTag);
+
+  PeerTapEvent last;
+  if (peerLedgerFindRecent(uidHash, lane, now, last)) {
+    printf("DUPLICATE %s: %s %us ago at gate %u\n", rfidTag, peerTapTypeName(last.type),
+           (unsigned)(now - last.time), (unsigned)last.origin);
+    return;
+  }
+
+  // The host has no backend; accepted taps count as entries unless tapped out
+  uint8_t type = lane == RFID_LANE_EXIT ? PEER_TAP_EXIT : PEER_TAP_ENTRY;
+  PeerTapEvent event = { uidHash, now, gateId, type, lane };
+  peerLedgerMerge(event, now);
+  peerOutboxAdd(event);
+  sendOutbox();
+  printf("ACCEPTED %s at gate %u\n", rfidTag, (unsigned)gateId);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <gate-id> [loss-percent] [key]\n", argv[0]);
+    return 1;
+  }
+  gateId = strtoul(argv[1], nullptr, 10);
+  lossPercent = argc > 2 ? atoi(argv[2]) : 0;
+  peerSetKey(argc > 3 ? argv[3] : "host-test-key");
+  srand(time(nullptr) ^ gateId);
+
+  if (!openSocket()) {
+    return 1;
+  }
+  peerLedgerReset();
+  printf("Gate %u on %s:%d, duplicate window %ds, loss %d%%\n", (unsigned)gateId,
+         PEER_MULTICAST_GROUP, PEER_MULTICAST_PORT, PEER_DUPLICATE_WINDOW_S, lossPercent);
+
+  unsigned long lastSend = 0;
+  char line[64];
+  while (true) {
+    pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { sock, POLLIN, 0 } };
+    poll(fds, 2, 100);
+
+    if (fds[1].revents & POLLIN) {
+      receivePacket();
+    }
+    if (fds[0].revents & (POLLIN | POLLHUP)) {
+      if (!fgets(line, sizeof(line), stdin)) {
+        break;
+      }
+      line[strcspn(line, "\r\n")] = '\0';
+      if (line[0] != '\0') {
+        tap(line);
+      }
+    }
+    if (nowMs() - lastSend >= PEER_RESEND_MS && peerOutboxPending()) {
+      sendOutbox();
+      lastSend = nowMs();
+    }
+  }
+
+  // Let the remaining repeats go out before exiting
+  while (peerOutboxPending()) {
+    usleep(PEER_RESEND_MS * 1000);
+    sendOutbox();
+  }
+  return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * Host test of the terminal's entry/exit reader lanes
+ *
+ * Runs the same scheduling and debounce code as the firmware
+ * (rfid_lanes.cpp) against two mock RC522 readers on a simulated clock.
+ * A mock reader answers a REQA once per card presentation, like a real
+ * card that is halted after its read and stays HALT until it leaves the
+ * field.
+ *
+ * Build:
+ *   g++ -std=c++11 -Wall -Iattendance_terminal -o rfid_lanes_host \
+ *       test_rfid_lanes_host.cpp attendance_terminal/rfid_lanes.cpp
+ *
+ * Usage: ./rfid_lanes_host      (exit status 0 when every check passes)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "rfid_lanes.h"
+
+#define POLL_MS 2                       // Failed REQA with the 2 ms RC522 timeout
+#define TAP_MS 1000                     // Feedback and backend round trip of one tap
+#define FEEDBACK_POLL_MS RFID_FEEDBACK_POLL_MS
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+  } while (0)
+
+struct Presentation {
+  uint32_t uid;
+  uint32_t from;                // Card enters the field
+  uint32_t until;               // Card leaves the field
+  bool answered;                // REQA answered once; the card is halted after its read
+};
+
+struct MockReader {
+  std::vector<Presentation> cards;
+
+  // PICC_IsNewCardPresent()
+  bool poll(uint32_t now) {
+    for (Presentation& card : cards) {
+      if (now >= card.from && now < card.until && !card.answered) {
+        card.answered = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // PICC_Select() of the card that answered last
+  uint32_t read(uint32_t now) {
+    for (const Presentation& card : cards) {
+      if (now >= card.from && now < card.until + TAP_MS && card.answered) {
+        return card.uid;
+      }
+    }
+    return 0;
+  }
+};
+
+struct Tap {
+  uint32_t uid;
+  uint32_t time;
+  uint8_t lane;
+};
+
+static MockReader readers[RFID_MAX_READERS];
+static std::vector<Tap> taps;
+static uint32_t now = 0;
+
+// pollForPendingCard()
+static void pollPending() {
+  int polled = rfidLanesNextPoll();
+  if (polled >= 0 && !rfidLanesIsLatched(polled) && readers[polled].poll(now)) {
+    rfidLanesLatch(polled);
+  }
+  now += POLL_MS;
+}
+
+// delayPollingReaders()
+static void delayPolling(uint32_t ms) {
+  uint32_t end = now + ms;
+  while (now < end) {
+    pollPending();
+    now += FEEDBACK_POLL_MS - POLL_MS;
+  }
+}
+
+// One loop() pass: handleRFIDScan()
+static void loopPass() {
+  pollPending();
+  int index = rfidLanesTakeLatched();
+  if (index < 0) {
+    return;
+  }
+  rfidLanesBeginServing(index);
+  uint32_t uid = readers[index].read(now);
+  if (uid != 0 && rfidLanesAccept(index, now)) {
+    taps.push_back({ uid, now, rfidLaneOf(index) });
+    delayPolling(TAP_MS);
+  }
+  rfidLanesEndServing();
+}
+
+static void reset(uint8_t readerCount) {
+  rfidLanesReset(readerCount);
+  for (MockReader& reader : readers) {
+    reader.cards.clear();
+  }
+  taps.clear();
+  now = 0;
+}
+
+static void runUntil(uint32_t end) {
+  while (now < end) {
+    loopPass();
+  }
+}
+
+static void testFairPolling() {
+  reset(2);
+  runUntil(2000);
+  uint32_t entry = rfidLanesStats(0).polls;
+  uint32_t exit = rfidLanesStats(1).polls;
+  CHECK(entry > 0 && (entry > exit ? entry - exit : exit - entry) <= 1,
+        "idle polls entry %u exit %u", (unsigned)entry, (unsigned)exit);
+}
+
+static void testDirectionTags() {
+  reset(2);
+  readers[0].cards.push_back({ 0xA1, 100, 400, false });
+  readers[1].cards.push_back({ 0xB2, 100, 400, false });
+  runUntil(5000);
+  CHECK(taps.size() == 2, "expected 2 taps, got %u", (unsigned)taps.size());
+  for (const Tap& tap : taps) {
+    uint8_t expected = tap.uid == 0xA1 ? RFID_LANE_ENTRY : RFID_LANE_EXIT;
+    CHECK(tap.lane == expected, "card %X tagged %s", (unsigned)tap.uid, rfidLaneDirection(tap.lane));
+  }
+  CHECK(strcmp(rfidLaneDirection(RFID_LANE_ENTRY), "entry") == 0 &&
+        strcmp(rfidLaneDirection(RFID_LANE_EXIT), "exit") == 0, "direction names");
+}
+
+static void testPerLaneDebounce() {
+  reset(2);
+  // Two students at the entry inside CARD_READ_DELAY, one at the exit meanwhile
+  readers[0].cards.push_back({ 0xA1, 100, 300, false });
+  readers[0].cards.push_back({ 0xA2, 1200, 1500, false });
+  readers[1].cards.push_back({ 0xB1, 1250, 1500, false });
+  runUntil(6000);
+
+  bool sawA2 = false, sawB1 = false;
+  for (const Tap& tap : taps) {
+    sawA2 |= tap.uid == 0xA2;
+    sawB1 |= tap.uid == 0xB1;
+  }
+  CHECK(!sawA2, "second entry card inside CARD_READ_DELAY was accepted");
+  CHECK(sawB1, "exit tap was blocked by the entry lane's debounce");
+  CHECK(rfidLanesStats(0).debounced == 1, "entry debounced %u", (unsigned)rfidLanesStats(0).debounced);
+  CHECK(rfidLanesStats(1).debounced == 0, "exit debounced %u", (unsigned)rfidLanesStats(1).debounced);
+}
+
+static void testFairServiceUnderLoad() {
+  reset(2);
+  // Both lanes always have a card waiting
+  for (uint32_t t = 0; t < 60000; t += CARD_READ_DELAY) {
+    readers[0].cards.push_back({ 0x1000 + t, t, t + CARD_READ_DELAY, false });
+    readers[1].cards.push_back({ 0x2000 + t, t, t + CARD_READ_DELAY, false });
+  }
+  runUntil(60000);
+  int entry = 0, exit = 0;
+  for (const Tap& tap : taps) {
+    (tap.lane == RFID_LANE_ENTRY ? entry : exit)++;
+  }
+  CHECK(entry > 0 && (entry > exit ? entry - exit : exit - entry) <= 1,
+        "served entry %d exit %d", entry, exit);
+}
+
+static void testSingleReader() {
+  reset(1);
+  readers[0].cards.push_back({ 0xC3, 100, 400, false });
+  runUntil(3000);
+  CHECK(taps.size() == 1 && taps[0].lane == RFID_LANE_NONE, "single reader tap should be untagged");
+  CHECK(rfidLaneDirection(RFID_LANE_NONE) == nullptr, "untagged lane has no direction");
+}
+
+static void testDisabledLane() {
+  reset(2);
+  rfidLanesSetEnabled(1, false);
+  readers[1].cards.push_back({ 0xB1, 100, 400, false });
+  runUntil(2000);
+  CHECK(rfidLanesStats(1).polls == 0, "disabled lane polled %u times", (unsigned)rfidLanesStats(1).polls);
+  CHECK(taps.empty(), "disabled lane produced a tap");
+}
+
+// Students walk up every walkMs per lane; returns taps served in windowMs
+static size_t servedAtGate(uint8_t readerCount, uint32_t walkMs, uint32_t windowMs) {
+  reset(readerCount);
+  uint32_t uid = 1;
+  for (uint8_t r = 0; r < readerCount; r++) {
+    for (uint32_t t = r * 50; t < windowMs; t += walkMs) {
+      readers[r].cards.push_back({ uid++, t, t + 800, false });
+    }
+  }
+  runUntil(windowMs);
+  return taps.size();
+}
+
+static void testThroughput() {
+  // Walk-up time per student dominates a 1 s tap, so a second lane doubles the gate
+  size_t single = servedAtGate(1, 2500, 600000);
+  size_t dual = servedAtGate(2, 2500, 600000);
+  printf("Throughput over 10 min: single reader %u taps, two lanes %u taps (x%.2f)\n",
+         (unsigned)single, (unsigned)dual, single ? (double)dual / single : 0.0);
+  CHECK(dual * 10 >= single * 19, "two lanes served %u vs %u", (unsigned)dual, (unsigned)single);
+}
+
+int main() {
+  testFairPolling();
+  testDirectionTags();
+  testPerLaneDebounce();
+  testFairServiceUnderLoad();
+  testSingleReader();
+  testDisabledLane();
+  testThroughput();
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All lane checks passed\n");
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Host benchmark and check of the terminal's OLED sprite atlas
+ *
+ * Checks that every sprite blitted from the atlas (sprite_atlas.cpp, the
+ * firmware's own code) matches its primitive drawing in sprite_shapes.h
+ * pixel for pixel, including moved and page-misaligned blits, then times
+ * each screen's icon both ways.
+ *
+ * The primitive side runs on host_canvas.h, whose drawPixel() inlines;
+ * on the device each pixel is a virtual Adafruit_GFX call, so the real
+ * gap is wider than the one printed here.
+ *
+ * Build (regenerate the atlas first if a shape changed):
+ *   g++ -std=c++11 -O2 -Wall -Iattendance_terminal -o sprite_atlas_host \
+ *       test_sprite_atlas_host.cpp attendance_terminal/sprite_atlas.cpp
+ *
+ * Usage: ./sprite_atlas_host      (exit status 0 when every check passes)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "host_canvas.h"
+#include "sprite_shapes.h"
+#include "sprite_atlas.h"
+
+#define ITERATIONS 20000
+
+static int failures = 0;
+// Keeps the timed loops from being optimised away
+static volatile unsigned benchmarkSink;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+  } while (0)
+
+struct Shape {
+  const char* name;
+  SpriteId id;
+  void (*draw)(HostCanvas&);
+};
+
+#define SHAPE_ENTRY(name, fn) { #name, SPRITE_##name, fn<HostCanvas> },
+static const Shape SHAPES[] = { SPRITE_SHAPE_LIST(SHAPE_ENTRY) };
+static const size_t SHAPE_COUNT = sizeof(SHAPES) / sizeof(SHAPES[0]);
+
+static void testBlitsMatchPrimitives() {
+  CHECK(SHAPE_COUNT == SPRITE_COUNT, "atlas has %d sprites, sprite_shapes.h %u; regenerate it",
+        (int)SPRITE_COUNT, (unsigned)SHAPE_COUNT);
+  for (size_t i = 0; i < SHAPE_COUNT; i++) {
+    HostCanvas drawn, blitted;
+    SHAPES[i].draw(drawn);
+    spriteBlit(blitted.buffer, SHAPES[i].id);
+    CHECK(memcmp(drawn.buffer, blitted.buffer, sizeof(drawn.buffer)) == 0,
+          "%s differs from its drawing; regenerate the atlas", SHAPES[i].name);
+
+    HostCanvas placed;
+    SpriteInfo info = spriteInfo(SHAPES[i].id);
+    spriteBlitAt(placed.buffer, SHAPES[i].id, info.x, info.y);
+    CHECK(memcmp(drawn.buffer, placed.buffer, sizeof(drawn.buffer)) == 0,
+          "%s placed at its own position differs", SHAPES[i].name);
+  }
+}
+
+// Every drawn pixel moved by (dx, dy) must be lit, and nothing else
+static bool matchesMoved(const HostCanvas& drawn, const HostCanvas& moved, int dx, int dy) {
+  for (int y = 0; y < HostCanvas::HEIGHT; y++) {
+    for (int x = 0; x < HostCanvas::WIDTH; x++) {
+      if (moved.pixel(x, y) != drawn.pixel(x - dx, y - dy)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static void testMovedBlits() {
+  HostCanvas drawn;
+  shapeSwipeCard(drawn);
+  SpriteInfo card = spriteInfo(SPRITE_SWIPE_CARD);
+  // The swipe animations' path, from fully off the left edge to off the right
+  for (int x = -card.width - 2; x <= HostCanvas::WIDTH + 2; x += 4) {
+    HostCanvas moved;
+    spriteBlitAt(moved.buffer, SPRITE_SWIPE_CARD, x, card.y);
+    CHECK(matchesMoved(drawn, moved, x - card.x, 0), "swipe card at x %d", x);
+  }
+  // Off the page grid and past the top and bottom edges
+  for (int dy = -21; dy <= 21; dy += 3) {
+    HostCanvas moved;
+    spriteBlitAt(moved.buffer, SPRITE_SWIPE_CARD, card.x + 40, card.y + dy);
+    CHECK(matchesMoved(drawn, moved, 40, dy), "swipe card moved by 40,%d", dy);
+  }
+}
+
+struct Screen {
+  const char* name;
+  SpriteId id;
+  void (*draw)(HostCanvas&);
+};
+
+static const Screen SCREENS[] = {
+  { "showSuccessScreen", SPRITE_HAPPY_EMOJI, shapeHappyEmoji<HostCanvas> },
+  { "showErrorScreen", SPRITE_SAD_EMOJI, shapeSadEmoji<HostCanvas> },
+  { "showCardScanScreen", SPRITE_CARD, shapeCard<HostCanvas> },
+  { "showWiFiStatus", SPRITE_WIFI_ON, shapeWiFiOn<HostCanvas> },
+  { "animateSuccess", SPRITE_CHECKMARK, shapeCheckmark<HostCanvas> },
+  { "animateError", SPRITE_CROSS, shapeCross<HostCanvas> },
+  { "drawGear", SPRITE_GEAR, shapeGear<HostCanvas> },
+  { "drawHeart", SPRITE_HEART, shapeHeart<HostCanvas> },
+};
+
+static double nsPerFrame(HostCanvas& canvas, const Screen& screen, bool blit) {
+  unsigned checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    canvas.clearDisplay();
+    if (blit) {
+      spriteBlit(canvas.buffer, screen.id);
+    } else {
+      screen.draw(canvas);
+    }
+    checksum += canvas.buffer[i % sizeof(canvas.buffer)];
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  benchmarkSink = checksum;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+static void benchmarkScreens() {
+  HostCanvas canvas;
+  double clearNs = 0;
+  {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+      canvas.clearDisplay();
+      benchmarkSink = canvas.buffer[i % sizeof(canvas.buffer)];
+    }
+    clearNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ITERATIONS;
+  }
+
+  printf("%-20s %12s %12s %8s\n", "screen icon", "primitive ns", "blit ns", "speedup");
+  double primitiveTotal = 0, blitTotal = 0;
+  for (const Screen& screen : SCREENS) {
+    double primitive = nsPerFrame(canvas, screen, false) - clearNs;
+    double blit = nsPerFrame(canvas, screen, true) - clearNs;
+    primitive = primitive > 1 ? primitive : 1;
+    blit = blit > 1 ? blit : 1;
+    primitiveTotal += primitive;
+    blitTotal += blit;
+    printf("%-20s %12.0f %12.0f %7.1fx\n", screen.name, primitive, blit, primitive / blit);
+  }
+  printf("%-20s %12.0f %12.0f %7.1fx\n", "all", primitiveTotal, blitTotal, primitiveTotal / blitTotal);
+  CHECK(blitTotal < primitiveTotal, "blits slower than primitives overall");
+}
+
+int main() {
+  testBlitsMatchPrimitives();
+  testMovedBlits();
+  benchmarkScreens();
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All sprite checks passed\n");
+  return 0;
+}
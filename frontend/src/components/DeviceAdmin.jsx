@@ -921,7 +921,7 @@ const DeviceAdmin = () => {
             </div>
             <div className="mt-6 text-xs text-gray-600 bg-gray-50 p-3 border border-gray-100 rounded-none">
               <strong>Note:</strong> Source code files (.ino, .cpp, .h) must be downloaded from your development environment. 
-              Only runtime configuration files (config.json, offline_logs.txt) can be downloaded directly from the device.
+              Only runtime data can be downloaded directly from the device: config.json and offline_logs.jsonl (pending offline taps, one JSON record per line).
             </div>
           </div>
         </div>